@@ -0,0 +1,314 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Arena savings of BranchAndBoundMemoryPlanner over GreedyMemoryPlanner for
+// the models in app/lib_src.
+//
+// Usage: arena_report [model_name...]
+//
+// Every model is allocated as in its demo, once with each planner, and the
+// arena bytes used and the time spent in AllocateTensors() are written to
+// stdout as JSON. Only the non-persistent head of the arena depends on the
+// planner, so the savings carry over to the device even though the host
+// figures are somewhat larger (see model_benchmark.cc). "persistent_bytes" is
+// the tail of the arena that holds the eval tensors, node data and kernel
+// buffers for the lifetime of the interpreter.
+//
+// The "shared_arena" section allocates all the selected models in one arena
+// with a shared non-persistent section (see
+// MicroAllocator::set_share_non_persistent_memory), compares its size with
+// the sum of the separate greedy arenas and runs every model once through a
+// MicroModelScheduler. Only the first MicroModelScheduler::kMaxModels of the
+// selected models take part.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "cifar10_demo/cifar10_model_data.h"
+#include "emergency_detect/emergency-detect.h"
+#include "mnist_demo/mnist_demo_model.h"
+#include "person_detection_demo/person_detect_model_data.h"
+#include "simple_example/mnist_model.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_model_scheduler.h"
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+struct ModelSpec {
+  const char* name;
+  const unsigned char* model_data;
+  // Input frames per InvokeStreaming() call, 0 to run Invoke() on the whole
+  // input.
+  int hop;
+  // Whether conv/pool chains run as fused nodes.
+  bool fuse_conv_pool;
+  // Whether the graph is simplified when it is allocated.
+  bool simplify_graph;
+};
+
+const ModelSpec kModels[] = {
+    {"emergency_detect", output_emergency_detect_tflite, 0, false, false},
+    {"emergency_detect_stream", output_emergency_detect_tflite, 1024, false,
+     false},
+    {"emergency_detect_fused", output_emergency_detect_tflite, 0, true, false},
+    {"emergency_detect_simplified", output_emergency_detect_tflite, 0, false,
+     true},
+    {"person_detection_demo", person_detect_model_data, 0, false, false},
+    {"cifar10_demo", cifar10_model_tflite, 0, false, false},
+    {"mnist_demo", mnist_dense_model_tflite, 0, false, false},
+    {"mnist_demo_simplified", mnist_dense_model_tflite, 0, false, true},
+    {"simple_example", mnist_model_tflite, 0, false, false},
+};
+
+const char* ModeName(const ModelSpec& spec) {
+  if (spec.hop > 0) {
+    return "streaming";
+  }
+  if (spec.simplify_graph) {
+    return "simplified";
+  }
+  return spec.fuse_conv_pool ? "fused" : "invoke";
+}
+
+constexpr size_t kArenaSize = 4 * 1024 * 1024;
+
+alignas(16) uint8_t tensor_arena[kArenaSize];
+
+struct PlanResult {
+  const char* error;
+  size_t arena_used_bytes;
+  size_t persistent_bytes;
+  int64_t allocate_ticks;
+};
+
+PlanResult AllocateModel(const ModelSpec& spec,
+                         tflite::MemoryPlannerType planner_type,
+                         tflite::ErrorReporter* error_reporter) {
+  PlanResult result = {};
+  const tflite::Model* model = tflite::GetModel(spec.model_data);
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    result.error = "unsupported schema version";
+    return result;
+  }
+
+  tflite::AllOpsResolver resolver;
+  tflite::MicroAllocator* allocator = tflite::MicroAllocator::Create(
+      tensor_arena, kArenaSize, error_reporter, planner_type);
+  tflite::MicroInterpreter interpreter(model, &resolver, allocator,
+                                       error_reporter);
+  if (spec.hop > 0 && interpreter.EnableStreaming(spec.hop) != kTfLiteOk) {
+    result.error = "EnableStreaming() failed";
+    return result;
+  }
+  if (spec.fuse_conv_pool &&
+      interpreter.EnableConvPoolFusion(
+          tflite::ops::micro::Register_CONV_2D_MAX_POOL_2D()) != kTfLiteOk) {
+    result.error = "EnableConvPoolFusion() failed";
+    return result;
+  }
+  if (spec.simplify_graph &&
+      interpreter.EnableGraphSimplification() != kTfLiteOk) {
+    result.error = "EnableGraphSimplification() failed";
+    return result;
+  }
+  const uint32_t start = tflite::GetCurrentTimeTicks();
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    result.error = "AllocateTensors() failed";
+    return result;
+  }
+  // Modulo 2^32, the tick counter may wrap during AllocateTensors().
+  result.allocate_ticks =
+      static_cast<uint32_t>(tflite::GetCurrentTimeTicks()) - start;
+  result.arena_used_bytes = interpreter.arena_used_bytes();
+  // Read before anything calls tensor(), which adds persistent TfLiteTensors.
+  result.persistent_bytes = allocator->persistent_bytes();
+  return result;
+}
+
+struct SharedResult {
+  const char* error;
+  size_t arena_used_bytes;
+};
+
+SharedResult AllocateAndRunShared(
+    const std::vector<const ModelSpec*>& specs,
+    tflite::ErrorReporter* error_reporter) {
+  SharedResult result = {};
+  tflite::AllOpsResolver resolver;
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(tensor_arena, kArenaSize, error_reporter);
+  allocator->set_share_non_persistent_memory(true);
+  tflite::MicroModelScheduler scheduler(error_reporter);
+  std::vector<std::unique_ptr<tflite::MicroInterpreter>> interpreters;
+  std::vector<std::vector<uint8_t>> frames;
+  for (const ModelSpec* spec : specs) {
+    const tflite::Model* model = tflite::GetModel(spec->model_data);
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+      result.error = "unsupported schema version";
+      return result;
+    }
+    interpreters.emplace_back(new tflite::MicroInterpreter(
+        model, &resolver, allocator, error_reporter));
+    tflite::MicroInterpreter* interpreter = interpreters.back().get();
+    if (spec->hop > 0 && interpreter->EnableStreaming(spec->hop) != kTfLiteOk) {
+      result.error = "EnableStreaming() failed";
+      return result;
+    }
+    if (spec->fuse_conv_pool &&
+        interpreter->EnableConvPoolFusion(
+            tflite::ops::micro::Register_CONV_2D_MAX_POOL_2D()) != kTfLiteOk) {
+      result.error = "EnableConvPoolFusion() failed";
+      return result;
+    }
+    if (spec->simplify_graph &&
+        interpreter->EnableGraphSimplification() != kTfLiteOk) {
+      result.error = "EnableGraphSimplification() failed";
+      return result;
+    }
+    if (interpreter->AllocateTensors() != kTfLiteOk) {
+      result.error = "AllocateTensors() failed";
+      return result;
+    }
+    if (scheduler.AddModel(interpreter, nullptr, nullptr, nullptr) !=
+        kTfLiteOk) {
+      result.error = "AddModel() failed";
+      return result;
+    }
+    const TfLiteTensor* input = interpreter->input(0);
+    frames.emplace_back(
+        spec->hop > 0 ? input->bytes / input->dims->data[1] * spec->hop : 0);
+  }
+  for (int i = 0; i < scheduler.models_size(); ++i) {
+    const void* model_frames = frames[i].empty() ? nullptr : frames[i].data();
+    if (scheduler.Invoke(i, model_frames, frames[i].size()) != kTfLiteOk) {
+      result.error = "Invoke() failed";
+      return result;
+    }
+  }
+  result.arena_used_bytes = allocator->used_bytes();
+  return result;
+}
+
+double TicksToMicroseconds(int64_t ticks) {
+  const int32_t tps = tflite::ticks_per_second();
+  return tps > 0 ? ticks * 1e6 / tps : 0.0;
+}
+
+bool IsSelected(const char* name, int argc, char** argv) {
+  if (argc <= 1) {
+    return true;
+  }
+  for (int i = 1; i < argc; ++i) {
+    if (strcmp(argv[i], name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+
+  const int model_count = sizeof(kModels) / sizeof(kModels[0]);
+  std::vector<const ModelSpec*> selected;
+  for (int i = 0; i < model_count; ++i) {
+    if (IsSelected(kModels[i].name, argc, argv)) {
+      selected.push_back(&kModels[i]);
+    }
+  }
+
+  const std::vector<const ModelSpec*> shared_models(
+      selected.begin(),
+      selected.begin() +
+          std::min<size_t>(selected.size(),
+                           tflite::MicroModelScheduler::kMaxModels));
+
+  bool ok = true;
+  size_t separate_arena_bytes = 0;
+  printf("{\n");
+  printf("  \"models\": [\n");
+  for (size_t i = 0; i < selected.size(); ++i) {
+    const ModelSpec& spec = *selected[i];
+    const PlanResult greedy = AllocateModel(
+        spec, tflite::MemoryPlannerType::kGreedy, error_reporter);
+    const PlanResult branch_and_bound = AllocateModel(
+        spec, tflite::MemoryPlannerType::kBranchAndBound, error_reporter);
+    const char* error =
+        greedy.error != nullptr ? greedy.error : branch_and_bound.error;
+    const char* separator = i + 1 == selected.size() ? "" : ",";
+
+    printf("    {\n");
+    printf("      \"name\": \"%s\",\n", spec.name);
+    printf("      \"mode\": \"%s\",\n", ModeName(spec));
+    if (error != nullptr) {
+      ok = false;
+      printf("      \"error\": \"%s\"\n", error);
+      printf("    }%s\n", separator);
+      continue;
+    }
+    if (i < shared_models.size()) {
+      separate_arena_bytes += greedy.arena_used_bytes;
+    }
+    const long saved_bytes =
+        static_cast<long>(greedy.arena_used_bytes) -
+        static_cast<long>(branch_and_bound.arena_used_bytes);
+    printf("      \"greedy_arena_bytes\": %zu,\n", greedy.arena_used_bytes);
+    printf("      \"branch_and_bound_arena_bytes\": %zu,\n",
+           branch_and_bound.arena_used_bytes);
+    printf("      \"saved_bytes\": %ld,\n", saved_bytes);
+    printf("      \"saved_percent\": %.1f,\n",
+           100.0 * saved_bytes / greedy.arena_used_bytes);
+    printf("      \"persistent_bytes\": %zu,\n", greedy.persistent_bytes);
+    printf("      \"greedy_allocate_us\": %.1f,\n",
+           TicksToMicroseconds(greedy.allocate_ticks));
+    printf("      \"branch_and_bound_allocate_us\": %.1f\n",
+           TicksToMicroseconds(branch_and_bound.allocate_ticks));
+    printf("    }%s\n", separator);
+  }
+  printf("  ],\n");
+
+  const SharedResult shared =
+      AllocateAndRunShared(shared_models, error_reporter);
+  printf("  \"shared_arena\": {\n");
+  printf("    \"models\": %zu,\n", shared_models.size());
+  if (!ok || shared.error != nullptr) {
+    ok = false;
+    printf("    \"error\": \"%s\"\n",
+           shared.error != nullptr ? shared.error : "model error");
+  } else {
+    const long saved_bytes = static_cast<long>(separate_arena_bytes) -
+                             static_cast<long>(shared.arena_used_bytes);
+    printf("    \"separate_arena_bytes\": %zu,\n", separate_arena_bytes);
+    printf("    \"shared_arena_bytes\": %zu,\n", shared.arena_used_bytes);
+    printf("    \"saved_bytes\": %ld\n", saved_bytes);
+  }
+  printf("  }\n");
+  printf("}\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,196 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks BranchAndBoundMemoryPlanner against GreedyMemoryPlanner.
+//
+// Usage: memory_planner_check
+//
+// The bundled models do not tell the planners apart: on every one of them the
+// greedy plan already reaches the lower bound (the largest sum of live buffer
+// sizes), so the search stops after its first, greedy, plan. This check
+// plans a small graph where the greedy order leaves a hole that the search
+// closes, and then random buffer sets, some with offline offsets. Every plan
+// must keep buffers that are live at the same time apart, keep the offline
+// offsets and be no larger than the greedy one. The process exits non-zero
+// on the first violation.
+
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "tensorflow/lite/micro/memory_planner/branch_and_bound_memory_planner.h"
+#include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+
+namespace {
+
+constexpr int kMaxBuffers = 64;
+constexpr int kRandomSets = 500;
+
+unsigned char greedy_scratch[kMaxBuffers * 64];
+unsigned char branch_and_bound_scratch[kMaxBuffers * 64];
+
+struct Buffer {
+  int size;
+  int first_time_used;
+  int last_time_used;
+  int offline_offset;
+};
+
+struct PlanSizes {
+  int greedy;
+  int branch_and_bound;
+  int lower_bound;
+};
+
+bool Overlaps(const Buffer& a, int a_offset, const Buffer& b, int b_offset) {
+  return a.first_time_used <= b.last_time_used &&
+         b.first_time_used <= a.last_time_used &&
+         a_offset < b_offset + b.size && b_offset < a_offset + a.size;
+}
+
+// Plans `buffers` with both planners and checks the branch-and-bound plan.
+bool Plan(const char* name, const std::vector<Buffer>& buffers,
+          tflite::ErrorReporter* error_reporter, PlanSizes* sizes) {
+  tflite::GreedyMemoryPlanner greedy(greedy_scratch, sizeof(greedy_scratch));
+  tflite::BranchAndBoundMemoryPlanner branch_and_bound(
+      branch_and_bound_scratch, sizeof(branch_and_bound_scratch));
+  for (const Buffer& buffer : buffers) {
+    if (greedy.AddBuffer(error_reporter, buffer.size, buffer.first_time_used,
+                         buffer.last_time_used,
+                         buffer.offline_offset) != kTfLiteOk ||
+        branch_and_bound.AddBuffer(
+            error_reporter, buffer.size, buffer.first_time_used,
+            buffer.last_time_used, buffer.offline_offset) != kTfLiteOk) {
+      fprintf(stderr, "%s: AddBuffer() failed\n", name);
+      return false;
+    }
+  }
+  sizes->greedy = greedy.GetMaximumMemorySize();
+  sizes->branch_and_bound = branch_and_bound.GetMaximumMemorySize();
+  sizes->lower_bound = branch_and_bound.GetLowerBound();
+  if (sizes->branch_and_bound > sizes->greedy ||
+      sizes->branch_and_bound < sizes->lower_bound) {
+    fprintf(stderr, "%s: %d bytes against greedy %d and lower bound %d\n",
+            name, sizes->branch_and_bound, sizes->greedy, sizes->lower_bound);
+    return false;
+  }
+
+  std::vector<int> offsets(buffers.size());
+  for (size_t i = 0; i < buffers.size(); ++i) {
+    if (branch_and_bound.GetOffsetForBuffer(error_reporter, i, &offsets[i]) !=
+        kTfLiteOk) {
+      return false;
+    }
+    if (offsets[i] < 0 ||
+        offsets[i] + buffers[i].size > sizes->branch_and_bound) {
+      fprintf(stderr, "%s: buffer %d is outside the arena\n", name,
+              static_cast<int>(i));
+      return false;
+    }
+    if (buffers[i].offline_offset !=
+            tflite::BranchAndBoundMemoryPlanner::kOnlinePlannedBuffer &&
+        offsets[i] != buffers[i].offline_offset) {
+      fprintf(stderr, "%s: offline buffer %d was moved\n", name,
+              static_cast<int>(i));
+      return false;
+    }
+    for (size_t j = 0; j < i; ++j) {
+      if (Overlaps(buffers[i], offsets[i], buffers[j], offsets[j])) {
+        fprintf(stderr, "%s: buffers %d and %d overlap\n", name,
+                static_cast<int>(j), static_cast<int>(i));
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+// Four buffers of a short chain: node 2 writes a 3K tensor next to a 5K
+// scratch buffer, nodes 3 and 4 pass a 2K tensor, and node 4 writes a 4K one
+// that node 5 reads. Greedy places the 5K and 4K buffers at offset zero and
+// stacks the 3K one on the 5K one, which leaves only 1K under it for the 2K
+// buffer: 10K. Putting the 4K buffer above the 2K one instead fits all of
+// them into the 8K that are live at node 2.
+bool CheckSmallChain(tflite::ErrorReporter* error_reporter) {
+  constexpr int kOnline =
+      tflite::BranchAndBoundMemoryPlanner::kOnlinePlannedBuffer;
+  const std::vector<Buffer> buffers = {
+      {3072, 2, 3, kOnline},
+      {2048, 3, 4, kOnline},
+      {5120, 2, 2, kOnline},
+      {4096, 4, 5, kOnline},
+  };
+  PlanSizes sizes;
+  if (!Plan("small_chain", buffers, error_reporter, &sizes)) {
+    return false;
+  }
+  printf("small_chain: greedy %d bytes, branch and bound %d bytes, "
+         "lower bound %d bytes\n",
+         sizes.greedy, sizes.branch_and_bound, sizes.lower_bound);
+  if (sizes.greedy != 10240 || sizes.branch_and_bound != 8192) {
+    fprintf(stderr, "small_chain: expected 10240 and 8192 bytes\n");
+    return false;
+  }
+  return true;
+}
+
+// Random sets of 5-45 buffers. A tenth of them are stacked at fixed offsets
+// at the bottom of the arena, as an offline plan would leave them.
+bool CheckRandomSets(tflite::ErrorReporter* error_reporter) {
+  int improved = 0;
+  long greedy_bytes = 0;
+  long branch_and_bound_bytes = 0;
+  for (int set = 0; set < kRandomSets; ++set) {
+    const int count = 5 + rand() % 41;
+    std::vector<Buffer> buffers(count);
+    int offline_end = 0;
+    for (Buffer& buffer : buffers) {
+      buffer.size = 16 * (1 + rand() % 256);
+      buffer.first_time_used = rand() % count;
+      buffer.last_time_used = buffer.first_time_used + rand() % 8;
+      buffer.offline_offset =
+          tflite::BranchAndBoundMemoryPlanner::kOnlinePlannedBuffer;
+      if (rand() % 10 == 0) {
+        buffer.offline_offset = offline_end;
+        offline_end += buffer.size;
+      }
+    }
+    char name[32];
+    snprintf(name, sizeof(name), "random_%d", set);
+    PlanSizes sizes;
+    if (!Plan(name, buffers, error_reporter, &sizes)) {
+      return false;
+    }
+    improved += sizes.branch_and_bound < sizes.greedy;
+    greedy_bytes += sizes.greedy;
+    branch_and_bound_bytes += sizes.branch_and_bound;
+  }
+  printf("random: %d of %d sets improved, %ld bytes against greedy %ld\n",
+         improved, kRandomSets, branch_and_bound_bytes, greedy_bytes);
+  return true;
+}
+
+}  // namespace
+
+int main() {
+  tflite::MicroErrorReporter micro_error_reporter;
+  srand(1);
+  if (!CheckSmallChain(&micro_error_reporter) ||
+      !CheckRandomSets(&micro_error_reporter)) {
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,365 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host benchmark of the models in app/lib_src.
+//
+// Usage: model_benchmark [iterations] [model_name...]
+//
+// Every model is run in the invocation mode of its demo on synthetic input,
+// with AllOpsResolver and an arena large enough for any of them. The results
+// are written to stdout as JSON, one object per model with invocations per
+// second, per-operator time, the arena bytes actually used and the peak stack
+// depth of setup and inference. Logs of the runtime go to stderr.
+//
+// Arena and stack figures are for the host ABI, where pointers are 8 bytes,
+// so they overestimate the device numbers somewhat.
+//
+// The TFLM_NUM_THREADS environment variable sets the threads the host
+// FULLY_CONNECTED and CONV_2D kernels may use (1 by default).
+
+#include <ucontext.h>
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "cifar10_demo/cifar10_model_data.h"
+#include "emergency_detect/emergency-detect.h"
+#include "mnist_demo/mnist_demo_model.h"
+#include "person_detection_demo/person_detect_model_data.h"
+#include "simple_example/mnist_model.h"
+#include "tensorflow/lite/core/api/profiler.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+struct ModelSpec {
+  const char* name;
+  const unsigned char* model_data;
+  // Input frames per InvokeStreaming() call, 0 to run Invoke() on the whole
+  // input.
+  int hop;
+  // Whether conv/pool chains run as fused nodes.
+  bool fuse_conv_pool;
+  // Whether the graph is simplified when it is allocated.
+  bool simplify_graph;
+};
+
+const ModelSpec kModels[] = {
+    {"emergency_detect", output_emergency_detect_tflite, 0, false, false},
+    {"emergency_detect_stream", output_emergency_detect_tflite, 1024, false,
+     false},
+    {"emergency_detect_fused", output_emergency_detect_tflite, 0, true, false},
+    {"emergency_detect_simplified", output_emergency_detect_tflite, 0, false,
+     true},
+    {"person_detection_demo", person_detect_model_data, 0, false, false},
+    {"cifar10_demo", cifar10_model_tflite, 0, false, false},
+    {"mnist_demo", mnist_dense_model_tflite, 0, false, false},
+    {"mnist_demo_simplified", mnist_dense_model_tflite, 0, false, true},
+    {"simple_example", mnist_model_tflite, 0, false, false},
+};
+
+const char* ModeName(const ModelSpec& spec) {
+  if (spec.hop > 0) {
+    return "streaming";
+  }
+  if (spec.simplify_graph) {
+    return "simplified";
+  }
+  return spec.fuse_conv_pool ? "fused" : "invoke";
+}
+
+constexpr int kDefaultIterations = 10;
+constexpr int kMaxOps = 256;
+constexpr size_t kArenaSize = 4 * 1024 * 1024;
+constexpr size_t kStackSize = 1024 * 1024;
+constexpr uint8_t kStackPaint = 0xa5;
+
+alignas(16) uint8_t tensor_arena[kArenaSize];
+alignas(16) uint8_t benchmark_stack[kStackSize];
+
+// Ticks elapsed since `start`. The tick counter is a 32-bit value that wraps,
+// so the difference is taken modulo 2^32 before it is widened.
+uint32_t TicksSince(uint32_t start) {
+  return static_cast<uint32_t>(tflite::GetCurrentTimeTicks()) - start;
+}
+
+// Accumulates the time spent in every operator across invocations.
+class OpTimeProfiler : public tflite::Profiler {
+ public:
+  uint32_t BeginEvent(const char* tag, EventType event_type,
+                      int64_t event_metadata1,
+                      int64_t event_metadata2) override {
+    if (event_type != EventType::OPERATOR_INVOKE_EVENT ||
+        event_metadata1 < 0 || event_metadata1 >= kMaxOps) {
+      return kMaxOps;
+    }
+    const int index = static_cast<int>(event_metadata1);
+    ops_[index].tag = tag;
+    ops_[index].start = tflite::GetCurrentTimeTicks();
+    return index;
+  }
+
+  void EndEvent(uint32_t event_handle) override {
+    if (event_handle >= static_cast<uint32_t>(kMaxOps)) {
+      return;
+    }
+    OpTime& op = ops_[event_handle];
+    op.ticks += TicksSince(op.start);
+    ++op.count;
+  }
+
+  void Reset() { memset(ops_, 0, sizeof(ops_)); }
+
+  const char* tag(int index) const { return ops_[index].tag; }
+  int64_t ticks(int index) const { return ops_[index].ticks; }
+  int count(int index) const { return ops_[index].count; }
+
+ private:
+  struct OpTime {
+    const char* tag;
+    uint32_t start;
+    int64_t ticks;
+    int count;
+  };
+  OpTime ops_[kMaxOps];
+};
+
+struct BenchmarkResult {
+  const char* error;
+  size_t arena_used_bytes;
+  size_t peak_stack_bytes;
+  size_t operators_size;
+  size_t removed_operators_size;
+  int64_t invoke_ticks;
+};
+
+// State handed to the benchmark context, which cannot take pointer arguments.
+const ModelSpec* current_model;
+int current_iterations;
+int num_threads = 1;
+BenchmarkResult current_result;
+OpTimeProfiler op_profiler;
+ucontext_t main_context;
+ucontext_t benchmark_context;
+
+uint32_t random_state = 1;
+
+void FillRandom(void* data, size_t bytes) {
+  uint8_t* out = static_cast<uint8_t*>(data);
+  for (size_t i = 0; i < bytes; ++i) {
+    random_state = random_state * 1664525u + 1013904223u;
+    out[i] = static_cast<uint8_t>(random_state >> 24);
+  }
+}
+
+void RunModel() {
+  const ModelSpec& spec = *current_model;
+  BenchmarkResult& result = current_result;
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+
+  const tflite::Model* model = tflite::GetModel(spec.model_data);
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    result.error = "unsupported schema version";
+    return;
+  }
+
+  tflite::AllOpsResolver resolver;
+  tflite::MicroInterpreter interpreter(model, resolver, tensor_arena,
+                                       kArenaSize, error_reporter,
+                                       &op_profiler);
+  if (spec.hop > 0 && interpreter.EnableStreaming(spec.hop) != kTfLiteOk) {
+    result.error = "EnableStreaming() failed";
+    return;
+  }
+  if (spec.fuse_conv_pool &&
+      interpreter.EnableConvPoolFusion(
+          tflite::ops::micro::Register_CONV_2D_MAX_POOL_2D()) != kTfLiteOk) {
+    result.error = "EnableConvPoolFusion() failed";
+    return;
+  }
+  if (spec.simplify_graph &&
+      interpreter.EnableGraphSimplification() != kTfLiteOk) {
+    result.error = "EnableGraphSimplification() failed";
+    return;
+  }
+  if (interpreter.SetNumThreads(num_threads) != kTfLiteOk) {
+    result.error = "SetNumThreads() failed";
+    return;
+  }
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    result.error = "AllocateTensors() failed";
+    return;
+  }
+  result.arena_used_bytes = interpreter.arena_used_bytes();
+  result.operators_size = interpreter.operators_size();
+  result.removed_operators_size = interpreter.removed_operators_size();
+
+  std::vector<uint8_t> frames;
+  if (spec.hop > 0) {
+    const TfLiteTensor* input = interpreter.input(0);
+    frames.resize(input->bytes / input->dims->data[1] * spec.hop);
+  } else {
+    for (size_t i = 0; i < interpreter.inputs_size(); ++i) {
+      TfLiteTensor* input = interpreter.input(i);
+      FillRandom(input->data.raw, input->bytes);
+    }
+  }
+
+  // The first invocation is a warm-up and, when streaming, fills the caches
+  // of the whole window.
+  for (int i = 0; i <= current_iterations; ++i) {
+    if (i == 1) {
+      op_profiler.Reset();
+    }
+    TfLiteStatus status;
+    const uint32_t start = tflite::GetCurrentTimeTicks();
+    if (spec.hop > 0) {
+      FillRandom(frames.data(), frames.size());
+      status = interpreter.InvokeStreaming(frames.data(), frames.size());
+    } else {
+      status = interpreter.Invoke();
+    }
+    if (i > 0) {
+      result.invoke_ticks += TicksSince(start);
+    }
+    if (status != kTfLiteOk) {
+      result.error = "Invoke() failed";
+      return;
+    }
+  }
+}
+
+// Runs RunModel() on a painted stack of its own and measures how much of it
+// was touched.
+void BenchmarkModel(const ModelSpec& spec, int iterations) {
+  current_model = &spec;
+  current_iterations = iterations;
+  memset(&current_result, 0, sizeof(current_result));
+  op_profiler.Reset();
+
+  memset(benchmark_stack, kStackPaint, kStackSize);
+  getcontext(&benchmark_context);
+  benchmark_context.uc_stack.ss_sp = benchmark_stack;
+  benchmark_context.uc_stack.ss_size = kStackSize;
+  benchmark_context.uc_link = &main_context;
+  makecontext(&benchmark_context, RunModel, 0);
+  swapcontext(&main_context, &benchmark_context);
+
+  // The stack grows down from the end of the buffer.
+  size_t untouched = 0;
+  while (untouched < kStackSize && benchmark_stack[untouched] == kStackPaint) {
+    ++untouched;
+  }
+  current_result.peak_stack_bytes = kStackSize - untouched;
+}
+
+double TicksToMicroseconds(int64_t ticks) {
+  const int32_t tps = tflite::ticks_per_second();
+  return tps > 0 ? ticks * 1e6 / tps : 0.0;
+}
+
+void PrintResult(const ModelSpec& spec, int iterations,
+                 const BenchmarkResult& result, bool last) {
+  printf("    {\n");
+  printf("      \"name\": \"%s\",\n", spec.name);
+  printf("      \"mode\": \"%s\",\n", ModeName(spec));
+  if (result.error != nullptr) {
+    printf("      \"error\": \"%s\"\n", result.error);
+    printf("    }%s\n", last ? "" : ",");
+    return;
+  }
+  const double invoke_us = TicksToMicroseconds(result.invoke_ticks);
+  printf("      \"iterations\": %d,\n", iterations);
+  printf("      \"invocations_per_second\": %.3f,\n",
+         invoke_us > 0 ? iterations * 1e6 / invoke_us : 0.0);
+  printf("      \"mean_invoke_us\": %.1f,\n", invoke_us / iterations);
+  printf("      \"arena_used_bytes\": %zu,\n", result.arena_used_bytes);
+  printf("      \"peak_stack_bytes\": %zu,\n", result.peak_stack_bytes);
+  printf("      \"removed_ops\": %zu,\n", result.removed_operators_size);
+  printf("      \"ops\": [");
+  const int ops = static_cast<int>(result.operators_size) < kMaxOps
+                      ? static_cast<int>(result.operators_size)
+                      : kMaxOps;
+  for (int i = 0; i < ops; ++i) {
+    const char* tag = op_profiler.tag(i);
+    const int count = op_profiler.count(i);
+    const double total_us = TicksToMicroseconds(op_profiler.ticks(i));
+    printf("%s\n        {\"index\": %d, \"op\": \"%s\", \"mean_us\": %.1f, "
+           "\"total_us\": %.1f}",
+           i == 0 ? "" : ",", i, tag != nullptr ? tag : "",
+           count > 0 ? total_us / count : 0.0, total_us);
+  }
+  printf("\n      ]\n");
+  printf("    }%s\n", last ? "" : ",");
+}
+
+bool IsSelected(const char* name, int argc, char** argv) {
+  if (argc <= 2) {
+    return true;
+  }
+  for (int i = 2; i < argc; ++i) {
+    if (strcmp(argv[i], name) == 0) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int iterations = argc > 1 ? atoi(argv[1]) : kDefaultIterations;
+  if (iterations <= 0) {
+    fprintf(stderr, "usage: %s [iterations] [model_name...]\n", argv[0]);
+    return 1;
+  }
+  if (const char* threads = getenv("TFLM_NUM_THREADS")) {
+    num_threads = atoi(threads);
+  }
+
+  const int model_count = sizeof(kModels) / sizeof(kModels[0]);
+  std::vector<const ModelSpec*> selected;
+  for (int i = 0; i < model_count; ++i) {
+    if (IsSelected(kModels[i].name, argc, argv)) {
+      selected.push_back(&kModels[i]);
+    }
+  }
+
+  bool ok = true;
+  printf("{\n");
+  printf("  \"ticks_per_second\": %d,\n",
+         static_cast<int>(tflite::ticks_per_second()));
+  printf("  \"num_threads\": %d,\n", num_threads);
+  printf("  \"models\": [\n");
+  for (size_t i = 0; i < selected.size(); ++i) {
+    BenchmarkModel(*selected[i], iterations);
+    ok &= current_result.error == nullptr;
+    PrintResult(*selected[i], iterations, current_result,
+                i + 1 == selected.size());
+  }
+  printf("  ]\n");
+  printf("}\n");
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Writes one of the models in app/lib_src back into a .tflite file.
+//
+// Usage: model_writer <model_name> <output.tflite>
+//
+// The demos only keep their models as C arrays. The converters in
+// micro/tools read .tflite files, so their checks in CMakeLists.txt run on
+// the files this writes.
+
+#include <cstdio>
+#include <cstring>
+
+#include "cifar10_demo/cifar10_model_data.h"
+#include "emergency_detect/emergency-detect.h"
+#include "mnist_demo/mnist_demo_model.h"
+#include "person_detection_demo/person_detect_model_data.h"
+#include "simple_example/mnist_model.h"
+
+namespace {
+
+struct ModelSpec {
+  const char* name;
+  const unsigned char* model_data;
+  const unsigned int* model_size;
+};
+
+const ModelSpec kModels[] = {
+    {"emergency_detect", output_emergency_detect_tflite,
+     &output_emergency_detect_tflite_len},
+    {"person_detection_demo", person_detect_model_data,
+     &person_detect_model_data_len},
+    {"cifar10_demo", cifar10_model_tflite, &cifar10_model_tflite_len},
+    {"mnist_demo", mnist_dense_model_tflite, &mnist_dense_model_tflite_len},
+    {"simple_example", mnist_model_tflite, &mnist_model_tflite_len},
+};
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  if (argc != 3) {
+    fprintf(stderr, "usage: %s <model_name> <output.tflite>\n", argv[0]);
+    return 1;
+  }
+
+  const ModelSpec* spec = nullptr;
+  for (const ModelSpec& model : kModels) {
+    if (strcmp(model.name, argv[1]) == 0) {
+      spec = &model;
+    }
+  }
+  if (spec == nullptr) {
+    fprintf(stderr, "Unknown model %s\n", argv[1]);
+    return 1;
+  }
+
+  FILE* file = fopen(argv[2], "wb");
+  if (file == nullptr) {
+    fprintf(stderr, "Cannot write %s\n", argv[2]);
+    return 1;
+  }
+  const bool ok =
+      fwrite(spec->model_data, 1, *spec->model_size, file) ==
+      *spec->model_size;
+  if (fclose(file) != 0 || !ok) {
+    fprintf(stderr, "Cannot write %s\n", argv[2]);
+    return 1;
+  }
+  return 0;
+}
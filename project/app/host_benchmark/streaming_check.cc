@@ -0,0 +1,139 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Checks InvokeStreaming() against Invoke() on the streaming demo models.
+//
+// Usage: streaming_check [hop...]
+//
+// For every hop (by default the demo's, and the smallest one the model
+// streams all layers with) random frames are pushed into a streaming
+// interpreter until the window has been replaced a few times over. After
+// every push a second interpreter runs Invoke() on the same window, with the
+// frames that were never pushed set to zero, and its outputs must match
+// bit for bit. The process exits non-zero on the first mismatch.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#include "emergency_detect/emergency-detect.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+constexpr size_t kArenaSize = 1024 * 1024;
+
+alignas(16) uint8_t invoke_arena[kArenaSize];
+alignas(16) uint8_t streaming_arena[kArenaSize];
+
+// Random samples in the range of the int16 audio the demo converts.
+void FillFrames(TfLiteType type, uint8_t* data, size_t bytes) {
+  if (type == kTfLiteFloat32) {
+    float* samples = reinterpret_cast<float*>(data);
+    for (size_t i = 0; i < bytes / sizeof(float); ++i) {
+      samples[i] = static_cast<int16_t>(rand());
+    }
+    return;
+  }
+  for (size_t i = 0; i < bytes; ++i) {
+    data[i] = static_cast<uint8_t>(rand());
+  }
+}
+
+bool CheckModel(const char* name, const unsigned char* model_data, int hop,
+                tflite::ErrorReporter* error_reporter) {
+  const tflite::Model* model = tflite::GetModel(model_data);
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    fprintf(stderr, "%s: unsupported schema version\n", name);
+    return false;
+  }
+  tflite::AllOpsResolver resolver;
+  tflite::MicroInterpreter invoke_interpreter(
+      model, resolver, invoke_arena, kArenaSize, error_reporter);
+  tflite::MicroInterpreter streaming_interpreter(
+      model, resolver, streaming_arena, kArenaSize, error_reporter);
+  if (streaming_interpreter.EnableStreaming(hop) != kTfLiteOk ||
+      invoke_interpreter.AllocateTensors() != kTfLiteOk ||
+      streaming_interpreter.AllocateTensors() != kTfLiteOk) {
+    fprintf(stderr, "%s: allocation with hop %d failed\n", name, hop);
+    return false;
+  }
+
+  TfLiteTensor* input = invoke_interpreter.input(0);
+  const int window_frames = input->dims->data[1];
+  const size_t frame_bytes = input->bytes / window_frames;
+  std::vector<uint8_t> window(input->bytes, 0);
+  std::vector<uint8_t> frames(hop * frame_bytes);
+  const int pushes = window_frames / hop + 3;
+  for (int push = 1; push <= pushes; ++push) {
+    FillFrames(input->type, frames.data(), frames.size());
+    memmove(window.data(), window.data() + frames.size(),
+            window.size() - frames.size());
+    memcpy(window.data() + window.size() - frames.size(), frames.data(),
+           frames.size());
+    memcpy(input->data.raw, window.data(), window.size());
+    if (streaming_interpreter.InvokeStreaming(frames.data(), frames.size()) !=
+            kTfLiteOk ||
+        invoke_interpreter.Invoke() != kTfLiteOk) {
+      fprintf(stderr, "%s: invocation %d with hop %d failed\n", name, push,
+              hop);
+      return false;
+    }
+    for (size_t i = 0; i < invoke_interpreter.outputs_size(); ++i) {
+      const TfLiteTensor* expected = invoke_interpreter.output(i);
+      const TfLiteTensor* actual = streaming_interpreter.output(i);
+      if (expected->bytes != actual->bytes ||
+          memcmp(expected->data.raw, actual->data.raw, expected->bytes) !=
+              0) {
+        fprintf(stderr, "%s: output %d differs after %d pushes of %d frames\n",
+                name, static_cast<int>(i), push, hop);
+        return false;
+      }
+    }
+  }
+  printf("%s: %d pushes of %d frames match Invoke(), arena %d bytes\n", name,
+         pushes, hop,
+         static_cast<int>(streaming_interpreter.arena_used_bytes()));
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  std::vector<int> hops;
+  for (int i = 1; i < argc; ++i) {
+    hops.push_back(atoi(argv[i]));
+  }
+  if (hops.empty()) {
+    // The demo's hop, and the total time stride of the model.
+    hops.push_back(1024);
+    hops.push_back(128);
+  }
+  srand(1);
+  for (int hop : hops) {
+    if (!CheckModel("emergency_detect", output_emergency_detect_tflite, hop,
+                    &micro_error_reporter)) {
+      return 1;
+    }
+  }
+  return 0;
+}
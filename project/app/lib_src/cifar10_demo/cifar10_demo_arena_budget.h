@@ -0,0 +1,18 @@
+// Generated by arena_budget from cifar10_demo/cifar10_model_data.cc. Do not edit.
+
+#ifndef CIFAR10_DEMO_ARENA_BUDGET_H_
+#define CIFAR10_DEMO_ARENA_BUDGET_H_
+
+namespace cifar10_demo {
+
+// Smallest tensor arena, in bytes, that the model allocates and runs in on
+// the 32-bit device.
+constexpr int kArenaMinSize = 46831;
+
+// Bytes of the TfLiteTensors that MICRO_RUNTIME builds keep, which their
+// arena needs on top of kArenaMinSize.
+constexpr int kKeptTensorsSize = 2208;
+
+}  // namespace cifar10_demo
+
+#endif  // CIFAR10_DEMO_ARENA_BUDGET_H_
@@ -13,13 +13,16 @@ See the License for the specific language governing permissions and
 limitations under the License.
 ==============================================================================*/
 
-#include "tensorflow/lite/micro/kernels/micro_ops.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include <cstdint>
+#include <cstring>
+
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/version.h"
 
+#include "cifar10_demo_arena_budget.h"
+#include "cifar10_demo_op_resolver.h"
 #include "cifar10_model_data.h"
 #include "main_functions.h"
 
@@ -27,8 +30,20 @@ limitations under the License.
 extern "C" void *__dso_handle __attribute__((weak));
 #endif
 
-const int tensor_arena_size = 45 * 1024;
+const int tensor_arena_size = 48 * 1024;
 uint8_t tensor_arena[tensor_arena_size] __attribute__((aligned(32)));
+#ifdef MICRO_RUNTIME
+// The NeuroPilot runtime keeps the TfLiteTensors of the model in the arena.
+static_assert(tensor_arena_size >=
+                  cifar10_demo::kArenaMinSize +
+                      cifar10_demo::kKeptTensorsSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see cifar10_demo_arena_budget.h");
+#else
+static_assert(tensor_arena_size >= cifar10_demo::kArenaMinSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see cifar10_demo_arena_budget.h");
+#endif
 
 tflite::ErrorReporter* error_reporter = nullptr;
 const tflite::Model* model = nullptr;
@@ -37,6 +52,9 @@ TfLiteTensor* model_input = nullptr;
 TfLiteTensor* model_output = nullptr;
 
 const int inputTensorSize = 32 * 32 * 3;
+// Input images that are not 16 byte aligned are copied here, the others are
+// used in place (see MicroInterpreter::SetInputBuffer()).
+uint8_t cifar10_input[inputTensorSize] __attribute__((aligned(16)));
 
 extern "C" int cifar10_setup()
 {
@@ -54,24 +72,15 @@ extern "C" int cifar10_setup()
 	error_reporter->Report("GetModel %s done, size %d bytes.\r\n",
 			get_model_file_name(), cifar10_model_tflite_len);
 
-	static tflite::MicroMutableOpResolver<4> resolver;
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
-		tflite::ops::micro::Register_DEPTHWISE_CONV_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_CONV_2D,
-		tflite::ops::micro::Register_CONV_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_FULLY_CONNECTED,
-		tflite::ops::micro::Register_FULLY_CONNECTED());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_MAX_POOL_2D,
-		tflite::ops::micro::Register_MAX_POOL_2D());
+	static cifar10_demo::OpResolver resolver;
 
 	static tflite::MicroInterpreter static_interpreter(model, resolver,
 		tensor_arena, tensor_arena_size, error_reporter);
 	interpreter = &static_interpreter;
 
+	// Keeps the input out of the arena.
+	interpreter->SetInputBuffer(0, cifar10_input, inputTensorSize);
+
 	TfLiteStatus allocate_status = interpreter->AllocateTensors();
 	if (allocate_status != kTfLiteOk) {
 		error_reporter->Report("AllocateTensors() failed.\r\n");
@@ -91,9 +100,13 @@ extern "C" int cifar10_invoke(const uint8_t *input)
 				       "Deer", "Dog", "Frog", "Horse",
 				       "Ship", "Truck" };
 
-	for (int i = 0; i < inputTensorSize; i++) {
-		model_input->data.uint8[i] = input[i];
+	// The model only reads its input.
+	uint8_t* image = const_cast<uint8_t*>(input);
+	if (reinterpret_cast<uintptr_t>(image) % 16 != 0) {
+		memcpy(cifar10_input, input, inputTensorSize);
+		image = cifar10_input;
 	}
+	interpreter->SetInputBuffer(0, image, inputTensorSize);
 
 	TfLiteStatus invoke_status = interpreter->Invoke();
 	if (invoke_status != kTfLiteOk) {
@@ -0,0 +1,18 @@
+// Generated by arena_budget from emergency_detect/emergency-detect.cc (hop 1024). Do not edit.
+
+#ifndef EMERGENCY_DETECT_ARENA_BUDGET_H_
+#define EMERGENCY_DETECT_ARENA_BUDGET_H_
+
+namespace emergency_detect {
+
+// Smallest tensor arena, in bytes, that the model allocates and runs in on
+// the 32-bit device.
+constexpr int kArenaMinSize = 50455;
+
+// Bytes of the TfLiteTensors that MICRO_RUNTIME builds keep, which their
+// arena needs on top of kArenaMinSize.
+constexpr int kKeptTensorsSize = 3264;
+
+}  // namespace emergency_detect
+
+#endif  // EMERGENCY_DETECT_ARENA_BUDGET_H_
@@ -0,0 +1,68 @@
+// Generated by op_resolver_generator from emergency_detect/emergency-detect.cc. Do not edit.
+
+#ifndef EMERGENCY_DETECT_OP_RESOLVER_H_
+#define EMERGENCY_DETECT_OP_RESOLVER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/micro_static_op_resolver.h"
+
+namespace emergency_detect {
+
+constexpr tflite::MicroStaticOp kOps[] = {
+    {tflite::BuiltinOperator_AVERAGE_POOL_2D,
+     tflite::ops::micro::Register_AVERAGE_POOL_2D,
+     tflite::ParseOpData},
+    {tflite::BuiltinOperator_CONV_2D,
+     tflite::ops::micro::Register_CONV_2D,
+     tflite::ParseConv2D},
+    {tflite::BuiltinOperator_FULLY_CONNECTED,
+     tflite::ops::micro::Register_FULLY_CONNECTED,
+     tflite::ParseFullyConnected},
+    {tflite::BuiltinOperator_MAX_POOL_2D,
+     tflite::ops::micro::Register_MAX_POOL_2D,
+     tflite::ParseOpData},
+    {tflite::BuiltinOperator_RESHAPE,
+     tflite::ops::micro::Register_RESHAPE,
+     tflite::ParseReshape},
+    {tflite::BuiltinOperator_SOFTMAX,
+     tflite::ops::micro::Register_SOFTMAX,
+     tflite::ParseSoftmax},
+    {tflite::BuiltinOperator_SUB,
+     tflite::ops::micro::Register_SUB,
+     tflite::ParseOpData},
+    {tflite::BuiltinOperator_DIV,
+     tflite::ops::micro::Register_DIV,
+     tflite::ParseOpData},
+    {tflite::BuiltinOperator_EXPAND_DIMS,
+     tflite::ops::micro::Register_EXPAND_DIMS,
+     tflite::ParseOpData},
+};
+
+// Index into kOps of every tflite::BuiltinOperator, -1 for the ops that
+// are not used.
+constexpr int8_t kOpSlots[tflite::kMicroStaticOpSlots] = {
+    -1, 0, -1, 1, -1, -1, -1, -1, -1, 2, -1, -1, -1, -1, -1, -1,  // 0
+    -1, 3, -1, -1, -1, -1, 4, -1, -1, 5, -1, -1, -1, -1, -1, -1,  // 16
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, 6, 7, -1, -1, -1, -1, -1,  // 32
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 48
+    -1, -1, -1, -1, -1, -1, 8, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 64
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 80
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 96
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 112
+};
+
+class OpResolver : public tflite::MicroStaticOpResolver<9> {
+ public:
+  OpResolver() : MicroStaticOpResolver(kOps, kOpSlots) {}
+
+ private:
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace emergency_detect
+
+#endif  // EMERGENCY_DETECT_OP_RESOLVER_H_
@@ -1,8 +1,7 @@
 #include "emergency-detect.h"
 
-#include "tensorflow/lite/micro/all_ops_resolver.h"
-#include "tensorflow/lite/micro/kernels/micro_ops.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "emergency_detect_arena_budget.h"
+#include "emergency_detect_op_resolver.h"
 
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
@@ -13,8 +12,20 @@
 extern "C" void *__dso_handle __attribute__((weak));
 #endif
 
-const int tensor_arena_size = 73 * 1024;
+const int tensor_arena_size = 53 * 1024;
 uint8_t tensor_arena[tensor_arena_size];
+#ifdef MICRO_RUNTIME
+// The NeuroPilot runtime keeps the TfLiteTensors of the model in the arena.
+static_assert(tensor_arena_size >=
+                  emergency_detect::kArenaMinSize +
+                      emergency_detect::kKeptTensorsSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see emergency_detect_arena_budget.h");
+#else
+static_assert(tensor_arena_size >= emergency_detect::kArenaMinSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see emergency_detect_arena_budget.h");
+#endif
 
 tflite::ErrorReporter *error_reporter = nullptr;
 const tflite::Model *model = nullptr;
@@ -23,10 +34,14 @@ tflite::MicroInterpreter *interpreter = nullptr;
 TfLiteTensor *model_input = nullptr;
 TfLiteTensor *model_output = nullptr;
 
-const int emergency_detect_input_size = 22050;
+// New samples per streaming inference. Must be a multiple of the total time
+// stride of the model (128) for every conv/pool layer to run incrementally.
+const int emergency_detect_hop_size = 1024;
 const char *emergency_detect_classes[] = { "NO BREATH", "BREATH", "CAUGH", "SPEAK" };
 
 extern "C" void emergency_detect_setup() {
+  if (interpreter != nullptr) return;
+
   static tflite::MicroErrorReporter micro_error_reporter;
   error_reporter = &micro_error_reporter;
 
@@ -40,40 +55,82 @@ extern "C" void emergency_detect_setup() {
   }
   error_reporter->Report("GetModel done, size %d bytes.\r\n", output_emergency_detect_tflite_len);
 
-  static tflite::AllOpsResolver resolver;
-                      
+  static emergency_detect::OpResolver resolver;
+
   static tflite::MicroInterpreter static_interpreter(model, resolver, tensor_arena,
                                                      tensor_arena_size, error_reporter);
-  interpreter = &static_interpreter;
 
-  TfLiteStatus allocate_status = interpreter->AllocateTensors();
+  if (static_interpreter.EnableStreaming(emergency_detect_hop_size) !=
+      kTfLiteOk) {
+    error_reporter->Report("EnableStreaming() failed.\r\n");
+    return;
+  }
+
+  TfLiteStatus allocate_status = static_interpreter.AllocateTensors();
   if (allocate_status != kTfLiteOk) {
     error_reporter->Report("AllocateTensors() failed.\r\n");
     return;
   }
+  interpreter = &static_interpreter;
 
   model_input = interpreter->input(0);
   model_output = interpreter->output(0);
 }
 
-extern "C" int emergency_detect_loop(int16_t *input_buf) {
-  for (int i = 0; i < emergency_detect_input_size; ++i) {
-    model_input->data.i16[i] = input_buf[i];
+static int emergency_detect_result() {
+  if (model_output->type != kTfLiteFloat32) {
+    error_reporter->Report("Unsupported output type %d.", model_output->type);
+    return -1;
+  }
+  float max_score = model_output->data.f[0];
+  int max_score_index = 0;
+  for (int i = 0; i < 4; ++i) {
+    const float score = model_output->data.f[i];
+    // In percent, the micro error reporter prints floats as mantissa and
+    // exponent.
+    error_reporter->Report("%s score: %d", emergency_detect_classes[i],
+                           static_cast<int>(score * 100));
+
+    if (score > max_score) {
+      max_score = score;
+      max_score_index = i;
+    }
   }
 
-  if (kTfLiteOk != interpreter->Invoke()) {
-    error_reporter->Report("Invoke failed.");
+  return max_score_index;
+}
+
+// Slides the model window by emergency_detect_hop_size samples. Only the
+// activations that depend on the new samples are recomputed.
+// Returns the class of the window, or -1 on failure.
+extern "C" int emergency_detect_stream(int16_t *hop_buf) {
+  if (interpreter == nullptr) {
     return -1;
   }
 
-  uint8_t max_score = 0;
-  int max_score_index = 0;
-  for (int i = 0; i < 4; ++i) {
-    uint8_t score = model_output->data.uint8[i];
-    error_reporter->Report("%s score: %d", emergency_detect_classes[i], score);
+  // The samples in the input tensor's type.
+  static float hop_frames[emergency_detect_hop_size];
+  size_t frames_bytes = 0;
+  if (model_input->type == kTfLiteFloat32) {
+    for (int i = 0; i < emergency_detect_hop_size; ++i) {
+      hop_frames[i] = hop_buf[i];
+    }
+    frames_bytes = emergency_detect_hop_size * sizeof(float);
+  } else if (model_input->type == kTfLiteInt16) {
+    int16_t *samples = reinterpret_cast<int16_t *>(hop_frames);
+    for (int i = 0; i < emergency_detect_hop_size; ++i) {
+      samples[i] = hop_buf[i];
+    }
+    frames_bytes = emergency_detect_hop_size * sizeof(int16_t);
+  } else {
+    error_reporter->Report("Unsupported input type %d.", model_input->type);
+    return -1;
+  }
 
-    if (score > max_score) max_score_index = i;
+  if (kTfLiteOk != interpreter->InvokeStreaming(hop_frames, frames_bytes)) {
+    error_reporter->Report("InvokeStreaming failed.");
+    return -1;
   }
 
-  return max_score_index;
+  return emergency_detect_result();
 }
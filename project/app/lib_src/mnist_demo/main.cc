@@ -15,8 +15,8 @@ limitations under the License.
 
 #include "mnist_demo_model.h"
 
-#include "tensorflow/lite/micro/kernels/micro_ops.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include "mnist_demo_arena_budget.h"
+#include "mnist_demo_op_resolver.h"
 
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
@@ -30,6 +30,18 @@ extern "C" void *__dso_handle __attribute__((weak));
 
 const int tensor_arena_size = 22 * 1024;
 uint8_t tensor_arena[tensor_arena_size] __attribute__((aligned(32)));
+#ifdef MICRO_RUNTIME
+// The NeuroPilot runtime keeps the TfLiteTensors of the model in the arena.
+static_assert(tensor_arena_size >=
+                  mnist_demo::kArenaMinSize +
+                      mnist_demo::kKeptTensorsSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see mnist_demo_arena_budget.h");
+#else
+static_assert(tensor_arena_size >= mnist_demo::kArenaMinSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see mnist_demo_arena_budget.h");
+#endif
 
 
 tflite::ErrorReporter* error_reporter = nullptr;
@@ -56,28 +68,7 @@ extern "C" void mnist_setup()
 	error_reporter->Report("GetModel done, size %d bytes.\r\n",
 		mnist_dense_model_tflite_len );
 
-	static tflite::MicroMutableOpResolver<7> resolver;
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
-		tflite::ops::micro::Register_DEPTHWISE_CONV_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_CONV_2D,
-		tflite::ops::micro::Register_CONV_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_FULLY_CONNECTED,
-		tflite::ops::micro::Register_FULLY_CONNECTED());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_AVERAGE_POOL_2D,
-		tflite::ops::micro::Register_AVERAGE_POOL_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_SOFTMAX,
-		tflite::ops::micro::Register_SOFTMAX());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_QUANTIZE,
-		tflite::ops::micro::Register_QUANTIZE());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_DEQUANTIZE,
-		tflite::ops::micro::Register_DEQUANTIZE());
+	static mnist_demo::OpResolver resolver;
 
 	static tflite::MicroInterpreter static_interpreter(model, resolver,
 		tensor_arena, tensor_arena_size, error_reporter);
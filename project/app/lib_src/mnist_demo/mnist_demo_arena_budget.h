@@ -0,0 +1,18 @@
+// Generated by arena_budget from mnist_demo/mnist_demo_model.cc. Do not edit.
+
+#ifndef MNIST_DEMO_ARENA_BUDGET_H_
+#define MNIST_DEMO_ARENA_BUDGET_H_
+
+namespace mnist_demo {
+
+// Smallest tensor arena, in bytes, that the model allocates and runs in on
+// the 32-bit device.
+constexpr int kArenaMinSize = 19403;
+
+// Bytes of the TfLiteTensors that MICRO_RUNTIME builds keep, which their
+// arena needs on top of kArenaMinSize.
+constexpr int kKeptTensorsSize = 2856;
+
+}  // namespace mnist_demo
+
+#endif  // MNIST_DEMO_ARENA_BUDGET_H_
@@ -0,0 +1,62 @@
+// Generated by op_resolver_generator from mnist_demo/mnist_demo_model.cc. Do not edit.
+
+#ifndef MNIST_DEMO_OP_RESOLVER_H_
+#define MNIST_DEMO_OP_RESOLVER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/micro_static_op_resolver.h"
+
+namespace mnist_demo {
+
+constexpr tflite::MicroStaticOp kOps[] = {
+    {tflite::BuiltinOperator_AVERAGE_POOL_2D,
+     tflite::ops::micro::Register_AVERAGE_POOL_2D,
+     tflite::ParseOpData},
+    {tflite::BuiltinOperator_CONV_2D,
+     tflite::ops::micro::Register_CONV_2D,
+     tflite::ParseConv2D},
+    {tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
+     tflite::ops::micro::Register_DEPTHWISE_CONV_2D,
+     tflite::ParseDepthwiseConv2D},
+    {tflite::BuiltinOperator_DEQUANTIZE,
+     tflite::ops::micro::Register_DEQUANTIZE,
+     tflite::ParseDequantize},
+    {tflite::BuiltinOperator_FULLY_CONNECTED,
+     tflite::ops::micro::Register_FULLY_CONNECTED,
+     tflite::ParseFullyConnected},
+    {tflite::BuiltinOperator_SOFTMAX,
+     tflite::ops::micro::Register_SOFTMAX,
+     tflite::ParseSoftmax},
+    {tflite::BuiltinOperator_QUANTIZE,
+     tflite::ops::micro::Register_QUANTIZE,
+     tflite::ParseQuantize},
+};
+
+// Index into kOps of every tflite::BuiltinOperator, -1 for the ops that
+// are not used.
+constexpr int8_t kOpSlots[tflite::kMicroStaticOpSlots] = {
+    -1, 0, -1, 1, 2, -1, 3, -1, -1, 4, -1, -1, -1, -1, -1, -1,  // 0
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, 5, -1, -1, -1, -1, -1, -1,  // 16
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 32
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 48
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 64
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 80
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 96
+    -1, -1, 6, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 112
+};
+
+class OpResolver : public tflite::MicroStaticOpResolver<7> {
+ public:
+  OpResolver() : MicroStaticOpResolver(kOps, kOpSlots) {}
+
+ private:
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace mnist_demo
+
+#endif  // MNIST_DEMO_OP_RESOLVER_H_
@@ -15,8 +15,11 @@ limitations under the License.
 
 #include "person_detect_model_data.h"
 
-#include "tensorflow/lite/micro/kernels/micro_ops.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
+#include <cstdint>
+#include <cstring>
+
+#include "person_detection_demo_arena_budget.h"
+#include "person_detection_demo_op_resolver.h"
 
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
@@ -27,8 +30,20 @@ limitations under the License.
 extern "C" void *__dso_handle __attribute__((weak));
 #endif
 
-const int tensor_arena_size = 73 * 1024;
+const int tensor_arena_size = 90 * 1024;
 uint8_t tensor_arena[tensor_arena_size] __attribute__((aligned(32)));
+#ifdef MICRO_RUNTIME
+// The NeuroPilot runtime keeps the TfLiteTensors of the model in the arena.
+static_assert(tensor_arena_size >=
+                  person_detection_demo::kArenaMinSize +
+                      person_detection_demo::kKeptTensorsSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see person_detection_demo_arena_budget.h");
+#else
+static_assert(tensor_arena_size >= person_detection_demo::kArenaMinSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see person_detection_demo_arena_budget.h");
+#endif
 
 tflite::ErrorReporter *error_reporter = nullptr;
 const tflite::Model *model = nullptr;
@@ -38,6 +53,9 @@ TfLiteTensor *model_input = nullptr;
 TfLiteTensor *model_output = nullptr;
 
 const int inputPersonTensorSize = 96 * 96;
+// Input frames that are not 16 byte aligned are copied here, the others are
+// used in place (see MicroInterpreter::SetInputBuffer()).
+uint8_t person_input[inputPersonTensorSize] __attribute__((aligned(16)));
 
 extern "C" void person_detection_setup() {
   static tflite::MicroErrorReporter micro_error_reporter;
@@ -53,19 +71,15 @@ extern "C" void person_detection_setup() {
   }
   error_reporter->Report("GetModel done, size %d bytes.\r\n", person_detect_model_data_len);
 
-  static tflite::MicroMutableOpResolver<3> resolver;
-  resolver.AddBuiltin(
-      tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
-      tflite::ops::micro::Register_DEPTHWISE_CONV_2D());
-  resolver.AddBuiltin(tflite::BuiltinOperator_CONV_2D,
-                      tflite::ops::micro::Register_CONV_2D());
-  resolver.AddBuiltin(tflite::BuiltinOperator_AVERAGE_POOL_2D,
-                      tflite::ops::micro::Register_AVERAGE_POOL_2D());
+  static person_detection_demo::OpResolver resolver;
 
   static tflite::MicroInterpreter static_interpreter(model, resolver, tensor_arena,
                                                      tensor_arena_size, error_reporter);
   interpreter = &static_interpreter;
 
+  // Keeps the input out of the arena.
+  interpreter->SetInputBuffer(0, person_input, inputPersonTensorSize);
+
   TfLiteStatus allocate_status = interpreter->AllocateTensors();
   if (allocate_status != kTfLiteOk) {
     error_reporter->Report("AllocateTensors() failed.\r\n");
@@ -78,9 +92,12 @@ extern "C" void person_detection_setup() {
 
 // 1: has person, 2: no person
 extern "C" int person_detection_loop(uint8_t *input_buf) {
-  for (int i = 0; i < inputPersonTensorSize; ++i) {
-    model_input->data.uint8[i] = input_buf[i];
+  uint8_t *frame = input_buf;
+  if (reinterpret_cast<uintptr_t>(frame) % 16 != 0) {
+    memcpy(person_input, input_buf, inputPersonTensorSize);
+    frame = person_input;
   }
+  interpreter->SetInputBuffer(0, frame, inputPersonTensorSize);
 
   if (kTfLiteOk != interpreter->Invoke()) {
     error_reporter->Report("Invoke failed.");
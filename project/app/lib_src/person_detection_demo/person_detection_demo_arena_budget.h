@@ -0,0 +1,18 @@
+// Generated by arena_budget from person_detection_demo/person_detect_model_data.cc. Do not edit.
+
+#ifndef PERSON_DETECTION_DEMO_ARENA_BUDGET_H_
+#define PERSON_DETECTION_DEMO_ARENA_BUDGET_H_
+
+namespace person_detection_demo {
+
+// Smallest tensor arena, in bytes, that the model allocates and runs in on
+// the 32-bit device.
+constexpr int kArenaMinSize = 84243;
+
+// Bytes of the TfLiteTensors that MICRO_RUNTIME builds keep, which their
+// arena needs on top of kArenaMinSize.
+constexpr int kKeptTensorsSize = 7912;
+
+}  // namespace person_detection_demo
+
+#endif  // PERSON_DETECTION_DEMO_ARENA_BUDGET_H_
@@ -0,0 +1,50 @@
+// Generated by op_resolver_generator from person_detection_demo/person_detect_model_data.cc. Do not edit.
+
+#ifndef PERSON_DETECTION_DEMO_OP_RESOLVER_H_
+#define PERSON_DETECTION_DEMO_OP_RESOLVER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/micro_static_op_resolver.h"
+
+namespace person_detection_demo {
+
+constexpr tflite::MicroStaticOp kOps[] = {
+    {tflite::BuiltinOperator_AVERAGE_POOL_2D,
+     tflite::ops::micro::Register_AVERAGE_POOL_2D,
+     tflite::ParseOpData},
+    {tflite::BuiltinOperator_CONV_2D,
+     tflite::ops::micro::Register_CONV_2D,
+     tflite::ParseConv2D},
+    {tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
+     tflite::ops::micro::Register_DEPTHWISE_CONV_2D,
+     tflite::ParseDepthwiseConv2D},
+};
+
+// Index into kOps of every tflite::BuiltinOperator, -1 for the ops that
+// are not used.
+constexpr int8_t kOpSlots[tflite::kMicroStaticOpSlots] = {
+    -1, 0, -1, 1, 2, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 0
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 16
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 32
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 48
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 64
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 80
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 96
+    -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,  // 112
+};
+
+class OpResolver : public tflite::MicroStaticOpResolver<3> {
+ public:
+  OpResolver() : MicroStaticOpResolver(kOps, kOpSlots) {}
+
+ private:
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace person_detection_demo
+
+#endif  // PERSON_DETECTION_DEMO_OP_RESOLVER_H_
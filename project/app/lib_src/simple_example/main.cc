@@ -15,9 +15,8 @@ limitations under the License.
 
 #include "mnist_model.h"
 
-#include "tensorflow/lite/micro/kernels/micro_ops.h"
-#include "tensorflow/lite/micro/micro_mutable_op_resolver.h"
-#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "simple_example_arena_budget.h"
+#include "simple_example_op_resolver.h"
 
 #include "tensorflow/lite/micro/micro_error_reporter.h"
 #include "tensorflow/lite/micro/micro_interpreter.h"
@@ -32,6 +31,18 @@ namespace simple_mnist {
 // Prepare tensor arena
 const int tensor_arena_size = 22 * 1024;
 uint8_t tensor_arena[tensor_arena_size] __attribute__((aligned(32)));
+#ifdef MICRO_RUNTIME
+// The NeuroPilot runtime keeps the TfLiteTensors of the model in the arena.
+static_assert(tensor_arena_size >=
+                  simple_example::kArenaMinSize +
+                      simple_example::kKeptTensorsSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see simple_example_arena_budget.h");
+#else
+static_assert(tensor_arena_size >= simple_example::kArenaMinSize,
+              "tensor_arena_size is below the arena budget of the model, "
+              "see simple_example_arena_budget.h");
+#endif
 
 tflite::ErrorReporter* error_reporter = nullptr;
 const tflite::Model* model = nullptr;
@@ -70,33 +81,7 @@ void model_setup(void)
 	TF_LITE_REPORT_ERROR(error_reporter,
 		"GetModel done, size %d bytes.\r\n", mnist_model_tflite_len );
 
-#ifdef LINUX_DEBUG
-	// Only use AllOpsResolver when testing on Linux x86
-	static tflite::AllOpsResolver resolver;
-#else
-	static tflite::MicroMutableOpResolver<7> resolver;
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_DEPTHWISE_CONV_2D,
-		tflite::ops::micro::Register_DEPTHWISE_CONV_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_CONV_2D,
-		tflite::ops::micro::Register_CONV_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_FULLY_CONNECTED,
-		tflite::ops::micro::Register_FULLY_CONNECTED());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_AVERAGE_POOL_2D,
-		tflite::ops::micro::Register_AVERAGE_POOL_2D());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_SOFTMAX,
-		tflite::ops::micro::Register_SOFTMAX());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_QUANTIZE,
-		tflite::ops::micro::Register_QUANTIZE());
-	resolver.AddBuiltin(
-		tflite::BuiltinOperator_DEQUANTIZE,
-		tflite::ops::micro::Register_DEQUANTIZE());
-#endif
+	static simple_example::OpResolver resolver;
 
 	// Create an interpreter
 	static tflite::MicroInterpreter static_interpreter(model, resolver,
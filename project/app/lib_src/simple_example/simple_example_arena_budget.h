@@ -0,0 +1,18 @@
+// Generated by arena_budget from simple_example/mnist_model.cc. Do not edit.
+
+#ifndef SIMPLE_EXAMPLE_ARENA_BUDGET_H_
+#define SIMPLE_EXAMPLE_ARENA_BUDGET_H_
+
+namespace simple_example {
+
+// Smallest tensor arena, in bytes, that the model allocates and runs in on
+// the 32-bit device.
+constexpr int kArenaMinSize = 19403;
+
+// Bytes of the TfLiteTensors that MICRO_RUNTIME builds keep, which their
+// arena needs on top of kArenaMinSize.
+constexpr int kKeptTensorsSize = 2856;
+
+}  // namespace simple_example
+
+#endif  // SIMPLE_EXAMPLE_ARENA_BUDGET_H_
@@ -15,6 +15,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <errno.h>
+#include <stdio.h>
 
 #include "FreeRTOS.h"
 #include "logical-dpc.h"
@@ -25,28 +26,20 @@
 #include "mt3620-timer.h"
 #include <semphr.h>
 
-#define DATALENGTH 22050
-int16_t AdcData[DATALENGTH] = { 0 };
-int rear = 0, full = 0;
+// The model keeps its own 22050 sample window; only the newest hop of samples
+// is buffered here. Must match emergency_detect_hop_size.
+#define HOPLENGTH 1024
+int16_t HopData[HOPLENGTH] = { 0 };
+int hopCount = 0;
 
-void insert(int16_t data) {
-    AdcData[rear] = data;
-    rear++;
-    rear %= DATALENGTH;
-    if (!full && rear == 0) {
-        full = 1;
-    }
-}
-
-int16_t get() {
-    rear++;
-    rear %= DATALENGTH;
-    return AdcData[rear];
-}
+// Results are only reported once the model window holds WINDOWLENGTH received
+// samples. Before that it still holds part of the zeros it starts with.
+#define WINDOWLENGTH 22050
+int windowCount = 0;
 
 static const char* label[] = { "NO BREATH", "BREATH", "CAUGH", "SPEAK" };
 extern void emergency_detect_setup();
-extern int emergency_detect_loop(int16_t* input_buf);
+extern int emergency_detect_stream(int16_t* hop_buf);
 
 extern uint32_t StackTop; // &StackTop == end of TCM
 
@@ -144,7 +137,6 @@ static void HandleSendTimerDeferred(void)
 // and prints their sender ID, length, and content (hex and text).
 static void HandleReceivedMessageDeferred(void)
 {
-    emergency_detect_setup();
     for (;;) {
         ComponentId sender;
         uint8_t rxData[2];
@@ -164,13 +156,16 @@ static void HandleReceivedMessageDeferred(void)
 
         int16_t rowData;
         rowData = (rxData[0] << 8) | rxData[1];
-        insert(rowData);
-        if (full) {
-            int16_t inputData[DATALENGTH];
-            for (int16_t i = 0; i < DATALENGTH; i++) {
-                inputData[i] = AdcData[(i + rear) % DATALENGTH];
+        HopData[hopCount++] = rowData;
+        if (hopCount == HOPLENGTH) {
+            hopCount = 0;
+            int result = emergency_detect_stream(HopData);
+            if (windowCount < WINDOWLENGTH) {
+                windowCount += HOPLENGTH;
+            }
+            if (result >= 0 && windowCount >= WINDOWLENGTH) {
+                printf("%s\n", label[result]);
             }
-            uint8_t result = emergency_detect_loop(inputData);
         }
     }
 }
@@ -190,6 +185,9 @@ _Noreturn void RTCoreMain(void)
 
     MT3620_Gpt_Init();
 
+    // Prepares the model once rather than on every received message.
+    emergency_detect_setup();
+
     IntercoreResult icr = SetupIntercoreComm(&icc, HandleReceivedMessageDeferred);
     if (icr != Intercore_OK) {
     } else {
@@ -0,0 +1,364 @@
+/**************************************************************************//**
+ * @file     cmsis_dsp_emulation.h
+ * @brief    CMSIS portable C emulation of the DSP extension intrinsics
+ * @version  V1.0.0
+ * @date     17. October 2020
+ ******************************************************************************/
+/*
+ * Copyright (c) 2009-2020 Arm Limited. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * Replaces the inline assembly SIMD intrinsics of cmsis_gcc.h when
+ * CMSIS_DSP_EMULATION is defined, so that code written for
+ * __ARM_FEATURE_DSP (the ARM_MATH_DSP paths of CMSIS-DSP and CMSIS-NN) can
+ * be built and tested on a host. Each function returns exactly what the
+ * Cortex-M4/M7 instruction writes to its destination register: lanes wrap
+ * or saturate as on the device and the GE flags set by the parallel
+ * add/subtract instructions are tracked for __SEL. The Q flag is not
+ * modelled.
+ */
+
+#ifndef __CMSIS_DSP_EMULATION_H
+#define __CMSIS_DSP_EMULATION_H
+
+#include <stdint.h>
+
+/* APSR.GE bits [3:0] of the last parallel add/subtract, one per byte. */
+static uint32_t __cmsis_dsp_emulation_ge __attribute__((unused));
+
+/* Signed and unsigned 8-bit and 16-bit lanes of a word. */
+__STATIC_FORCEINLINE int32_t __EMU_S8(uint32_t op, uint32_t lane)
+{
+  return (int32_t)(int8_t)(uint8_t)(op >> (8U * lane));
+}
+
+__STATIC_FORCEINLINE int32_t __EMU_U8(uint32_t op, uint32_t lane)
+{
+  return (int32_t)((op >> (8U * lane)) & 0xFFU);
+}
+
+__STATIC_FORCEINLINE int32_t __EMU_S16(uint32_t op, uint32_t lane)
+{
+  return (int32_t)(int16_t)(uint16_t)(op >> (16U * lane));
+}
+
+__STATIC_FORCEINLINE int32_t __EMU_U16(uint32_t op, uint32_t lane)
+{
+  return (int32_t)((op >> (16U * lane)) & 0xFFFFU);
+}
+
+__STATIC_FORCEINLINE int32_t __EMU_SAT(int32_t val, int32_t min, int32_t max)
+{
+  return (val < min) ? min : ((val > max) ? max : val);
+}
+
+/* Packs two 16-bit lane results, keeping the low half of each. */
+__STATIC_FORCEINLINE uint32_t __EMU_PACK16(int32_t lo, int32_t hi)
+{
+  return ((uint32_t)lo & 0xFFFFU) | ((uint32_t)hi << 16);
+}
+
+/* Packs four 8-bit lane results, keeping the low byte of each. */
+__STATIC_FORCEINLINE uint32_t __EMU_PACK8(const int32_t res[4])
+{
+  return ((uint32_t)res[0] & 0xFFU)         | (((uint32_t)res[1] & 0xFFU) << 8) |
+         (((uint32_t)res[2] & 0xFFU) << 16) | ((uint32_t)res[3] << 24);
+}
+
+/* Four byte lanes: op selects the operation, kind how the lanes are read and
+   written (0 signed, 1 signed saturating, 2 signed halving, 3 unsigned,
+   4 unsigned saturating, 5 unsigned halving). Only kinds 0 and 3 set GE. */
+__STATIC_FORCEINLINE uint32_t __EMU_ARITH8(uint32_t op1, uint32_t op2, int32_t sub, int32_t kind)
+{
+  int32_t res[4];
+  uint32_t ge = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < 4U; i++)
+  {
+    const int32_t is_signed = kind < 3;
+    const int32_t a = is_signed ? __EMU_S8(op1, i) : __EMU_U8(op1, i);
+    const int32_t b = is_signed ? __EMU_S8(op2, i) : __EMU_U8(op2, i);
+    int32_t r = sub ? (a - b) : (a + b);
+
+    if ((kind == 0 && r >= 0) || (kind == 3 && (sub ? (r >= 0) : (r >= 0x100))))
+    {
+      ge |= 1U << i;
+    }
+    switch (kind)
+    {
+      case 1: r = __EMU_SAT(r, -128, 127); break;
+      case 4: r = __EMU_SAT(r, 0, 255);    break;
+      case 2:
+      case 5: r = r >> 1;                  break;
+      default:                             break;
+    }
+    res[i] = r;
+  }
+  if (kind == 0 || kind == 3)
+  {
+    __cmsis_dsp_emulation_ge = ge;
+  }
+  return __EMU_PACK8(res);
+}
+
+/* Two halfword lanes. sub_lo/sub_hi select subtraction for the low/high
+   result, exchange pairs each half of op1 with the other half of op2 (the
+   ASX/SAX forms). kind as for __EMU_ARITH8. */
+__STATIC_FORCEINLINE uint32_t __EMU_ARITH16(uint32_t op1, uint32_t op2, int32_t sub_lo, int32_t sub_hi,
+                                            int32_t exchange, int32_t kind)
+{
+  int32_t res[2];
+  uint32_t ge = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < 2U; i++)
+  {
+    const int32_t is_signed = kind < 3;
+    const uint32_t j = exchange ? (1U - i) : i;
+    const int32_t sub = (i == 0U) ? sub_lo : sub_hi;
+    const int32_t a = is_signed ? __EMU_S16(op1, i) : __EMU_U16(op1, i);
+    const int32_t b = is_signed ? __EMU_S16(op2, j) : __EMU_U16(op2, j);
+    int32_t r = sub ? (a - b) : (a + b);
+
+    if ((kind == 0 && r >= 0) || (kind == 3 && (sub ? (r >= 0) : (r >= 0x10000))))
+    {
+      ge |= 3U << (2U * i);
+    }
+    switch (kind)
+    {
+      case 1: r = __EMU_SAT(r, -32768, 32767); break;
+      case 4: r = __EMU_SAT(r, 0, 65535);      break;
+      case 2:
+      case 5: r = r >> 1;                      break;
+      default:                                 break;
+    }
+    res[i] = r;
+  }
+  if (kind == 0 || kind == 3)
+  {
+    __cmsis_dsp_emulation_ge = ge;
+  }
+  return __EMU_PACK16(res[0], res[1]);
+}
+
+__STATIC_FORCEINLINE uint32_t __SADD8  (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 0, 0); }
+__STATIC_FORCEINLINE uint32_t __QADD8  (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 0, 1); }
+__STATIC_FORCEINLINE uint32_t __SHADD8 (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 0, 2); }
+__STATIC_FORCEINLINE uint32_t __UADD8  (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 0, 3); }
+__STATIC_FORCEINLINE uint32_t __UQADD8 (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 0, 4); }
+__STATIC_FORCEINLINE uint32_t __UHADD8 (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 0, 5); }
+__STATIC_FORCEINLINE uint32_t __SSUB8  (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 1, 0); }
+__STATIC_FORCEINLINE uint32_t __QSUB8  (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 1, 1); }
+__STATIC_FORCEINLINE uint32_t __SHSUB8 (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 1, 2); }
+__STATIC_FORCEINLINE uint32_t __USUB8  (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 1, 3); }
+__STATIC_FORCEINLINE uint32_t __UQSUB8 (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 1, 4); }
+__STATIC_FORCEINLINE uint32_t __UHSUB8 (uint32_t op1, uint32_t op2) { return __EMU_ARITH8(op1, op2, 1, 5); }
+
+__STATIC_FORCEINLINE uint32_t __SADD16 (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 0, 0, 0); }
+__STATIC_FORCEINLINE uint32_t __QADD16 (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 0, 0, 1); }
+__STATIC_FORCEINLINE uint32_t __SHADD16(uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 0, 0, 2); }
+__STATIC_FORCEINLINE uint32_t __UADD16 (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 0, 0, 3); }
+__STATIC_FORCEINLINE uint32_t __UQADD16(uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 0, 0, 4); }
+__STATIC_FORCEINLINE uint32_t __UHADD16(uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 0, 0, 5); }
+__STATIC_FORCEINLINE uint32_t __SSUB16 (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 1, 0, 0); }
+__STATIC_FORCEINLINE uint32_t __QSUB16 (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 1, 0, 1); }
+__STATIC_FORCEINLINE uint32_t __SHSUB16(uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 1, 0, 2); }
+__STATIC_FORCEINLINE uint32_t __USUB16 (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 1, 0, 3); }
+__STATIC_FORCEINLINE uint32_t __UQSUB16(uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 1, 0, 4); }
+__STATIC_FORCEINLINE uint32_t __UHSUB16(uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 1, 0, 5); }
+
+/* ASX: low = op1.lo - op2.hi, high = op1.hi + op2.lo. SAX is the reverse. */
+__STATIC_FORCEINLINE uint32_t __SASX   (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 0, 1, 0); }
+__STATIC_FORCEINLINE uint32_t __QASX   (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 0, 1, 1); }
+__STATIC_FORCEINLINE uint32_t __SHASX  (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 0, 1, 2); }
+__STATIC_FORCEINLINE uint32_t __UASX   (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 0, 1, 3); }
+__STATIC_FORCEINLINE uint32_t __UQASX  (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 0, 1, 4); }
+__STATIC_FORCEINLINE uint32_t __UHASX  (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 1, 0, 1, 5); }
+__STATIC_FORCEINLINE uint32_t __SSAX   (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 1, 1, 0); }
+__STATIC_FORCEINLINE uint32_t __QSAX   (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 1, 1, 1); }
+__STATIC_FORCEINLINE uint32_t __SHSAX  (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 1, 1, 2); }
+__STATIC_FORCEINLINE uint32_t __USAX   (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 1, 1, 3); }
+__STATIC_FORCEINLINE uint32_t __UQSAX  (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 1, 1, 4); }
+__STATIC_FORCEINLINE uint32_t __UHSAX  (uint32_t op1, uint32_t op2) { return __EMU_ARITH16(op1, op2, 0, 1, 1, 5); }
+
+__STATIC_FORCEINLINE uint32_t __USADA8(uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  uint32_t i;
+
+  for (i = 0U; i < 4U; i++)
+  {
+    const int32_t diff = __EMU_U8(op1, i) - __EMU_U8(op2, i);
+    op3 += (uint32_t)((diff < 0) ? -diff : diff);
+  }
+  return op3;
+}
+
+__STATIC_FORCEINLINE uint32_t __USAD8(uint32_t op1, uint32_t op2)
+{
+  return __USADA8(op1, op2, 0U);
+}
+
+/* Saturates both signed halfwords to ARG2 bits (1..16). */
+#define __SSAT16(ARG1, ARG2) \
+  __EMU_PACK16(__EMU_SAT(__EMU_S16((ARG1), 0U), -(1 << ((ARG2) - 1)), (1 << ((ARG2) - 1)) - 1), \
+               __EMU_SAT(__EMU_S16((ARG1), 1U), -(1 << ((ARG2) - 1)), (1 << ((ARG2) - 1)) - 1))
+
+/* Saturates both signed halfwords to ARG2 unsigned bits (0..15). */
+#define __USAT16(ARG1, ARG2) \
+  __EMU_PACK16(__EMU_SAT(__EMU_S16((ARG1), 0U), 0, (1 << (ARG2)) - 1), \
+               __EMU_SAT(__EMU_S16((ARG1), 1U), 0, (1 << (ARG2)) - 1))
+
+__STATIC_FORCEINLINE uint32_t __UXTB16(uint32_t op1)
+{
+  return op1 & 0x00FF00FFU;
+}
+
+__STATIC_FORCEINLINE uint32_t __UXTAB16(uint32_t op1, uint32_t op2)
+{
+  return __EMU_PACK16(__EMU_U16(op1, 0U) + __EMU_U8(op2, 0U), __EMU_U16(op1, 1U) + __EMU_U8(op2, 2U));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTB16(uint32_t op1)
+{
+  return __EMU_PACK16(__EMU_S8(op1, 0U), __EMU_S8(op1, 2U));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTB16_RORn(uint32_t op1, uint32_t rotate)
+{
+  return __SXTB16(__ROR(op1, rotate));
+}
+
+__STATIC_FORCEINLINE uint32_t __SXTAB16(uint32_t op1, uint32_t op2)
+{
+  return __EMU_PACK16(__EMU_S16(op1, 0U) + __EMU_S8(op2, 0U), __EMU_S16(op1, 1U) + __EMU_S8(op2, 2U));
+}
+
+/* Dual 16-bit multiplies. The products always fit in 32 bits; the 32-bit
+   sums wrap like the instructions do. */
+__STATIC_FORCEINLINE uint32_t __EMU_MUL16(uint32_t op1, uint32_t lane1, uint32_t op2, uint32_t lane2)
+{
+  return (uint32_t)(__EMU_S16(op1, lane1) * __EMU_S16(op2, lane2));
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUAD  (uint32_t op1, uint32_t op2)
+{
+  return __EMU_MUL16(op1, 0U, op2, 0U) + __EMU_MUL16(op1, 1U, op2, 1U);
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUADX (uint32_t op1, uint32_t op2)
+{
+  return __EMU_MUL16(op1, 0U, op2, 1U) + __EMU_MUL16(op1, 1U, op2, 0U);
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLAD (uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUAD(op1, op2) + op3;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLADX (uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUADX(op1, op2) + op3;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUSD  (uint32_t op1, uint32_t op2)
+{
+  return __EMU_MUL16(op1, 0U, op2, 0U) - __EMU_MUL16(op1, 1U, op2, 1U);
+}
+
+__STATIC_FORCEINLINE uint32_t __SMUSDX (uint32_t op1, uint32_t op2)
+{
+  return __EMU_MUL16(op1, 0U, op2, 1U) - __EMU_MUL16(op1, 1U, op2, 0U);
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLSD (uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUSD(op1, op2) + op3;
+}
+
+__STATIC_FORCEINLINE uint32_t __SMLSDX (uint32_t op1, uint32_t op2, uint32_t op3)
+{
+  return __SMUSDX(op1, op2) + op3;
+}
+
+/* The 64-bit forms add the two products at full precision. */
+__STATIC_FORCEINLINE uint64_t __SMLALD (uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)((int64_t)__EMU_S16(op1, 0U) * __EMU_S16(op2, 0U) +
+                          (int64_t)__EMU_S16(op1, 1U) * __EMU_S16(op2, 1U));
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLALDX (uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)((int64_t)__EMU_S16(op1, 0U) * __EMU_S16(op2, 1U) +
+                          (int64_t)__EMU_S16(op1, 1U) * __EMU_S16(op2, 0U));
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLSLD (uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)((int64_t)__EMU_S16(op1, 0U) * __EMU_S16(op2, 0U) -
+                          (int64_t)__EMU_S16(op1, 1U) * __EMU_S16(op2, 1U));
+}
+
+__STATIC_FORCEINLINE uint64_t __SMLSLDX (uint32_t op1, uint32_t op2, uint64_t acc)
+{
+  return acc + (uint64_t)((int64_t)__EMU_S16(op1, 0U) * __EMU_S16(op2, 1U) -
+                          (int64_t)__EMU_S16(op1, 1U) * __EMU_S16(op2, 0U));
+}
+
+/* Takes each byte from op1 where the matching GE flag is set, else from op2. */
+__STATIC_FORCEINLINE uint32_t __SEL  (uint32_t op1, uint32_t op2)
+{
+  uint32_t mask = 0U;
+  uint32_t i;
+
+  for (i = 0U; i < 4U; i++)
+  {
+    if ((__cmsis_dsp_emulation_ge >> i) & 1U)
+    {
+      mask |= 0xFFU << (8U * i);
+    }
+  }
+  return (op1 & mask) | (op2 & ~mask);
+}
+
+__STATIC_FORCEINLINE  int32_t __QADD( int32_t op1,  int32_t op2)
+{
+  const int64_t sum = (int64_t)op1 + op2;
+  return (int32_t)((sum > INT32_MAX) ? INT32_MAX : ((sum < INT32_MIN) ? INT32_MIN : sum));
+}
+
+__STATIC_FORCEINLINE  int32_t __QSUB( int32_t op1,  int32_t op2)
+{
+  const int64_t diff = (int64_t)op1 - op2;
+  return (int32_t)((diff > INT32_MAX) ? INT32_MAX : ((diff < INT32_MIN) ? INT32_MIN : diff));
+}
+
+#define __PKHBT(ARG1,ARG2,ARG3)          ( ((((uint32_t)(ARG1))          ) & 0x0000FFFFUL) |  \
+                                           ((((uint32_t)(ARG2)) << (ARG3)) & 0xFFFF0000UL)  )
+
+/* The bottom half comes from an arithmetic shift, as in "pkhtb ..., asr #n". */
+#define __PKHTB(ARG1,ARG2,ARG3)          ( ((((uint32_t)(ARG1))                    ) & 0xFFFF0000UL) |  \
+                                           (((uint32_t)(((int32_t)(ARG2)) >> (ARG3))) & 0x0000FFFFUL)  )
+
+__STATIC_FORCEINLINE int32_t __SMMLA (int32_t op1, int32_t op2, int32_t op3)
+{
+  return (int32_t)((uint32_t)op3 + (uint32_t)(((int64_t)op1 * op2) >> 32));
+}
+
+#endif /* __CMSIS_DSP_EMULATION_H */
@@ -293,6 +293,115 @@ extern    "C"
     int32_t arm_convolve_s8_get_buffer_size(const cmsis_nn_dims* input_dims,
                                             const cmsis_nn_dims* filter_dims);
 
+  /**
+   * @brief s8 convolution function with a filter packed by arm_convolve_s8_pack_filter()
+   * @param[in, out] ctx                 Function context. The buffer size is given by arm_convolve_s8_get_buffer_size
+   * @param[in]      conv_params         Convolution parameters, as for arm_convolve_s8
+   * @param[in]      quant_params        Per-channel quantization info.
+   * @param[in]      input_dims          Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+   * @param[in]      input_data          Input (activation) data pointer. Data type: int8
+   * @param[in]      filter_dims         Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+   * @param[in]      packed_filter_data  Packed filter data pointer. Data type: int8
+   * @param[in]      bias_dims           Bias tensor dimensions. Format: [C_OUT]
+   * @param[in]      bias_data           Bias data pointer. Data type: int32
+   * @param[in]      output_dims         Output tensor dimensions. Format: [N, H, W, C_OUT]
+   * @param[out]     output_data         Output data pointer. Data type: int8
+   *
+   * @return     The function returns <code>ARM_MATH_SUCCESS</code>, or <code>ARM_MATH_ARGUMENT_ERROR</code>
+   *             if arm_convolve_s8_packed_filter_size() is 0 for the dimensions.
+   *
+   * @details
+   *    1. Supported framework: TensorFlow Lite micro
+   *    2. Bit exact with arm_convolve_s8. Packing the filter once, e.g. when the model is prepared, saves
+   *       reordering its values in the inner loop of every call.
+   *
+   */
+    arm_status arm_convolve_s8_packed(const cmsis_nn_context* ctx,
+                                      const cmsis_nn_conv_params* conv_params,
+                                      const cmsis_nn_per_channel_quant_params* quant_params,
+                                      const cmsis_nn_dims* input_dims,
+                                      const q7_t *input_data,
+                                      const cmsis_nn_dims* filter_dims,
+                                      const q7_t *packed_filter_data,
+                                      const cmsis_nn_dims* bias_dims,
+                                      const int32_t *bias_data,
+                                      const cmsis_nn_dims* output_dims,
+                                      q7_t *output_data);
+
+  /**
+   * @brief Get the size of the packed filter of arm_convolve_s8_packed
+   *
+   * @param[in]       input_dims            Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+   * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+   * @return          The function returns the packed filter size (bytes), or 0 when arm_convolve_s8_packed
+   *                  is not available for the dimensions or gains nothing on the target (no DSP extension, or MVE).
+   *
+   */
+    int32_t arm_convolve_s8_packed_filter_size(const cmsis_nn_dims* input_dims,
+                                               const cmsis_nn_dims* filter_dims);
+
+  /**
+   * @brief Pack a filter for arm_convolve_s8_packed
+   *
+   * @param[in]       input_dims            Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+   * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN]
+   * @param[in]       filter_data           Filter data pointer. Data type: int8
+   * @param[out]      packed_filter         Packed filter of arm_convolve_s8_packed_filter_size() bytes
+   *
+   */
+    void arm_convolve_s8_pack_filter(const cmsis_nn_dims* input_dims,
+                                     const cmsis_nn_dims* filter_dims,
+                                     const q7_t *filter_data,
+                                     q7_t *packed_filter);
+
+  /**
+   * @brief Basic s16 convolution function
+   * @param[in, out] ctx            Function context that contains the additional buffer if required by the implementation.
+                                    arm_convolve_s16_get_buffer_size will return the buffer_size if required
+   * @param[in]      conv_params    Convolution parameters (e.g. strides, dilations, pads,...).
+   *                                conv_params->input_offset and conv_params->output_offset are not used.
+   * @param[in]      quant_params   Per-channel quantization info.
+   *                                It contains the multiplier and shift values to be applied to each output channel
+   * @param[in]      input_dims     Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+   * @param[in]      input_data     Input (activation) data pointer. Data type: int16
+   * @param[in]      filter_dims    Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN] where HK and WK are the spatial filter dimensions
+   * @param[in]      filter_data    Filter data pointer. Data type: int8
+   * @param[in]      bias_dims      Bias tensor dimensions. Format: [C_OUT]
+   * @param[in]      bias_data      Bias data pointer. Data type: int64. Can be NULL.
+   * @param[in]      output_dims    Output tensor dimensions. Format: [N, H, W, C_OUT]
+   * @param[out]     output_data    Output data pointer. Data type: int16
+
+   * @return     The function returns <code>ARM_MATH_SUCCESS</code>
+   *
+   * @details
+   *    1. Supported framework: TensorFlow Lite micro, 16x8 quantization.
+   *    2. Accumulation is done in 64 bits, bit-exact with the TensorFlow Lite reference kernel.
+   *    3. Additional memory is required for optimization. Refer to argument 'ctx' for details.
+   *
+   */
+    arm_status arm_convolve_s16(const cmsis_nn_context* ctx,
+                                const cmsis_nn_conv_params* conv_params,
+                                const cmsis_nn_per_channel_quant_params* quant_params,
+                                const cmsis_nn_dims* input_dims,
+                                const q15_t *input_data,
+                                const cmsis_nn_dims* filter_dims,
+                                const q7_t *filter_data,
+                                const cmsis_nn_dims* bias_dims,
+                                const int64_t *bias_data,
+                                const cmsis_nn_dims* output_dims,
+                                q15_t *output_data);
+
+  /**
+   * @brief Get the required buffer size for s16 convolution function
+   *
+   * @param[in]       input_dims            Input (activation) tensor dimensions. Format: [N, H, W, C_IN]
+   * @param[in]       filter_dims           Filter tensor dimensions. Format: [C_OUT, HK, WK, C_IN] where HK and WK are the spatial filter dimensions
+   * @return          The function returns  required buffer size(bytes)
+   *
+   */
+    int32_t arm_convolve_s16_get_buffer_size(const cmsis_nn_dims* input_dims,
+                                             const cmsis_nn_dims* filter_dims);
+
   /**
    * @brief Basic Q7 convolution function
    * @param[in]       Im_in       pointer to input tensor
@@ -638,12 +747,13 @@ extern    "C"
    *   - Supported framework : TensorFlow Lite Micro
    *   - The following constrains on the arguments apply
    *      -# input_dims->n equals 1
-   *      -# ouput_dims->w is a multiple of 4
+   *      -# ouput_dims->w is a multiple of 4 (MVE implementation only)
    *      -# Explicit constraints(since it is for 1xN convolution)
    *      -## input_dims->h equals 1
    *      -## output_dims->h equals 1
    *      -## filter_dims->h equals 1
-   *@todo  Remove constraint on output_dims->w to make the function generic.
+   *   - The non-MVE implementation needs no additional buffer. It handles any
+   *     output width and skips padded kernel taps instead of reading zeros.
    *
    */
    arm_status arm_convolve_1_x_n_s8(const cmsis_nn_context* ctx,
@@ -1223,6 +1333,96 @@ int32_t arm_depthwise_conv_s8_opt_get_buffer_size(const uint16_t input_ch,
    */
     int32_t arm_fully_connected_s8_get_buffer_size(const uint16_t col_dim);
 
+  /**
+   * @brief S8 fully-connected layer function for TF Lite with block-sparse weights
+   * @param[in]       pInput                       pointer to pInput vector
+   * @param[in]       pWeight                      pointer to the stored weight blocks, each block_rows x block_cols
+   *                                               values in row-major order
+   * @param[in]       block_segments               row_dim / block_rows + 1 offsets into block_indices. The blocks of
+   *                                               block row r are block_segments[r] to block_segments[r + 1] - 1.
+   * @param[in]       block_indices                block column of each stored block
+   * @param[in]       block_rows                   rows of a block. row_dim must be a multiple of it.
+   * @param[in]       block_cols                   columns of a block. col_dim must be a multiple of it.
+   * @param[in]       col_dim                      dimension of the input vector
+   * @param[in]       row_dim                      dimension of the output vector
+   * @param[in]       nb_batches                   number of batches
+   * @param[in]       input_offset                 tensor offset for input. Range: -127 to 128
+   * @param[in]       filter_offset                tensor offset for filter. Range: -127 to 128
+   * @param[in]       out_mult                     requantization parameter
+   * @param[in]       out_shift                    requantization parameter
+   * @param[in]       output_offset                tensor offset for output. Range: int8
+   * @param[in]       pBias                        pointer to bias. Can be NULL.
+   * @param[out]      pOut                         pointer to output vector
+   * @param[in]       output_activation_min        for clamping
+   * @param[in]       output_activation_max        for clamping
+   * @return          The function returns either
+   *                  <code>ARM_MATH_SIZE_MISMATCH</code> if the dimensions are not multiples of the block size or,
+   *                  <code>ARM_MATH_SUCCESS</code> on successful completion.
+   *
+   * @details
+   *
+   *    1. Supported framework: TensorFlow Lite micro
+   *    2. Bit exact with arm_fully_connected_s8 on the dense weights, in which the missing blocks hold
+   *       -filter_offset. Only the stored blocks are read, so the cost scales with their number.
+   *
+   */
+
+    arm_status
+    arm_fully_connected_s8_sparse(const int8_t *pInput,
+                                  const int8_t *pWeight,
+                                  const int32_t *block_segments,
+                                  const int32_t *block_indices,
+                                  const uint16_t block_rows,
+                                  const uint16_t block_cols,
+                                  const uint16_t col_dim,
+                                  const uint16_t row_dim,
+                                  const uint16_t nb_batches,
+                                  const int32_t input_offset,
+                                  const int32_t filter_offset,
+                                  const int32_t out_mult,
+                                  const int32_t out_shift,
+                                  const int32_t output_offset,
+                                  const int32_t *pBias,
+                                  int8_t *pOut,
+                                  const int32_t output_activation_min,
+                                  const int32_t output_activation_max);
+
+  /**
+   * @brief S16 basic fully-connected and matrix multiplication layer function for TF Lite
+   * @param[in]       pInput                       pointer to pInput vector. Data type: int16
+   * @param[in]       pWeight                      pointer to matrix weights. Data type: int8
+   * @param[in]       col_dim                      dimension of the input vector
+   * @param[in]       row_dim                      dimension of the output vector
+   * @param[in]       nb_batches                   number of batches
+   * @param[in]       out_mult                     requantization parameter
+   * @param[in]       out_shift                    requantization parameter
+   * @param[in]       pBias                        pointer to bias. Data type: int64. Can be NULL.
+   * @param[out]      pOut                         pointer to output vector. Data type: int16
+   * @param[in]       output_activation_min        for clamping. Range: int16
+   * @param[in]       output_activation_max        for clamping. Range: int16
+   * @return          The function returns         ARM_MATH_SUCCESS
+   *
+   * @details
+   *
+   *    1. Supported framework: TensorFlow Lite, 16x8 quantization.
+   *    2. Input, output and weights are symmetrically quantized, so there are no offsets.
+   *    3. No buffer is needed; the weights are widened to 16 bits in registers.
+   *
+   */
+
+    arm_status
+    arm_fully_connected_s16(const int16_t *pInput,
+                            const int8_t *pWeight,
+                            const int32_t col_dim,
+                            const int32_t row_dim,
+                            const int32_t nb_batches,
+                            const int32_t out_mult,
+                            const int32_t out_shift,
+                            const int64_t *pBias,
+                            int16_t *pOut,
+                            const int32_t output_activation_min,
+                            const int32_t output_activation_max);
+
   /**
    * @brief Q7 opt fully-connected layer function
    * @param[in]       pV          pointer to input vector
@@ -1729,6 +1929,59 @@ extern    "C"
     int32_t arm_avgpool_s8_get_buffer_size(const int dim_dst_width,
                                            const int ch_src);
 
+  /**
+   * @brief s16 average pooling function
+   * @param[in]       dim_src_height     input tensor dimension
+   * @param[in]       dim_src_width      input tensor dimension
+   * @param[in]       dim_dst_height     output tensor dimension
+   * @param[in]       dim_dst_width      output tensor dimension
+   * @param[in]       stride_height      stride along y
+   * @param[in]       stride_width       stride along x
+   * @param[in]       dim_kernel_height  filter kernel size along y
+   * @param[in]       dim_kernel_width   filter kernel size along x
+   * @param[in]       padding_height     padding size along y
+   * @param[in]       padding_width      padding size along x
+   * @param[in]       act_min            Min clamping. Range: int16
+   * @param[in]       act_max            Max clamping. Range: int16
+   * @param[in]       ch_src             number of input tensor channels
+   * @param[in]       src                pointer to input tensor
+   * @param[in]       bufferA            Temporary buffer holding one 32-bit sum per channel. Use
+   *                                     arm_avgpool_s16_get_buffer_size() to get the size of required memory.
+   * @param[in,out]   dst                pointer to output tensor
+   * @return                             The function returns <code>ARM_MATH_SUCCESS</code>
+   *
+   * @details
+   *    - Supported Framework: TensorFlow Lite, 16x8 quantization.
+   *
+   */
+
+    arm_status arm_avgpool_s16(const int dim_src_height,
+                               const int dim_src_width,
+                               const int dim_dst_height,
+                               const int dim_dst_width,
+                               const int stride_height,
+                               const int stride_width,
+                               const int dim_kernel_height,
+                               const int dim_kernel_width,
+                               const int padding_height,
+                               const int padding_width,
+                               const int act_min,
+                               const int act_max,
+                               const int ch_src,
+                               const int16_t *src,
+                               int32_t *bufferA,
+                               int16_t *dst);
+
+  /**
+   * @brief Get the required buffer size for S16 average pooling function
+   * @param[in]       dim_dst_width         output tensor dimension
+   * @param[in]       ch_src                number of input tensor channels
+   * @return          The function returns  required buffer size
+   *
+   */
+    int32_t arm_avgpool_s16_get_buffer_size(const int dim_dst_width,
+                                            const int ch_src);
+
    /**
    * @brief s8 DSP optimized max pooling function
    * @param[in]       input_y     input tensor dimension along y
@@ -1817,6 +2070,46 @@ extern    "C"
                                int8_t *input,
                                int16_t *tmp_buffer,
                                int8_t *output);
+
+  /**
+   * @brief s16 max pooling function
+   * @param[in]       input_y     input tensor dimension along y
+   * @param[in]       input_x     input tensor dimension along x
+   * @param[in]       output_y    output tensor dimension along y
+   * @param[in]       output_x    output tensor dimension along x
+   * @param[in]       stride_y    stride along y
+   * @param[in]       stride_x    stride along x
+   * @param[in]       kernel_y    filter kernel size along y
+   * @param[in]       kernel_x    filter kernel size along x
+   * @param[in]       pad_y       padding size along y
+   * @param[in]       pad_x       padding size along x
+   * @param[in]       act_min     Activation min. Lower limit to clamp output to. Range: int16
+   * @param[in]       act_max     Activation max. Upper limit to clamp output to. Range: int16
+   * @param[in]       depth       number of input channels
+   * @param[in]       input       pointer to input tensor
+   * @param[in,out]   output      pointer to output tensor
+   * @return                      The function returns <code>ARM_MATH_SUCCESS</code>
+   *
+   * @details
+   *    - Supported Framework: TensorFlow Lite, 16x8 quantization.
+   *    - Unlike arm_max_pool_s8_opt the input is not modified.
+   *
+   */
+    arm_status arm_max_pool_s16(const int input_y,
+                                const int input_x,
+                                const int output_y,
+                                const int output_x,
+                                const int stride_y,
+                                const int stride_x,
+                                const int kernel_y,
+                                const int kernel_x,
+                                const int pad_y,
+                                const int pad_x,
+                                const int act_min,
+                                const int act_max,
+                                const int depth,
+                                const int16_t *input,
+                                int16_t *output);
 /**
  * @defgroup Softmax Softmax Functions
  *
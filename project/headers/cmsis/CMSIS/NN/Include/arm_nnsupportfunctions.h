@@ -33,6 +33,16 @@
 #include "cmsis/CMSIS/DSP/Include/arm_math.h"
 #include "cmsis/CMSIS/DSP/Include/arm_common_tables.h"
 
+/* Host builds for x86 that enable SSE4.1 or AVX2 (see CMSIS_NN_X86_SIMD in
+ * tools/cmake/cmsis.cmake) run the s8 matrix and depthwise cores with x86
+ * SIMD instead of the portable C loops. Like the DSP versions they widen to
+ * 16 bits and accumulate in 32 bits, so the results are bit exact. */
+#if !defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI) && \
+    (defined(__AVX2__) || defined(__SSE4_1__))
+#define ARM_NN_X86_SIMD
+#include <immintrin.h>
+#endif
+
 #ifdef __cplusplus
 extern    "C"
 {
@@ -258,6 +268,28 @@ arm_status arm_nn_mat_mul_core_1x_s8(int32_t row_elements,
                                      int32_t *const sum_col,
                                      int32_t *const output);
 
+/**
+ * @brief s16 x s8 matrix-multiplication without requantization for one row & one column
+ * @param[in]       row_elements  number of row elements
+ * @param[in]       row_base      pointer to row operand. Data type: int8
+ * @param[in]       col_base      pointer to col operand. Data type: int16
+ * @param[out]      output        pointer to store the 64-bit result of multiply-accumulate
+ * @return     The function returns <code>ARM_MATH_SUCCESS</code>
+ *
+ * @details Pseudo-code
+ *      *output = 0
+ *      for (i = 0; i < row_elements; i++)
+ *          *output += row_base[i] * col_base[i]
+ *
+ *      The DSP implementation accumulates blocks of __SMLAD results in 32 bits
+ *      and only adds them up in 64 bits, which cannot overflow.
+ *
+*/
+arm_status arm_nn_mat_mul_core_1x_s16(int32_t row_elements,
+                                      const int8_t *row_base,
+                                      const int16_t *col_base,
+                                      int64_t *const output);
+
 /**
  * @brief General Matrix-multiplication without requantization for four rows and one column
  * @param[in]       row_elements  number of row elements
@@ -362,6 +394,34 @@ arm_status arm_nn_vec_mat_mult_t_s8(const q7_t *lhs,
                                     const int32_t activation_min,
                                     const int32_t activation_max);
 
+/**
+ * @brief s16 Vector by s8 Matrix (transposed) multiplication
+ *
+ * @param[in]      lhs             Input left-hand side vector
+ * @param[in]      rhs             Input right-hand side matrix (transposed)
+ * @param[in]      bias            Input bias. Can be NULL.
+ * @param[out]     dst             Output vector
+ * @param[in]      dst_multiplier  Output multiplier
+ * @param[in]      dst_shift       Output shift
+ * @param[in]      rhs_cols        Number of columns in the right-hand side input matrix
+ * @param[in]      rhs_rows        Number of rows in the right-hand side input matrix
+ * @param[in]      activation_min  Minimum value to clamp the output to. Range: int16
+ * @param[in]      activation_max  Maximum value to clamp the output to. Range: int16
+ *
+ * @return         The function returns <code>ARM_MATH_SUCCESS</code>
+ *
+ */
+arm_status arm_nn_vec_mat_mult_t_s16(const q15_t *lhs,
+                                     const q7_t *rhs,
+                                     const q63_t *bias,
+                                     q15_t *dst,
+                                     const int32_t dst_multiplier,
+                                     const int32_t dst_shift,
+                                     const int32_t rhs_cols,
+                                     const int32_t rhs_rows,
+                                     const int32_t activation_min,
+                                     const int32_t activation_max);
+
 /**
  * @brief Depthwise convolution of transposed rhs matrix with 4 lhs matrices. To be used in padded cases where
  *        the padding is -lhs_offset(Range: int8). Dimensions are the same for lhs and rhs.
@@ -589,6 +649,183 @@ __STATIC_FORCEINLINE const q7_t *read_and_pad_reordered_with_offset(const q7_t *
 
 #endif
 
+#if defined(ARM_NN_X86_SIMD)
+
+#if defined(__AVX2__)
+#define ARM_NN_X86_S16_LANES 16
+#define ARM_NN_X86_S32_LANES 8
+typedef __m256i arm_nn_x86_vec_t;
+#else
+#define ARM_NN_X86_S16_LANES 8
+#define ARM_NN_X86_S32_LANES 4
+typedef __m128i arm_nn_x86_vec_t;
+#endif
+
+/**
+ * @brief read ARM_NN_X86_S16_LANES q7 values and sign extend them to q15
+ */
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_read_q7_to_q15(const q7_t *source)
+{
+#if defined(__AVX2__)
+    return _mm256_cvtepi8_epi16(_mm_loadu_si128((const __m128i *)source));
+#else
+    return _mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)source));
+#endif
+}
+
+/**
+ * @brief read ARM_NN_X86_S32_LANES q7 values and sign extend them to q31
+ */
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_read_q7_to_q31(const q7_t *source)
+{
+#if defined(__AVX2__)
+    return _mm256_cvtepi8_epi32(_mm_loadl_epi64((const __m128i *)source));
+#else
+    return _mm_cvtepi8_epi32(_mm_cvtsi32_si128(arm_nn_read_q7x4(source)));
+#endif
+}
+
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_read_q31(const q31_t *source)
+{
+#if defined(__AVX2__)
+    return _mm256_loadu_si256((const __m256i *)source);
+#else
+    return _mm_loadu_si128((const __m128i *)source);
+#endif
+}
+
+__STATIC_FORCEINLINE void arm_nn_x86_write_q31(q31_t *dst, const arm_nn_x86_vec_t val)
+{
+#if defined(__AVX2__)
+    _mm256_storeu_si256((__m256i *)dst, val);
+#else
+    _mm_storeu_si128((__m128i *)dst, val);
+#endif
+}
+
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_dup_q15(const q31_t val)
+{
+#if defined(__AVX2__)
+    return _mm256_set1_epi16((q15_t)val);
+#else
+    return _mm_set1_epi16((q15_t)val);
+#endif
+}
+
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_dup_q31(const q31_t val)
+{
+#if defined(__AVX2__)
+    return _mm256_set1_epi32(val);
+#else
+    return _mm_set1_epi32(val);
+#endif
+}
+
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_add_q31(const arm_nn_x86_vec_t a, const arm_nn_x86_vec_t b)
+{
+#if defined(__AVX2__)
+    return _mm256_add_epi32(a, b);
+#else
+    return _mm_add_epi32(a, b);
+#endif
+}
+
+/**
+ * @brief q31 lanes of acc plus the q31 products of a and b
+ */
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_mla_q31(const arm_nn_x86_vec_t acc,
+                                                         const arm_nn_x86_vec_t a,
+                                                         const arm_nn_x86_vec_t b)
+{
+#if defined(__AVX2__)
+    return _mm256_add_epi32(acc, _mm256_mullo_epi32(a, b));
+#else
+    return _mm_add_epi32(acc, _mm_mullo_epi32(a, b));
+#endif
+}
+
+/**
+ * @brief q31 lanes of acc plus the pairwise sums of the q15 products of a and b,
+ *        the x86 counterpart of __SMLAD
+ */
+__STATIC_FORCEINLINE arm_nn_x86_vec_t arm_nn_x86_smlad(const arm_nn_x86_vec_t a,
+                                                       const arm_nn_x86_vec_t b,
+                                                       const arm_nn_x86_vec_t acc)
+{
+#if defined(__AVX2__)
+    return _mm256_add_epi32(acc, _mm256_madd_epi16(a, b));
+#else
+    return _mm_add_epi32(acc, _mm_madd_epi16(a, b));
+#endif
+}
+
+/**
+ * @brief sum of the q31 lanes
+ */
+__STATIC_FORCEINLINE q31_t arm_nn_x86_reduce_q31(const arm_nn_x86_vec_t val)
+{
+#if defined(__AVX2__)
+    __m128i sum = _mm_add_epi32(_mm256_castsi256_si128(val), _mm256_extracti128_si256(val, 1));
+#else
+    __m128i sum = val;
+#endif
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+    sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+    return _mm_cvtsi128_si32(sum);
+}
+
+/**
+ * @brief dot product of (lhs + lhs_offset) and (rhs + rhs_offset) over len q7 values
+ *
+ * The offsets are added in 16 bits as in read_and_pad_reordered_with_offset(),
+ * which cannot overflow for offsets in the [-128, 128] range of the s8 kernels.
+ */
+__STATIC_FORCEINLINE q31_t arm_nn_x86_dot_q7_with_offset(const q7_t *lhs,
+                                                         const q7_t *rhs,
+                                                         const int32_t len,
+                                                         const q31_t lhs_offset,
+                                                         const q31_t rhs_offset)
+{
+    const __m128i lhs_offset_vec = _mm_set1_epi16((q15_t)lhs_offset);
+    const __m128i rhs_offset_vec = _mm_set1_epi16((q15_t)rhs_offset);
+    __m128i acc = _mm_setzero_si128();
+    int32_t i = 0;
+
+#if defined(__AVX2__)
+    if (len >= 16)
+    {
+        const __m256i lhs_offset_vec_256 = _mm256_set1_epi16((q15_t)lhs_offset);
+        const __m256i rhs_offset_vec_256 = _mm256_set1_epi16((q15_t)rhs_offset);
+        __m256i acc_256 = _mm256_setzero_si256();
+
+        for (; i <= (len - 16); i += 16)
+        {
+            const __m256i lhs_vec = _mm256_add_epi16(arm_nn_x86_read_q7_to_q15(lhs + i), lhs_offset_vec_256);
+            const __m256i rhs_vec = _mm256_add_epi16(arm_nn_x86_read_q7_to_q15(rhs + i), rhs_offset_vec_256);
+            acc_256 = arm_nn_x86_smlad(lhs_vec, rhs_vec, acc_256);
+        }
+        acc = _mm_add_epi32(_mm256_castsi256_si128(acc_256), _mm256_extracti128_si256(acc_256, 1));
+    }
+#endif
+    for (; i <= (len - 8); i += 8)
+    {
+        const __m128i lhs_vec = _mm_add_epi16(_mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(lhs + i))), lhs_offset_vec);
+        const __m128i rhs_vec = _mm_add_epi16(_mm_cvtepi8_epi16(_mm_loadl_epi64((const __m128i *)(rhs + i))), rhs_offset_vec);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(lhs_vec, rhs_vec));
+    }
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(1, 0, 3, 2)));
+    acc = _mm_add_epi32(acc, _mm_shuffle_epi32(acc, _MM_SHUFFLE(2, 3, 0, 1)));
+
+    q31_t res = _mm_cvtsi128_si32(acc);
+    for (; i < len; i++)
+    {
+        res += (lhs[i] + lhs_offset) * (rhs[i] + rhs_offset);
+    }
+    return res;
+}
+
+#endif
+
 
 
 /**
@@ -742,6 +979,25 @@ __STATIC_FORCEINLINE q31_t arm_nn_requantize(const q31_t val, const q31_t multip
                                        RIGHT_SHIFT(shift));
 }
 
+/**
+ * @brief           Requantize a given 64-bit value.
+ * @param[in]       val         Value to be requantized
+ * @param[in]       multiplier  multiplier
+ * @param[in]       shift       left or right shift for 'val * multiplier'
+ *
+ * @return          Returns (val * multiplier)/(2 ^ shift)
+ *
+ * @details         The multiplier is reduced to 16 bits first so that the product fits in 64 bits. This matches
+ *                  MultiplyByQuantizedMultiplier() for int64 values in TensorFlow Lite.
+ *
+ */
+__STATIC_FORCEINLINE q31_t arm_nn_requantize_s64(const q63_t val, const q31_t multiplier, const q31_t shift)
+{
+  const q63_t reduced_multiplier = ((q63_t)multiplier + (1 << 15)) >> 16;
+  const int32_t total_shift = 15 - shift;
+  return (q31_t)((val * reduced_multiplier + ((q63_t)1 << (total_shift - 1))) >> total_shift);
+}
+
 /**
  * @brief           memcpy optimized for MVE
  * @param[in, out]  dst         Destination pointer
@@ -61,13 +61,13 @@ arm_status arm_convolve_1_x_n_s8(const cmsis_nn_context* ctx,
                                  q7_t *output_data)
 {
     arm_status status = ARM_MATH_SUCCESS;
+
+#if defined(ARM_MATH_MVEI)
     if (output_dims->w % 4 != 0)
     {
-        status = ARM_MATH_SIZE_MISMATCH;
-        goto out;
+        return ARM_MATH_SIZE_MISMATCH;
     }
 
-#if defined(ARM_MATH_MVEI)
     q15_t *buffer_a = (q15_t *)ctx->buf;
 
     const uint16_t input_x   = input_dims->w;
@@ -163,20 +163,92 @@ arm_status arm_convolve_1_x_n_s8(const cmsis_nn_context* ctx,
     }
 
 #else
-    status = arm_convolve_s8(ctx,
-                             conv_params,
-                             quant_params,
-                             input_dims,
-                             input_data,
-                             filter_dims,
-                             filter_data,
-                             bias_dims,
-                             bias_data,
-                             output_dims,
-                             output_data);
+    /* Temporal (1xN) convolution works directly on the NWC input, since every
+     * kernel window is a contiguous run of kernel_x * input_ch elements. No
+     * im2col buffer is needed and four output columns share one pass over the
+     * filter row. Columns whose window is clipped by the padding only use the
+     * valid part of the kernel. */
+    (void)ctx;
+    (void)bias_dims;
+
+    const int32_t input_x   = input_dims->w;
+    const int32_t kernel_x  = filter_dims->w;
+    const int32_t output_x  = output_dims->w;
+    const int32_t output_ch = output_dims->c;
+    const int32_t input_ch  = input_dims->c;
+    const int32_t pad_x     = conv_params->padding.w;
+    const int32_t stride_x  = conv_params->stride.w;
+
+    const int32_t input_offset       = conv_params->input_offset;
+    const int32_t out_offset         = conv_params->output_offset;
+    const int32_t out_activation_min = conv_params->activation.min;
+    const int32_t out_activation_max = conv_params->activation.max;
+    const int32_t *output_mult       = quant_params->multiplier;
+    const int32_t *output_shift      = quant_params->shift;
+    const int32_t row_elements       = kernel_x * input_ch;
+
+    int32_t i_out_x = 0;
+    while (i_out_x < output_x)
+    {
+        const int32_t est_input_x_idx = stride_x * i_out_x - pad_x;
+
+        if ((i_out_x + 4 <= output_x) && (est_input_x_idx >= 0) &&
+            (est_input_x_idx + 3 * stride_x + kernel_x <= input_x))
+        {
+            const q7_t *ip = input_data + est_input_x_idx * input_ch;
+            for (int i_out_ch = 0; i_out_ch < output_ch; i_out_ch++)
+            {
+                int32_t sum_row;
+                int32_t acc[4];
+                (void)arm_nn_mat_mul_core_4x_s8(row_elements,
+                                                stride_x * input_ch,
+                                                ip,
+                                                filter_data + row_elements * i_out_ch,
+                                                &sum_row,
+                                                acc);
+                const int32_t offset = sum_row * input_offset +
+                                       (bias_data ? bias_data[i_out_ch] : 0);
+                for (int i = 0; i < 4; i++)
+                {
+                    int32_t res = acc[i] + offset;
+                    res = arm_nn_requantize(res, output_mult[i_out_ch], output_shift[i_out_ch]);
+                    res += out_offset;
+                    res = MAX(res, out_activation_min);
+                    res = MIN(res, out_activation_max);
+                    output_data[i * output_ch + i_out_ch] = (q7_t)res;
+                }
+            }
+            output_data += 4 * output_ch;
+            i_out_x += 4;
+        }
+        else
+        {
+            const int32_t input_begin_idx = MAX(0, est_input_x_idx);
+            const int32_t ker_begin_idx = MAX(0, -est_input_x_idx);
+            const int32_t ker_end_idx = MIN(kernel_x, input_x - est_input_x_idx);
+            for (int i_out_ch = 0; i_out_ch < output_ch; i_out_ch++)
+            {
+                int32_t sum_row;
+                int32_t acc;
+                (void)arm_nn_mat_mul_core_1x_s8((ker_end_idx - ker_begin_idx) * input_ch,
+                                                input_data + input_begin_idx * input_ch,
+                                                filter_data + row_elements * i_out_ch + ker_begin_idx * input_ch,
+                                                &sum_row,
+                                                &acc);
+                int32_t res = acc + sum_row * input_offset +
+                              (bias_data ? bias_data[i_out_ch] : 0);
+                res = arm_nn_requantize(res, output_mult[i_out_ch], output_shift[i_out_ch]);
+                res += out_offset;
+                res = MAX(res, out_activation_min);
+                res = MIN(res, out_activation_max);
+                output_data[i_out_ch] = (q7_t)res;
+            }
+            output_data += output_ch;
+            i_out_x++;
+        }
+    }
 #endif
 
-out:
     /* Return to application */
     return status;
 }
@@ -184,13 +256,9 @@ out:
 int32_t arm_convolve_1_x_n_s8_get_buffer_size(const cmsis_nn_dims* input_dims,
                                               const cmsis_nn_dims* filter_dims)
 {
-#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
-    return (2 * input_dims->c * filter_dims->w * filter_dims->h) * sizeof(int16_t);
-#else
     (void)input_dims;
     (void)filter_dims;
     return 0;
-#endif
 }
 
 /**
@@ -0,0 +1,229 @@
+/*
+ * Copyright (C) 2010-2020 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_s16.c
+ * Description:  s16 version of convolution using symmetric quantization.
+ *
+ * $Date:        October 2020
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+
+#include "cmsis/CMSIS/DSP/Include/arm_math.h"
+#include "cmsis/CMSIS/NN/Include/arm_nn_types.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+/*
+   * Basic s16 convolution function.
+   *
+   * Refer header file for details. The DSP implementation reads the input directly when a kernel row is
+   * contiguous in memory, as it is for temporal (1xN) convolutions, and falls back to im2col otherwise.
+   *
+   */
+
+arm_status arm_convolve_s16(const cmsis_nn_context* ctx,
+                            const cmsis_nn_conv_params* conv_params,
+                            const cmsis_nn_per_channel_quant_params* quant_params,
+                            const cmsis_nn_dims* input_dims,
+                            const q15_t *input_data,
+                            const cmsis_nn_dims* filter_dims,
+                            const q7_t *filter_data,
+                            const cmsis_nn_dims* bias_dims,
+                            const int64_t *bias_data,
+                            const cmsis_nn_dims* output_dims,
+                            q15_t *output_data)
+{
+    (void)bias_dims;
+    q15_t *buffer_a = (q15_t *)ctx->buf;
+
+    const int32_t input_batches = input_dims->n;
+    const int32_t input_x       = input_dims->w;
+    const int32_t input_y       = input_dims->h;
+    const int32_t input_ch      = input_dims->c;
+    const int32_t kernel_x      = filter_dims->w;
+    const int32_t kernel_y      = filter_dims->h;
+    const int32_t output_x      = output_dims->w;
+    const int32_t output_y      = output_dims->h;
+    const int32_t output_ch     = output_dims->c;
+
+    const int32_t pad_x         = conv_params->padding.w;
+    const int32_t pad_y         = conv_params->padding.h;
+    const int32_t stride_x      = conv_params->stride.w;
+    const int32_t stride_y      = conv_params->stride.h;
+    const int32_t dilation_x    = conv_params->dilation.w;
+    const int32_t dilation_y    = conv_params->dilation.h;
+
+    const int32_t out_activation_min = conv_params->activation.min;
+    const int32_t out_activation_max = conv_params->activation.max;
+    int32_t *output_mult             = quant_params->multiplier;
+    int32_t *output_shift            = quant_params->shift;
+
+    int i_batch;
+    for (i_batch = 0; i_batch < input_batches; i_batch++)
+    {
+#if defined(ARM_MATH_DSP)
+        const int32_t num_elem = kernel_x * kernel_y * input_ch;
+        int32_t i_out_y, i_out_x, i_out_ch, i_ker_y, i_ker_x;
+        q15_t *out = output_data;
+
+        for (i_out_y = 0; i_out_y < output_y; i_out_y++)
+        {
+            for (i_out_x = 0; i_out_x < output_x; i_out_x++)
+            {
+                const int32_t base_idx_y = stride_y * i_out_y - pad_y;
+                const int32_t base_idx_x = stride_x * i_out_x - pad_x;
+                const q15_t *col;
+
+                if (kernel_y == 1 && dilation_x == 1 && base_idx_y >= 0 && base_idx_y < input_y &&
+                    base_idx_x >= 0 && base_idx_x + kernel_x <= input_x)
+                {
+                    /* The receptive field is a contiguous run of the input */
+                    col = input_data + (base_idx_y * input_x + base_idx_x) * input_ch;
+                }
+                else
+                {
+                    /* This part implements the im2col function */
+                    q15_t *im2col_buf = buffer_a;
+                    for (i_ker_y = 0; i_ker_y < kernel_y; i_ker_y++)
+                    {
+                        const int32_t in_row = base_idx_y + dilation_y * i_ker_y;
+                        for (i_ker_x = 0; i_ker_x < kernel_x; i_ker_x++)
+                        {
+                            const int32_t in_col = base_idx_x + dilation_x * i_ker_x;
+                            if (in_row < 0 || in_row >= input_y || in_col < 0 || in_col >= input_x)
+                            {
+                                /* Filling 0 for out-of-bound paddings */
+                                memset(im2col_buf, 0, sizeof(q15_t) * input_ch);
+                            }
+                            else
+                            {
+                                /* Copying the pixel data to column */
+                                memcpy(im2col_buf, input_data + (in_row * input_x + in_col) * input_ch,
+                                       sizeof(q15_t) * input_ch);
+                            }
+                            im2col_buf += input_ch;
+                        }
+                    }
+                    col = buffer_a;
+                }
+
+                for (i_out_ch = 0; i_out_ch < output_ch; i_out_ch++)
+                {
+                    q63_t sum;
+                    q31_t result;
+
+                    (void)arm_nn_mat_mul_core_1x_s16(num_elem, filter_data + i_out_ch * num_elem, col, &sum);
+                    if (bias_data)
+                    {
+                        sum += bias_data[i_out_ch];
+                    }
+
+                    result = arm_nn_requantize_s64(sum, output_mult[i_out_ch], output_shift[i_out_ch]);
+                    result = MAX(result, out_activation_min);
+                    result = MIN(result, out_activation_max);
+                    *out++ = (q15_t)result;
+                }
+            }
+        }
+#else
+        /* Run the following code as reference implementation for Cortex-M0 and Cortex-M3 */
+        (void)buffer_a;
+        int32_t i_out_ch, i_out_y, i_out_x, i_input_ch, i_ker_y, i_ker_x;
+        q63_t conv_out;
+        q31_t result;
+
+        for (i_out_ch = 0; i_out_ch < output_ch; i_out_ch++)
+        {
+            for (i_out_y = 0; i_out_y < output_y; i_out_y++)
+            {
+                for (i_out_x = 0; i_out_x < output_x; i_out_x++)
+                {
+                    conv_out = bias_data ? bias_data[i_out_ch] : 0;
+
+                    const int32_t base_idx_y = stride_y * i_out_y - pad_y;
+                    const int32_t base_idx_x = stride_x * i_out_x - pad_x;
+
+                    for (i_ker_y = 0; i_ker_y < kernel_y; i_ker_y++)
+                    {
+                        const int32_t in_row = base_idx_y + dilation_y * i_ker_y;
+                        if (in_row < 0 || in_row >= input_y)
+                        {
+                            continue;
+                        }
+                        for (i_ker_x = 0; i_ker_x < kernel_x; i_ker_x++)
+                        {
+                            const int32_t in_col = base_idx_x + dilation_x * i_ker_x;
+                            if (in_col < 0 || in_col >= input_x)
+                            {
+                                continue;
+                            }
+                            for (i_input_ch = 0; i_input_ch < input_ch; i_input_ch++)
+                            {
+                                conv_out +=
+                                    (int32_t)input_data[(in_row * input_x + in_col) * input_ch + i_input_ch] *
+                                    filter_data[i_out_ch * input_ch * kernel_y * kernel_x +
+                                           (i_ker_y * kernel_x + i_ker_x) * input_ch + i_input_ch];
+                            }
+                        }
+                    }
+                    result = arm_nn_requantize_s64(conv_out, output_mult[i_out_ch], output_shift[i_out_ch]);
+                    result = MAX(result, out_activation_min);
+                    result = MIN(result, out_activation_max);
+                    output_data[i_out_ch + (i_out_y * output_x + i_out_x) * output_ch] = (int16_t)result;
+                }
+            }
+        }
+#endif
+        /* Advance to the next batch */
+        input_data += (input_x * input_y * input_ch);
+        output_data += (output_x * output_y * output_ch);
+    }
+
+    /* Return to application */
+    return ARM_MATH_SUCCESS;
+}
+
+int32_t arm_convolve_s16_get_buffer_size(const cmsis_nn_dims* input_dims,
+                                         const cmsis_nn_dims* filter_dims)
+{
+#if defined(ARM_MATH_DSP)
+    return (input_dims->c * filter_dims->w * filter_dims->h) * sizeof(int16_t);
+#else
+    (void)input_dims;
+    (void)filter_dims;
+    return 0;
+#endif
+}
+
+/**
+ * @} end of NNConv group
+ */
@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2010-2020 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_convolve_s8_packed.c
+ * Description:  s8 convolution with the filter packed ahead of time for
+ *               the SXTB16 sign extension of the DSP extension.
+ *
+ * $Date:        October 17, 2020
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+#include "cmsis/CMSIS/DSP/Include/arm_math.h"
+#include "cmsis/CMSIS/NN/Include/arm_nn_types.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup NNConv
+ * @{
+ */
+
+/*
+ * The packed layout swaps the two middle values of every group of four filter values, so that
+ * read_and_pad_reordered() expands the group in its original order without the two PKHBT/PKHTB
+ * instructions of read_and_pad(). The swap is its own inverse.
+ */
+
+int32_t arm_convolve_s8_packed_filter_size(const cmsis_nn_dims* input_dims,
+                                           const cmsis_nn_dims* filter_dims)
+{
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+    const int32_t col_len = input_dims->c * filter_dims->w * filter_dims->h;
+    /* arm_nn_mat_mult_kernel_s8_s16_reordered() has no tail for the last columns */
+    if (col_len % 4 == 0)
+    {
+        return filter_dims->n * col_len * sizeof(q7_t);
+    }
+#else
+    (void)input_dims;
+    (void)filter_dims;
+#endif
+    return 0;
+}
+
+void arm_convolve_s8_pack_filter(const cmsis_nn_dims* input_dims,
+                                 const cmsis_nn_dims* filter_dims,
+                                 const q7_t *filter_data,
+                                 q7_t *packed_filter)
+{
+    const int32_t size = filter_dims->n * filter_dims->h * filter_dims->w * input_dims->c;
+    int32_t i;
+
+    for (i = 0; i < size; i += 4)
+    {
+        packed_filter[i] = filter_data[i];
+        packed_filter[i + 1] = filter_data[i + 2];
+        packed_filter[i + 2] = filter_data[i + 1];
+        packed_filter[i + 3] = filter_data[i + 3];
+    }
+}
+
+/*
+ * s8 convolution with a packed filter.
+ *
+ * Refer header file for details.
+ *
+ */
+
+arm_status arm_convolve_s8_packed(const cmsis_nn_context* ctx,
+                                  const cmsis_nn_conv_params* conv_params,
+                                  const cmsis_nn_per_channel_quant_params* quant_params,
+                                  const cmsis_nn_dims* input_dims,
+                                  const q7_t *input_data,
+                                  const cmsis_nn_dims* filter_dims,
+                                  const q7_t *packed_filter_data,
+                                  const cmsis_nn_dims* bias_dims,
+                                  const int32_t *bias_data,
+                                  const cmsis_nn_dims* output_dims,
+                                  q7_t *output_data)
+{
+    (void)bias_dims;
+    if (arm_convolve_s8_packed_filter_size(input_dims, filter_dims) == 0)
+    {
+        return ARM_MATH_ARGUMENT_ERROR;
+    }
+
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+    q15_t *buffer_a = (q15_t *)ctx->buf;
+
+    const uint16_t input_batches = input_dims->n;
+    const uint16_t input_x       = input_dims->w;
+    const uint16_t input_y       = input_dims->h;
+    const uint16_t input_ch      = input_dims->c;
+    const uint16_t kernel_x      = filter_dims->w;
+    const uint16_t kernel_y      = filter_dims->h;
+    const uint16_t output_x      = output_dims->w;
+    const uint16_t output_y      = output_dims->h;
+    const uint16_t output_ch     = output_dims->c;
+
+    const uint16_t pad_x         = conv_params->padding.w;
+    const uint16_t pad_y         = conv_params->padding.h;
+    const uint16_t stride_x      = conv_params->stride.w;
+    const uint16_t stride_y      = conv_params->stride.h;
+
+    const int32_t input_offset       = conv_params->input_offset;
+    const int32_t out_offset         = conv_params->output_offset;
+    const int32_t out_activation_min = conv_params->activation.min;
+    const int32_t out_activation_max = conv_params->activation.max;
+    int32_t *output_mult             = quant_params->multiplier;
+    int32_t *output_shift            = quant_params->shift;
+
+    int i_batch;
+    for (i_batch = 0; i_batch < input_batches; i_batch++)
+    {
+        int32_t i_out_y, i_out_x, i_ker_y, i_ker_x;
+
+        /* Generate two columns from the input tensor a GEMM computation */
+        q15_t *two_column_buf = buffer_a;
+        q7_t *out = output_data;
+
+        /* This part implements the im2col function */
+        for (i_out_y = 0; i_out_y < output_y; i_out_y++)
+        {
+            for (i_out_x = 0; i_out_x < output_x; i_out_x++)
+            {
+                for (i_ker_y = i_out_y * stride_y - pad_y; i_ker_y < i_out_y * stride_y - pad_y + kernel_y; i_ker_y++)
+                {
+                    for (i_ker_x = i_out_x * stride_x - pad_x; i_ker_x < i_out_x * stride_x - pad_x + kernel_x; i_ker_x++)
+                    {
+                        if (i_ker_y < 0 || i_ker_y >= input_y || i_ker_x < 0 || i_ker_x >= input_x)
+                        {
+                            /* Filling 0 for out-of-bound paddings */
+                            memset(two_column_buf, 0, sizeof(q15_t) * input_ch);
+                        }
+                        else
+                        {
+                            /* Copying the pixel data to column */
+                            arm_q7_to_q15_with_offset(input_data + (i_ker_y * input_x + i_ker_x) * input_ch, two_column_buf, input_ch, input_offset);
+                        }
+                        two_column_buf += input_ch;
+                    }
+                }
+
+                /* Computation is filed for every 2 columns */
+                if (two_column_buf == buffer_a + 2 * input_ch * kernel_y * kernel_x)
+                {
+                    out =
+                        arm_nn_mat_mult_kernel_s8_s16_reordered(packed_filter_data,
+                                                                buffer_a,
+                                                                output_ch,
+                                                                output_shift,
+                                                                output_mult,
+                                                                out_offset,
+                                                                out_activation_min,
+                                                                out_activation_max,
+                                                                input_ch * kernel_y * kernel_x,
+                                                                bias_data,
+                                                                out);
+
+                    /* counter reset */
+                    two_column_buf = buffer_a;
+                }
+            }
+        }
+
+        /* left-over because odd number of output pixels */
+        if (two_column_buf != buffer_a)
+        {
+            const q7_t *ker_a = packed_filter_data;
+            int i;
+
+            for (i = 0; i < output_ch; i++)
+            {
+                /* Load the accumulator with bias first */
+                q31_t sum = bias_data[i];
+
+                /* Point to the beginning of the im2col buffer where the input is available as a rearranged column */
+                const q15_t *ip_as_col = buffer_a;
+
+                /* 4 multiply and accumulates are done in one loop. The column length is a multiple of 4. */
+                uint16_t col_count = (input_ch * kernel_y * kernel_x) >> 2;
+
+                while (col_count)
+                {
+                    q31_t ker_a1, ker_a2;
+                    q31_t ip_b1, ip_b2;
+
+                    ker_a = read_and_pad_reordered(ker_a, &ker_a1, &ker_a2);
+
+                    ip_b1 = arm_nn_read_q15x2_ia(&ip_as_col);
+                    sum = __SMLAD(ker_a1, ip_b1, sum);
+                    ip_b2 = arm_nn_read_q15x2_ia(&ip_as_col);
+                    sum = __SMLAD(ker_a2, ip_b2, sum);
+
+                    col_count--;
+                }
+
+                sum = arm_nn_requantize(sum, output_mult[i], output_shift[i]);
+                sum += out_offset;
+                sum = MAX(sum, out_activation_min);
+                sum = MIN(sum, out_activation_max);
+                *out++ = (q7_t)sum;
+            }
+        }
+
+        /* Advance to the next batch */
+        input_data += (input_x * input_y * input_ch);
+        output_data += (output_x * output_y * output_ch);
+    }
+
+    /* Return to application */
+    return ARM_MATH_SUCCESS;
+#else
+    (void)ctx;
+    (void)conv_params;
+    (void)quant_params;
+    (void)input_data;
+    (void)packed_filter_data;
+    (void)bias_data;
+    (void)output_dims;
+    (void)output_data;
+    return ARM_MATH_ARGUMENT_ERROR;
+#endif
+}
+
+/**
+ * @} end of NNConv group
+ */
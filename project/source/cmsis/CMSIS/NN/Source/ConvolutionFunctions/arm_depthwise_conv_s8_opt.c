@@ -383,6 +383,86 @@ arm_status arm_depthwise_conv_s8_opt(const q7_t *input,
         }
     }
 
+#elif defined(ARM_NN_X86_SIMD)
+    /* Accumulates ARM_NN_X86_S32_LANES channels at a time directly from the
+     * input, so no im2col buffer is needed. Like the reference implementation
+     * this ignores dilation. */
+    (void)dilation_x;
+    (void)dilation_y;
+    (void)buffer_a;
+
+    const arm_nn_x86_vec_t input_offset_vec = arm_nn_x86_dup_q31(input_offset);
+    q31_t acc[ARM_NN_X86_S32_LANES];
+
+    for (int32_t i_out_y = 0; i_out_y < output_y; i_out_y++)
+    {
+        const int32_t base_idx_y = (i_out_y * stride_y) - pad_y;
+        const int32_t ker_y_start = MAX(0, -base_idx_y);
+        const int32_t ker_y_end = MIN(kernel_y, input_y - base_idx_y);
+
+        for (int32_t i_out_x = 0; i_out_x < output_x; i_out_x++)
+        {
+            const int32_t base_idx_x = (i_out_x * stride_x) - pad_x;
+            const int32_t ker_x_start = MAX(0, -base_idx_x);
+            const int32_t ker_x_end = MIN(kernel_x, input_x - base_idx_x);
+            int32_t i_ch = 0;
+
+            for (; i_ch <= (input_ch - ARM_NN_X86_S32_LANES); i_ch += ARM_NN_X86_S32_LANES)
+            {
+                arm_nn_x86_vec_t acc_vec = arm_nn_x86_read_q31(&bias[i_ch]);
+
+                for (int32_t i_ker_y = ker_y_start; i_ker_y < ker_y_end; i_ker_y++)
+                {
+                    const q7_t *input_ptr = input + ((base_idx_y + i_ker_y) * input_x + base_idx_x + ker_x_start) * input_ch + i_ch;
+                    const q7_t *kernel_ptr = kernel + (i_ker_y * kernel_x + ker_x_start) * input_ch + i_ch;
+
+                    for (int32_t i_ker_x = ker_x_start; i_ker_x < ker_x_end; i_ker_x++)
+                    {
+                        const arm_nn_x86_vec_t in = arm_nn_x86_add_q31(arm_nn_x86_read_q7_to_q31(input_ptr), input_offset_vec);
+                        acc_vec = arm_nn_x86_mla_q31(acc_vec, in, arm_nn_x86_read_q7_to_q31(kernel_ptr));
+                        input_ptr += input_ch;
+                        kernel_ptr += input_ch;
+                    }
+                }
+                arm_nn_x86_write_q31(acc, acc_vec);
+
+                for (int32_t i = 0; i < ARM_NN_X86_S32_LANES; i++)
+                {
+                    q31_t res = arm_nn_requantize(acc[i], output_mult[i_ch + i], output_shift[i_ch + i]);
+                    res += output_offset;
+                    res = MAX(res, output_activation_min);
+                    res = MIN(res, output_activation_max);
+                    output[i] = (q7_t)res;
+                }
+                output += ARM_NN_X86_S32_LANES;
+            }
+
+            // Leftover channels
+            for (; i_ch < input_ch; i_ch++)
+            {
+                q31_t res = bias[i_ch];
+
+                for (int32_t i_ker_y = ker_y_start; i_ker_y < ker_y_end; i_ker_y++)
+                {
+                    const q7_t *input_ptr = input + ((base_idx_y + i_ker_y) * input_x + base_idx_x + ker_x_start) * input_ch + i_ch;
+                    const q7_t *kernel_ptr = kernel + (i_ker_y * kernel_x + ker_x_start) * input_ch + i_ch;
+
+                    for (int32_t i_ker_x = ker_x_start; i_ker_x < ker_x_end; i_ker_x++)
+                    {
+                        res += (*input_ptr + input_offset) * *kernel_ptr;
+                        input_ptr += input_ch;
+                        kernel_ptr += input_ch;
+                    }
+                }
+
+                res = arm_nn_requantize(res, output_mult[i_ch], output_shift[i_ch]);
+                res += output_offset;
+                res = MAX(res, output_activation_min);
+                res = MIN(res, output_activation_max);
+                *output++ = (q7_t)res;
+            }
+        }
+    }
 #else
     (void)buffer_a;
     /* Run the following code as reference implementation for Cortex-M0 and Cortex-M3 */
@@ -412,7 +492,7 @@ arm_status arm_depthwise_conv_s8_opt(const q7_t *input,
                                  dilation_x,
                                  dilation_y,
                                  NULL);
-#endif /* ARM_MATH_MVEI | ARM_MATH_DSP */
+#endif /* ARM_MATH_MVEI | ARM_MATH_DSP | ARM_NN_X86_SIMD */
 
     /* Return to application */
     return ARM_MATH_SUCCESS;
@@ -0,0 +1,137 @@
+/*
+ * Copyright (C) 2010-2020 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_fully_connected_s8_sparse.c
+ * Description:  Fully connected function compatible with TF Lite, for
+ *               weights stored as nonzero blocks.
+ *
+ * $Date:        October 17, 2020
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+
+#include "cmsis/CMSIS/DSP/Include/arm_math.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup FC
+ * @{
+ */
+
+/*
+   * S8 fully-connected layer function for TensorFlow Lite with block-sparse weights
+   *
+   * Refer header file for details.
+   *
+   */
+
+arm_status
+arm_fully_connected_s8_sparse(const int8_t *input,
+                              const int8_t *kernel,
+                              const int32_t *block_segments,
+                              const int32_t *block_indices,
+                              const uint16_t block_rows,
+                              const uint16_t block_cols,
+                              const uint16_t col_dim,
+                              const uint16_t row_dim,
+                              const uint16_t nb_batches,
+                              const int32_t input_offset,
+                              const int32_t filter_offset,
+                              const int32_t out_mult,
+                              const int32_t out_shift,
+                              const int32_t output_offset,
+                              const int32_t *bias,
+                              int8_t *output,
+                              const int32_t output_activation_min,
+                              const int32_t output_activation_max)
+{
+    if (block_rows == 0 || block_cols == 0 || row_dim % block_rows || col_dim % block_cols)
+    {
+        return ARM_MATH_SIZE_MISMATCH;
+    }
+
+    const int32_t block_size = block_rows * block_cols;
+    const int32_t num_block_rows = row_dim / block_rows;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+    const int16_t input_offset_s16 = input_offset;
+    const int16_t filter_offset_s16 = filter_offset;
+    const uint32_t input_offset_s16x2 = __PKHBT(input_offset_s16, input_offset_s16, 16);
+    const uint32_t filter_offset_s16x2 = __PKHBT(filter_offset_s16, filter_offset_s16, 16);
+#endif
+
+    for (int32_t batch = 0; batch < nb_batches; batch++)
+    {
+        for (int32_t block_row = 0; block_row < num_block_rows; block_row++)
+        {
+            const int32_t block_start = block_segments[block_row];
+            const int32_t block_end = block_segments[block_row + 1];
+
+            for (int32_t i = 0; i < block_rows; i++)
+            {
+                const int32_t row = block_row * block_rows + i;
+                q31_t acc = bias ? bias[row] : 0;
+
+                for (int32_t block = block_start; block < block_end; block++)
+                {
+                    const q7_t *kernel_ptr = kernel + block * block_size + i * block_cols;
+                    const q7_t *input_ptr = input + block_indices[block] * block_cols;
+                    int32_t col = 0;
+#if defined(ARM_MATH_DSP) && !defined(ARM_MATH_MVEI)
+                    for (; col <= block_cols - 4; col += 4)
+                    {
+                        const q31_t kernel_val = arm_nn_read_q7x4_ia(&kernel_ptr);
+                        const q31_t input_val = arm_nn_read_q7x4_ia(&input_ptr);
+                        const q31_t kernel_even = __SXTAB16(filter_offset_s16x2, kernel_val);
+                        const q31_t kernel_odd = __SXTAB16(filter_offset_s16x2, __ROR(kernel_val, 8));
+                        const q31_t input_even = __SXTAB16(input_offset_s16x2, input_val);
+                        const q31_t input_odd = __SXTAB16(input_offset_s16x2, __ROR(input_val, 8));
+                        acc = __SMLAD(input_even, kernel_even, acc);
+                        acc = __SMLAD(input_odd, kernel_odd, acc);
+                    }
+#endif
+                    for (; col < block_cols; col++)
+                    {
+                        acc += (*input_ptr++ + input_offset) * (*kernel_ptr++ + filter_offset);
+                    }
+                }
+
+                acc = arm_nn_requantize(acc, out_mult, out_shift);
+                acc += output_offset;
+                acc = MAX(acc, output_activation_min);
+                acc = MIN(acc, output_activation_max);
+                output[row] = (q7_t)acc;
+            }
+        }
+        input += col_dim;
+        output += row_dim;
+    }
+    return (ARM_MATH_SUCCESS);
+}
+
+/**
+ * @} end of FC group
+ */
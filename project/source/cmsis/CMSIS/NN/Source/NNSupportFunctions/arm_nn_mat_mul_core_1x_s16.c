@@ -0,0 +1,105 @@
+/*
+ * Copyright (C) 2010-2020 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_nn_mat_mul_core_1x_s16.c
+ * Description:  s16 x s8 matrix-multiplication core for one row & one column
+ *
+ * $Date:        October 2020
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ * -------------------------------------------------------------------- */
+
+#include "cmsis/CMSIS/DSP/Include/arm_math.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnsupportfunctions.h"
+
+/* Each iteration of the DSP loop does two __SMLAD, i.e. four s8 x s16
+ * products of at most 2^22 each, so the 32-bit accumulator can take 127
+ * iterations before it has to be flushed into the 64-bit one. */
+#define MAX_COL_BLOCK_COUNT (127)
+
+/**
+ * @ingroup groupSupport
+ */
+
+/**
+ * @addtogroup NNBasicMath
+ * @{
+ */
+
+/*
+   * s16 x s8 matrix multiplication to process 1 row
+   *
+   * Refer header file for details.
+   *
+   */
+
+arm_status arm_nn_mat_mul_core_1x_s16(int32_t row_elements,
+                                      const int8_t *row_base,
+                                      const int16_t *col_base,
+                                      int64_t *const output)
+{
+    int64_t acc_n0 = 0;
+
+#if defined(ARM_MATH_DSP)
+    int32_t col_count = row_elements >> 2;
+
+    while (col_count)
+    {
+        int32_t block_count = MIN(col_count, MAX_COL_BLOCK_COUNT);
+        q31_t acc_block = 0;
+
+        col_count -= block_count;
+        while (block_count)
+        {
+            q31_t row_a, row_b;
+            q31_t col_a, col_b;
+
+            row_base = read_and_pad(row_base, &row_a, &row_b);
+
+            col_a = arm_nn_read_q15x2_ia(&col_base);
+            acc_block = __SMLAD(row_a, col_a, acc_block);
+            col_b = arm_nn_read_q15x2_ia(&col_base);
+            acc_block = __SMLAD(row_b, col_b, acc_block);
+
+            block_count--;
+        }
+        acc_n0 += acc_block;
+    }
+
+    /* Handle left over mac */
+    col_count = row_elements & 0x3;
+#else
+    int32_t col_count = row_elements;
+#endif
+    while (col_count)
+    {
+        acc_n0 += (int32_t)*row_base++ * *col_base++;
+        col_count--;
+    }
+
+    *output = acc_n0;
+    return ARM_MATH_SUCCESS;
+}
+
+/**
+ * @} end of NNBasicMath group
+ */
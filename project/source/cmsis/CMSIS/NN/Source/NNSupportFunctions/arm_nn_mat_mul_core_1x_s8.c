@@ -74,7 +74,36 @@ arm_status arm_nn_mat_mul_core_1x_s8(int32_t row_elements,
            :[cnt] "r"(row_elements)
            :"q0","q1", "memory", "r14");
 #else
-    for (int i = 0; i < row_elements; i++)
+    int32_t i = 0;
+#if defined(ARM_MATH_DSP)
+    for (; i <= (row_elements - 4); i += 4)
+    {
+        q31_t col_a, col_b;
+        q31_t row_a, row_b;
+
+        read_and_pad(col_base + i, &col_a, &col_b);
+        sum_tmp = __SMLAD(col_a, 0x00010001, sum_tmp);
+        sum_tmp = __SMLAD(col_b, 0x00010001, sum_tmp);
+
+        read_and_pad(row_base + i, &row_a, &row_b);
+        acc_n0 = __SMLAD(row_a, col_a, acc_n0);
+        acc_n0 = __SMLAD(row_b, col_b, acc_n0);
+    }
+#elif defined(ARM_NN_X86_SIMD)
+    const arm_nn_x86_vec_t ones = arm_nn_x86_dup_q15(1);
+    arm_nn_x86_vec_t sum_vec = arm_nn_x86_dup_q31(0);
+    arm_nn_x86_vec_t acc_vec = sum_vec;
+
+    for (; i <= (row_elements - ARM_NN_X86_S16_LANES); i += ARM_NN_X86_S16_LANES)
+    {
+        const arm_nn_x86_vec_t col = arm_nn_x86_read_q7_to_q15(col_base + i);
+        sum_vec = arm_nn_x86_smlad(col, ones, sum_vec);
+        acc_vec = arm_nn_x86_smlad(arm_nn_x86_read_q7_to_q15(row_base + i), col, acc_vec);
+    }
+    sum_tmp = arm_nn_x86_reduce_q31(sum_vec);
+    acc_n0 = arm_nn_x86_reduce_q31(acc_vec);
+#endif
+    for (; i < row_elements; i++)
     {
         sum_tmp += col_base[i];
         acc_n0 += row_base[i] * col_base[i];
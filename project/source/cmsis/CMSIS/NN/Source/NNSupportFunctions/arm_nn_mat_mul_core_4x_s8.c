@@ -93,7 +93,61 @@ arm_status arm_nn_mat_mul_core_4x_s8(const int32_t row_elements,
         : [cnt] "r"(row_elements)
         : "q0", "q1", "q2", "q3", "q4", "memory", "r14");
 #else
-    for (int i = 0; i < row_elements; i++)
+    int32_t i = 0;
+#if defined(ARM_MATH_DSP)
+    /* Widen four int8 values at a time to two pairs of int16 and accumulate
+     * them with dual 16-bit multiply-accumulates. */
+    for (; i <= (row_elements - 4); i += 4)
+    {
+        q31_t col_a, col_b;
+        q31_t row_a, row_b;
+
+        read_and_pad(col_base + i, &col_a, &col_b);
+        sum_tmp = __SMLAD(col_a, 0x00010001, sum_tmp);
+        sum_tmp = __SMLAD(col_b, 0x00010001, sum_tmp);
+
+        read_and_pad(ip_row_0 + i, &row_a, &row_b);
+        acc_n0 = __SMLAD(row_a, col_a, acc_n0);
+        acc_n0 = __SMLAD(row_b, col_b, acc_n0);
+
+        read_and_pad(ip_row_1 + i, &row_a, &row_b);
+        acc_n1 = __SMLAD(row_a, col_a, acc_n1);
+        acc_n1 = __SMLAD(row_b, col_b, acc_n1);
+
+        read_and_pad(ip_row_2 + i, &row_a, &row_b);
+        acc_n2 = __SMLAD(row_a, col_a, acc_n2);
+        acc_n2 = __SMLAD(row_b, col_b, acc_n2);
+
+        read_and_pad(ip_row_3 + i, &row_a, &row_b);
+        acc_n3 = __SMLAD(row_a, col_a, acc_n3);
+        acc_n3 = __SMLAD(row_b, col_b, acc_n3);
+    }
+#elif defined(ARM_NN_X86_SIMD)
+    /* Same widening as above, ARM_NN_X86_S16_LANES values at a time. */
+    const arm_nn_x86_vec_t ones = arm_nn_x86_dup_q15(1);
+    arm_nn_x86_vec_t sum_vec = arm_nn_x86_dup_q31(0);
+    arm_nn_x86_vec_t acc_vec_0 = sum_vec;
+    arm_nn_x86_vec_t acc_vec_1 = sum_vec;
+    arm_nn_x86_vec_t acc_vec_2 = sum_vec;
+    arm_nn_x86_vec_t acc_vec_3 = sum_vec;
+
+    for (; i <= (row_elements - ARM_NN_X86_S16_LANES); i += ARM_NN_X86_S16_LANES)
+    {
+        const arm_nn_x86_vec_t col = arm_nn_x86_read_q7_to_q15(col_base + i);
+        sum_vec = arm_nn_x86_smlad(col, ones, sum_vec);
+
+        acc_vec_0 = arm_nn_x86_smlad(arm_nn_x86_read_q7_to_q15(ip_row_0 + i), col, acc_vec_0);
+        acc_vec_1 = arm_nn_x86_smlad(arm_nn_x86_read_q7_to_q15(ip_row_1 + i), col, acc_vec_1);
+        acc_vec_2 = arm_nn_x86_smlad(arm_nn_x86_read_q7_to_q15(ip_row_2 + i), col, acc_vec_2);
+        acc_vec_3 = arm_nn_x86_smlad(arm_nn_x86_read_q7_to_q15(ip_row_3 + i), col, acc_vec_3);
+    }
+    sum_tmp = arm_nn_x86_reduce_q31(sum_vec);
+    acc_n0 = arm_nn_x86_reduce_q31(acc_vec_0);
+    acc_n1 = arm_nn_x86_reduce_q31(acc_vec_1);
+    acc_n2 = arm_nn_x86_reduce_q31(acc_vec_2);
+    acc_n3 = arm_nn_x86_reduce_q31(acc_vec_3);
+#endif
+    for (; i < row_elements; i++)
     {
         int32_t col = col_base[i];
         sum_tmp += col;
@@ -33,11 +33,15 @@
 #include "cmsis/CMSIS/NN/Include/arm_nnsupportfunctions.h"
 
 // Work around for https://github.com/ARMmbed/mbed-os/issues/12568
+#if defined(CMSIS_DSP_EMULATION)
+#define __patched_SXTB16_RORn __SXTB16_RORn
+#else
 __STATIC_FORCEINLINE uint32_t __patched_SXTB16_RORn(uint32_t op1, uint32_t rotate) {
   uint32_t result;
   __ASM ("sxtb16 %0, %1, ROR %2" : "=r" (result) : "r" (op1), "i" (rotate) );
   return result;
 }
+#endif
 
 /**
  * @ingroup groupSupport
@@ -409,6 +413,33 @@ arm_status arm_nn_mat_mult_nt_t_s8(const q7_t *lhs,
             dst_ptr += rhs_rows;
         }
     }
+#elif defined(ARM_NN_X86_SIMD)
+    /* lhs_offset is folded into the 16-bit lhs values instead of being applied
+     * through the rhs row sums, which gives the same 32-bit result. */
+    for (int32_t lhs_rows_idx = 0; lhs_rows_idx < lhs_rows; ++lhs_rows_idx)
+    {
+        const q7_t *rhs_ptr = &rhs[0];
+
+        for (int32_t rhs_rows_idx = 0; rhs_rows_idx < rhs_rows; ++rhs_rows_idx)
+        {
+            q31_t res00 = bias[rhs_rows_idx] + arm_nn_x86_dot_q7_with_offset(lhs, rhs_ptr, rhs_cols, lhs_offset, 0);
+
+            // Quantize down
+            res00 = arm_nn_requantize(res00, dst_multipliers[rhs_rows_idx], dst_shifts[rhs_rows_idx]);
+
+            // Add offset
+            res00 += dst_offset;
+
+            // Clamp the result
+            res00 = MAX(res00, activation_min);
+            res00 = MIN(res00, activation_max);
+
+            *dst++ = (q7_t)res00;
+            rhs_ptr += rhs_cols;
+        }
+
+        lhs += rhs_cols;
+    }
 #else
     for (int32_t rhs_rows_idx = 0; rhs_rows_idx <= (rhs_rows - 2); rhs_rows_idx += 2)
     {
@@ -379,6 +379,27 @@ arm_status arm_nn_vec_mat_mult_t_s8(const q7_t *lhs,
         *dst = (q7_t)res00;
     }
 
+#elif defined(ARM_NN_X86_SIMD)
+
+    for (int32_t rhs_rows_idx = 0; rhs_rows_idx < rhs_rows; ++rhs_rows_idx)
+    {
+        q31_t res00 = *bias++ + arm_nn_x86_dot_q7_with_offset(lhs, rhs, rhs_cols, lhs_offset, rhs_offset);
+
+        // Quantize down
+        res00 = arm_nn_requantize(res00, dst_multiplier, dst_shift);
+
+        // Add offset
+        res00 += dst_offset;
+
+        // Clamp the result
+        res00 = MAX(res00, activation_min);
+        res00 = MIN(res00, activation_max);
+
+        *dst++ = (q7_t)res00;
+
+        rhs += rhs_cols;
+    }
+
 #else
 
     for (int32_t rhs_rows_idx = 0; rhs_rows_idx <= (rhs_rows - 2); rhs_rows_idx += 2)
@@ -0,0 +1,213 @@
+/*
+ * Copyright (C) 2010-2020 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_avgpool_s16.c
+ * Description:  s16 average pooling function
+ *
+ * $Date:        October 2020
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+
+#include "cmsis/CMSIS/DSP/Include/arm_math.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+
+#if defined (ARM_MATH_DSP)
+
+static void accumulate_q15_to_q31(q31_t *buffer, const q15_t *source, const int32_t length, const int32_t first)
+{
+    int32_t cnt = length >> 1;
+
+    while (cnt > 0l)
+    {
+        const q31_t in = arm_nn_read_q15x2_ia(&source);
+#ifndef ARM_MATH_BIG_ENDIAN
+        const q31_t in_lo = (q15_t)in;
+        const q31_t in_hi = in >> 16;
+#else
+        const q31_t in_lo = in >> 16;
+        const q31_t in_hi = (q15_t)in;
+#endif
+        if (first)
+        {
+            buffer[0] = in_lo;
+            buffer[1] = in_hi;
+        }
+        else
+        {
+            buffer[0] += in_lo;
+            buffer[1] += in_hi;
+        }
+        buffer += 2;
+        cnt--;
+    }
+
+    if (length & 0x1)
+    {
+        *buffer = first ? *source : *buffer + *source;
+    }
+}
+
+static void buffer_scale_back_q31_to_q15_and_clamp(const q31_t *buffer, q15_t *target, const int32_t length,
+                                                   const int32_t count, const int act_min, const int act_max)
+{
+    int i;
+    int32_t sum;
+
+    for (i = 0; i < length; i++)
+    {
+        sum = buffer[i] > 0 ? (buffer[i] + count / 2) / count : (buffer[i] - count / 2) / count;
+
+        sum = MAX(sum, act_min);
+        sum = MIN(sum, act_max);
+
+        target[i] = (q15_t)sum;
+    }
+}
+#endif
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup Pooling
+ * @{
+ */
+
+/*
+ * s16 average pooling function
+ *
+ * Refer to header file for details.
+ *
+ */
+
+arm_status arm_avgpool_s16(const int dim_src_height,
+                           const int dim_src_width,
+                           const int dim_dst_height,
+                           const int dim_dst_width,
+                           const int stride_height,
+                           const int stride_width,
+                           const int dim_kernel_height,
+                           const int dim_kernel_width,
+                           const int padding_height,
+                           const int padding_width,
+                           const int act_min,
+                           const int act_max,
+                           const int ch_src,
+                           const int16_t *src,
+                           int32_t *bufferA,
+                           int16_t *dst)
+{
+
+#if defined (ARM_MATH_DSP)
+
+  /* Run the following code for Cortex-M4 and Cortex-M7
+   */
+  int32_t k_x, k_y, i_x, i_y;
+
+  for (i_y = 0; i_y < dim_dst_height; i_y++)
+  {
+    for (i_x = 0; i_x < dim_dst_width; i_x++)
+    {
+      /* Condition for kernel start dimension: (base_idx_<x,y> + kernel_<x,y>_start) >= 0 */
+      const int32_t base_idx_y = (i_y * stride_height) - padding_height;
+      const int32_t base_idx_x = (i_x * stride_width) - padding_width;
+      const int32_t kernel_y_start = MAX(0, -base_idx_y);
+      const int32_t kernel_x_start = MAX(0, -base_idx_x);
+
+      /* Condition for kernel end dimension: (base_idx_<x,y> + kernel_<x,y>_end) < dim_src_<width,height> */
+      const int32_t kernel_y_end = MIN(dim_kernel_height, dim_src_height - base_idx_y);
+      const int32_t kernel_x_end = MIN(dim_kernel_width, dim_src_width - base_idx_x);
+
+      int count = 0;
+
+      for (k_y = kernel_y_start; k_y < kernel_y_end; k_y++)
+      {
+        for (k_x = kernel_x_start; k_x < kernel_x_end; k_x++)
+        {
+          const q15_t *start = src + ch_src * (k_x + base_idx_x + (k_y + base_idx_y) * dim_src_width);
+
+          accumulate_q15_to_q31(bufferA, start, ch_src, count == 0);
+          count++;
+        }
+      }
+      buffer_scale_back_q31_to_q15_and_clamp(bufferA, dst, ch_src, count, act_min, act_max);
+      dst += ch_src;
+    }
+  }
+#else
+
+  /* Reference C code adapted from arm_avgpool_s8.
+   */
+  (void)bufferA;
+  int32_t i_ch_in, i_x, i_y;
+  int32_t k_x, k_y;
+
+  for (i_y = 0; i_y < dim_dst_height; i_y++)
+  {
+    for (i_x = 0; i_x < dim_dst_width; i_x++)
+    {
+      for (i_ch_in = 0; i_ch_in < ch_src; i_ch_in++)
+      {
+        int32_t sum = 0;
+        int32_t count = 0;
+        for (k_y = i_y * stride_height - padding_height; k_y < i_y * stride_height - padding_height + dim_kernel_height; k_y++)
+        {
+          for (k_x = i_x * stride_width - padding_width; k_x < i_x * stride_width - padding_width + dim_kernel_width; k_x++)
+          {
+            if (k_y >= 0 && k_x >= 0 && k_y < dim_src_height && k_x < dim_src_width)
+            {
+              sum += src[i_ch_in + ch_src * (k_x + k_y * dim_src_width)];
+              count++;
+            }
+          }
+        }
+        sum = sum > 0 ? (sum + count / 2) / count : (sum - count / 2) / count;
+        sum = MAX(sum, act_min);
+        sum = MIN(sum, act_max);
+
+        dst[i_ch_in + ch_src * (i_x + i_y * dim_dst_width)] = (int16_t)sum;
+      }
+    }
+  }
+
+#endif
+  return ARM_MATH_SUCCESS;
+}
+
+int32_t arm_avgpool_s16_get_buffer_size(const int dim_dst_width,
+                                        const int ch_src)
+{
+  (void)dim_dst_width;
+
+#if defined(ARM_MATH_DSP)
+  return (ch_src * sizeof(int32_t));
+#else
+  (void)ch_src;
+  return 0;
+#endif
+}
+
+/**
+ * @} end of Pooling group
+ */
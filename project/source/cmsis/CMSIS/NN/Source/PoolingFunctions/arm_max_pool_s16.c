@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2010-2020 Arm Limited or its affiliates. All rights reserved.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ * Licensed under the Apache License, Version 2.0 (the License); you may
+ * not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ * www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an AS IS BASIS, WITHOUT
+ * WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/* ----------------------------------------------------------------------
+ * Project:      CMSIS NN Library
+ * Title:        arm_max_pool_s16.c
+ * Description:  s16 max pool implementation
+ *
+ * $Date:        October 2020
+ * $Revision:    V.1.0.0
+ *
+ * Target Processor:  Cortex-M cores
+ *
+ * -------------------------------------------------------------------- */
+
+#include "cmsis/CMSIS/DSP/Include/arm_math.h"
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+
+static void compare_and_replace_if_larger_q15(q15_t *base,
+                                              const q15_t *target,
+                                              const int32_t length)
+{
+    int32_t cnt = length;
+
+    while (cnt > 0l)
+    {
+        if (*target > *base)
+        {
+            *base = *target;
+        }
+        base++;
+        target++;
+        cnt--;
+    }
+}
+
+static void clamp_output(q15_t *source, const int32_t length, const int32_t act_min, const int32_t act_max)
+{
+    int32_t cnt = length;
+
+    while (cnt > 0l)
+    {
+        int32_t comp = *source;
+        comp = MAX(comp, act_min);
+        comp = MIN(comp, act_max);
+        *source++ = (q15_t)comp;
+        cnt--;
+    }
+}
+
+/**
+ *  @ingroup groupNN
+ */
+
+/**
+ * @addtogroup Pooling
+ * @{
+ */
+
+/*
+   * s16 max pooling function
+   *
+   * Refer to header file for details.
+   *
+   */
+
+arm_status arm_max_pool_s16(const int input_y,
+                            const int input_x,
+                            const int output_y,
+                            const int output_x,
+                            const int stride_y,
+                            const int stride_x,
+                            const int kernel_y,
+                            const int kernel_x,
+                            const int pad_y,
+                            const int pad_x,
+                            const int act_min,
+                            const int act_max,
+                            const int depth,
+                            const int16_t *src,
+                            int16_t *dst)
+{
+    int32_t i_out_x, i_out_y;
+    int32_t i_ker_x, i_ker_y;
+    int32_t i_ch;
+
+    for (i_out_y = 0; i_out_y < output_y; i_out_y++)
+    {
+        for (i_out_x = 0; i_out_x < output_x; i_out_x++)
+        {
+            /* Condition for kernel start dimension: (base_idx_<x,y> + ker_<x,y>_start) >= 0 */
+            const int32_t base_idx_y = (i_out_y * stride_y) - pad_y;
+            const int32_t base_idx_x = (i_out_x * stride_x) - pad_x;
+            const int32_t ker_y_start = MAX(0, -base_idx_y);
+            const int32_t ker_x_start = MAX(0, -base_idx_x);
+
+            /* Condition for kernel end dimension: (base_idx_<x,y> + ker_<x,y>_end) < input_<x,y> */
+            const int32_t ker_y_end = MIN(kernel_y, input_y - base_idx_y);
+            const int32_t ker_x_end = MIN(kernel_x, input_x - base_idx_x);
+
+            int32_t count = 0;
+
+            /* The whole channel vector of a pixel is compared at once, so that the input is read contiguously */
+            for (i_ker_y = ker_y_start; i_ker_y < ker_y_end; i_ker_y++)
+            {
+                for (i_ker_x = ker_x_start; i_ker_x < ker_x_end; i_ker_x++)
+                {
+                    const q15_t *start = src + depth * (i_ker_x + base_idx_x + (i_ker_y + base_idx_y) * input_x);
+
+                    if (count == 0)
+                    {
+                        memcpy(dst, start, depth * sizeof(q15_t));
+                    }
+                    else
+                    {
+                        compare_and_replace_if_larger_q15(dst, start, depth);
+                    }
+                    count++;
+                }
+            }
+
+            if (count == 0)
+            {
+                for (i_ch = 0; i_ch < depth; i_ch++)
+                {
+                    dst[i_ch] = Q15_MIN;
+                }
+            }
+
+            /* Activation function */
+            clamp_output(dst, depth, act_min, act_max);
+            dst += depth;
+        }
+    }
+    return ARM_MATH_SUCCESS;
+}
+
+/**
+ * @} end of Pooling group
+ */
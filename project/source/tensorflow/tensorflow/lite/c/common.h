@@ -377,6 +377,17 @@ typedef struct TfLiteSparsity {
   int dim_metadata_size;
 } TfLiteSparsity;
 
+// Weights stored as packed indices into a palette of values. The tensor keeps
+// its type and dense shape, and its data holds the indices, packed from the
+// low bits of each byte up.
+// WARNING: This is an experimental interface that is subject to change.
+typedef struct TfLitePalette {
+  // Bits per index: 1, 2, 4 or 8.
+  int bits_per_index;
+  // The 1 << bits_per_index palette values, of the tensor's type.
+  const void* values;
+} TfLitePalette;
+
 // An tensor in the interpreter system which is a wrapper around a buffer of
 // data including a dimensionality (or NULL if not currently defined).
 typedef struct TfLiteTensor {
@@ -444,6 +455,24 @@ typedef struct TfLiteTensor {
   const TfLiteIntArray* dims_signature;
 } TfLiteTensor;
 
+// Light-weight tensor struct for the TF Micro runtime. Holds only what a
+// kernel needs to run during TfLiteRegistration::invoke; everything else
+// (quantization parameters, byte size, ...) is read from the TfLiteTensor in
+// prepare and kept in the kernel's OpData.
+typedef struct TfLiteEvalTensor {
+  // A union of data pointers. The appropriate type should be used for a typed
+  // tensor based on `type`.
+  TfLitePtrUnion data;
+
+  // A pointer to a structure representing the dimensionality interpretation
+  // that the buffer should have.
+  TfLiteIntArray* dims;
+
+  // The data type specification for data stored in `data`. This affects
+  // what member of `data` union should be used.
+  TfLiteType type;
+} TfLiteEvalTensor;
+
 #ifndef TF_LITE_STATIC_MEMORY
 // Free data memory of tensor `t`.
 void TfLiteTensorDataFree(TfLiteTensor* t);
@@ -660,6 +689,30 @@ typedef struct TfLiteContext {
 #ifdef MICRO_RUNTIME
   struct DynamicContext dl_context;
 #endif
+
+  // Returns a TfLiteTensor struct for a given index. Used by runtimes that
+  // leave `tensors` null and only build a TfLiteTensor on request (TF Micro);
+  // see GetInput() in kernels/kernel_util.h.
+  // WARNING: This is an experimental interface that is subject to change.
+  // WARNING: This method may not be available on all platforms.
+  TfLiteTensor* (*GetTensor)(const struct TfLiteContext* context,
+                             int tensor_idx);
+
+  // Returns a TfLiteEvalTensor struct for a given index.
+  // WARNING: This is an experimental interface that is subject to change.
+  // WARNING: This method may not be available on all platforms.
+  TfLiteEvalTensor* (*GetEvalTensor)(const struct TfLiteContext* context,
+                                     int tensor_idx);
+
+  // Sets `palette` to the palette of palettized weights, or to NULL if the
+  // tensor stores its values. Only TF Micro decodes palettes. They are kept
+  // out of TfLiteTensor, whose layout the prebuilt NeuroPilot runtime relies
+  // on.
+  // WARNING: This is an experimental interface that is subject to change.
+  // WARNING: This method may not be available on all platforms.
+  TfLiteStatus (*GetTensorPalette)(const struct TfLiteContext* context,
+                                   int tensor_idx,
+                                   const TfLitePalette** palette);
 } TfLiteContext;
 
 typedef struct TfLiteRegistration {
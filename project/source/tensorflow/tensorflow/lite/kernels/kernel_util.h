@@ -28,29 +28,39 @@ inline int NumDimensions(const TfLiteTensor* t) { return t->dims->size; }
 inline int SizeOfDimension(const TfLiteTensor* t, int dim) {
   return t->dims->data[dim];
 }
+// Returns the tensor at `tensor_index`. TF Micro does not keep a TfLiteTensor
+// for every tensor once the graph is prepared: `context->tensors` is then null
+// and the tensor is built on request by `context->GetTensor`.
+inline TfLiteTensor* GetTensorAtIndex(const TfLiteContext* context,
+                                      int tensor_index) {
+  if (context->tensors != nullptr) {
+    return &context->tensors[tensor_index];
+  }
+  return context->GetTensor(context, tensor_index);
+}
 inline const TfLiteTensor* GetInput(const TfLiteContext* context,
                                     const TfLiteNode* node, int index) {
-  return &context->tensors[node->inputs->data[index]];
+  return GetTensorAtIndex(context, node->inputs->data[index]);
 }
 // Note: You must check if result is not null:
 // TfLiteTensor* my_tensor = GetVariableInput(context, node, kMyTensorIdx);
 // TF_LITE_ENSURE(context, my_tensor != nullptr);
 inline TfLiteTensor* GetVariableInput(TfLiteContext* context,
                                       const TfLiteNode* node, int index) {
-  TfLiteTensor* tensor = &context->tensors[node->inputs->data[index]];
-  return (tensor->is_variable) ? tensor : nullptr;
+  TfLiteTensor* tensor = GetTensorAtIndex(context, node->inputs->data[index]);
+  return (tensor != nullptr && tensor->is_variable) ? tensor : nullptr;
 }
 inline TfLiteTensor* GetOutput(TfLiteContext* context, const TfLiteNode* node,
                                int index) {
-  return &context->tensors[node->outputs->data[index]];
+  return GetTensorAtIndex(context, node->outputs->data[index]);
 }
 inline TfLiteTensor* GetTemporary(TfLiteContext* context,
                                   const TfLiteNode* node, int index) {
-  return &context->tensors[node->temporaries->data[index]];
+  return GetTensorAtIndex(context, node->temporaries->data[index]);
 }
 inline const TfLiteTensor* GetIntermediates(TfLiteContext* context,
                                             const TfLiteNode* node, int index) {
-  return &context->tensors[node->intermediates->data[index]];
+  return GetTensorAtIndex(context, node->intermediates->data[index]);
 }
 inline int NumInputs(const TfLiteNode* node) { return node->inputs->size; }
 inline int NumOutputs(const TfLiteNode* node) { return node->outputs->size; }
@@ -76,7 +86,7 @@ inline const TfLiteTensor* GetOptionalInputTensor(TfLiteContext* context,
   const bool use_tensor = index < node->inputs->size &&
                           node->inputs->data[index] != kTfLiteOptionalTensor;
   if (use_tensor) {
-    return &context->tensors[node->inputs->data[index]];
+    return GetTensorAtIndex(context, node->inputs->data[index]);
   }
   return nullptr;
 }
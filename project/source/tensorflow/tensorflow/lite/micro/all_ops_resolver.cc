@@ -41,7 +41,10 @@ AllOpsResolver::AllOpsResolver() {
              tflite::ops::micro::Register_DEPTHWISE_CONV_2D());
   AddBuiltin(BuiltinOperator_DEQUANTIZE,
              tflite::ops::micro::Register_DEQUANTIZE());
+  AddBuiltin(BuiltinOperator_DIV, tflite::ops::micro::Register_DIV());
   AddBuiltin(BuiltinOperator_EQUAL, tflite::ops::micro::Register_EQUAL());
+  AddBuiltin(BuiltinOperator_EXPAND_DIMS,
+             tflite::ops::micro::Register_EXPAND_DIMS());
   AddBuiltin(BuiltinOperator_FLOOR, tflite::ops::micro::Register_FLOOR());
   AddBuiltin(BuiltinOperator_FULLY_CONNECTED,
              tflite::ops::micro::Register_FULLY_CONNECTED());
@@ -0,0 +1,317 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Compares int8 fully connected layers with block-sparse weights against the
+// dense arm_fully_connected_s8() and reference kernel, at several block
+// shapes and fractions of zero blocks.
+//
+// Weights and activations are random, with the chosen fraction of blocks set
+// to zero. Every kernel must give the outputs of the dense reference kernel.
+// One CSV row per case is written to stdout:
+//
+//   name,rows,cols,block,sparsity,stored_blocks,dense_bytes,sparse_bytes,
+//   result,reference_us,cmsis_us,cmsis_sparse_us,portable_sparse_us,speedup
+//
+// where sparse_bytes counts the int32 block indices, cmsis_sparse_us is
+// arm_fully_connected_s8_sparse() as called by the cmsis-nn kernel,
+// portable_sparse_us is the kernel in kernels/block_sparse.h that the host
+// kernels use, and speedup is cmsis_us / cmsis_sparse_us. The exit code is
+// non-zero when a case is not bit-exact.
+//
+// Which CMSIS-NN code is exercised depends on how the cmsis library was
+// built: the portable C paths by default, the DSP paths with
+// CMSIS_DSP_EMULATION and the x86 paths with CMSIS_NN_X86_SIMD.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace {
+
+constexpr int kMaxRows = 256;
+constexpr int kMaxCols = 2048;
+constexpr int kMaxWeights = kMaxRows * kMaxCols;
+
+// Each implementation is repeated until it has run for at least this long,
+// so that small shapes are not lost in the timer resolution.
+constexpr int32_t kMinTimingUs = 2000;
+constexpr int kMaxTimingRuns = 10000;
+
+struct LayerShape {
+  const char* name;
+  int rows;
+  int cols;
+};
+
+// The CONV_2D of emergency-detect-82 with the most weights, as the matrix it
+// multiplies every output pixel by, and generic layers around it.
+constexpr LayerShape kShapes[] = {
+    {"emergency_detect_82_conv1d_3", 16, 2048},
+    {"fc_64x256", 64, 256},
+    {"fc_128x1024", 128, 1024},
+    {"fc_256x2048", 256, 2048},
+};
+
+struct BlockShape {
+  int rows;
+  int cols;
+};
+
+constexpr BlockShape kBlocks[] = {{1, 4}, {1, 16}, {4, 4}};
+
+constexpr int kSparsityPercents[] = {0, 50, 75, 90};
+
+int8_t input_data[kMaxCols];
+int8_t dense_weights[kMaxWeights];
+int8_t sparse_values[kMaxWeights];
+int32_t block_segments[kMaxRows + 1];
+int32_t block_indices[kMaxWeights];
+int32_t bias_data[kMaxRows];
+int8_t reference_output[kMaxRows];
+int8_t cmsis_output[kMaxRows];
+int8_t cmsis_sparse_output[kMaxRows];
+int8_t portable_sparse_output[kMaxRows];
+int block_order[kMaxWeights];
+
+int failures = 0;
+uint32_t random_state = 1;
+
+uint32_t NextRandom() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state;
+}
+
+int8_t NextRandomInt8() { return static_cast<int8_t>(NextRandom() >> 24); }
+
+float TicksToMicroseconds(uint32_t ticks) {
+  const int32_t tps = tflite::ticks_per_second();
+  if (tps == 0) {
+    return 0.0f;
+  }
+  return static_cast<float>(ticks) * 1000000.0f / static_cast<float>(tps);
+}
+
+// The tick counter is 32 bits wide and wraps, so elapsed time is taken
+// modulo 2^32.
+template <typename Fn>
+float TimeMicroseconds(Fn fn) {
+  const uint32_t min_ticks = static_cast<uint32_t>(
+      static_cast<int64_t>(kMinTimingUs) * tflite::ticks_per_second() /
+      1000000);
+  const uint32_t start = tflite::GetCurrentTimeTicks();
+  uint32_t elapsed = 0;
+  int runs = 0;
+  do {
+    fn();
+    ++runs;
+    elapsed = static_cast<uint32_t>(tflite::GetCurrentTimeTicks()) - start;
+  } while (elapsed < min_ticks && runs < kMaxTimingRuns);
+  return TicksToMicroseconds(elapsed) / runs;
+}
+
+// Fills the dense weights with random values, zeroes `sparsity_percent` of
+// the blocks chosen at random, and encodes the others as the converter does.
+// Returns the number of stored blocks.
+int MakeWeights(const LayerShape& shape, const BlockShape& block,
+                int sparsity_percent) {
+  const int size = shape.rows * shape.cols;
+  for (int i = 0; i < size; ++i) {
+    dense_weights[i] = NextRandomInt8();
+  }
+  const int num_block_cols = shape.cols / block.cols;
+  const int num_blocks = (shape.rows / block.rows) * num_block_cols;
+  for (int i = 0; i < num_blocks; ++i) {
+    block_order[i] = i;
+  }
+  for (int i = num_blocks - 1; i > 0; --i) {
+    std::swap(block_order[i], block_order[NextRandom() % (i + 1)]);
+  }
+  const int zero_blocks = num_blocks * sparsity_percent / 100;
+  for (int k = 0; k < zero_blocks; ++k) {
+    const int b = block_order[k];
+    for (int i = 0; i < block.rows; ++i) {
+      const int row = (b / num_block_cols) * block.rows + i;
+      memset(&dense_weights[row * shape.cols + (b % num_block_cols) *
+                                                   block.cols],
+             0, block.cols);
+    }
+  }
+
+  int stored = 0;
+  int8_t* values = sparse_values;
+  block_segments[0] = 0;
+  for (int b = 0; b < num_blocks; ++b) {
+    const int block_row = b / num_block_cols;
+    const int block_col = b % num_block_cols;
+    bool is_zero = true;
+    for (int i = 0; i < block.rows; ++i) {
+      const int8_t* row = &dense_weights[(block_row * block.rows + i) *
+                                             shape.cols +
+                                         block_col * block.cols];
+      for (int j = 0; j < block.cols; ++j) {
+        is_zero &= row[j] == 0;
+      }
+    }
+    if (!is_zero) {
+      block_indices[stored++] = block_col;
+      for (int i = 0; i < block.rows; ++i) {
+        memcpy(values,
+               &dense_weights[(block_row * block.rows + i) * shape.cols +
+                              block_col * block.cols],
+               block.cols);
+        values += block.cols;
+      }
+    }
+    if (block_col == num_block_cols - 1) {
+      block_segments[block_row + 1] = stored;
+    }
+  }
+  return stored;
+}
+
+void RunCase(const LayerShape& shape, const BlockShape& block,
+             int sparsity_percent) {
+  const int stored = MakeWeights(shape, block, sparsity_percent);
+  for (int i = 0; i < shape.cols; ++i) {
+    input_data[i] = NextRandomInt8();
+  }
+  for (int i = 0; i < shape.rows; ++i) {
+    bias_data[i] = static_cast<int32_t>(NextRandom() >> 18) - (1 << 13);
+  }
+
+  // Symmetric int8 weights as in TFLite, with a right shift that keeps most
+  // outputs inside the int8 range.
+  const int32_t input_offset = 5;
+  const int32_t output_offset = -3;
+  const int32_t output_multiplier = 1518500250;
+  int32_t output_shift = -6;
+  for (int depth = 1; depth < shape.cols; depth *= 4) {
+    --output_shift;
+  }
+
+  tflite::FullyConnectedParams op_params;
+  op_params.input_offset = input_offset;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output_offset;
+  op_params.output_multiplier = output_multiplier;
+  op_params.output_shift = output_shift;
+  op_params.quantized_activation_min = -128;
+  op_params.quantized_activation_max = 127;
+  const tflite::RuntimeShape input_shape({1, shape.cols});
+  const tflite::RuntimeShape filter_shape({shape.rows, shape.cols});
+  const tflite::RuntimeShape bias_shape({shape.rows});
+  const tflite::RuntimeShape output_shape({1, shape.rows});
+
+  tflite::micro::BlockSparseWeights weights;
+  weights.rows = shape.rows;
+  weights.cols = shape.cols;
+  weights.block_rows = block.rows;
+  weights.block_cols = block.cols;
+  weights.segments = block_segments;
+  weights.indices = block_indices;
+
+  auto reference_fn = [&]() {
+    tflite::reference_integer_ops::FullyConnected(
+        op_params, input_shape, input_data, filter_shape, dense_weights,
+        bias_shape, bias_data, output_shape, reference_output);
+  };
+  auto cmsis_fn = [&]() {
+    arm_fully_connected_s8(input_data, dense_weights, shape.cols, shape.rows,
+                           1, input_offset, 0, output_multiplier,
+                           output_shift, output_offset, bias_data,
+                           cmsis_output, -128, 127, nullptr);
+  };
+  auto cmsis_sparse_fn = [&]() {
+    arm_fully_connected_s8_sparse(
+        input_data, sparse_values, block_segments, block_indices, block.rows,
+        block.cols, shape.cols, shape.rows, 1, input_offset, 0,
+        output_multiplier, output_shift, output_offset, bias_data,
+        cmsis_sparse_output, -128, 127);
+  };
+  auto portable_sparse_fn = [&]() {
+    tflite::micro::BlockSparseFullyConnected(
+        weights, sparse_values, 0, 1, input_data, input_offset,
+        portable_sparse_output, [&](int32_t acc, int out_channel) {
+          acc += bias_data[out_channel];
+          acc = tflite::MultiplyByQuantizedMultiplier(acc, output_multiplier,
+                                                      output_shift);
+          acc += output_offset;
+          acc = std::max(acc, static_cast<int32_t>(-128));
+          acc = std::min(acc, static_cast<int32_t>(127));
+          return static_cast<int8_t>(acc);
+        });
+  };
+
+  reference_fn();
+  cmsis_fn();
+  cmsis_sparse_fn();
+  portable_sparse_fn();
+  int mismatches = 0;
+  for (int i = 0; i < shape.rows; ++i) {
+    mismatches += cmsis_output[i] != reference_output[i];
+    mismatches += cmsis_sparse_output[i] != reference_output[i];
+    mismatches += portable_sparse_output[i] != reference_output[i];
+  }
+  if (mismatches > 0) {
+    ++failures;
+  }
+
+  const float reference_us = TimeMicroseconds(reference_fn);
+  const float cmsis_us = TimeMicroseconds(cmsis_fn);
+  const float cmsis_sparse_us = TimeMicroseconds(cmsis_sparse_fn);
+  const float portable_sparse_us = TimeMicroseconds(portable_sparse_fn);
+  const int sparse_bytes =
+      stored * block.rows * block.cols +
+      (shape.rows / block.rows + 1 + stored) * sizeof(int32_t);
+  printf("%s,%d,%d,%dx%d,%d,%d,%d,%d,%s,%.2f,%.2f,%.2f,%.2f,%.2f\n",
+         shape.name, shape.rows, shape.cols, block.rows, block.cols,
+         sparsity_percent, stored, shape.rows * shape.cols, sparse_bytes,
+         mismatches > 0 ? "mismatch" : "exact", reference_us, cmsis_us,
+         cmsis_sparse_us, portable_sparse_us,
+         cmsis_sparse_us > 0.0f ? cmsis_us / cmsis_sparse_us : 0.0f);
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  printf(
+      "name,rows,cols,block,sparsity,stored_blocks,dense_bytes,sparse_bytes,"
+      "result,reference_us,cmsis_us,cmsis_sparse_us,portable_sparse_us,"
+      "speedup\n");
+  for (const LayerShape& shape : kShapes) {
+    for (const BlockShape& block : kBlocks) {
+      for (int sparsity_percent : kSparsityPercents) {
+        RunCase(shape, block, sparsity_percent);
+      }
+    }
+  }
+
+  if (failures > 0) {
+    TF_LITE_REPORT_ERROR(&micro_error_reporter,
+                         "%d cases are not bit-exact", failures);
+    return 1;
+  }
+  return 0;
+}
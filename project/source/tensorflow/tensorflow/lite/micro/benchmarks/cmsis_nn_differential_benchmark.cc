@@ -0,0 +1,849 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Differential test of the int8 micro kernels against the reference kernels
+// in kernels/internal/reference/integer_ops.
+//
+// For every op, random shapes and quantization parameters are generated, with
+// odd channel counts, SAME and VALID padding, dilation and strides larger
+// than the filter. The kernel runs through its TfLiteRegistration, as the
+// only node of a graph hosted by MicroAotRuntime: init and prepare once, then
+// invoke. Whichever CMSIS-NN function or fallback the kernel picks for the
+// case is what gets tested, and the output must be bit-exact with the
+// reference function run on the same data. One CSV row per case is written to
+// stdout:
+//
+//   op,batches,input_h,input_w,input_c,filter_h,filter_w,output_c,stride_h,
+//   stride_w,dilation_h,dilation_w,pad_h,pad_w,result,mismatches,
+//   reference_us,kernel_us,speedup
+//
+// The exit code is non-zero when a case fails to prepare or invoke or is not
+// bit-exact.
+//
+// Usage: cmsis_nn_differential_benchmark [cases_per_op] [seed]
+//
+// The kernels under test are the micro/kernels/cmsis-nn ones when the library
+// is built with TFLM_USE_CMSIS_NN, the micro/kernels/linux ones otherwise.
+// Which CMSIS-NN code they call depends on how the cmsis library was built:
+// the portable C paths by default, the DSP paths with CMSIS_DSP_EMULATION and
+// the x86 paths with CMSIS_NN_X86_SIMD.
+
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <initializer_list>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/add.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/depthwise_conv.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/mul.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/pooling.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/micro_ops.h"
+#include "tensorflow/lite/micro/micro_aot_runtime.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace {
+
+constexpr int kDefaultCasesPerOp = 50;
+constexpr int kMaxTensorSize = 16 * 1024;
+constexpr int kMaxChannels = 64;
+constexpr int kMaxScratchSize = 32 * 1024;
+constexpr int kMaxScratchBuffers = 4;
+constexpr int kMaxTensors = 4;
+constexpr size_t kPersistentSize = 64 * 1024;
+
+// Each implementation is repeated until it has run for at least this long,
+// so that small shapes are not lost in the timer resolution.
+constexpr int32_t kMinTimingUs = 2000;
+constexpr int kMaxTimingRuns = 10000;
+
+int8_t input_data[kMaxTensorSize];
+int8_t input2_data[kMaxTensorSize];
+int8_t filter_data[kMaxTensorSize];
+int32_t bias_data[kMaxChannels];
+int32_t output_multiplier[kMaxChannels];
+int32_t output_shift[kMaxChannels];
+int8_t reference_output[kMaxTensorSize];
+int8_t kernel_output[kMaxTensorSize];
+
+// Every scratch buffer the kernel requests gets its own kMaxScratchSize
+// slot of the arena.
+alignas(16) uint8_t scratch_arena[kMaxScratchBuffers * kMaxScratchSize];
+alignas(16) uint8_t persistent[kPersistentSize];
+
+tflite::MicroErrorReporter micro_error_reporter;
+
+void ReportError(TfLiteContext* context, const char* format, ...) {
+  va_list args;
+  va_start(args, format);
+  micro_error_reporter.Report(format, args);
+  va_end(args);
+}
+
+// Context for the quantization helpers of kernels/kernel_util.h, which only
+// use it to report errors.
+TfLiteContext* ErrorContext() {
+  static TfLiteContext context = {};
+  context.ReportError = ReportError;
+  return &context;
+}
+
+uint32_t random_state = 1;
+
+uint32_t NextRandom() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return random_state;
+}
+
+// Uniform in [min, max].
+int32_t RandomInt(int32_t min, int32_t max) {
+  const uint32_t range = static_cast<uint32_t>(max - min) + 1u;
+  return min + static_cast<int32_t>((NextRandom() >> 8) % range);
+}
+
+bool RandomChance(int percent) { return RandomInt(0, 99) < percent; }
+
+int8_t NextRandomInt8() { return static_cast<int8_t>(NextRandom() >> 24); }
+
+void FillRandom(int8_t* data, int size) {
+  for (int i = 0; i < size; ++i) {
+    data[i] = NextRandomInt8();
+  }
+}
+
+float RandomScale() { return 0.005f + RandomInt(0, 1000) * 0.0002f; }
+
+TfLitePadding RandomPadding() {
+  return RandomChance(50) ? kTfLitePaddingSame : kTfLitePaddingValid;
+}
+
+// Usually none, otherwise one of the fused activations that clamp the output.
+TfLiteFusedActivation RandomActivation() {
+  if (RandomChance(60)) {
+    return kTfLiteActNone;
+  }
+  const TfLiteFusedActivation activations[] = {
+      kTfLiteActRelu, kTfLiteActRelu1, kTfLiteActRelu6};
+  return activations[RandomInt(0, 2)];
+}
+
+// Right shift that keeps most requantized sums of accum_depth int8 products
+// inside the int8 range, with an occasional left shift.
+int32_t RandomShift(int accum_depth) {
+  if (RandomChance(3)) {
+    return 1;
+  }
+  int bits = 0;
+  while ((1 << bits) < accum_depth) {
+    ++bits;
+  }
+  return -(6 + bits / 2 + RandomInt(0, 4));
+}
+
+// Picks a filter scale per channel so that input_scale * filter_scale /
+// output_scale is a requantization multiplier in [0.5, 1) times
+// 2^RandomShift(accum_depth), and random int32 biases. As the converter
+// does, the bias scale is input_scale * filter_scale.
+void FillPerChannelQuantization(int channels, int accum_depth,
+                                float input_scale, float output_scale,
+                                float* filter_scales, float* bias_scales) {
+  for (int i = 0; i < channels; ++i) {
+    bias_data[i] = RandomInt(-(1 << 14), 1 << 14);
+    const double multiplier = std::ldexp(RandomInt(1 << 30, INT32_MAX),
+                                         RandomShift(accum_depth) - 31);
+    filter_scales[i] =
+        static_cast<float>(multiplier * output_scale / input_scale);
+    bias_scales[i] = input_scale * filter_scales[i];
+  }
+}
+
+float TicksToMicroseconds(uint32_t ticks) {
+  const int32_t tps = tflite::ticks_per_second();
+  if (tps == 0) {
+    return 0.0f;
+  }
+  return static_cast<float>(ticks) * 1000000.0f / static_cast<float>(tps);
+}
+
+// The tick counter is 32 bits wide and wraps, so elapsed time is taken
+// modulo 2^32.
+template <typename Fn>
+float TimeMicroseconds(Fn fn) {
+  const uint32_t min_ticks = static_cast<uint32_t>(
+      static_cast<int64_t>(kMinTimingUs) * tflite::ticks_per_second() /
+      1000000);
+  const uint32_t start = tflite::GetCurrentTimeTicks();
+  uint32_t elapsed = 0;
+  int runs = 0;
+  do {
+    fn();
+    ++runs;
+    elapsed = static_cast<uint32_t>(tflite::GetCurrentTimeTicks()) - start;
+  } while (elapsed < min_ticks && runs < kMaxTimingRuns);
+  return TicksToMicroseconds(elapsed) / runs;
+}
+
+struct CaseShape {
+  int batches = 1;
+  int input_h = 1;
+  int input_w = 1;
+  int input_c = 1;
+  int filter_h = 1;
+  int filter_w = 1;
+  int output_c = 1;
+  int stride_h = 1;
+  int stride_w = 1;
+  int dilation_h = 1;
+  int dilation_w = 1;
+  int pad_h = 0;
+  int pad_w = 0;
+};
+
+// The tensors of a one-node graph: inputs first, the output last, each with
+// storage for its shape and quantization.
+struct CaseGraph {
+  TfLiteTensor tensors[kMaxTensors];
+  tflite::AotIntArray<4> dims[kMaxTensors];
+  tflite::AotFloatArray<kMaxChannels> scales[kMaxTensors];
+  tflite::AotIntArray<kMaxChannels> zero_points[kMaxTensors];
+  TfLiteAffineQuantization quantizations[kMaxTensors];
+  int tensors_size = 0;
+
+  // Adds an int8 or int32 tensor. With more than one scale the tensor is
+  // quantized per channel along `quantized_dimension`.
+  TfLiteTensor* AddTensor(TfLiteType type,
+                          TfLiteAllocationType allocation_type, void* data,
+                          std::initializer_list<int> shape,
+                          const float* tensor_scales, int scales_size,
+                          int32_t zero_point, int quantized_dimension = 0) {
+    const int index = tensors_size++;
+    tflite::AotIntArray<4>& tensor_dims = dims[index];
+    tensor_dims.size = 0;
+    size_t bytes = type == kTfLiteInt32 ? sizeof(int32_t) : sizeof(int8_t);
+    for (int dim : shape) {
+      tensor_dims.data[tensor_dims.size++] = dim;
+      bytes *= dim;
+    }
+    TfLiteTensor* tensor = &tensors[index];
+    tflite::AotInitTensor(tensor, type, allocation_type, data, bytes,
+                          tensor_dims.array());
+    if (scales_size > 0) {
+      scales[index].size = scales_size;
+      zero_points[index].size = scales_size;
+      for (int i = 0; i < scales_size; ++i) {
+        scales[index].data[i] = tensor_scales[i];
+        zero_points[index].data[i] = zero_point;
+      }
+      tflite::AotSetQuantization(tensor, &quantizations[index],
+                                 scales[index].array(),
+                                 zero_points[index].array(),
+                                 quantized_dimension);
+    }
+    return tensor;
+  }
+};
+
+int failures = 0;
+
+// Runs `registration` with `builtin_data` as the only node of `graph` and
+// compares its output with the one of `reference_fn`, times both and prints
+// the row. A kernel that fails to prepare or invoke is reported as "error".
+template <typename ReferenceFn>
+void RunCase(const char* op, const CaseShape& shape, CaseGraph* graph,
+             const TfLiteRegistration* registration, void* builtin_data,
+             ReferenceFn reference_fn) {
+  tflite::AotIntArray<kMaxTensors - 1> inputs;
+  inputs.size = graph->tensors_size - 1;
+  for (int i = 0; i < inputs.size; ++i) {
+    inputs.data[i] = i;
+  }
+  tflite::AotIntArray<1> outputs = {1, {graph->tensors_size - 1}};
+  TfLiteNode node = {};
+  node.inputs = inputs.array();
+  node.outputs = outputs.array();
+  node.builtin_data = builtin_data;
+
+  tflite::AotScratchBuffer scratch_buffers[kMaxScratchBuffers];
+  for (int i = 0; i < kMaxScratchBuffers; ++i) {
+    scratch_buffers[i] = {static_cast<uint32_t>(i * kMaxScratchSize),
+                          kMaxScratchSize};
+  }
+  tflite::MicroAotRuntime runtime(graph->tensors, graph->tensors_size,
+                                  scratch_arena, scratch_buffers,
+                                  kMaxScratchBuffers, persistent,
+                                  kPersistentSize, &micro_error_reporter);
+  const TfLiteRegistration* registrations[] = {registration};
+  TfLiteContext* context = runtime.context();
+  const TfLiteTensor* output = &graph->tensors[graph->tensors_size - 1];
+  const int output_size = output->bytes;
+  auto kernel_fn = [&]() { return registration->invoke(context, &node); };
+
+  memset(reference_output, 0, output_size);
+  memset(kernel_output, 0, output_size);
+  reference_fn();
+  TfLiteStatus status = runtime.Prepare(&node, registrations, 1);
+  if (status == kTfLiteOk) {
+    status = kernel_fn();
+  }
+
+  int mismatches = 0;
+  for (int i = 0; i < output_size; ++i) {
+    if (reference_output[i] != kernel_output[i]) {
+      ++mismatches;
+    }
+  }
+  const char* result = "exact";
+  if (status != kTfLiteOk) {
+    result = "error";
+  } else if (mismatches > 0) {
+    result = "mismatch";
+  }
+  if (status != kTfLiteOk || mismatches > 0) {
+    ++failures;
+  }
+
+  float reference_us = 0.0f;
+  float kernel_us = 0.0f;
+  if (status == kTfLiteOk) {
+    reference_us = TimeMicroseconds(reference_fn);
+    kernel_us = TimeMicroseconds(kernel_fn);
+  }
+  printf("%s,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%d,%s,%d,%.2f,%.2f,%.2f\n",
+         op, shape.batches, shape.input_h, shape.input_w, shape.input_c,
+         shape.filter_h, shape.filter_w, shape.output_c, shape.stride_h,
+         shape.stride_w, shape.dilation_h, shape.dilation_w, shape.pad_h,
+         shape.pad_w, result, mismatches, reference_us, kernel_us,
+         kernel_us > 0.0f ? reference_us / kernel_us : 0.0f);
+}
+
+// Picks the spatial part of a conv, depthwise conv or pooling case and
+// computes the output size and padding as the kernels' Prepare does. Returns
+// false when the output would be empty.
+bool RandomSpatialShape(bool allow_dilation, CaseShape* shape,
+                        TfLitePadding* padding, int* output_h,
+                        int* output_w) {
+  shape->stride_h = RandomChance(70) ? 1 : RandomInt(2, 4);
+  shape->stride_w = RandomChance(70) ? 1 : RandomInt(2, 4);
+  if (allow_dilation && RandomChance(20)) {
+    shape->dilation_h = RandomInt(1, 3);
+    shape->dilation_w = RandomInt(1, 3);
+  }
+  *padding = RandomPadding();
+  const TfLitePaddingValues padding_values = tflite::ComputePaddingHeightWidth(
+      shape->stride_h, shape->stride_w, shape->dilation_h, shape->dilation_w,
+      shape->input_h, shape->input_w, shape->filter_h, shape->filter_w,
+      *padding, output_h, output_w);
+  shape->pad_h = padding_values.height;
+  shape->pad_w = padding_values.width;
+  return *output_h > 0 && *output_w > 0;
+}
+
+void RunConvCase() {
+  CaseShape shape;
+  TfLitePadding padding;
+  int output_h = 0;
+  int output_w = 0;
+  do {
+    shape = CaseShape();
+    shape.batches = RandomChance(80) ? 1 : 2;
+    shape.input_c = RandomInt(1, 19);
+    shape.output_c = RandomInt(1, 17);
+    const int kind = RandomInt(0, 2);
+    if (kind == 0) {
+      // Pointwise.
+      shape.input_h = RandomInt(1, 10);
+      shape.input_w = RandomInt(1, 10);
+    } else if (kind == 1) {
+      // Temporal, a single row.
+      shape.batches = 1;
+      shape.input_w = RandomInt(1, 64);
+      shape.filter_w = RandomInt(1, 9);
+    } else {
+      shape.input_h = RandomInt(1, 12);
+      shape.input_w = RandomInt(1, 12);
+      shape.filter_h = RandomInt(1, 5);
+      shape.filter_w = RandomInt(1, 5);
+    }
+  } while (!RandomSpatialShape(/*allow_dilation=*/true, &shape, &padding,
+                               &output_h, &output_w));
+
+  const int input_size =
+      shape.batches * shape.input_h * shape.input_w * shape.input_c;
+  const int filter_size =
+      shape.output_c * shape.filter_h * shape.filter_w * shape.input_c;
+  const int output_size = shape.batches * output_h * output_w * shape.output_c;
+  if (input_size > kMaxTensorSize || filter_size > kMaxTensorSize ||
+      output_size > kMaxTensorSize) {
+    return;
+  }
+  FillRandom(input_data, input_size);
+  FillRandom(filter_data, filter_size);
+  const float input_scale = RandomScale();
+  const float output_scale = RandomScale();
+  float filter_scales[kMaxChannels];
+  float bias_scales[kMaxChannels];
+  FillPerChannelQuantization(shape.output_c,
+                             shape.filter_h * shape.filter_w * shape.input_c,
+                             input_scale, output_scale, filter_scales,
+                             bias_scales);
+
+  TfLiteConvParams params = {};
+  params.padding = padding;
+  params.stride_width = shape.stride_w;
+  params.stride_height = shape.stride_h;
+  params.activation = RandomActivation();
+  params.dilation_width_factor = shape.dilation_w;
+  params.dilation_height_factor = shape.dilation_h;
+
+  CaseGraph graph;
+  TfLiteTensor* input = graph.AddTensor(
+      kTfLiteInt8, kTfLiteArenaRw, input_data,
+      {shape.batches, shape.input_h, shape.input_w, shape.input_c},
+      &input_scale, 1, RandomInt(-127, 127));
+  TfLiteTensor* filter = graph.AddTensor(
+      kTfLiteInt8, kTfLiteMmapRo, filter_data,
+      {shape.output_c, shape.filter_h, shape.filter_w, shape.input_c},
+      filter_scales, shape.output_c, 0, /*quantized_dimension=*/0);
+  TfLiteTensor* bias =
+      graph.AddTensor(kTfLiteInt32, kTfLiteMmapRo, bias_data, {shape.output_c},
+                      bias_scales, shape.output_c, 0);
+  TfLiteTensor* output = graph.AddTensor(
+      kTfLiteInt8, kTfLiteArenaRw, kernel_output,
+      {shape.batches, output_h, output_w, shape.output_c}, &output_scale, 1,
+      RandomInt(-128, 127));
+
+  tflite::ConvParams op_params;
+  op_params.input_offset = -input->params.zero_point;
+  op_params.output_offset = output->params.zero_point;
+  op_params.stride_height = shape.stride_h;
+  op_params.stride_width = shape.stride_w;
+  op_params.dilation_height_factor = shape.dilation_h;
+  op_params.dilation_width_factor = shape.dilation_w;
+  op_params.padding_values.height = shape.pad_h;
+  op_params.padding_values.width = shape.pad_w;
+  int32_t unused_multiplier;
+  int unused_shift;
+  if (tflite::PopulateConvolutionQuantizationParams(
+          ErrorContext(), input, filter, bias, output, params.activation,
+          &unused_multiplier, &unused_shift,
+          &op_params.quantized_activation_min,
+          &op_params.quantized_activation_max, output_multiplier,
+          reinterpret_cast<int*>(output_shift),
+          shape.output_c) != kTfLiteOk) {
+    ++failures;
+    return;
+  }
+
+  const tflite::RuntimeShape input_shape(
+      {shape.batches, shape.input_h, shape.input_w, shape.input_c});
+  const tflite::RuntimeShape filter_shape(
+      {shape.output_c, shape.filter_h, shape.filter_w, shape.input_c});
+  const tflite::RuntimeShape bias_shape({shape.output_c});
+  const tflite::RuntimeShape output_shape(
+      {shape.batches, output_h, output_w, shape.output_c});
+  RunCase("conv", shape, &graph, tflite::ops::micro::Register_CONV_2D(),
+          &params, [&]() {
+            tflite::reference_integer_ops::ConvPerChannel(
+                op_params, output_multiplier, output_shift, input_shape,
+                input_data, filter_shape, filter_data, bias_shape, bias_data,
+                output_shape, reference_output);
+          });
+}
+
+void RunDepthwiseConvCase() {
+  CaseShape shape;
+  TfLitePadding padding;
+  int depth_multiplier = 1;
+  int output_h = 0;
+  int output_w = 0;
+  do {
+    shape = CaseShape();
+    shape.batches = RandomChance(80) ? 1 : 2;
+    shape.input_h = RandomInt(1, 12);
+    shape.input_w = RandomInt(1, 12);
+    shape.input_c = RandomInt(1, 19);
+    depth_multiplier = RandomChance(70) ? 1 : RandomInt(2, 3);
+    shape.output_c = shape.input_c * depth_multiplier;
+    if (RandomChance(40)) {
+      shape.filter_h = 3;
+      shape.filter_w = 3;
+    } else {
+      shape.filter_h = RandomInt(1, 5);
+      shape.filter_w = RandomInt(1, 5);
+    }
+  } while (!RandomSpatialShape(/*allow_dilation=*/true, &shape, &padding,
+                               &output_h, &output_w));
+
+  const int input_size =
+      shape.batches * shape.input_h * shape.input_w * shape.input_c;
+  const int filter_size = shape.filter_h * shape.filter_w * shape.output_c;
+  const int output_size = shape.batches * output_h * output_w * shape.output_c;
+  if (input_size > kMaxTensorSize || output_size > kMaxTensorSize ||
+      shape.output_c > kMaxChannels) {
+    return;
+  }
+  FillRandom(input_data, input_size);
+  FillRandom(filter_data, filter_size);
+  const float input_scale = RandomScale();
+  const float output_scale = RandomScale();
+  float filter_scales[kMaxChannels];
+  float bias_scales[kMaxChannels];
+  FillPerChannelQuantization(shape.output_c, shape.filter_h * shape.filter_w,
+                             input_scale, output_scale, filter_scales,
+                             bias_scales);
+
+  TfLiteDepthwiseConvParams params = {};
+  params.padding = padding;
+  params.stride_width = shape.stride_w;
+  params.stride_height = shape.stride_h;
+  params.depth_multiplier = depth_multiplier;
+  params.activation = RandomActivation();
+  params.dilation_width_factor = shape.dilation_w;
+  params.dilation_height_factor = shape.dilation_h;
+
+  CaseGraph graph;
+  TfLiteTensor* input = graph.AddTensor(
+      kTfLiteInt8, kTfLiteArenaRw, input_data,
+      {shape.batches, shape.input_h, shape.input_w, shape.input_c},
+      &input_scale, 1, RandomInt(-127, 127));
+  TfLiteTensor* filter = graph.AddTensor(
+      kTfLiteInt8, kTfLiteMmapRo, filter_data,
+      {1, shape.filter_h, shape.filter_w, shape.output_c}, filter_scales,
+      shape.output_c, 0, /*quantized_dimension=*/3);
+  TfLiteTensor* bias =
+      graph.AddTensor(kTfLiteInt32, kTfLiteMmapRo, bias_data, {shape.output_c},
+                      bias_scales, shape.output_c, 0);
+  TfLiteTensor* output = graph.AddTensor(
+      kTfLiteInt8, kTfLiteArenaRw, kernel_output,
+      {shape.batches, output_h, output_w, shape.output_c}, &output_scale, 1,
+      RandomInt(-128, 127));
+
+  tflite::DepthwiseParams op_params;
+  op_params.padding_values.width = shape.pad_w;
+  op_params.padding_values.height = shape.pad_h;
+  op_params.stride_width = shape.stride_w;
+  op_params.stride_height = shape.stride_h;
+  op_params.dilation_width_factor = shape.dilation_w;
+  op_params.dilation_height_factor = shape.dilation_h;
+  op_params.depth_multiplier = depth_multiplier;
+  op_params.input_offset = -input->params.zero_point;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output->params.zero_point;
+  int32_t unused_multiplier;
+  int unused_shift;
+  if (tflite::PopulateConvolutionQuantizationParams(
+          ErrorContext(), input, filter, bias, output, params.activation,
+          &unused_multiplier, &unused_shift,
+          &op_params.quantized_activation_min,
+          &op_params.quantized_activation_max, output_multiplier,
+          reinterpret_cast<int*>(output_shift),
+          shape.output_c) != kTfLiteOk) {
+    ++failures;
+    return;
+  }
+
+  const tflite::RuntimeShape input_shape(
+      {shape.batches, shape.input_h, shape.input_w, shape.input_c});
+  const tflite::RuntimeShape filter_shape(
+      {1, shape.filter_h, shape.filter_w, shape.output_c});
+  const tflite::RuntimeShape bias_shape({shape.output_c});
+  const tflite::RuntimeShape output_shape(
+      {shape.batches, output_h, output_w, shape.output_c});
+  RunCase("depthwise_conv", shape, &graph,
+          tflite::ops::micro::Register_DEPTHWISE_CONV_2D(), &params, [&]() {
+            tflite::reference_integer_ops::DepthwiseConvPerChannel(
+                op_params, output_multiplier, output_shift, input_shape,
+                input_data, filter_shape, filter_data, bias_shape, bias_data,
+                output_shape, reference_output);
+          });
+}
+
+void RunFullyConnectedCase() {
+  CaseShape shape;
+  shape.batches = RandomChance(60) ? 1 : RandomInt(2, 4);
+  shape.input_c = RandomInt(1, 300);
+  shape.output_c = RandomInt(1, 40);
+
+  const int input_size = shape.batches * shape.input_c;
+  const int filter_size = shape.output_c * shape.input_c;
+  if (filter_size > kMaxTensorSize) {
+    return;
+  }
+  FillRandom(input_data, input_size);
+  FillRandom(filter_data, filter_size);
+  const float input_scale = RandomScale();
+  const float output_scale = RandomScale();
+  float filter_scale;
+  float bias_scale;
+  FillPerChannelQuantization(1, shape.input_c, input_scale, output_scale,
+                             &filter_scale, &bias_scale);
+  for (int i = 1; i < shape.output_c; ++i) {
+    bias_data[i] = RandomInt(-(1 << 14), 1 << 14);
+  }
+
+  TfLiteFullyConnectedParams params = {};
+  params.activation = RandomActivation();
+  params.weights_format = kTfLiteFullyConnectedWeightsFormatDefault;
+
+  // int8 weights are symmetric, so the filter zero point is always 0.
+  CaseGraph graph;
+  TfLiteTensor* input = graph.AddTensor(
+      kTfLiteInt8, kTfLiteArenaRw, input_data, {shape.batches, shape.input_c},
+      &input_scale, 1, RandomInt(-127, 127));
+  TfLiteTensor* filter =
+      graph.AddTensor(kTfLiteInt8, kTfLiteMmapRo, filter_data,
+                      {shape.output_c, shape.input_c}, &filter_scale, 1, 0);
+  TfLiteTensor* bias =
+      graph.AddTensor(kTfLiteInt32, kTfLiteMmapRo, bias_data, {shape.output_c},
+                      &bias_scale, 1, 0);
+  TfLiteTensor* output = graph.AddTensor(
+      kTfLiteInt8, kTfLiteArenaRw, kernel_output,
+      {shape.batches, shape.output_c}, &output_scale, 1, RandomInt(-128, 127));
+
+  tflite::FullyConnectedParams op_params;
+  op_params.input_offset = -input->params.zero_point;
+  op_params.weights_offset = 0;
+  op_params.output_offset = output->params.zero_point;
+  double real_multiplier = 0.0;
+  if (tflite::GetQuantizedConvolutionMultipler(ErrorContext(), input, filter,
+                                               bias, output,
+                                               &real_multiplier) !=
+          kTfLiteOk ||
+      tflite::CalculateActivationRangeQuantized(
+          ErrorContext(), params.activation, output,
+          &op_params.quantized_activation_min,
+          &op_params.quantized_activation_max) != kTfLiteOk) {
+    ++failures;
+    return;
+  }
+  int shift;
+  tflite::QuantizeMultiplier(real_multiplier, &op_params.output_multiplier,
+                             &shift);
+  op_params.output_shift = shift;
+
+  const tflite::RuntimeShape input_shape({shape.batches, shape.input_c});
+  const tflite::RuntimeShape filter_shape({shape.output_c, shape.input_c});
+  const tflite::RuntimeShape bias_shape({shape.output_c});
+  const tflite::RuntimeShape output_shape({shape.batches, shape.output_c});
+  RunCase("fully_connected", shape, &graph,
+          tflite::ops::micro::Register_FULLY_CONNECTED(), &params, [&]() {
+            tflite::reference_integer_ops::FullyConnected(
+                op_params, input_shape, input_data, filter_shape, filter_data,
+                bias_shape, bias_data, output_shape, reference_output);
+          });
+}
+
+void RunPoolingCase(bool average) {
+  CaseShape shape;
+  TfLitePadding padding;
+  int output_h = 0;
+  int output_w = 0;
+  do {
+    shape = CaseShape();
+    shape.batches = RandomChance(80) ? 1 : 2;
+    shape.input_h = RandomInt(1, 12);
+    shape.input_w = RandomInt(1, 12);
+    shape.input_c = RandomInt(1, 19);
+    shape.output_c = shape.input_c;
+    shape.filter_h = RandomInt(1, 5);
+    shape.filter_w = RandomInt(1, 5);
+  } while (!RandomSpatialShape(/*allow_dilation=*/false, &shape, &padding,
+                               &output_h, &output_w));
+
+  const int input_size =
+      shape.batches * shape.input_h * shape.input_w * shape.input_c;
+  const int output_size = shape.batches * output_h * output_w * shape.input_c;
+  if (input_size > kMaxTensorSize || output_size > kMaxTensorSize) {
+    return;
+  }
+  FillRandom(input_data, input_size);
+
+  TfLitePoolParams params = {};
+  params.padding = padding;
+  params.stride_width = shape.stride_w;
+  params.stride_height = shape.stride_h;
+  params.filter_width = shape.filter_w;
+  params.filter_height = shape.filter_h;
+  params.activation = RandomActivation();
+
+  // Pooling does not requantize: the output has the input's parameters.
+  const float scale = RandomScale();
+  const int32_t zero_point = RandomInt(-128, 127);
+  CaseGraph graph;
+  graph.AddTensor(kTfLiteInt8, kTfLiteArenaRw, input_data,
+                  {shape.batches, shape.input_h, shape.input_w, shape.input_c},
+                  &scale, 1, zero_point);
+  TfLiteTensor* output = graph.AddTensor(
+      kTfLiteInt8, kTfLiteArenaRw, kernel_output,
+      {shape.batches, output_h, output_w, shape.input_c}, &scale, 1,
+      zero_point);
+
+  tflite::PoolParams op_params;
+  op_params.stride_height = shape.stride_h;
+  op_params.stride_width = shape.stride_w;
+  op_params.filter_height = shape.filter_h;
+  op_params.filter_width = shape.filter_w;
+  op_params.padding_values.height = shape.pad_h;
+  op_params.padding_values.width = shape.pad_w;
+  if (tflite::CalculateActivationRangeQuantized(
+          ErrorContext(), params.activation, output,
+          &op_params.quantized_activation_min,
+          &op_params.quantized_activation_max) != kTfLiteOk) {
+    ++failures;
+    return;
+  }
+
+  const tflite::RuntimeShape input_shape(
+      {shape.batches, shape.input_h, shape.input_w, shape.input_c});
+  const tflite::RuntimeShape output_shape(
+      {shape.batches, output_h, output_w, shape.input_c});
+  if (average) {
+    RunCase("average_pool", shape, &graph,
+            tflite::ops::micro::Register_AVERAGE_POOL_2D(), &params, [&]() {
+              tflite::reference_integer_ops::AveragePool(
+                  op_params, input_shape, input_data, output_shape,
+                  reference_output);
+            });
+  } else {
+    RunCase("max_pool", shape, &graph,
+            tflite::ops::micro::Register_MAX_POOL_2D(), &params, [&]() {
+              tflite::reference_integer_ops::MaxPool(op_params, input_shape,
+                                                     input_data, output_shape,
+                                                     reference_output);
+            });
+  }
+}
+
+// Quantization parameters for ADD and MUL are derived from random scales the
+// same way the kernels do.
+void RunElementwiseCase(bool add) {
+  CaseShape shape;
+  shape.input_c = RandomChance(50) ? RandomInt(1, 64) : RandomInt(65, 4096);
+  shape.output_c = shape.input_c;
+  const int size = shape.input_c;
+  FillRandom(input_data, size);
+  FillRandom(input2_data, size);
+
+  const float input1_scale = RandomScale();
+  const float input2_scale = RandomScale();
+  const float output_scale = RandomScale();
+  const TfLiteFusedActivation activation = RandomActivation();
+
+  CaseGraph graph;
+  TfLiteTensor* input1 =
+      graph.AddTensor(kTfLiteInt8, kTfLiteArenaRw, input_data, {size},
+                      &input1_scale, 1, RandomInt(-127, 127));
+  TfLiteTensor* input2 =
+      graph.AddTensor(kTfLiteInt8, kTfLiteArenaRw, input2_data, {size},
+                      &input2_scale, 1, RandomInt(-127, 127));
+  TfLiteTensor* output =
+      graph.AddTensor(kTfLiteInt8, kTfLiteArenaRw, kernel_output, {size},
+                      &output_scale, 1, RandomInt(-128, 127));
+
+  tflite::ArithmeticParams op_params;
+  op_params.input1_offset = -input1->params.zero_point;
+  op_params.input2_offset = -input2->params.zero_point;
+  op_params.output_offset = output->params.zero_point;
+  int32_t activation_min = 0;
+  int32_t activation_max = 0;
+  if (tflite::CalculateActivationRangeQuantized(
+          ErrorContext(), activation, output, &activation_min,
+          &activation_max) != kTfLiteOk) {
+    ++failures;
+    return;
+  }
+  tflite::SetActivationParams(activation_min, activation_max, &op_params);
+
+  if (add) {
+    op_params.left_shift = 20;
+    const double twice_max_input_scale =
+        2 * static_cast<double>(
+                input1_scale > input2_scale ? input1_scale : input2_scale);
+    tflite::QuantizeMultiplierSmallerThanOneExp(
+        input1_scale / twice_max_input_scale, &op_params.input1_multiplier,
+        &op_params.input1_shift);
+    tflite::QuantizeMultiplierSmallerThanOneExp(
+        input2_scale / twice_max_input_scale, &op_params.input2_multiplier,
+        &op_params.input2_shift);
+    tflite::QuantizeMultiplierSmallerThanOneExp(
+        twice_max_input_scale /
+            ((1 << op_params.left_shift) * static_cast<double>(output_scale)),
+        &op_params.output_multiplier, &op_params.output_shift);
+  } else {
+    tflite::QuantizeMultiplier(static_cast<double>(input1_scale) *
+                                   input2_scale / output_scale,
+                               &op_params.output_multiplier,
+                               &op_params.output_shift);
+  }
+
+  const tflite::RuntimeShape flat_shape({size});
+  if (add) {
+    TfLiteAddParams params = {activation};
+    RunCase("add", shape, &graph, tflite::ops::micro::Register_ADD(), &params,
+            [&]() {
+              tflite::reference_integer_ops::Add(
+                  op_params, flat_shape, input_data, flat_shape, input2_data,
+                  flat_shape, reference_output);
+            });
+  } else {
+    TfLiteMulParams params = {activation};
+    RunCase("mul", shape, &graph, tflite::ops::micro::Register_MUL(), &params,
+            [&]() {
+              tflite::reference_integer_ops::Mul(
+                  op_params, flat_shape, input_data, flat_shape, input2_data,
+                  flat_shape, reference_output);
+            });
+  }
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  const int cases_per_op = argc > 1 ? atoi(argv[1]) : kDefaultCasesPerOp;
+  if (argc > 2) {
+    random_state = static_cast<uint32_t>(strtoul(argv[2], nullptr, 10));
+  }
+
+  printf(
+      "op,batches,input_h,input_w,input_c,filter_h,filter_w,output_c,"
+      "stride_h,stride_w,dilation_h,dilation_w,pad_h,pad_w,result,"
+      "mismatches,reference_us,kernel_us,speedup\n");
+  for (int i = 0; i < cases_per_op; ++i) {
+    RunConvCase();
+    RunDepthwiseConvCase();
+    RunFullyConnectedCase();
+    RunPoolingCase(/*average=*/true);
+    RunPoolingCase(/*average=*/false);
+    RunElementwiseCase(/*add=*/true);
+    RunElementwiseCase(/*add=*/false);
+  }
+
+  if (failures > 0) {
+    TF_LITE_REPORT_ERROR(&micro_error_reporter,
+                         "%d cases are not bit-exact", failures);
+    return 1;
+  }
+  return 0;
+}
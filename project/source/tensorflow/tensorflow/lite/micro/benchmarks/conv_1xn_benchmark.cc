@@ -0,0 +1,390 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Compares the generic CMSIS-NN int8 convolution (im2col followed by a matrix
+// multiplication) with the dedicated 1xN kernel on the temporal convolutions
+// of the emergency-detect and emergency-detect-82 audio models. Both models
+// run conv1d as a CONV_2D with a height of 1 over the raw 11025-sample window.
+//
+// Usage: conv_1xn_benchmark <model.tflite>...
+//
+// Every CONV_2D of the given models whose input and filter heights are 1 is
+// run with its own shape, stride, padding, fused activation, weights and
+// bias. Float weights are quantized symmetrically per output channel, int8
+// weights (emergency-detect.tflite stores the second conv that way) are used
+// as they are. The models are float, so there are no activation scales to
+// take over: the input is random int8 data and the output scale is chosen so
+// that it spans the int8 range. The outputs of both kernels are checked to be
+// bit-exact.
+//
+// The whole of emergency-detect-82 can not be run instead, its REDUCE_MAX has
+// no micro kernel.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_time.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+constexpr int kRuns = 3;
+constexpr float kInputScale = 1.0f / 128;
+constexpr int32_t kInputZeroPoint = -3;
+constexpr int32_t kOutputZeroPoint = 5;
+
+uint32_t random_state = 1;
+
+int8_t NextRandomInt8() {
+  random_state = random_state * 1664525u + 1013904223u;
+  return static_cast<int8_t>(random_state >> 24);
+}
+
+int32_t TicksToMicroseconds(int64_t ticks) {
+  const int32_t tps = tflite::ticks_per_second();
+  if (tps == 0) {
+    return 0;
+  }
+  return static_cast<int32_t>(ticks * 1000000 / tps);
+}
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data->resize(size > 0 ? size : 0);
+  const bool ok = size > 0 && fread(data->data(), 1, size, file) ==
+                                  static_cast<size_t>(size);
+  fclose(file);
+  return ok;
+}
+
+// A conv1d layer of a model, with its weights quantized to int8.
+struct Conv1xNLayer {
+  int index;
+  cmsis_nn_conv_params conv_params;
+  cmsis_nn_dims input_dims;
+  cmsis_nn_dims filter_dims;
+  cmsis_nn_dims bias_dims;
+  cmsis_nn_dims output_dims;
+  std::vector<int8_t> filter;
+  std::vector<int32_t> bias;
+  std::vector<int32_t> output_multiplier;
+  std::vector<int32_t> output_shift;
+};
+
+const tflite::Buffer* TensorBuffer(const tflite::Model* model,
+                                   const tflite::Tensor* tensor) {
+  const tflite::Buffer* buffer = model->buffers()->Get(tensor->buffer());
+  if (buffer == nullptr || buffer->data() == nullptr ||
+      buffer->data()->size() == 0) {
+    return nullptr;
+  }
+  return buffer;
+}
+
+// Fills the int8 filter and returns the scale of every output channel.
+bool QuantizeFilter(const tflite::Model* model, const tflite::Tensor* tensor,
+                    int output_c, int channel_size,
+                    std::vector<int8_t>* filter, std::vector<float>* scales) {
+  const tflite::Buffer* buffer = TensorBuffer(model, tensor);
+  if (buffer == nullptr) {
+    return false;
+  }
+  filter->resize(output_c * channel_size);
+  scales->resize(output_c);
+  if (tensor->type() == tflite::TensorType_INT8) {
+    const tflite::QuantizationParameters* quantization =
+        tensor->quantization();
+    if (buffer->data()->size() != filter->size() || quantization == nullptr ||
+        quantization->scale() == nullptr ||
+        quantization->scale()->size() == 0) {
+      return false;
+    }
+    memcpy(filter->data(), buffer->data()->data(), filter->size());
+    for (int c = 0; c < output_c; ++c) {
+      const int index = quantization->scale()->size() > 1 ? c : 0;
+      (*scales)[c] = quantization->scale()->Get(index);
+    }
+    return true;
+  }
+  if (tensor->type() != tflite::TensorType_FLOAT32 ||
+      buffer->data()->size() != filter->size() * sizeof(float)) {
+    return false;
+  }
+  const float* weights = reinterpret_cast<const float*>(buffer->data()->data());
+  for (int c = 0; c < output_c; ++c) {
+    float max_abs = 0.0f;
+    for (int i = 0; i < channel_size; ++i) {
+      max_abs = std::max(max_abs, std::fabs(weights[c * channel_size + i]));
+    }
+    const float scale = max_abs > 0.0f ? max_abs / 127 : 1.0f;
+    (*scales)[c] = scale;
+    for (int i = 0; i < channel_size; ++i) {
+      const int32_t value = static_cast<int32_t>(
+          std::round(weights[c * channel_size + i] / scale));
+      (*filter)[c * channel_size + i] =
+          static_cast<int8_t>(std::min(127, std::max(-127, value)));
+    }
+  }
+  return true;
+}
+
+// Reads the CONV_2D at `op` if it is a batch 1 conv1d, see the file comment.
+bool ReadLayer(const tflite::Model* model, const tflite::Operator* op,
+               Conv1xNLayer* layer) {
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  const tflite::Conv2DOptions* options = op->builtin_options_as_Conv2DOptions();
+  if (options == nullptr || op->inputs()->size() < 2 ||
+      op->outputs()->size() != 1) {
+    return false;
+  }
+  const tflite::Tensor* input = subgraph->tensors()->Get(op->inputs()->Get(0));
+  const tflite::Tensor* filter =
+      subgraph->tensors()->Get(op->inputs()->Get(1));
+  const tflite::Tensor* output =
+      subgraph->tensors()->Get(op->outputs()->Get(0));
+  const tflite::Tensor* bias =
+      op->inputs()->size() > 2 && op->inputs()->Get(2) >= 0
+          ? subgraph->tensors()->Get(op->inputs()->Get(2))
+          : nullptr;
+  if (input->shape()->size() != 4 || filter->shape()->size() != 4 ||
+      output->shape()->size() != 4 || input->shape()->Get(0) != 1 ||
+      input->shape()->Get(1) != 1 || filter->shape()->Get(1) != 1 ||
+      options->dilation_w_factor() != 1) {
+    return false;
+  }
+
+  layer->input_dims = {1, 1, input->shape()->Get(2), input->shape()->Get(3)};
+  layer->filter_dims = {filter->shape()->Get(0), 1, filter->shape()->Get(2),
+                        filter->shape()->Get(3)};
+  layer->output_dims = {1, 1, output->shape()->Get(2),
+                        output->shape()->Get(3)};
+  layer->bias_dims = {1, 1, 1, layer->output_dims.c};
+  const int output_c = layer->output_dims.c;
+  const int channel_size = layer->filter_dims.w * layer->filter_dims.c;
+
+  std::vector<float> filter_scales;
+  if (!QuantizeFilter(model, filter, output_c, channel_size, &layer->filter,
+                      &filter_scales)) {
+    return false;
+  }
+
+  cmsis_nn_conv_params& conv_params = layer->conv_params;
+  conv_params.input_offset = -kInputZeroPoint;
+  conv_params.output_offset = kOutputZeroPoint;
+  conv_params.stride.h = 1;
+  conv_params.stride.w = options->stride_w();
+  conv_params.padding.h = 0;
+  conv_params.padding.w = 0;
+  if (options->padding() == tflite::Padding_SAME) {
+    const int total = (layer->output_dims.w - 1) * conv_params.stride.w +
+                      layer->filter_dims.w - layer->input_dims.w;
+    conv_params.padding.w = std::max(total, 0) / 2;
+  }
+  conv_params.dilation.h = 1;
+  conv_params.dilation.w = 1;
+  const bool relu = options->fused_activation_function() ==
+                    tflite::ActivationFunctionType_RELU;
+  conv_params.activation.min = relu ? kOutputZeroPoint : -128;
+  conv_params.activation.max = 127;
+
+  // With random inputs, which have a standard deviation of about 74, the
+  // accumulator of a channel has one of 74 times the norm of its weights.
+  // Four of those of the widest channel fill the output range.
+  float max_deviation = 0.0f;
+  for (int c = 0; c < output_c; ++c) {
+    float sum_of_squares = 0.0f;
+    for (int i = 0; i < channel_size; ++i) {
+      const float weight = layer->filter[c * channel_size + i];
+      sum_of_squares += weight * weight;
+    }
+    max_deviation = std::max(
+        max_deviation, filter_scales[c] * 74 * std::sqrt(sum_of_squares));
+  }
+  const float output_scale = kInputScale * max_deviation * 4 / 128;
+
+  const float* bias_data = nullptr;
+  if (bias != nullptr && bias->type() == tflite::TensorType_FLOAT32) {
+    const tflite::Buffer* buffer = TensorBuffer(model, bias);
+    if (buffer != nullptr &&
+        buffer->data()->size() == output_c * sizeof(float)) {
+      bias_data = reinterpret_cast<const float*>(buffer->data()->data());
+    }
+  }
+  layer->bias.resize(output_c);
+  layer->output_multiplier.resize(output_c);
+  layer->output_shift.resize(output_c);
+  for (int c = 0; c < output_c; ++c) {
+    const double accumulator_scale =
+        static_cast<double>(kInputScale) * filter_scales[c];
+    layer->bias[c] =
+        bias_data != nullptr
+            ? static_cast<int32_t>(std::round(bias_data[c] / accumulator_scale))
+            : 0;
+    int shift;
+    tflite::QuantizeMultiplier(accumulator_scale / output_scale,
+                               &layer->output_multiplier[c], &shift);
+    layer->output_shift[c] = shift;
+  }
+  return true;
+}
+
+bool RunLayer(tflite::ErrorReporter* error_reporter, const char* model_name,
+              Conv1xNLayer* layer) {
+  std::vector<int8_t> input(layer->input_dims.w * layer->input_dims.c);
+  for (int8_t& value : input) {
+    value = NextRandomInt8();
+  }
+  const size_t output_size = layer->output_dims.w * layer->output_dims.c;
+  std::vector<int8_t> generic_output(output_size);
+  std::vector<int8_t> conv_1xn_output(output_size);
+
+  cmsis_nn_per_channel_quant_params quant_params;
+  quant_params.multiplier = layer->output_multiplier.data();
+  quant_params.shift = layer->output_shift.data();
+
+  cmsis_nn_context generic_ctx;
+  generic_ctx.size =
+      arm_convolve_s8_get_buffer_size(&layer->input_dims, &layer->filter_dims);
+  std::vector<int16_t> generic_scratch(generic_ctx.size / sizeof(int16_t) + 1);
+  generic_ctx.buf = generic_scratch.data();
+  cmsis_nn_context conv_1xn_ctx;
+  conv_1xn_ctx.size = arm_convolve_1_x_n_s8_get_buffer_size(
+      &layer->input_dims, &layer->filter_dims);
+  std::vector<int16_t> conv_1xn_scratch(conv_1xn_ctx.size / sizeof(int16_t) +
+                                        1);
+  conv_1xn_ctx.buf = conv_1xn_scratch.data();
+
+  // Ticks are subtracted as uint32_t, so a wrap of the tick counter between
+  // two readings does not matter, and summed in 64 bits.
+  int64_t generic_ticks = 0;
+  int64_t conv_1xn_ticks = 0;
+  for (int run = 0; run < kRuns; ++run) {
+    uint32_t start = tflite::GetCurrentTimeTicks();
+    arm_status status = arm_convolve_s8(
+        &generic_ctx, &layer->conv_params, &quant_params, &layer->input_dims,
+        input.data(), &layer->filter_dims, layer->filter.data(),
+        &layer->bias_dims, layer->bias.data(), &layer->output_dims,
+        generic_output.data());
+    generic_ticks +=
+        static_cast<uint32_t>(tflite::GetCurrentTimeTicks()) - start;
+    if (status != ARM_MATH_SUCCESS) {
+      TF_LITE_REPORT_ERROR(error_reporter, "%s/conv_%d: generic kernel failed",
+                           model_name, layer->index);
+      return false;
+    }
+
+    start = tflite::GetCurrentTimeTicks();
+    status = arm_convolve_1_x_n_s8(
+        &conv_1xn_ctx, &layer->conv_params, &quant_params, &layer->input_dims,
+        input.data(), &layer->filter_dims, layer->filter.data(),
+        &layer->bias_dims, layer->bias.data(), &layer->output_dims,
+        conv_1xn_output.data());
+    conv_1xn_ticks +=
+        static_cast<uint32_t>(tflite::GetCurrentTimeTicks()) - start;
+    if (status != ARM_MATH_SUCCESS) {
+      TF_LITE_REPORT_ERROR(error_reporter, "%s/conv_%d: 1xN kernel failed",
+                           model_name, layer->index);
+      return false;
+    }
+  }
+
+  if (memcmp(generic_output.data(), conv_1xn_output.data(), output_size) !=
+      0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "%s/conv_%d: outputs differ",
+                         model_name, layer->index);
+    return false;
+  }
+
+  generic_ticks /= kRuns;
+  conv_1xn_ticks /= kRuns;
+  TF_LITE_REPORT_ERROR(
+      error_reporter,
+      "%s/conv_%d (%dx%d, %d taps, %d filters): generic %d ticks (%d us, "
+      "scratch %d bytes), 1xN %d ticks (%d us, scratch %d bytes)",
+      model_name, layer->index, layer->input_dims.w, layer->input_dims.c,
+      layer->filter_dims.w, layer->filter_dims.n,
+      static_cast<int>(generic_ticks), TicksToMicroseconds(generic_ticks),
+      generic_ctx.size, static_cast<int>(conv_1xn_ticks),
+      TicksToMicroseconds(conv_1xn_ticks), conv_1xn_ctx.size);
+  return true;
+}
+
+bool RunModel(tflite::ErrorReporter* error_reporter, const char* path) {
+  std::vector<uint8_t> model_data;
+  if (!ReadFile(path, &model_data)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot read %s", path);
+    return false;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  if (model->version() != TFLITE_SCHEMA_VERSION ||
+      model->subgraphs()->size() == 0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "%s: unsupported model", path);
+    return false;
+  }
+  const char* model_name = strrchr(path, '/');
+  model_name = model_name != nullptr ? model_name + 1 : path;
+
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  int layers = 0;
+  bool ok = true;
+  for (const tflite::Operator* op : *subgraph->operators()) {
+    const tflite::OperatorCode* opcode =
+        model->operator_codes()->Get(op->opcode_index());
+    if (opcode->builtin_code() != tflite::BuiltinOperator_CONV_2D) {
+      continue;
+    }
+    Conv1xNLayer layer;
+    if (!ReadLayer(model, op, &layer)) {
+      continue;
+    }
+    layer.index = ++layers;
+    ok &= RunLayer(error_reporter, model_name, &layer);
+  }
+  if (layers == 0) {
+    TF_LITE_REPORT_ERROR(error_reporter, "%s: no conv1d layers", path);
+    return false;
+  }
+  return ok;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  if (argc < 2) {
+    TF_LITE_REPORT_ERROR(&micro_error_reporter,
+                         "Usage: conv_1xn_benchmark <model.tflite>...");
+    return 1;
+  }
+  bool ok = true;
+  for (int i = 1; i < argc; ++i) {
+    ok &= RunModel(&micro_error_reporter, argv[i]);
+  }
+  return ok ? 0 : 1;
+}
@@ -0,0 +1,88 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+
+#include "tensorflow/lite/c/common.h"
+
+namespace tflite {
+namespace micro {
+
+TfLiteStatus GetBlockSparseWeights(TfLiteContext* context,
+                                   const TfLiteTensor* tensor, int rows,
+                                   int cols, BlockSparseWeights* result) {
+  const TfLiteSparsity* sparsity = tensor->sparsity;
+  TF_LITE_ENSURE(context, sparsity != nullptr);
+  TF_LITE_ENSURE_EQ(context, tensor->allocation_type, kTfLiteMmapRo);
+  const TfLiteIntArray* traversal_order = sparsity->traversal_order;
+  const TfLiteIntArray* block_map = sparsity->block_map;
+  const TfLiteDimensionMetadata* dim_metadata = sparsity->dim_metadata;
+
+  // Either [rows, cols, block_rows, block_cols] blocked along both
+  // dimensions, or [rows, cols, block_cols] blocked along cols only.
+  const int num_dims = sparsity->dim_metadata_size;
+  TF_LITE_ENSURE_MSG(context, num_dims == 3 || num_dims == 4,
+                     "Block-sparse weights must be a 2D view of blocks.");
+  TF_LITE_ENSURE_EQ(context, traversal_order->size, num_dims);
+  for (int i = 0; i < num_dims; ++i) {
+    TF_LITE_ENSURE_EQ(context, traversal_order->data[i], i);
+  }
+  TF_LITE_ENSURE_EQ(context, block_map->size, num_dims - 2);
+  if (num_dims == 4) {
+    TF_LITE_ENSURE_EQ(context, block_map->data[0], 0);
+    TF_LITE_ENSURE_EQ(context, block_map->data[1], 1);
+  } else {
+    TF_LITE_ENSURE_EQ(context, block_map->data[0], 1);
+  }
+  TF_LITE_ENSURE_EQ(context, dim_metadata[0].format, kTfLiteDimDense);
+  TF_LITE_ENSURE_EQ(context, dim_metadata[1].format, kTfLiteDimSparseCSR);
+  for (int i = 2; i < num_dims; ++i) {
+    TF_LITE_ENSURE_EQ(context, dim_metadata[i].format, kTfLiteDimDense);
+  }
+
+  const int block_rows = num_dims == 4 ? dim_metadata[2].dense_size : 1;
+  const int block_cols = dim_metadata[num_dims - 1].dense_size;
+  TF_LITE_ENSURE(context, block_rows > 0 && block_cols > 0);
+  TF_LITE_ENSURE_EQ(context, rows % block_rows, 0);
+  TF_LITE_ENSURE_EQ(context, cols % block_cols, 0);
+  const int num_block_rows = rows / block_rows;
+  const int num_block_cols = cols / block_cols;
+  TF_LITE_ENSURE_EQ(context, dim_metadata[0].dense_size, num_block_rows);
+
+  // The kernels trust the indices at invoke time.
+  const TfLiteIntArray* segments = dim_metadata[1].array_segments;
+  const TfLiteIntArray* indices = dim_metadata[1].array_indices;
+  TF_LITE_ENSURE_EQ(context, segments->size, num_block_rows + 1);
+  TF_LITE_ENSURE_EQ(context, segments->data[0], 0);
+  for (int i = 0; i < num_block_rows; ++i) {
+    TF_LITE_ENSURE(context, segments->data[i] <= segments->data[i + 1]);
+  }
+  TF_LITE_ENSURE_EQ(context, segments->data[num_block_rows], indices->size);
+  for (int i = 0; i < indices->size; ++i) {
+    TF_LITE_ENSURE(context,
+                   indices->data[i] >= 0 && indices->data[i] < num_block_cols);
+  }
+
+  result->rows = rows;
+  result->cols = cols;
+  result->block_rows = block_rows;
+  result->block_cols = block_cols;
+  result->segments = segments->data;
+  result->indices = indices->data;
+  return kTfLiteOk;
+}
+
+}  // namespace micro
+}  // namespace tflite
@@ -0,0 +1,165 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/kernels/conv_patch.h"
+
+namespace tflite {
+namespace micro {
+
+// Block-sparse weights of FULLY_CONNECTED and CONV_2D, as written by
+// tools/block_sparse_converter.cc.
+//
+// The weights are seen as a [rows, cols] matrix: rows are the output channels
+// and cols the remaining dimensions flattened in their serialized order (H, W
+// and I for conv filters), the order in which the kernels accumulate them.
+// The matrix is cut into block_rows x block_cols blocks, and only the blocks
+// with a nonzero value are stored, row-major inside each block and in block
+// order in the tensor's buffer. The tensor keeps its dense shape, and its
+// sparsity parameters describe the blocks in the standard TFLite format:
+//
+//   traversal_order: [0, 1, 2, 3]        block_map: [0, 1]
+//   dim_metadata:    [DENSE rows / block_rows,
+//                     SPARSE_CSR cols / block_cols,
+//                     DENSE block_rows, DENSE block_cols]
+//
+// or, for block_rows == 1, the [0, 1, 2] / [1] form TFLite uses for 1x4
+// blocks, without the third dimension. The CSR segments and indices must be
+// int32; they are read in place from the model.
+//
+// A missing block stands for filter values equal to the filter zero point, so
+// quantized results are exactly those of the dense kernels on the pruned
+// weights.
+struct BlockSparseWeights {
+  int rows;
+  int cols;
+  int block_rows;
+  int block_cols;
+  // Block rows + 1 offsets into `indices`: the stored blocks of block row r
+  // are segments[r] to segments[r + 1] - 1.
+  const int32_t* segments;
+  // Block column of each stored block.
+  const int32_t* indices;
+};
+
+// Reads the block-sparse encoding of `tensor` as a [rows, cols] matrix into
+// `result`, reporting an error if it is not in the format above.
+TfLiteStatus GetBlockSparseWeights(TfLiteContext* context,
+                                   const TfLiteTensor* tensor, int rows,
+                                   int cols, BlockSparseWeights* result);
+
+// Multiplies the weights by the vector `input` of `weights.cols` values and
+// calls `output_stage(acc, row)` with the accumulator of every row. Each row
+// is accumulated in ascending column order like the dense reference kernels,
+// skipping the missing blocks.
+template <typename T, typename AccT, typename OutputStage>
+inline void BlockSparseMatVec(const BlockSparseWeights& weights,
+                              const T* values, AccT filter_offset,
+                              const T* input, AccT input_offset,
+                              const OutputStage& output_stage) {
+  const int block_rows = weights.block_rows;
+  const int block_cols = weights.block_cols;
+  const int block_size = block_rows * block_cols;
+  for (int block_row = 0; block_row * block_rows < weights.rows; ++block_row) {
+    const int begin = weights.segments[block_row];
+    const int end = weights.segments[block_row + 1];
+    for (int i = 0; i < block_rows; ++i) {
+      AccT acc = 0;
+      for (int block = begin; block < end; ++block) {
+        const T* block_values = values + block * block_size + i * block_cols;
+        const T* block_input = input + weights.indices[block] * block_cols;
+        for (int j = 0; j < block_cols; ++j) {
+          acc += AccumulatorTerm(block_values[j], filter_offset) *
+                 AccumulatorTerm(block_input[j], input_offset);
+        }
+      }
+      output_stage(acc, block_row * block_rows + i);
+    }
+  }
+}
+
+// Fully connected layer over `batches` input rows of `weights.cols` values.
+// `output_stage(acc, out_channel)` adds the bias and requantizes or clamps.
+template <typename T, typename AccT, typename OutputStage>
+inline void BlockSparseFullyConnected(const BlockSparseWeights& weights,
+                                      const T* values, AccT filter_offset,
+                                      int batches, const T* input_data,
+                                      AccT input_offset, T* output_data,
+                                      const OutputStage& output_stage) {
+  for (int b = 0; b < batches; ++b) {
+    T* output_row = output_data + b * weights.rows;
+    BlockSparseMatVec(weights, values, filter_offset,
+                      input_data + b * weights.cols, input_offset,
+                      [&](AccT acc, int out_channel) {
+                        output_row[out_channel] =
+                            output_stage(acc, out_channel);
+                      });
+  }
+}
+
+// Convolution with block-sparse filters of shape `filter_shape`. The receptive
+// field of each output pixel is gathered into `patch` (weights.cols values),
+// with `pad_value` (the input zero point, or 0 for float) for the taps outside
+// the image so that they add nothing, then multiplied by the weights.
+template <typename T, typename AccT, typename OutputStage>
+inline void BlockSparseConv(const ConvParams& params,
+                            const BlockSparseWeights& weights,
+                            const T* values, AccT filter_offset,
+                            const RuntimeShape& input_shape,
+                            const T* input_data, AccT input_offset,
+                            T pad_value, const RuntimeShape& filter_shape,
+                            const RuntimeShape& output_shape, T* output_data,
+                            T* patch, const OutputStage& output_stage) {
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  TFLITE_DCHECK_EQ(weights.rows, output_depth);
+  TFLITE_DCHECK_EQ(weights.cols, filter_height * filter_width * input_depth);
+
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        GatherConvPatch(params, input_shape, input_data, filter_height,
+                        filter_width, batch, out_y, out_x, pad_value, patch);
+        T* output_pixel =
+            &output_data[Offset(output_shape, batch, out_y, out_x, 0)];
+        BlockSparseMatVec(weights, values, filter_offset, patch, input_offset,
+                          [&](AccT acc, int out_channel) {
+                            output_pixel[out_channel] =
+                                output_stage(acc, out_channel);
+                          });
+      }
+    }
+  }
+}
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_BLOCK_SPARSE_H_
@@ -0,0 +1,848 @@
+/* Copyright 2019 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/kernels/internal/reference/conv.h"
+
+#include "cmsis/CMSIS/NN/Include/arm_nnfunctions.h"
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/reference/integer_ops/conv.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/palettized.h"
+
+namespace tflite {
+namespace ops {
+namespace micro {
+namespace conv {
+
+constexpr int kInputTensor = 0;
+constexpr int kFilterTensor = 1;
+constexpr int kBiasTensor = 2;
+constexpr int kOutputTensor = 0;
+
+// Conv is quantized along dimension 0:
+// https://www.tensorflow.org/lite/performance/quantization_spec
+constexpr int kConvQuantizedDimension = 0;
+
+// Largest filter, in bytes, that is copied into the persistent arena in the
+// layout of arm_convolve_s8_packed(). The copy sits next to the activations,
+// in TCM on the MT3620 RT core, so larger filters are reordered in the inner
+// loop of arm_convolve_s8 instead. arena_budget counts the copies.
+constexpr int32_t kMaxPackedFilterBytes = 2048;
+
+// This file has 2 implementation of Conv.
+
+struct OpData {
+  TfLitePaddingValues padding;
+  // The scaling factor from input to output (aka the 'real multiplier') can
+  // be represented as a fixed point multiplier plus a left shift.
+  int32_t output_multiplier;
+  int output_shift;
+
+  // Per channel output multiplier and shift.
+  int32_t* per_channel_output_multiplier;
+  int32_t* per_channel_output_shift;
+
+  // The range of the fused activation layer. For example for kNone and
+  // uint8_t these would be 0 and 255.
+  int32_t output_activation_min;
+  int32_t output_activation_max;
+
+  // Index of the im2col scratch buffer for the CMSIS-NN kernels, -1 if none.
+  int buffer_idx;
+
+  // Copy of the filter in the layout of arm_convolve_s8_packed(), written
+  // once in Prepare(), or nullptr when the layer takes another kernel or the
+  // filter is larger than kMaxPackedFilterBytes. It is a persistent arena
+  // buffer of the filter's size.
+  int8_t* packed_filter;
+
+  // Quantization parameters, which are only available in Prepare().
+  int32_t input_zero_point;
+  int32_t filter_zero_point;
+  int32_t output_zero_point;
+
+  // Set for block-sparse or palettized filters, which take EvalCompressed()
+  // with its patch in the scratch buffer `buffer_idx`, and for palettized ones
+  // their tile in `tile_idx`.
+  bool is_sparse;
+  tflite::micro::BlockSparseWeights sparse_weights;
+  bool is_palettized;
+  tflite::micro::PalettizedWeights palettized_weights;
+  int tile_idx;
+};
+
+#if defined(__ARM_FEATURE_DSP)
+// 1x1 filters with unit stride and no padding are a plain matrix
+// multiplication.
+inline bool UseConv1x1Fast(const cmsis_nn_conv_params& conv_params,
+                           const cmsis_nn_dims& input_dims,
+                           const cmsis_nn_dims& filter_dims) {
+  return conv_params.padding.w == 0 && conv_params.padding.h == 0 &&
+         input_dims.c % 4 == 0 && conv_params.stride.w == 1 &&
+         conv_params.stride.h == 1 && filter_dims.w == 1 &&
+         filter_dims.h == 1;
+}
+
+// Temporal convolutions, i.e. conv1d lowered to CONV_2D with a height of 1,
+// slide over contiguous rows of the input and need neither im2col nor
+// padded kernel taps.
+inline bool UseConv1xN(const cmsis_nn_conv_params& conv_params,
+                       const cmsis_nn_dims& input_dims,
+                       const cmsis_nn_dims& filter_dims,
+                       const cmsis_nn_dims& output_dims) {
+#if defined(ARM_MATH_MVEI)
+  // The MVE kernel computes four output columns at a time.
+  if (output_dims.w % 4 != 0) {
+    return false;
+  }
+#endif
+  return input_dims.n == 1 && input_dims.h == 1 && filter_dims.h == 1 &&
+         output_dims.h == 1 && conv_params.dilation.w == 1;
+}
+#endif
+
+inline PaddingType RuntimePaddingType(TfLitePadding padding) {
+  switch (padding) {
+    case TfLitePadding::kTfLitePaddingSame:
+      return PaddingType::kSame;
+    case TfLitePadding::kTfLitePaddingValid:
+      return PaddingType::kValid;
+    case TfLitePadding::kTfLitePaddingUnknown:
+    default:
+      return PaddingType::kNone;
+  }
+}
+
+TfLiteStatus CalculateOpData(TfLiteContext* context, TfLiteNode* node,
+                             const TfLiteConvParams* params, int width,
+                             int height, int filter_width, int filter_height,
+                             int out_width, int out_height,
+                             const TfLiteType data_type, OpData* data) {
+  bool has_bias = node->inputs->size == 3;
+  // Check number of inputs/outputs
+  TF_LITE_ENSURE(context, has_bias || node->inputs->size == 2);
+  TF_LITE_ENSURE_EQ(context, node->outputs->size, 1);
+
+  // Matching GetWindowedOutputSize in TensorFlow.
+  auto padding = params->padding;
+  data->padding = ComputePaddingHeightWidth(
+      params->stride_height, params->stride_width,
+      params->dilation_height_factor, params->dilation_width_factor, height,
+      width, filter_height, filter_width, padding, &out_height, &out_width);
+
+  // Note that quantized inference requires that all tensors have their
+  // parameters set. This is usually done during quantized training.
+  if (data_type != kTfLiteFloat32) {
+    const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+    const TfLiteTensor* filter = GetInput(context, node, kFilterTensor);
+    const TfLiteTensor* bias =
+        GetOptionalInputTensor(context, node, kBiasTensor);
+    TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+    int output_channels = filter->dims->data[kConvQuantizedDimension];
+
+    TF_LITE_ENSURE_STATUS(tflite::PopulateConvolutionQuantizationParams(
+        context, input, filter, bias, output, params->activation,
+        &data->output_multiplier, &data->output_shift,
+        &data->output_activation_min, &data->output_activation_max,
+        data->per_channel_output_multiplier,
+        reinterpret_cast<int*>(data->per_channel_output_shift),
+        output_channels));
+  }
+  return kTfLiteOk;
+}
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  void* data = nullptr;
+  if (context->AllocatePersistentBuffer(context, sizeof(OpData), &data) ==
+      kTfLiteError) {
+    return nullptr;
+  }
+  return data;
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto params = static_cast<const TfLiteConvParams*>(node->builtin_data);
+
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  const TfLiteTensor* filter = GetInput(context, node, kFilterTensor);
+
+  int input_width = input->dims->data[2];
+  int input_height = input->dims->data[1];
+  int filter_width = filter->dims->data[2];
+  int filter_height = filter->dims->data[1];
+  int output_width = output->dims->data[2];
+  int output_height = output->dims->data[1];
+
+  // Dynimically allocate per-channel quantization parameters.
+  const int num_channels = filter->dims->data[kConvQuantizedDimension];
+  TF_LITE_ENSURE_STATUS(context->AllocatePersistentBuffer(
+      context, num_channels * sizeof(int32_t),
+      reinterpret_cast<void**>(&data->per_channel_output_multiplier)));
+  TF_LITE_ENSURE_STATUS(context->AllocatePersistentBuffer(
+      context, num_channels * sizeof(int32_t),
+      reinterpret_cast<void**>(&data->per_channel_output_shift)));
+
+  // All per-channel quantized tensors need valid zero point and scale arrays.
+  if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, filter->quantization.type,
+                      kTfLiteAffineQuantization);
+
+    const auto* affine_quantization =
+        static_cast<TfLiteAffineQuantization*>(filter->quantization.params);
+    TF_LITE_ENSURE(context, affine_quantization);
+    TF_LITE_ENSURE(context, affine_quantization->scale);
+    TF_LITE_ENSURE(context, affine_quantization->zero_point);
+
+    TF_LITE_ENSURE(context,
+                   affine_quantization->scale->size == 1 ||
+                       affine_quantization->scale->size ==
+                           filter->dims->data[kConvQuantizedDimension]);
+    TF_LITE_ENSURE_EQ(context, affine_quantization->scale->size,
+                      affine_quantization->zero_point->size);
+  }
+
+  // 16x8 quantization is symmetric, which the int16 kernels rely on.
+  if (input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, filter->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+  }
+
+  data->input_zero_point = input->params.zero_point;
+  data->filter_zero_point = filter->params.zero_point;
+  data->output_zero_point = output->params.zero_point;
+
+  TF_LITE_ENSURE_STATUS(CalculateOpData(
+      context, node, params, input_width, input_height, filter_width,
+      filter_height, output_width, output_height, input->type, data));
+
+  data->buffer_idx = -1;
+  data->packed_filter = nullptr;
+  data->is_sparse = filter->sparsity != nullptr;
+  const TfLitePalette* palette;
+  TF_LITE_ENSURE_STATUS(
+      tflite::micro::GetInputPalette(context, node, kFilterTensor, &palette));
+  data->is_palettized = palette != nullptr;
+  if (data->is_sparse || data->is_palettized) {
+    TF_LITE_ENSURE(context, input->type != kTfLiteInt16);
+    const int patch_size =
+        filter_height * filter_width * input->dims->data[3];
+    // The patch and the tile hold input and filter values: float, or 8-bit
+    // quantized.
+    const size_t value_size =
+        input->type == kTfLiteFloat32 ? sizeof(float) : sizeof(int8_t);
+    if (data->is_sparse) {
+      TF_LITE_ENSURE_STATUS(tflite::micro::GetBlockSparseWeights(
+          context, filter, num_channels, patch_size, &data->sparse_weights));
+    } else {
+      TF_LITE_ENSURE_STATUS(tflite::micro::GetPalettizedWeights(
+          context, filter, palette, num_channels, patch_size,
+          &data->palettized_weights));
+      TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context,
+          data->palettized_weights.tile_rows * patch_size * value_size,
+          &data->tile_idx));
+    }
+    return context->RequestScratchBufferInArena(
+        context, patch_size * value_size, &data->buffer_idx);
+  }
+#if defined(__ARM_FEATURE_DSP)
+  const TfLiteTensor* bias = GetOptionalInputTensor(context, node, kBiasTensor);
+  if (input->type == kTfLiteInt16) {
+    cmsis_nn_dims input_dims;
+    input_dims.n = input->dims->data[0];
+    input_dims.h = input_height;
+    input_dims.w = input_width;
+    input_dims.c = input->dims->data[3];
+
+    cmsis_nn_dims filter_dims;
+    filter_dims.n = filter->dims->data[0];
+    filter_dims.h = filter_height;
+    filter_dims.w = filter_width;
+    filter_dims.c = input_dims.c;
+
+    const int32_t buf_size =
+        arm_convolve_s16_get_buffer_size(&input_dims, &filter_dims);
+    if (buf_size > 0) {
+      TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context, buf_size, &data->buffer_idx));
+    }
+  } else if (input->type == kTfLiteInt8 && bias != nullptr &&
+             params->dilation_width_factor == 1 &&
+             params->dilation_height_factor == 1) {
+    cmsis_nn_conv_params conv_params;
+    conv_params.padding.h = data->padding.height;
+    conv_params.padding.w = data->padding.width;
+    conv_params.stride.h = params->stride_height;
+    conv_params.stride.w = params->stride_width;
+    conv_params.dilation.h = params->dilation_height_factor;
+    conv_params.dilation.w = params->dilation_width_factor;
+
+    cmsis_nn_dims input_dims;
+    input_dims.n = input->dims->data[0];
+    input_dims.h = input_height;
+    input_dims.w = input_width;
+    input_dims.c = input->dims->data[3];
+
+    cmsis_nn_dims filter_dims;
+    filter_dims.n = filter->dims->data[0];
+    filter_dims.h = filter_height;
+    filter_dims.w = filter_width;
+    filter_dims.c = input_dims.c;
+
+    cmsis_nn_dims output_dims;
+    output_dims.n = input_dims.n;
+    output_dims.h = output_height;
+    output_dims.w = output_width;
+    output_dims.c = output->dims->data[3];
+
+    int32_t buf_size;
+    if (UseConv1x1Fast(conv_params, input_dims, filter_dims)) {
+      buf_size = arm_convolve_1x1_s8_fast_get_buffer_size(&input_dims);
+    } else if (UseConv1xN(conv_params, input_dims, filter_dims,
+                          output_dims)) {
+      buf_size = arm_convolve_1_x_n_s8_get_buffer_size(&input_dims,
+                                                       &filter_dims);
+    } else {
+      buf_size = arm_convolve_s8_get_buffer_size(&input_dims, &filter_dims);
+      // Small constant filters are packed once here rather than reordered in
+      // the inner loop of every Eval().
+      const int32_t packed_size =
+          arm_convolve_s8_packed_filter_size(&input_dims, &filter_dims);
+      if (packed_size > 0 && packed_size <= kMaxPackedFilterBytes &&
+          IsConstantTensor(filter)) {
+        TF_LITE_ENSURE_STATUS(context->AllocatePersistentBuffer(
+            context, packed_size,
+            reinterpret_cast<void**>(&data->packed_filter)));
+        arm_convolve_s8_pack_filter(&input_dims, &filter_dims,
+                                    GetTensorData<int8_t>(filter),
+                                    data->packed_filter);
+      }
+    }
+    if (buf_size > 0) {
+      TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context, buf_size, &data->buffer_idx));
+    }
+  }
+#endif
+  return kTfLiteOk;
+}
+
+void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
+                   TfLiteConvParams* params, const OpData& data,
+                   const TfLiteEvalTensor* input,
+                   const TfLiteEvalTensor* filter,
+                   const TfLiteEvalTensor* bias, TfLiteEvalTensor* output) {
+  const int32_t input_offset = -data.input_zero_point;
+  const int32_t filter_offset = -data.filter_zero_point;
+  const int32_t output_offset = data.output_zero_point;
+
+  // TODO(b/154032858): Investigate removing extra copies.
+  ConvParams op_params;
+  op_params.padding_type = RuntimePaddingType(params->padding);
+  op_params.padding_values.width = data.padding.width;
+  op_params.padding_values.height = data.padding.height;
+  op_params.stride_width = params->stride_width;
+  op_params.stride_height = params->stride_height;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+  op_params.input_offset = input_offset;
+  op_params.weights_offset = filter_offset;
+  op_params.output_offset = output_offset;
+  op_params.output_multiplier = data.output_multiplier;
+  op_params.output_shift = -data.output_shift;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
+  reference_ops::Conv(op_params, tflite::micro::GetTensorShape(input),
+                      tflite::micro::GetTensorData<uint8_t>(input),
+                      tflite::micro::GetTensorShape(filter),
+                      tflite::micro::GetTensorData<uint8_t>(filter),
+                      tflite::micro::GetTensorShape(bias),
+                      tflite::micro::GetTensorData<int32_t>(bias),
+                      tflite::micro::GetTensorShape(output),
+                      tflite::micro::GetTensorData<uint8_t>(output),
+                      RuntimeShape(), nullptr, nullptr);
+}
+
+TfLiteStatus EvalQuantizedPerChannel(
+    TfLiteContext* context, TfLiteNode* node, TfLiteConvParams* params,
+    const OpData& data, const TfLiteEvalTensor* input,
+    const TfLiteEvalTensor* filter, const TfLiteEvalTensor* bias,
+    TfLiteEvalTensor* output) {
+#if defined(__ARM_FEATURE_DSP)
+  // The CMSIS-NN s8 convolutions ignore dilation and read the bias
+  // unconditionally, so dilated layers and layers without a bias take the
+  // reference path below.
+  if (bias != nullptr && params->dilation_width_factor == 1 &&
+      params->dilation_height_factor == 1) {
+    cmsis_nn_conv_params conv_params;
+    conv_params.input_offset = -data.input_zero_point;
+    conv_params.output_offset = data.output_zero_point;
+    conv_params.stride.h = params->stride_height;
+    conv_params.stride.w = params->stride_width;
+    conv_params.dilation.h = params->dilation_height_factor;
+    conv_params.dilation.w = params->dilation_width_factor;
+    conv_params.padding.h = data.padding.height;
+    conv_params.padding.w = data.padding.width;
+    conv_params.activation.min = data.output_activation_min;
+    conv_params.activation.max = data.output_activation_max;
+
+    cmsis_nn_per_channel_quant_params quant_params;
+    quant_params.multiplier = data.per_channel_output_multiplier;
+    quant_params.shift = data.per_channel_output_shift;
+
+    RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+    RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+    RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+    RuntimeShape bias_shape = tflite::micro::GetTensorShape(bias);
+
+    // Sanity check.
+    TFLITE_DCHECK_LE(conv_params.activation.min, conv_params.activation.max);
+    TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+    TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+    TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+    const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+    const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+    const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+    if (bias) {
+      TFLITE_DCHECK_EQ(bias_shape.FlatSize(), output_depth);
+    }
+
+    cmsis_nn_dims input_dims;
+    input_dims.n = batch_size;
+    input_dims.h = input_shape.Dims(1);
+    input_dims.w = input_shape.Dims(2);
+    input_dims.c = input_depth;
+
+    cmsis_nn_dims filter_dims;
+    filter_dims.n = output_depth;
+    filter_dims.h = filter_shape.Dims(1);
+    filter_dims.w = filter_shape.Dims(2);
+    filter_dims.c = input_depth;
+
+    cmsis_nn_dims bias_dims;
+    bias_dims.n = 1;
+    bias_dims.h = 1;
+    bias_dims.w = 1;
+    bias_dims.c = output_depth;
+
+    cmsis_nn_dims output_dims;
+    output_dims.n = batch_size;
+    output_dims.h = output_shape.Dims(1);
+    output_dims.w = output_shape.Dims(2);
+    output_dims.c = output_depth;
+
+    cmsis_nn_context ctx;
+    ctx.buf = nullptr;
+    ctx.size = 0;
+    if (data.buffer_idx > -1) {
+      ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
+    }
+
+    if (UseConv1x1Fast(conv_params, input_dims, filter_dims)) {
+      TF_LITE_ENSURE_EQ(
+          context,
+          arm_convolve_1x1_s8_fast(
+              &ctx, &conv_params, &quant_params, &input_dims,
+              tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+              tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+              tflite::micro::GetTensorData<int32_t>(bias), &output_dims,
+              tflite::micro::GetTensorData<int8_t>(output)),
+          ARM_MATH_SUCCESS);
+    } else if (UseConv1xN(conv_params, input_dims, filter_dims, output_dims)) {
+      TF_LITE_ENSURE_EQ(
+          context,
+          arm_convolve_1_x_n_s8(
+              &ctx, &conv_params, &quant_params, &input_dims,
+              tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+              tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+              tflite::micro::GetTensorData<int32_t>(bias), &output_dims,
+              tflite::micro::GetTensorData<int8_t>(output)),
+          ARM_MATH_SUCCESS);
+    } else if (data.packed_filter != nullptr) {
+      TF_LITE_ENSURE_EQ(
+          context,
+          arm_convolve_s8_packed(
+              &ctx, &conv_params, &quant_params, &input_dims,
+              tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+              data.packed_filter, &bias_dims,
+              tflite::micro::GetTensorData<int32_t>(bias), &output_dims,
+              tflite::micro::GetTensorData<int8_t>(output)),
+          ARM_MATH_SUCCESS);
+    } else {
+      TF_LITE_ENSURE_EQ(
+          context,
+          arm_convolve_s8(
+              &ctx, &conv_params, &quant_params, &input_dims,
+              tflite::micro::GetTensorData<int8_t>(input), &filter_dims,
+              tflite::micro::GetTensorData<int8_t>(filter), &bias_dims,
+              tflite::micro::GetTensorData<int32_t>(bias), &output_dims,
+              tflite::micro::GetTensorData<int8_t>(output)),
+          ARM_MATH_SUCCESS);
+    }
+    return kTfLiteOk;
+  }
+#else
+#pragma message( \
+    "CMSIS-NN optimization for conv not available for this target. Using reference kernel.")
+#endif
+
+  // TODO(b/154032858): Investigate removing extra copies.
+  ConvParams op_params;
+  op_params.input_offset = -data.input_zero_point;
+  op_params.output_offset = data.output_zero_point;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.padding_values.height = data.padding.height;
+  op_params.padding_values.width = data.padding.width;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
+
+  reference_integer_ops::ConvPerChannel(
+      op_params, data.per_channel_output_multiplier,
+      data.per_channel_output_shift, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int32_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+TfLiteStatus EvalQuantizedPerChannel16x8(
+    TfLiteContext* context, TfLiteNode* node, TfLiteConvParams* params,
+    const OpData& data, const TfLiteEvalTensor* input,
+    const TfLiteEvalTensor* filter, const TfLiteEvalTensor* bias,
+    TfLiteEvalTensor* output) {
+#if defined(__ARM_FEATURE_DSP)
+  cmsis_nn_conv_params conv_params;
+  conv_params.input_offset = 0;
+  conv_params.output_offset = 0;
+  conv_params.stride.h = params->stride_height;
+  conv_params.stride.w = params->stride_width;
+  conv_params.dilation.h = params->dilation_height_factor;
+  conv_params.dilation.w = params->dilation_width_factor;
+  conv_params.padding.h = data.padding.height;
+  conv_params.padding.w = data.padding.width;
+  conv_params.activation.min = data.output_activation_min;
+  conv_params.activation.max = data.output_activation_max;
+
+  cmsis_nn_per_channel_quant_params quant_params;
+  quant_params.multiplier = data.per_channel_output_multiplier;
+  quant_params.shift = data.per_channel_output_shift;
+
+  RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+  RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+
+  // Sanity check.
+  TFLITE_DCHECK_LE(conv_params.activation.min, conv_params.activation.max);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batch_size = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+
+  cmsis_nn_dims input_dims;
+  input_dims.n = batch_size;
+  input_dims.h = input_shape.Dims(1);
+  input_dims.w = input_shape.Dims(2);
+  input_dims.c = input_depth;
+
+  cmsis_nn_dims filter_dims;
+  filter_dims.n = output_depth;
+  filter_dims.h = filter_shape.Dims(1);
+  filter_dims.w = filter_shape.Dims(2);
+  filter_dims.c = input_depth;
+
+  cmsis_nn_dims bias_dims;
+  bias_dims.n = 1;
+  bias_dims.h = 1;
+  bias_dims.w = 1;
+  bias_dims.c = output_depth;
+
+  cmsis_nn_dims output_dims;
+  output_dims.n = batch_size;
+  output_dims.h = output_shape.Dims(1);
+  output_dims.w = output_shape.Dims(2);
+  output_dims.c = output_depth;
+
+  cmsis_nn_context ctx;
+  ctx.buf = nullptr;
+  ctx.size = 0;
+  if (data.buffer_idx > -1) {
+    ctx.buf = context->GetScratchBuffer(context, data.buffer_idx);
+  }
+
+  TF_LITE_ENSURE_EQ(
+      context,
+      arm_convolve_s16(&ctx, &conv_params, &quant_params, &input_dims,
+                       tflite::micro::GetTensorData<int16_t>(input),
+                       &filter_dims,
+                       tflite::micro::GetTensorData<int8_t>(filter),
+                       &bias_dims, tflite::micro::GetTensorData<int64_t>(bias),
+                       &output_dims,
+                       tflite::micro::GetTensorData<int16_t>(output)),
+      ARM_MATH_SUCCESS);
+#else
+#pragma message( \
+    "CMSIS-NN optimization for 16x8 conv not available for this target. Using reference kernel.")
+
+  // TODO(b/154032858): Investigate removing extra copies.
+  ConvParams op_params;
+  op_params.input_offset = 0;
+  op_params.output_offset = 0;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.padding_values.height = data.padding.height;
+  op_params.padding_values.width = data.padding.width;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
+
+  reference_integer_ops::ConvPerChannel(
+      op_params, data.per_channel_output_multiplier,
+      data.per_channel_output_shift, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int16_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int64_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int16_t>(output));
+#endif
+  return kTfLiteOk;
+}
+
+void EvalFloat(TfLiteContext* context, TfLiteNode* node,
+               TfLiteConvParams* params, const OpData& data,
+               const TfLiteEvalTensor* input, const TfLiteEvalTensor* filter,
+               const TfLiteEvalTensor* bias, TfLiteEvalTensor* output) {
+  float output_activation_min, output_activation_max;
+  CalculateActivationRange(params->activation, &output_activation_min,
+                           &output_activation_max);
+  // TODO(b/154032858): Investigate removing extra copies.
+  ConvParams op_params;
+  op_params.padding_type = RuntimePaddingType(params->padding);
+  op_params.padding_values.width = data.padding.width;
+  op_params.padding_values.height = data.padding.height;
+  op_params.stride_width = params->stride_width;
+  op_params.stride_height = params->stride_height;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+  op_params.float_activation_min = output_activation_min;
+  op_params.float_activation_max = output_activation_max;
+
+  reference_ops::Conv(op_params, tflite::micro::GetTensorShape(input),
+                      tflite::micro::GetTensorData<float>(input),
+                      tflite::micro::GetTensorShape(filter),
+                      tflite::micro::GetTensorData<float>(filter),
+                      tflite::micro::GetTensorShape(bias),
+                      tflite::micro::GetTensorData<float>(bias),
+                      tflite::micro::GetTensorShape(output),
+                      tflite::micro::GetTensorData<float>(output),
+                      RuntimeShape(), nullptr);
+}
+
+// Block-sparse or palettized filters, whose kernels accumulate the stored
+// values in the same order as the dense ones.
+template <typename T, typename AccT, typename OutputStage>
+void CompressedConv(TfLiteContext* context, const ConvParams& op_params,
+                    const OpData& data, const TfLiteEvalTensor* input,
+                    AccT input_offset, T pad_value,
+                    const TfLiteEvalTensor* filter, AccT filter_offset,
+                    TfLiteEvalTensor* output,
+                    const OutputStage& output_stage) {
+  T* patch =
+      static_cast<T*>(context->GetScratchBuffer(context, data.buffer_idx));
+  if (data.is_sparse) {
+    tflite::micro::BlockSparseConv(
+        op_params, data.sparse_weights,
+        tflite::micro::GetTensorData<T>(filter), filter_offset,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<T>(input), input_offset, pad_value,
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<T>(output), patch, output_stage);
+  } else {
+    tflite::micro::PalettizedConv(
+        op_params, data.palettized_weights, filter_offset,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<T>(input), input_offset, pad_value,
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<T>(output),
+        static_cast<T*>(context->GetScratchBuffer(context, data.tile_idx)),
+        patch, output_stage);
+  }
+}
+
+// Block-sparse or palettized filters, with the portable kernels: the
+// per-channel requantization rules out arm_fully_connected_s8_sparse() or
+// arm_fully_connected_s8() per pixel. The missing blocks are skipped and the
+// palettized rows decoded a tile at a time, and the others accumulated in the
+// same order as the dense kernels.
+TfLiteStatus EvalCompressed(TfLiteContext* context, TfLiteNode* node,
+                            TfLiteConvParams* params, const OpData& data,
+                            const TfLiteEvalTensor* input,
+                            const TfLiteEvalTensor* filter,
+                            const TfLiteEvalTensor* bias,
+                            TfLiteEvalTensor* output) {
+  ConvParams op_params;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.padding_values.height = data.padding.height;
+  op_params.padding_values.width = data.padding.width;
+
+  switch (input->type) {
+    case kTfLiteFloat32: {
+      float output_activation_min, output_activation_max;
+      CalculateActivationRange(params->activation, &output_activation_min,
+                               &output_activation_max);
+      const float* bias_data = tflite::micro::GetTensorData<float>(bias);
+      CompressedConv(
+          context, op_params, data, input, 0.0f, 0.0f, filter, 0.0f, output,
+          [&](float total, int out_channel) {
+            const float bias_value =
+                bias_data ? bias_data[out_channel] : 0.0f;
+            return ActivationFunctionWithMinMax(total + bias_value,
+                                                output_activation_min,
+                                                output_activation_max);
+          });
+      return kTfLiteOk;
+    }
+    case kTfLiteInt8: {
+      const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+      CompressedConv(
+          context, op_params, data, input, -data.input_zero_point,
+          static_cast<int8_t>(data.input_zero_point), filter, 0, output,
+          [&](int32_t acc, int out_channel) {
+            if (bias_data) {
+              acc += bias_data[out_channel];
+            }
+            acc = MultiplyByQuantizedMultiplier(
+                acc, data.per_channel_output_multiplier[out_channel],
+                data.per_channel_output_shift[out_channel]);
+            acc += data.output_zero_point;
+            acc = std::max(acc, data.output_activation_min);
+            acc = std::min(acc, data.output_activation_max);
+            return static_cast<int8_t>(acc);
+          });
+      return kTfLiteOk;
+    }
+    case kTfLiteUInt8: {
+      const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+      CompressedConv(
+          context, op_params, data, input, -data.input_zero_point,
+          static_cast<uint8_t>(data.input_zero_point), filter,
+          -data.filter_zero_point, output, [&](int32_t acc, int out_channel) {
+            if (bias_data) {
+              acc += bias_data[out_channel];
+            }
+            acc = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                                -data.output_shift);
+            acc += data.output_zero_point;
+            acc = std::max(acc, data.output_activation_min);
+            acc = std::min(acc, data.output_activation_max);
+            return static_cast<uint8_t>(acc);
+          });
+      return kTfLiteOk;
+    }
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(input->type), input->type);
+      return kTfLiteError;
+  }
+}
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
+
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kFilterTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, kBiasTensor);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  if (data.is_sparse || data.is_palettized) {
+    return EvalCompressed(context, node, params, data, input, filter, bias,
+                          output);
+  }
+
+  switch (input->type) {  // Already know in/out types are same.
+    case kTfLiteFloat32:
+      EvalFloat(context, node, params, data, input, filter, bias, output);
+      break;
+    case kTfLiteInt8:
+      return EvalQuantizedPerChannel(context, node, params, data, input,
+                                     filter, bias, output);
+    case kTfLiteInt16:
+      return EvalQuantizedPerChannel16x8(context, node, params, data, input,
+                                         filter, bias, output);
+    case kTfLiteUInt8:
+      EvalQuantized(context, node, params, data, input, filter, bias, output);
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(input->type), input->type);
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace conv
+
+TfLiteRegistration* Register_CONV_2D() {
+  static TfLiteRegistration r = {/*init=*/conv::Init,
+                                 /*free=*/nullptr,
+                                 /*prepare=*/conv::Prepare,
+                                 /*invoke=*/conv::Eval,
+                                 /*profiling_string=*/nullptr,
+                                 /*builtin_code=*/0,
+                                 /*custom_name=*/nullptr,
+                                 /*version=*/0};
+  return &r;
+}
+
+}  // namespace micro
+}  // namespace ops
+}  // namespace tflite
@@ -23,6 +23,9 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/palettized.h"
 
 namespace tflite {
 namespace ops {
@@ -41,6 +44,22 @@ struct OpData {
   int32_t output_activation_max;
   // The index of the temporary tensor where the quantized inputs are cached.
   int input_quantized_index;
+  // Index of the scratch buffer for the CMSIS-NN kernel, -1 if none.
+  int buffer_idx;
+
+  // Quantization parameters, which are only available in Prepare().
+  int32_t input_zero_point;
+  int32_t filter_zero_point;
+  int32_t output_zero_point;
+
+  // Set for block-sparse weights, which take EvalCompressed().
+  bool is_sparse;
+  tflite::micro::BlockSparseWeights sparse_weights;
+  // Set for palettized weights, which take EvalCompressed() with their tile
+  // in the scratch buffer `tile_idx`.
+  bool is_palettized;
+  tflite::micro::PalettizedWeights palettized_weights;
+  int tile_idx;
 };
 
 constexpr int kInputTensor = 0;
@@ -72,18 +91,75 @@ TfLiteStatus CalculateOpData(TfLiteContext* context,
 }  // namespace
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
-  void* raw;
-  context->AllocatePersistentBuffer(context, sizeof(int), &raw);
-  return raw;
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  void* data = nullptr;
+  if (context->AllocatePersistentBuffer(context, sizeof(OpData), &data) ==
+      kTfLiteError) {
+    return nullptr;
+  }
+  return data;
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  auto* params =
+      reinterpret_cast<TfLiteFullyConnectedParams*>(node->builtin_data);
+
   const TfLiteTensor* input = GetInput(context, node, kInputTensor);
   const TfLiteTensor* filter = GetInput(context, node, kWeightsTensor);
+  const TfLiteTensor* bias = GetOptionalInputTensor(context, node, kBiasTensor);
   TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
   TF_LITE_ENSURE_EQ(context, input->type, output->type);
-  TF_LITE_ENSURE_MSG(context, input->type == filter->type,
+  TF_LITE_ENSURE_MSG(context,
+                     input->type == filter->type ||
+                         (input->type == kTfLiteInt16 &&
+                          filter->type == kTfLiteInt8),
                      "Hybrid models are not supported on TFLite Micro.");
+
+  // 16x8 quantization is symmetric, which the int16 kernels rely on.
+  if (input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, filter->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, filter->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+  }
+
+  data->input_zero_point = input->params.zero_point;
+  data->filter_zero_point = filter->params.zero_point;
+  data->output_zero_point = output->params.zero_point;
+
+  data->buffer_idx = -1;
+  data->is_sparse = filter->sparsity != nullptr;
+  if (data->is_sparse) {
+    TF_LITE_ENSURE(context, input->type != kTfLiteInt16);
+    TF_LITE_ENSURE_EQ(context, NumDimensions(filter), 2);
+    TF_LITE_ENSURE_STATUS(tflite::micro::GetBlockSparseWeights(
+        context, filter, SizeOfDimension(filter, 0),
+        SizeOfDimension(filter, 1), &data->sparse_weights));
+    return CalculateOpData(context, params, input->type, input, filter, bias,
+                           output, data);
+  }
+  const TfLitePalette* palette;
+  TF_LITE_ENSURE_STATUS(
+      tflite::micro::GetInputPalette(context, node, kWeightsTensor, &palette));
+  data->is_palettized = palette != nullptr;
+  if (data->is_palettized) {
+    TF_LITE_ENSURE(context, input->type != kTfLiteInt16);
+    TF_LITE_ENSURE_EQ(context, NumDimensions(filter), 2);
+    TF_LITE_ENSURE_STATUS(tflite::micro::GetPalettizedWeights(
+        context, filter, palette, SizeOfDimension(filter, 0),
+        SizeOfDimension(filter, 1), &data->palettized_weights));
+    // The tile holds weight values: float, or 8-bit quantized.
+    const tflite::micro::PalettizedWeights& weights = data->palettized_weights;
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context,
+        weights.tile_rows * weights.cols *
+            (input->type == kTfLiteFloat32 ? sizeof(float) : sizeof(int8_t)),
+        &data->tile_idx));
+  }
 #if defined(__ARM_FEATURE_DSP)
   RuntimeShape filter_shape = GetTensorShape(filter);
   const int filter_dim_count = filter_shape.DimensionsCount();
@@ -91,98 +167,157 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
 
   const int32_t buf_size = arm_fully_connected_s8_get_buffer_size(accum_depth);
 
-  int* buffer_idx = reinterpret_cast<int*>(node->user_data);
-
-  node->user_data = buffer_idx;
   if (buf_size > 0) {
-    TF_LITE_ENSURE_STATUS(
-        context->RequestScratchBufferInArena(context, buf_size, buffer_idx));
-  } else {
-    *buffer_idx = -1;
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, buf_size, &data->buffer_idx));
   }
 #endif
-  return kTfLiteOk;
+  return CalculateOpData(context, params, input->type, input, filter, bias,
+                         output, data);
 }
 
 TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
-                               TfLiteFullyConnectedParams* params, OpData* data,
-                               const TfLiteTensor* input,
-                               const TfLiteTensor* filter,
-                               const TfLiteTensor* bias, TfLiteTensor* output) {
-  RuntimeShape output_shape = GetTensorShape(output);
+                               TfLiteFullyConnectedParams* params,
+                               const OpData& data,
+                               const TfLiteEvalTensor* input,
+                               const TfLiteEvalTensor* filter,
+                               const TfLiteEvalTensor* bias,
+                               TfLiteEvalTensor* output) {
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
   const int batches = output_shape.Dims(0);
   const int output_depth = output_shape.Dims(1);
-  RuntimeShape filter_shape = GetTensorShape(filter);
+  RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
   const int filter_dim_count = filter_shape.DimensionsCount();
   const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
 
 #if defined(__ARM_FEATURE_DSP)
   int16_t* buf = nullptr;
 
-  auto* buffer_idx = reinterpret_cast<int*>(node->user_data);
-  if (*buffer_idx > -1) {
-    void* raw = context->GetScratchBuffer(context, *buffer_idx);
+  if (data.buffer_idx > -1) {
+    void* raw = context->GetScratchBuffer(context, data.buffer_idx);
     buf = reinterpret_cast<int16_t*>(raw);
   }
 
   TF_LITE_ENSURE_EQ(
       context,
-      arm_fully_connected_s8(
-          GetTensorData<int8_t>(input), GetTensorData<int8_t>(filter),
-          accum_depth, output_depth, batches, -input->params.zero_point,
-          -filter->params.zero_point, data->output_multiplier,
-          -data->output_shift, output->params.zero_point,
-          GetTensorData<int32_t>(bias), GetTensorData<int8_t>(output),
-          data->output_activation_min, data->output_activation_max, buf),
+      arm_fully_connected_s8(tflite::micro::GetTensorData<int8_t>(input),
+                             tflite::micro::GetTensorData<int8_t>(filter),
+                             accum_depth, output_depth, batches,
+                             -data.input_zero_point, -data.filter_zero_point,
+                             data.output_multiplier, -data.output_shift,
+                             data.output_zero_point,
+                             tflite::micro::GetTensorData<int32_t>(bias),
+                             tflite::micro::GetTensorData<int8_t>(output),
+                             data.output_activation_min,
+                             data.output_activation_max, buf),
       ARM_MATH_SUCCESS);
 #else
 #pragma message( \
     "CMSIS-NN optimization for fully_connected not available for this target. Using reference kernel.")
 
   FullyConnectedParams op_params;
-  op_params.input_offset = -input->params.zero_point;
-  op_params.weights_offset = -filter->params.zero_point;
-  op_params.output_offset = output->params.zero_point;
-  op_params.output_multiplier = data->output_multiplier;
+  op_params.input_offset = -data.input_zero_point;
+  op_params.weights_offset = -data.filter_zero_point;
+  op_params.output_offset = data.output_zero_point;
+  op_params.output_multiplier = data.output_multiplier;
   // TODO(b/138810107): Figure out whether output shift should be inverted
-  op_params.output_shift = -data->output_shift;
-  op_params.quantized_activation_min = data->output_activation_min;
-  op_params.quantized_activation_max = data->output_activation_max;
+  op_params.output_shift = -data.output_shift;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
+
+  reference_integer_ops::FullyConnected(
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int32_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus EvalQuantizedInt16(TfLiteContext* context, TfLiteNode* node,
+                                TfLiteFullyConnectedParams* params,
+                                const OpData& data,
+                                const TfLiteEvalTensor* input,
+                                const TfLiteEvalTensor* filter,
+                                const TfLiteEvalTensor* bias,
+                                TfLiteEvalTensor* output) {
+#if defined(__ARM_FEATURE_DSP)
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  const int batches = output_shape.Dims(0);
+  const int output_depth = output_shape.Dims(1);
+  RuntimeShape filter_shape = tflite::micro::GetTensorShape(filter);
+  const int filter_dim_count = filter_shape.DimensionsCount();
+  const int accum_depth = filter_shape.Dims(filter_dim_count - 1);
+
+  TF_LITE_ENSURE_EQ(
+      context,
+      arm_fully_connected_s16(tflite::micro::GetTensorData<int16_t>(input),
+                              tflite::micro::GetTensorData<int8_t>(filter),
+                              accum_depth, output_depth, batches,
+                              data.output_multiplier, -data.output_shift,
+                              tflite::micro::GetTensorData<int64_t>(bias),
+                              tflite::micro::GetTensorData<int16_t>(output),
+                              data.output_activation_min,
+                              data.output_activation_max),
+      ARM_MATH_SUCCESS);
+#else
+#pragma message( \
+    "CMSIS-NN optimization for 16x8 fully_connected not available for this target. Using reference kernel.")
+
+  FullyConnectedParams op_params;
+  op_params.weights_offset = 0;
+  op_params.output_multiplier = data.output_multiplier;
+  op_params.output_shift = -data.output_shift;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
 
   reference_integer_ops::FullyConnected(
-      op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
-      GetTensorShape(filter), GetTensorData<int8_t>(filter),
-      GetTensorShape(bias), GetTensorData<int32_t>(bias),
-      GetTensorShape(output), GetTensorData<int8_t>(output));
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int16_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int64_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int16_t>(output));
 #endif
   return kTfLiteOk;
 }
 
 TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
-                           TfLiteFullyConnectedParams* params, OpData* data,
-                           const TfLiteTensor* input,
-                           const TfLiteTensor* filter, const TfLiteTensor* bias,
-                           TfLiteTensor* output) {
-  const int32_t input_offset = -input->params.zero_point;
-  const int32_t filter_offset = -filter->params.zero_point;
-  const int32_t output_offset = output->params.zero_point;
+                           TfLiteFullyConnectedParams* params,
+                           const OpData& data, const TfLiteEvalTensor* input,
+                           const TfLiteEvalTensor* filter,
+                           const TfLiteEvalTensor* bias,
+                           TfLiteEvalTensor* output) {
+  const int32_t input_offset = -data.input_zero_point;
+  const int32_t filter_offset = -data.filter_zero_point;
+  const int32_t output_offset = data.output_zero_point;
 
   tflite::FullyConnectedParams op_params;
   op_params.input_offset = input_offset;
   op_params.weights_offset = filter_offset;
   op_params.output_offset = output_offset;
-  op_params.output_multiplier = data->output_multiplier;
+  op_params.output_multiplier = data.output_multiplier;
   // Legacy ops used mixed left and right shifts. Now all are +ve-means-left.
-  op_params.output_shift = -data->output_shift;
-  op_params.quantized_activation_min = data->output_activation_min;
-  op_params.quantized_activation_max = data->output_activation_max;
-
-#define TF_LITE_FULLY_CONNECTED(output_data_type)                      \
-  reference_ops::FullyConnected(                                       \
-      op_params, GetTensorShape(input), GetTensorData<uint8_t>(input), \
-      GetTensorShape(filter), GetTensorData<uint8_t>(filter),          \
-      GetTensorShape(bias), GetTensorData<int32_t>(bias),              \
-      GetTensorShape(output), GetTensorData<output_data_type>(output))
+  op_params.output_shift = -data.output_shift;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
+
+#define TF_LITE_FULLY_CONNECTED(output_data_type)      \
+  reference_ops::FullyConnected(                       \
+      op_params, tflite::micro::GetTensorShape(input), \
+      tflite::micro::GetTensorData<uint8_t>(input),    \
+      tflite::micro::GetTensorShape(filter),           \
+      tflite::micro::GetTensorData<uint8_t>(filter),   \
+      tflite::micro::GetTensorShape(bias),             \
+      tflite::micro::GetTensorData<int32_t>(bias),     \
+      tflite::micro::GetTensorShape(output),           \
+      tflite::micro::GetTensorData<output_data_type>(output))
   switch (output->type) {
     case kTfLiteUInt8:
       TF_LITE_FULLY_CONNECTED(uint8_t);
@@ -200,9 +335,10 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
 }
 
 TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
-                       TfLiteFullyConnectedParams* params, OpData* data,
-                       const TfLiteTensor* input, const TfLiteTensor* filter,
-                       const TfLiteTensor* bias, TfLiteTensor* output) {
+                       TfLiteFullyConnectedParams* params,
+                       const TfLiteEvalTensor* input,
+                       const TfLiteEvalTensor* filter,
+                       const TfLiteEvalTensor* bias, TfLiteEvalTensor* output) {
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
@@ -210,36 +346,209 @@ TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.float_activation_min = output_activation_min;
   op_params.float_activation_max = output_activation_max;
   tflite::reference_ops::FullyConnected(
-      op_params, GetTensorShape(input), GetTensorData<float>(input),
-      GetTensorShape(filter), GetTensorData<float>(filter),
-      GetTensorShape(bias), GetTensorData<float>(bias), GetTensorShape(output),
-      GetTensorData<float>(output));
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<float>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<float>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<float>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<float>(output));
+  return kTfLiteOk;
+}
+
+// Block-sparse or palettized weights, whose portable kernels accumulate the
+// stored values in the same order as the dense ones.
+template <typename T, typename AccT, typename OutputStage>
+void CompressedFullyConnected(TfLiteContext* context, const OpData& data,
+                              const TfLiteEvalTensor* filter,
+                              AccT filter_offset, int batches,
+                              const T* input_data, AccT input_offset,
+                              T* output_data,
+                              const OutputStage& output_stage) {
+  if (data.is_sparse) {
+    tflite::micro::BlockSparseFullyConnected(
+        data.sparse_weights, tflite::micro::GetTensorData<T>(filter),
+        filter_offset, batches, input_data, input_offset, output_data,
+        output_stage);
+  } else {
+    tflite::micro::PalettizedFullyConnected(
+        data.palettized_weights, filter_offset, batches, input_data,
+        input_offset, output_data,
+        static_cast<T*>(context->GetScratchBuffer(context, data.tile_idx)),
+        output_stage);
+  }
+}
+
+// Palettized int8 weights with a bias: every tile of rows is decoded, then
+// multiplied by arm_fully_connected_s8() like dense weights.
+TfLiteStatus EvalPalettizedInt8(TfLiteContext* context, const OpData& data,
+                                const TfLiteEvalTensor* input,
+                                const TfLiteEvalTensor* bias,
+                                TfLiteEvalTensor* output) {
+  const tflite::micro::PalettizedWeights& weights = data.palettized_weights;
+  const int batches =
+      tflite::micro::GetTensorShape(output).FlatSize() / weights.rows;
+  int8_t* tile =
+      static_cast<int8_t*>(context->GetScratchBuffer(context, data.tile_idx));
+  int16_t* buf = nullptr;
+  if (data.buffer_idx > -1) {
+    buf = static_cast<int16_t*>(
+        context->GetScratchBuffer(context, data.buffer_idx));
+  }
+  const int8_t* input_data = tflite::micro::GetTensorData<int8_t>(input);
+  const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+  int8_t* output_data = tflite::micro::GetTensorData<int8_t>(output);
+  for (int begin = 0; begin < weights.rows; begin += weights.tile_rows) {
+    const int end = std::min(begin + weights.tile_rows, weights.rows);
+    tflite::micro::DecodePalettizedRows(weights, begin, end, tile);
+    for (int b = 0; b < batches; ++b) {
+      TF_LITE_ENSURE_EQ(
+          context,
+          arm_fully_connected_s8(
+              input_data + b * weights.cols, tile, weights.cols, end - begin,
+              1, -data.input_zero_point, -data.filter_zero_point,
+              data.output_multiplier, -data.output_shift,
+              data.output_zero_point, bias_data + begin,
+              output_data + b * weights.rows + begin,
+              data.output_activation_min, data.output_activation_max, buf),
+          ARM_MATH_SUCCESS);
+    }
+  }
   return kTfLiteOk;
 }
 
+// Block-sparse or palettized weights. Int8 block-sparse weights take
+// arm_fully_connected_s8_sparse(), and int8 palettized ones with a bias
+// EvalPalettizedInt8(); the others the portable kernels. All are bit-exact
+// with the dense kernels.
+TfLiteStatus EvalCompressed(TfLiteContext* context, TfLiteNode* node,
+                            TfLiteFullyConnectedParams* params,
+                            const OpData& data, const TfLiteEvalTensor* input,
+                            const TfLiteEvalTensor* filter,
+                            const TfLiteEvalTensor* bias,
+                            TfLiteEvalTensor* output) {
+  const int rows = data.is_sparse ? data.sparse_weights.rows
+                                  : data.palettized_weights.rows;
+  const int batches = tflite::micro::GetTensorShape(output).FlatSize() / rows;
+
+  switch (input->type) {
+    case kTfLiteFloat32: {
+      float output_activation_min, output_activation_max;
+      CalculateActivationRange(params->activation, &output_activation_min,
+                               &output_activation_max);
+      const float* bias_data = tflite::micro::GetTensorData<float>(bias);
+      CompressedFullyConnected(
+          context, data, filter, 0.0f, batches,
+          tflite::micro::GetTensorData<float>(input), 0.0f,
+          tflite::micro::GetTensorData<float>(output),
+          [&](float total, int out_channel) {
+            const float bias_value =
+                bias_data ? bias_data[out_channel] : 0.0f;
+            return ActivationFunctionWithMinMax(total + bias_value,
+                                                output_activation_min,
+                                                output_activation_max);
+          });
+      return kTfLiteOk;
+    }
+    case kTfLiteInt8: {
+      if (data.is_sparse) {
+        const tflite::micro::BlockSparseWeights& weights =
+            data.sparse_weights;
+        TF_LITE_ENSURE_EQ(
+            context,
+            arm_fully_connected_s8_sparse(
+                tflite::micro::GetTensorData<int8_t>(input),
+                tflite::micro::GetTensorData<int8_t>(filter),
+                weights.segments, weights.indices, weights.block_rows,
+                weights.block_cols, weights.cols, weights.rows, batches,
+                -data.input_zero_point, -data.filter_zero_point,
+                data.output_multiplier, -data.output_shift,
+                data.output_zero_point,
+                tflite::micro::GetTensorData<int32_t>(bias),
+                tflite::micro::GetTensorData<int8_t>(output),
+                data.output_activation_min, data.output_activation_max),
+            ARM_MATH_SUCCESS);
+        return kTfLiteOk;
+      }
+      if (bias != nullptr) {
+        return EvalPalettizedInt8(context, data, input, bias, output);
+      }
+      CompressedFullyConnected(
+          context, data, filter, -data.filter_zero_point, batches,
+          tflite::micro::GetTensorData<int8_t>(input), -data.input_zero_point,
+          tflite::micro::GetTensorData<int8_t>(output),
+          [&](int32_t acc, int out_channel) {
+            acc = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                                -data.output_shift);
+            acc += data.output_zero_point;
+            acc = std::max(acc, data.output_activation_min);
+            acc = std::min(acc, data.output_activation_max);
+            return static_cast<int8_t>(acc);
+          });
+      return kTfLiteOk;
+    }
+    case kTfLiteUInt8: {
+      TF_LITE_ENSURE_EQ(context, output->type, kTfLiteUInt8);
+      const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+      CompressedFullyConnected(
+          context, data, filter, -data.filter_zero_point, batches,
+          tflite::micro::GetTensorData<uint8_t>(input),
+          -data.input_zero_point,
+          tflite::micro::GetTensorData<uint8_t>(output),
+          [&](int32_t acc, int out_channel) {
+            if (bias_data) {
+              acc += bias_data[out_channel];
+            }
+            acc = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                                -data.output_shift);
+            acc += data.output_zero_point;
+            acc = std::max(acc, data.output_activation_min);
+            acc = std::min(acc, data.output_activation_max);
+            return static_cast<uint8_t>(acc);
+          });
+      return kTfLiteOk;
+    }
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(input->type), input->type);
+      return kTfLiteError;
+  }
+}
+
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
   auto* params =
       reinterpret_cast<TfLiteFullyConnectedParams*>(node->builtin_data);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, kBiasTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+
+  if (data.is_sparse || data.is_palettized) {
+    return EvalCompressed(context, node, params, data, input, filter, bias,
+                          output);
+  }
 
-  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
-  const TfLiteTensor* filter = GetInput(context, node, kWeightsTensor);
-  const TfLiteTensor* bias = GetOptionalInputTensor(context, node, kBiasTensor);
-  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
-
-  TfLiteType data_type = input->type;
-  OpData local_data_object;
-  OpData* data = &local_data_object;
-  TF_LITE_ENSURE_STATUS(CalculateOpData(context, params, data_type, input,
-                                        filter, bias, output, data));
-
-  // Checks in Prepare ensure input, output and filter types are all the same.
+  // Checks in Prepare ensure input, output and filter types are all the same,
+  // except for the int8 filter of 16x8 models.
   switch (input->type) {
     case kTfLiteFloat32:
-      return EvalFloat(context, node, params, data, input, filter, bias,
-                       output);
+      return EvalFloat(context, node, params, input, filter, bias, output);
     case kTfLiteInt8:
       return EvalQuantizedInt8(context, node, params, data, input, filter, bias,
                                output);
+    case kTfLiteInt16:
+      return EvalQuantizedInt16(context, node, params, data, input, filter,
+                                bias, output);
 
     case kTfLiteUInt8:
       return EvalQuantized(context, node, params, data, input, filter, bias,
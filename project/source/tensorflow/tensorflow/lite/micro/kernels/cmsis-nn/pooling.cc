@@ -20,6 +20,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
 
 namespace tflite {
 namespace ops {
@@ -33,12 +34,17 @@ constexpr int kOutputTensor = 0;
 
 struct OpData {
   TfLitePaddingValues padding;
+  // The range of the fused activation layer of the quantized kernels.
+  int32_t activation_min;
+  int32_t activation_max;
+  // Index of the scratch buffer for the CMSIS-NN kernels, -1 if none.
+  int buffer_idx;
 };
 
-TfLiteStatus CalculateOpData(const TfLiteContext* context,
+TfLiteStatus CalculateOpData(TfLiteContext* context,
                              const TfLitePoolParams* params,
-                             const TfLiteTensor* input,
-                             const TfLiteTensor* output, OpData* data) {
+                             const TfLiteTensor* input, TfLiteTensor* output,
+                             OpData* data) {
   // input: batch, height, width, channel
   int height = SizeOfDimension(input, 1);
   int width = SizeOfDimension(input, 2);
@@ -51,12 +57,20 @@ TfLiteStatus CalculateOpData(const TfLiteContext* context,
       /*dilation_rate_width=*/1, height, width, params->filter_height,
       params->filter_width, params->padding, &out_height, &out_width);
 
+  if (input->type == kTfLiteUInt8 || input->type == kTfLiteInt8 ||
+      input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+        context, params->activation, output, &data->activation_min,
+        &data->activation_max));
+    TFLITE_DCHECK_LE(data->activation_min, data->activation_max);
+  }
   return kTfLiteOk;
 }
 
 void AverageEvalFloat(const TfLiteContext* context, const TfLiteNode* node,
                       const TfLitePoolParams* params, const OpData* data,
-                      const TfLiteTensor* input, TfLiteTensor* output) {
+                      const TfLiteEvalTensor* input,
+                      TfLiteEvalTensor* output) {
   float activation_min, activation_max;
   CalculateActivationRange(params->activation, &activation_min,
                            &activation_max);
@@ -70,18 +84,16 @@ void AverageEvalFloat(const TfLiteContext* context, const TfLiteNode* node,
   op_params.padding_values.width = data->padding.width;
   op_params.float_activation_min = activation_min;
   op_params.float_activation_max = activation_max;
-  reference_ops::AveragePool(
-      op_params, GetTensorShape(input), GetTensorData<float>(input),
-      GetTensorShape(output), GetTensorData<float>(output));
+  reference_ops::AveragePool(op_params, tflite::micro::GetTensorShape(input),
+                             tflite::micro::GetTensorData<float>(input),
+                             tflite::micro::GetTensorShape(output),
+                             tflite::micro::GetTensorData<float>(output));
 }
 
 void AverageEvalUint8(TfLiteContext* context, const TfLiteNode* node,
                       const TfLitePoolParams* params, const OpData* data,
-                      const TfLiteTensor* input, TfLiteTensor* output) {
-  int32_t activation_min, activation_max;
-  (void)CalculateActivationRangeQuantized(context, params->activation, output,
-                                          &activation_min, &activation_max);
-
+                      const TfLiteEvalTensor* input,
+                      TfLiteEvalTensor* output) {
   PoolParams op_params;
   op_params.stride_height = params->stride_height;
   op_params.stride_width = params->stride_width;
@@ -89,29 +101,26 @@ void AverageEvalUint8(TfLiteContext* context, const TfLiteNode* node,
   op_params.filter_width = params->filter_width;
   op_params.padding_values.height = data->padding.height;
   op_params.padding_values.width = data->padding.width;
-  op_params.quantized_activation_min = activation_min;
-  op_params.quantized_activation_max = activation_max;
-  reference_ops::AveragePool(
-      op_params, GetTensorShape(input), GetTensorData<uint8_t>(input),
-      GetTensorShape(output), GetTensorData<uint8_t>(output));
+  op_params.quantized_activation_min = data->activation_min;
+  op_params.quantized_activation_max = data->activation_max;
+  reference_ops::AveragePool(op_params, tflite::micro::GetTensorShape(input),
+                             tflite::micro::GetTensorData<uint8_t>(input),
+                             tflite::micro::GetTensorShape(output),
+                             tflite::micro::GetTensorData<uint8_t>(output));
 }
 
 TfLiteStatus AverageEvalInt8(TfLiteContext* context, const TfLiteNode* node,
                              const TfLitePoolParams* params, const OpData* data,
-                             TfLiteTensor* input, TfLiteTensor* output) {
-  int32_t activation_min, activation_max;
-  (void)CalculateActivationRangeQuantized(context, params->activation, output,
-                                          &activation_min, &activation_max);
-
-  TFLITE_DCHECK_LE(activation_min, activation_max);
-
+                             TfLiteEvalTensor* input,
+                             TfLiteEvalTensor* output) {
 #if defined(__ARM_FEATURE_DSP)
-  RuntimeShape input_shape = GetTensorShape(input);
+  RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
 
-  RuntimeShape output_shape = GetTensorShape(output);
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
   TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
 
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
   const int depth = MatchingDim(input_shape, 3, output_shape, 3);
   const int input_height = input_shape.Dims(1);
   const int input_width = input_shape.Dims(2);
@@ -127,21 +136,28 @@ TfLiteStatus AverageEvalInt8(TfLiteContext* context, const TfLiteNode* node,
 
   int16_t* scratch_buffer = nullptr;
 
-  auto* buffer_idx = reinterpret_cast<int*>(node->user_data);
-
-  if (*buffer_idx > -1) {
-    void* raw = context->GetScratchBuffer(context, *buffer_idx);
+  if (data->buffer_idx > -1) {
+    void* raw = context->GetScratchBuffer(context, data->buffer_idx);
     scratch_buffer = reinterpret_cast<int16_t*>(raw);
   }
 
-  TF_LITE_ENSURE_EQ(
-      context,
-      arm_avgpool_s8(input_height, input_width, output_height, output_width,
-                     stride_height, stride_width, filter_height, filter_width,
-                     padding_height, padding_width, activation_min,
-                     activation_max, depth, GetTensorData<int8_t>(input),
-                     scratch_buffer, GetTensorData<int8_t>(output)),
-      ARM_MATH_SUCCESS);
+  // The CMSIS-NN pooling functions work on a single image.
+  const int input_batch_size = input_height * input_width * depth;
+  const int output_batch_size = output_height * output_width * depth;
+  for (int b = 0; b < batches; ++b) {
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_avgpool_s8(
+            input_height, input_width, output_height, output_width,
+            stride_height, stride_width, filter_height, filter_width,
+            padding_height, padding_width, data->activation_min,
+            data->activation_max, depth,
+            tflite::micro::GetTensorData<int8_t>(input) + b * input_batch_size,
+            scratch_buffer,
+            tflite::micro::GetTensorData<int8_t>(output) +
+                b * output_batch_size),
+        ARM_MATH_SUCCESS);
+  }
 #else
 #pragma message( \
     "CMSIS-NN optimization for avg_pool not available for this target. Using reference kernel.")
@@ -153,19 +169,21 @@ TfLiteStatus AverageEvalInt8(TfLiteContext* context, const TfLiteNode* node,
   op_params.filter_width = params->filter_width;
   op_params.padding_values.height = data->padding.height;
   op_params.padding_values.width = data->padding.width;
-  op_params.quantized_activation_min = activation_min;
-  op_params.quantized_activation_max = activation_max;
+  op_params.quantized_activation_min = data->activation_min;
+  op_params.quantized_activation_max = data->activation_max;
   reference_integer_ops::AveragePool(
-      op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
-      GetTensorShape(output), GetTensorData<int8_t>(output));
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
 
 #endif
   return kTfLiteOk;
 }
 
 void MaxEvalFloat(TfLiteContext* context, TfLiteNode* node,
-                  TfLitePoolParams* params, OpData* data, TfLiteTensor* input,
-                  TfLiteTensor* output) {
+                  TfLitePoolParams* params, const OpData* data,
+                  const TfLiteEvalTensor* input, TfLiteEvalTensor* output) {
   float activation_min, activation_max;
   CalculateActivationRange(params->activation, &activation_min,
                            &activation_max);
@@ -179,18 +197,16 @@ void MaxEvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.padding_values.width = data->padding.width;
   op_params.float_activation_min = activation_min;
   op_params.float_activation_max = activation_max;
-  reference_ops::MaxPool(op_params, GetTensorShape(input),
-                         GetTensorData<float>(input), GetTensorShape(output),
-                         GetTensorData<float>(output));
+  reference_ops::MaxPool(op_params, tflite::micro::GetTensorShape(input),
+                         tflite::micro::GetTensorData<float>(input),
+                         tflite::micro::GetTensorShape(output),
+                         tflite::micro::GetTensorData<float>(output));
 }
 
 void MaxEvalQuantizedUInt8(TfLiteContext* context, TfLiteNode* node,
-                           TfLitePoolParams* params, OpData* data,
-                           TfLiteTensor* input, TfLiteTensor* output) {
-  int32_t activation_min, activation_max;
-  (void)CalculateActivationRangeQuantized(context, params->activation, output,
-                                          &activation_min, &activation_max);
-
+                           TfLitePoolParams* params, const OpData* data,
+                           const TfLiteEvalTensor* input,
+                           TfLiteEvalTensor* output) {
   tflite::PoolParams op_params;
   op_params.stride_height = params->stride_height;
   op_params.stride_width = params->stride_width;
@@ -198,29 +214,25 @@ void MaxEvalQuantizedUInt8(TfLiteContext* context, TfLiteNode* node,
   op_params.filter_width = params->filter_width;
   op_params.padding_values.height = data->padding.height;
   op_params.padding_values.width = data->padding.width;
-  op_params.quantized_activation_min = activation_min;
-  op_params.quantized_activation_max = activation_max;
-  reference_ops::MaxPool(op_params, GetTensorShape(input),
-                         GetTensorData<uint8_t>(input), GetTensorShape(output),
-                         GetTensorData<uint8_t>(output));
+  op_params.quantized_activation_min = data->activation_min;
+  op_params.quantized_activation_max = data->activation_max;
+  reference_ops::MaxPool(op_params, tflite::micro::GetTensorShape(input),
+                         tflite::micro::GetTensorData<uint8_t>(input),
+                         tflite::micro::GetTensorShape(output),
+                         tflite::micro::GetTensorData<uint8_t>(output));
 }
 
 TfLiteStatus MaxEvalInt8(TfLiteContext* context, const TfLiteNode* node,
                          const TfLitePoolParams* params, const OpData* data,
-                         TfLiteTensor* input, TfLiteTensor* output) {
-  int32_t activation_min, activation_max;
-  (void)CalculateActivationRangeQuantized(context, params->activation, output,
-                                          &activation_min, &activation_max);
-
-  TFLITE_DCHECK_LE(activation_min, activation_max);
-
+                         TfLiteEvalTensor* input, TfLiteEvalTensor* output) {
 #if defined(__ARM_FEATURE_DSP)
-  RuntimeShape input_shape = GetTensorShape(input);
+  RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
 
-  RuntimeShape output_shape = GetTensorShape(output);
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
   TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
 
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
   const int depth = MatchingDim(input_shape, 3, output_shape, 3);
   const int input_height = input_shape.Dims(1);
   const int input_width = input_shape.Dims(2);
@@ -236,22 +248,30 @@ TfLiteStatus MaxEvalInt8(TfLiteContext* context, const TfLiteNode* node,
 
   int16_t* scratch_buffer = nullptr;
 
-  auto* buffer_idx = reinterpret_cast<int*>(node->user_data);
-
-  if (*buffer_idx > -1) {
-    void* raw = context->GetScratchBuffer(context, *buffer_idx);
+  if (data->buffer_idx > -1) {
+    void* raw = context->GetScratchBuffer(context, data->buffer_idx);
     scratch_buffer = reinterpret_cast<int16_t*>(raw);
   }
 
-  TF_LITE_ENSURE_EQ(
-      context,
-      arm_max_pool_s8_opt(input_height, input_width, output_height,
-                          output_width, stride_height, stride_width,
-                          filter_height, filter_width, padding_height,
-                          padding_width, activation_min, activation_max, depth,
-                          GetTensorData<int8_t>(input), scratch_buffer,
-                          GetTensorData<int8_t>(output)),
-      ARM_MATH_SUCCESS);
+  // arm_max_pool_s8_opt pools in place in its input on DSP targets, which
+  // clobbers the input tensor and is not bit-exact once there is horizontal
+  // padding, so the plain C version is used.
+  const int input_batch_size = input_height * input_width * depth;
+  const int output_batch_size = output_height * output_width * depth;
+  for (int b = 0; b < batches; ++b) {
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_max_pool_s8(
+            input_height, input_width, output_height, output_width,
+            stride_height, stride_width, filter_height, filter_width,
+            padding_height, padding_width, data->activation_min,
+            data->activation_max, depth,
+            tflite::micro::GetTensorData<int8_t>(input) + b * input_batch_size,
+            scratch_buffer,
+            tflite::micro::GetTensorData<int8_t>(output) +
+                b * output_batch_size),
+        ARM_MATH_SUCCESS);
+  }
 #else
 #pragma message( \
     "CMSIS-NN optimization for max_pool not available for this target. Using reference kernel.")
@@ -263,11 +283,150 @@ TfLiteStatus MaxEvalInt8(TfLiteContext* context, const TfLiteNode* node,
   op_params.filter_width = params->filter_width;
   op_params.padding_values.height = data->padding.height;
   op_params.padding_values.width = data->padding.width;
-  op_params.quantized_activation_min = activation_min;
-  op_params.quantized_activation_max = activation_max;
+  op_params.quantized_activation_min = data->activation_min;
+  op_params.quantized_activation_max = data->activation_max;
   reference_integer_ops::MaxPool(
-      op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
-      GetTensorShape(output), GetTensorData<int8_t>(output));
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
+
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus AverageEvalInt16(TfLiteContext* context, const TfLiteNode* node,
+                              const TfLitePoolParams* params,
+                              const OpData* data,
+                              const TfLiteEvalTensor* input,
+                              TfLiteEvalTensor* output) {
+#if defined(__ARM_FEATURE_DSP)
+  RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int stride_height = params->stride_height;
+  const int stride_width = params->stride_width;
+
+  const int filter_height = params->filter_height;
+  const int filter_width = params->filter_width;
+  const int padding_height = data->padding.height;
+  const int padding_width = data->padding.width;
+
+  int32_t* scratch_buffer = nullptr;
+
+  if (data->buffer_idx > -1) {
+    void* raw = context->GetScratchBuffer(context, data->buffer_idx);
+    scratch_buffer = reinterpret_cast<int32_t*>(raw);
+  }
+
+  const int input_batch_size = input_height * input_width * depth;
+  const int output_batch_size = output_height * output_width * depth;
+  for (int b = 0; b < batches; ++b) {
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_avgpool_s16(
+            input_height, input_width, output_height, output_width,
+            stride_height, stride_width, filter_height, filter_width,
+            padding_height, padding_width, data->activation_min,
+            data->activation_max, depth,
+            tflite::micro::GetTensorData<int16_t>(input) +
+                b * input_batch_size,
+            scratch_buffer,
+            tflite::micro::GetTensorData<int16_t>(output) +
+                b * output_batch_size),
+        ARM_MATH_SUCCESS);
+  }
+#else
+#pragma message( \
+    "CMSIS-NN optimization for 16x8 avg_pool not available for this target. Using reference kernel.")
+
+  PoolParams op_params;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.filter_height = params->filter_height;
+  op_params.filter_width = params->filter_width;
+  op_params.padding_values.height = data->padding.height;
+  op_params.padding_values.width = data->padding.width;
+  op_params.quantized_activation_min = data->activation_min;
+  op_params.quantized_activation_max = data->activation_max;
+  reference_integer_ops::AveragePool(
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int16_t>(input),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int16_t>(output));
+
+#endif
+  return kTfLiteOk;
+}
+
+TfLiteStatus MaxEvalInt16(TfLiteContext* context, const TfLiteNode* node,
+                          const TfLitePoolParams* params, const OpData* data,
+                          const TfLiteEvalTensor* input,
+                          TfLiteEvalTensor* output) {
+#if defined(__ARM_FEATURE_DSP)
+  RuntimeShape input_shape = tflite::micro::GetTensorShape(input);
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+
+  RuntimeShape output_shape = tflite::micro::GetTensorShape(output);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int depth = MatchingDim(input_shape, 3, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int stride_height = params->stride_height;
+  const int stride_width = params->stride_width;
+
+  const int filter_height = params->filter_height;
+  const int filter_width = params->filter_width;
+  const int padding_height = data->padding.height;
+  const int padding_width = data->padding.width;
+
+  const int input_batch_size = input_height * input_width * depth;
+  const int output_batch_size = output_height * output_width * depth;
+  for (int b = 0; b < batches; ++b) {
+    TF_LITE_ENSURE_EQ(
+        context,
+        arm_max_pool_s16(
+            input_height, input_width, output_height, output_width,
+            stride_height, stride_width, filter_height, filter_width,
+            padding_height, padding_width, data->activation_min,
+            data->activation_max, depth,
+            tflite::micro::GetTensorData<int16_t>(input) +
+                b * input_batch_size,
+            tflite::micro::GetTensorData<int16_t>(output) +
+                b * output_batch_size),
+        ARM_MATH_SUCCESS);
+  }
+#else
+#pragma message( \
+    "CMSIS-NN optimization for 16x8 max_pool not available for this target. Using reference kernel.")
+
+  PoolParams op_params;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.filter_height = params->filter_height;
+  op_params.filter_width = params->filter_width;
+  op_params.padding_values.height = data->padding.height;
+  op_params.padding_values.width = data->padding.width;
+  op_params.quantized_activation_min = data->activation_min;
+  op_params.quantized_activation_max = data->activation_max;
+  reference_integer_ops::MaxPool(
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int16_t>(input),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int16_t>(output));
 
 #endif
   return kTfLiteOk;
@@ -276,16 +435,27 @@ TfLiteStatus MaxEvalInt8(TfLiteContext* context, const TfLiteNode* node,
 }  // namespace
 
 void* Init(TfLiteContext* context, const char* buffer, size_t length) {
-  void* raw;
-  context->AllocatePersistentBuffer(context, sizeof(int), &raw);
-  return raw;
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  void* data = nullptr;
+  if (context->AllocatePersistentBuffer(context, sizeof(OpData), &data) ==
+      kTfLiteError) {
+    return nullptr;
+  }
+  return data;
 }
 
 TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
-#if defined(__ARM_FEATURE_DSP)
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
+
   const TfLiteTensor* input = GetInput(context, node, kInputTensor);
-  const TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
 
+  data->buffer_idx = -1;
+#if defined(__ARM_FEATURE_DSP)
   RuntimeShape input_shape = GetTensorShape(input);
   TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
 
@@ -296,43 +466,42 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   const int output_width = output_shape.Dims(2);
 
   const int32_t buffer_size =
-      arm_avgpool_s8_get_buffer_size(output_width, depth);
+      input->type == kTfLiteInt16
+          ? arm_avgpool_s16_get_buffer_size(output_width, depth)
+          : arm_avgpool_s8_get_buffer_size(output_width, depth);
 
-  int* buffer_idx = reinterpret_cast<int*>(node->user_data);
-
-  node->user_data = buffer_idx;
   if (buffer_size > 0) {
-    TF_LITE_ENSURE_STATUS(
-        context->RequestScratchBufferInArena(context, buffer_size, buffer_idx));
-  } else {
-    *buffer_idx = -1;
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, buffer_size, &data->buffer_idx));
   }
 #endif
-  return kTfLiteOk;
+  return CalculateOpData(context, params, input, output, data);
 }
 
 TfLiteStatus AverageEval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
   auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
-  OpData data;
+  const OpData* data = static_cast<const OpData*>(node->user_data);
 
   // Todo: make 'input' const once CMSIS-reuse is fixed
-  TfLiteTensor* input = &context->tensors[flatbuffers::EndianScalar(
-      node->inputs->data[kInputTensor])];
-  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
-
-  TF_LITE_ENSURE_STATUS(CalculateOpData(context, params, input, output, &data));
+  TfLiteEvalTensor* input =
+      context->GetEvalTensor(context, node->inputs->data[kInputTensor]);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
 
   // Inputs and outputs share the same type, guaranteed by the converter.
   switch (input->type) {
     case kTfLiteFloat32:
-      AverageEvalFloat(context, node, params, &data, input, output);
+      AverageEvalFloat(context, node, params, data, input, output);
       break;
     case kTfLiteUInt8:
-      AverageEvalUint8(context, node, params, &data, input, output);
+      AverageEvalUint8(context, node, params, data, input, output);
       break;
     case kTfLiteInt8:
-      return AverageEvalInt8(context, node, params, &data, input, output);
+      return AverageEvalInt8(context, node, params, data, input, output);
       break;
+    case kTfLiteInt16:
+      return AverageEvalInt16(context, node, params, data, input, output);
     default:
       TF_LITE_KERNEL_LOG(context, "Input type %s is not currently supported",
                          TfLiteTypeGetName(input->type));
@@ -342,25 +511,27 @@ TfLiteStatus AverageEval(TfLiteContext* context, TfLiteNode* node) {
 }
 
 TfLiteStatus MaxEval(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
   auto* params = reinterpret_cast<TfLitePoolParams*>(node->builtin_data);
-  OpData data;
-
-  TfLiteTensor* input = &context->tensors[flatbuffers::EndianScalar(
-      node->inputs->data[kInputTensor])];
-  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  const OpData* data = static_cast<const OpData*>(node->user_data);
 
-  TF_LITE_ENSURE_STATUS(CalculateOpData(context, params, input, output, &data));
+  TfLiteEvalTensor* input =
+      context->GetEvalTensor(context, node->inputs->data[kInputTensor]);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
 
   switch (input->type) {
     case kTfLiteFloat32:
-      MaxEvalFloat(context, node, params, &data, input, output);
+      MaxEvalFloat(context, node, params, data, input, output);
       break;
     case kTfLiteUInt8:
-      MaxEvalQuantizedUInt8(context, node, params, &data, input, output);
+      MaxEvalQuantizedUInt8(context, node, params, data, input, output);
       break;
     case kTfLiteInt8:
-      MaxEvalInt8(context, node, params, &data, input, output);
+      MaxEvalInt8(context, node, params, data, input, output);
       break;
+    case kTfLiteInt16:
+      return MaxEvalInt16(context, node, params, data, input, output);
     default:
       TF_LITE_KERNEL_LOG(context, "Type %s not currently supported.",
                          TfLiteTypeGetName(input->type));
@@ -0,0 +1,74 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CONV_PATCH_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CONV_PATCH_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+
+namespace tflite {
+namespace micro {
+
+// Input and filter values as the patch-based kernels accumulate them:
+// quantized ones widened to int32 with their offset added, float ones as they
+// are.
+template <typename T>
+inline int32_t AccumulatorTerm(T value, int32_t offset) {
+  return static_cast<int32_t>(value) + offset;
+}
+
+inline float AccumulatorTerm(float value, float offset) { return value; }
+
+// Gathers the receptive field of output pixel (batch, out_y, out_x) into
+// `patch`, in the (filter_y, filter_x, in_channel) order of the serialized
+// filters. Taps outside the image get `pad_value`, the input zero point or 0
+// for float, so that they add nothing to the accumulators.
+template <typename T>
+inline void GatherConvPatch(const ConvParams& params,
+                            const RuntimeShape& input_shape,
+                            const T* input_data, int filter_height,
+                            int filter_width, int batch, int out_y, int out_x,
+                            T pad_value, T* patch) {
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int input_depth = input_shape.Dims(3);
+  const int in_y_origin = (out_y * params.stride_height) -
+                          params.padding_values.height;
+  const int in_x_origin = (out_x * params.stride_width) -
+                          params.padding_values.width;
+  for (int filter_y = 0; filter_y < filter_height; ++filter_y) {
+    const int in_y = in_y_origin + params.dilation_height_factor * filter_y;
+    for (int filter_x = 0; filter_x < filter_width; ++filter_x) {
+      const int in_x = in_x_origin + params.dilation_width_factor * filter_x;
+      const bool is_point_inside_image = (in_x >= 0) && (in_x < input_width) &&
+                                         (in_y >= 0) && (in_y < input_height);
+      const T* input_pixel =
+          is_point_inside_image
+              ? &input_data[Offset(input_shape, batch, in_y, in_x, 0)]
+              : nullptr;
+      for (int in_channel = 0; in_channel < input_depth; ++in_channel) {
+        *patch++ = input_pixel ? input_pixel[in_channel] : pad_value;
+      }
+    }
+  }
+}
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CONV_PATCH_H_
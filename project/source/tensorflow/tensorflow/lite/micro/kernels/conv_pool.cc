@@ -0,0 +1,478 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/conv_pool.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/quantization_util.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace ops {
+namespace micro {
+namespace conv_pool {
+
+// A CONV_2D whose output is only read by a MAX_POOL_2D, possibly through
+// shape-only ops, run as one kernel. Every conv output is computed exactly as
+// the CONV_2D kernel computes it, but only the maximum of each pool window is
+// written, so the full resolution activation never reaches the arena. The
+// pool windows must not overlap, which MicroAllocator::FuseConvPoolChains()
+// checks, so no conv output is computed twice.
+
+constexpr int kInputTensor = 0;
+constexpr int kFilterTensor = 1;
+constexpr int kBiasTensor = 2;
+constexpr int kOutputTensor = 0;
+constexpr int kConvOutputTensor = 0;
+constexpr int kPoolInputTensor = 1;
+
+// Conv is quantized along dimension 0:
+// https://www.tensorflow.org/lite/performance/quantization_spec
+constexpr int kConvQuantizedDimension = 0;
+
+struct OpData {
+  TfLitePaddingValues conv_padding;
+  TfLitePaddingValues pool_padding;
+
+  // Per channel output multiplier and shift of the conv.
+  int32_t* per_channel_output_multiplier;
+  int32_t* per_channel_output_shift;
+
+  // The ranges of the activations fused into the conv and the pool, which
+  // are applied one after the other.
+  int32_t conv_activation_min;
+  int32_t conv_activation_max;
+  int32_t pool_activation_min;
+  int32_t pool_activation_max;
+
+  int32_t input_zero_point;
+  int32_t output_zero_point;
+
+  // The pool input is the conv output in another shape. Both are walked in
+  // the order of their elements, so a pool input position maps to the conv
+  // output position with the same index.
+  int conv_output_width;
+  int pool_input_height;
+  int pool_input_width;
+};
+
+void* Init(TfLiteContext* context, const char* buffer, size_t length) {
+  TFLITE_DCHECK(context->AllocatePersistentBuffer != nullptr);
+  void* data = nullptr;
+  if (context->AllocatePersistentBuffer(context, sizeof(OpData), &data) ==
+      kTfLiteError) {
+    return nullptr;
+  }
+  return data;
+}
+
+TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
+  TFLITE_DCHECK(node->user_data != nullptr);
+  TFLITE_DCHECK(node->builtin_data != nullptr);
+
+  OpData* data = static_cast<OpData*>(node->user_data);
+  const auto* params =
+      static_cast<const TfLiteConvPoolParams*>(node->builtin_data);
+
+  TF_LITE_ENSURE(context, NumInputs(node) == 2 || NumInputs(node) == 3);
+  TF_LITE_ENSURE_EQ(context, NumOutputs(node), 1);
+  TF_LITE_ENSURE(context, node->intermediates != nullptr &&
+                              node->intermediates->size == 2);
+
+  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
+  const TfLiteTensor* filter = GetInput(context, node, kFilterTensor);
+  const TfLiteTensor* bias = GetOptionalInputTensor(context, node, kBiasTensor);
+  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  const TfLiteTensor* conv_output =
+      GetIntermediates(context, node, kConvOutputTensor);
+  const TfLiteTensor* pool_input =
+      GetIntermediates(context, node, kPoolInputTensor);
+
+  TF_LITE_ENSURE_EQ(context, NumDimensions(conv_output), 4);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(pool_input), 4);
+  TF_LITE_ENSURE_EQ(context, NumDimensions(output), 4);
+  TF_LITE_ENSURE_EQ(context, input->type, output->type);
+  TF_LITE_ENSURE_EQ(context, conv_output->type, output->type);
+  TF_LITE_ENSURE_EQ(context, pool_input->type, output->type);
+  TF_LITE_ENSURE_EQ(context, NumElements(conv_output),
+                    NumElements(pool_input));
+  TF_LITE_ENSURE_EQ(context, conv_output->dims->data[0],
+                    pool_input->dims->data[0]);
+  TF_LITE_ENSURE_EQ(context, conv_output->dims->data[3],
+                    pool_input->dims->data[3]);
+
+  int out_height, out_width;
+  data->conv_padding = ComputePaddingHeightWidth(
+      params->conv.stride_height, params->conv.stride_width,
+      params->conv.dilation_height_factor, params->conv.dilation_width_factor,
+      input->dims->data[1], input->dims->data[2], filter->dims->data[1],
+      filter->dims->data[2], params->conv.padding, &out_height, &out_width);
+  data->pool_padding = ComputePaddingHeightWidth(
+      params->pool.stride_height, params->pool.stride_width, 1, 1,
+      pool_input->dims->data[1], pool_input->dims->data[2],
+      params->pool.filter_height, params->pool.filter_width,
+      params->pool.padding, &out_height, &out_width);
+
+  data->conv_output_width = conv_output->dims->data[2];
+  data->pool_input_height = pool_input->dims->data[1];
+  data->pool_input_width = pool_input->dims->data[2];
+
+  if (input->type == kTfLiteFloat32) {
+    return kTfLiteOk;
+  }
+  TF_LITE_ENSURE(context,
+                 input->type == kTfLiteInt8 || input->type == kTfLiteInt16);
+  TF_LITE_ENSURE_EQ(context, filter->quantization.type,
+                    kTfLiteAffineQuantization);
+  const auto* affine_quantization =
+      static_cast<TfLiteAffineQuantization*>(filter->quantization.params);
+  TF_LITE_ENSURE(context, affine_quantization);
+  TF_LITE_ENSURE(context, affine_quantization->scale);
+  TF_LITE_ENSURE(context, affine_quantization->zero_point);
+  const int num_channels = filter->dims->data[kConvQuantizedDimension];
+  TF_LITE_ENSURE(context, affine_quantization->scale->size == 1 ||
+                              affine_quantization->scale->size ==
+                                  num_channels);
+  TF_LITE_ENSURE_EQ(context, affine_quantization->scale->size,
+                    affine_quantization->zero_point->size);
+
+  // 16x8 quantization is symmetric, which the int16 path relies on.
+  if (input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, filter->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, conv_output->params.zero_point, 0);
+  }
+
+  TF_LITE_ENSURE_STATUS(context->AllocatePersistentBuffer(
+      context, num_channels * sizeof(int32_t),
+      reinterpret_cast<void**>(&data->per_channel_output_multiplier)));
+  TF_LITE_ENSURE_STATUS(context->AllocatePersistentBuffer(
+      context, num_channels * sizeof(int32_t),
+      reinterpret_cast<void**>(&data->per_channel_output_shift)));
+
+  // The conv requantizes to its own output, whose values the pool passes on.
+  int32_t output_multiplier;
+  int output_shift;
+  TF_LITE_ENSURE_STATUS(tflite::PopulateConvolutionQuantizationParams(
+      context, input, filter, bias, const_cast<TfLiteTensor*>(conv_output),
+      params->conv.activation, &output_multiplier, &output_shift,
+      &data->conv_activation_min, &data->conv_activation_max,
+      data->per_channel_output_multiplier,
+      reinterpret_cast<int*>(data->per_channel_output_shift), num_channels));
+  TF_LITE_ENSURE_STATUS(CalculateActivationRangeQuantized(
+      context, params->pool.activation, output, &data->pool_activation_min,
+      &data->pool_activation_max));
+
+  data->input_zero_point = input->params.zero_point;
+  data->output_zero_point = conv_output->params.zero_point;
+  return kTfLiteOk;
+}
+
+// Writes to `output` the maximum of `conv_at(batch, y, x, channel)` over every
+// pool window, clamped to [pool_min, pool_max] like MAX_POOL_2D does.
+template <typename T, typename ConvAt>
+void MaxPoolConvOutputs(const TfLitePoolParams& params, const OpData& data,
+                        const ConvAt& conv_at, T pool_min, T pool_max,
+                        const RuntimeShape& output_shape, T* output_data) {
+  const int batches = output_shape.Dims(0);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int depth = output_shape.Dims(3);
+  for (int batch = 0; batch < batches; ++batch) {
+    for (int out_y = 0; out_y < output_height; ++out_y) {
+      for (int out_x = 0; out_x < output_width; ++out_x) {
+        const int in_x_origin =
+            (out_x * params.stride_width) - data.pool_padding.width;
+        const int in_y_origin =
+            (out_y * params.stride_height) - data.pool_padding.height;
+        // Compute the boundaries of the filter region clamped so as to
+        // ensure that the filter window fits in the input array.
+        const int filter_x_start = std::max(0, -in_x_origin);
+        const int filter_x_end =
+            std::min(params.filter_width, data.pool_input_width - in_x_origin);
+        const int filter_y_start = std::max(0, -in_y_origin);
+        const int filter_y_end = std::min(
+            params.filter_height, data.pool_input_height - in_y_origin);
+        T* out = output_data + Offset(output_shape, batch, out_y, out_x, 0);
+        for (int channel = 0; channel < depth; ++channel) {
+          out[channel] = std::numeric_limits<T>::lowest();
+        }
+        for (int filter_y = filter_y_start; filter_y < filter_y_end;
+             ++filter_y) {
+          for (int filter_x = filter_x_start; filter_x < filter_x_end;
+               ++filter_x) {
+            const int position =
+                (in_y_origin + filter_y) * data.pool_input_width +
+                in_x_origin + filter_x;
+            const int conv_y = position / data.conv_output_width;
+            const int conv_x = position % data.conv_output_width;
+            for (int channel = 0; channel < depth; ++channel) {
+              const T value = conv_at(batch, conv_y, conv_x, channel);
+              out[channel] = std::max(out[channel], value);
+            }
+          }
+        }
+        for (int channel = 0; channel < depth; ++channel) {
+          out[channel] = std::min(std::max(out[channel], pool_min), pool_max);
+        }
+      }
+    }
+  }
+}
+
+// Geometry shared by the conv functors below. The dims are cached as ints
+// because the functors run once per conv output and channel.
+class ConvGeometry {
+ public:
+  ConvGeometry(const TfLiteConvParams& params, const OpData& data,
+               const TfLiteEvalTensor* input, const TfLiteEvalTensor* filter)
+      : stride_width_(params.stride_width),
+        stride_height_(params.stride_height),
+        dilation_width_(params.dilation_width_factor),
+        dilation_height_(params.dilation_height_factor),
+        padding_width_(data.conv_padding.width),
+        padding_height_(data.conv_padding.height),
+        input_height_(input->dims->data[1]),
+        input_width_(input->dims->data[2]),
+        input_depth_(input->dims->data[3]),
+        filter_height_(filter->dims->data[1]),
+        filter_width_(filter->dims->data[2]) {}
+
+  // Visits the input and filter offsets of every tap of the conv output at
+  // (batch, out_y, out_x, out_channel) that lies inside the input, in the
+  // order the reference kernels accumulate them.
+  template <typename Visitor>
+  void ForEachTap(int batch, int out_y, int out_x, int out_channel,
+                  Visitor* visitor) const {
+    const int in_x_origin = (out_x * stride_width_) - padding_width_;
+    const int in_y_origin = (out_y * stride_height_) - padding_height_;
+    for (int filter_y = 0; filter_y < filter_height_; ++filter_y) {
+      const int in_y = in_y_origin + dilation_height_ * filter_y;
+      if ((in_y < 0) || (in_y >= input_height_)) {
+        continue;
+      }
+      const int input_row = (batch * input_height_ + in_y) * input_width_;
+      const int filter_row =
+          (out_channel * filter_height_ + filter_y) * filter_width_;
+      for (int filter_x = 0; filter_x < filter_width_; ++filter_x) {
+        const int in_x = in_x_origin + dilation_width_ * filter_x;
+        if ((in_x < 0) || (in_x >= input_width_)) {
+          continue;
+        }
+        (*visitor)((input_row + in_x) * input_depth_,
+                   (filter_row + filter_x) * input_depth_, input_depth_);
+      }
+    }
+  }
+
+ private:
+  const int stride_width_;
+  const int stride_height_;
+  const int dilation_width_;
+  const int dilation_height_;
+  const int padding_width_;
+  const int padding_height_;
+  const int input_height_;
+  const int input_width_;
+  const int input_depth_;
+  const int filter_height_;
+  const int filter_width_;
+};
+
+// Computes one conv output the way reference_ops::Conv does.
+class FloatConv {
+ public:
+  FloatConv(const TfLiteConvParams& params, const OpData& data,
+            const TfLiteEvalTensor* input, const TfLiteEvalTensor* filter,
+            const TfLiteEvalTensor* bias)
+      : geometry_(params, data, input, filter),
+        input_data_(tflite::micro::GetTensorData<float>(input)),
+        filter_data_(tflite::micro::GetTensorData<float>(filter)),
+        bias_data_(tflite::micro::GetTensorData<float>(bias)) {
+    CalculateActivationRange(params.activation, &activation_min_,
+                             &activation_max_);
+  }
+
+  float operator()(int batch, int out_y, int out_x, int out_channel) const {
+    Accumulator accumulator = {input_data_, filter_data_, 0.f};
+    geometry_.ForEachTap(batch, out_y, out_x, out_channel, &accumulator);
+    float bias_value = 0.0f;
+    if (bias_data_) {
+      bias_value = bias_data_[out_channel];
+    }
+    return ActivationFunctionWithMinMax(accumulator.total + bias_value,
+                                        activation_min_, activation_max_);
+  }
+
+ private:
+  struct Accumulator {
+    void operator()(int input_offset, int filter_offset, int depth) {
+      const float* input = input_data + input_offset;
+      const float* filter = filter_data + filter_offset;
+      for (int in_channel = 0; in_channel < depth; ++in_channel) {
+        total += (input[in_channel] * filter[in_channel]);
+      }
+    }
+    const float* input_data;
+    const float* filter_data;
+    float total;
+  };
+
+  const ConvGeometry geometry_;
+  const float* input_data_;
+  const float* filter_data_;
+  const float* bias_data_;
+  float activation_min_;
+  float activation_max_;
+};
+
+// Computes one conv output the way reference_integer_ops::ConvPerChannel
+// does, for int8 activations with int32 bias and int16 activations with int64
+// bias.
+template <typename InputT, typename BiasT>
+class QuantizedConv {
+ public:
+  QuantizedConv(const TfLiteConvParams& params, const OpData& data,
+                const TfLiteEvalTensor* input, const TfLiteEvalTensor* filter,
+                const TfLiteEvalTensor* bias)
+      : data_(data),
+        geometry_(params, data, input, filter),
+        input_data_(tflite::micro::GetTensorData<InputT>(input)),
+        filter_data_(tflite::micro::GetTensorData<int8_t>(filter)),
+        bias_data_(tflite::micro::GetTensorData<BiasT>(bias)) {}
+
+  InputT operator()(int batch, int out_y, int out_x, int out_channel) const {
+    Accumulator accumulator = {input_data_, filter_data_,
+                               -data_.input_zero_point, 0};
+    geometry_.ForEachTap(batch, out_y, out_x, out_channel, &accumulator);
+    BiasT acc = accumulator.acc;
+    if (bias_data_) {
+      acc += bias_data_[out_channel];
+    }
+    int32_t scaled_acc = MultiplyByQuantizedMultiplier(
+        acc, data_.per_channel_output_multiplier[out_channel],
+        data_.per_channel_output_shift[out_channel]);
+    scaled_acc += data_.output_zero_point;
+    scaled_acc = std::max(scaled_acc, data_.conv_activation_min);
+    scaled_acc = std::min(scaled_acc, data_.conv_activation_max);
+    return static_cast<InputT>(scaled_acc);
+  }
+
+ private:
+  struct Accumulator {
+    void operator()(int input_offset, int filter_offset, int depth) {
+      const InputT* input = input_data + input_offset;
+      const int8_t* filter = filter_data + filter_offset;
+      for (int in_channel = 0; in_channel < depth; ++in_channel) {
+        const int32_t input_val = input[in_channel];
+        const int32_t filter_val = filter[in_channel];
+        acc += filter_val * (input_val + input_offset_value);
+      }
+    }
+    const InputT* input_data;
+    const int8_t* filter_data;
+    int32_t input_offset_value;
+    BiasT acc;
+  };
+
+  const OpData& data_;
+  const ConvGeometry geometry_;
+  const InputT* input_data_;
+  const int8_t* filter_data_;
+  const BiasT* bias_data_;
+};
+
+TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
+  const auto* params =
+      static_cast<const TfLiteConvPoolParams*>(node->builtin_data);
+
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kFilterTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, kBiasTensor);
+
+  TFLITE_DCHECK(node->user_data != nullptr);
+  const OpData& data = *(static_cast<const OpData*>(node->user_data));
+
+  switch (input->type) {
+    case kTfLiteFloat32: {
+      float pool_min, pool_max;
+      CalculateActivationRange(params->pool.activation, &pool_min, &pool_max);
+      MaxPoolConvOutputs(params->pool, data,
+                         FloatConv(params->conv, data, input, filter, bias),
+                         pool_min, pool_max,
+                         tflite::micro::GetTensorShape(output),
+                         tflite::micro::GetTensorData<float>(output));
+      break;
+    }
+    case kTfLiteInt8:
+      MaxPoolConvOutputs(
+          params->pool, data,
+          QuantizedConv<int8_t, int32_t>(params->conv, data, input, filter,
+                                         bias),
+          static_cast<int8_t>(data.pool_activation_min),
+          static_cast<int8_t>(data.pool_activation_max),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int8_t>(output));
+      break;
+    case kTfLiteInt16:
+      MaxPoolConvOutputs(
+          params->pool, data,
+          QuantizedConv<int16_t, int64_t>(params->conv, data, input, filter,
+                                          bias),
+          static_cast<int16_t>(data.pool_activation_min),
+          static_cast<int16_t>(data.pool_activation_max),
+          tflite::micro::GetTensorShape(output),
+          tflite::micro::GetTensorData<int16_t>(output));
+      break;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(input->type), input->type);
+      return kTfLiteError;
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace conv_pool
+
+TfLiteRegistration* Register_CONV_2D_MAX_POOL_2D() {
+  static TfLiteRegistration r = {/*init=*/conv_pool::Init,
+                                 /*free=*/nullptr,
+                                 /*prepare=*/conv_pool::Prepare,
+                                 /*invoke=*/conv_pool::Eval,
+                                 /*profiling_string=*/nullptr,
+                                 /*builtin_code=*/BuiltinOperator_CUSTOM,
+                                 /*custom_name=*/"CONV_2D_MAX_POOL_2D",
+                                 /*version=*/0};
+  return &r;
+}
+
+}  // namespace micro
+}  // namespace ops
+}  // namespace tflite
@@ -0,0 +1,36 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_CONV_POOL_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_CONV_POOL_H_
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+
+namespace tflite {
+
+// Builtin data of a CONV_2D node that MicroAllocator::FuseConvPoolChains()
+// fused with the MAX_POOL_2D reading its output.
+//
+// The fused node has the inputs of the CONV_2D, the output of the
+// MAX_POOL_2D and two intermediates: the CONV_2D output and the MAX_POOL_2D
+// input, which hold the same elements in different shapes but have no
+// buffer. Only their shapes and quantization parameters are read.
+struct TfLiteConvPoolParams {
+  TfLiteConvParams conv;
+  TfLitePoolParams pool;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_CONV_POOL_H_
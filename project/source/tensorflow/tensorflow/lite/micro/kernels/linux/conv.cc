@@ -23,6 +23,13 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
 #include "tensorflow/lite/kernels/padding.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "tensorflow/lite/micro/kernels/conv_patch.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/palettized.h"
+#ifdef TF_LITE_MICRO_HOST_THREADS
+#include "tensorflow/lite/micro/linux/host_thread_pool.h"
+#endif
 
 namespace tflite {
 namespace ops {
@@ -38,6 +45,12 @@ constexpr int kOutputTensor = 0;
 // https://www.tensorflow.org/lite/performance/quantization_spec
 constexpr int kConvQuantizedDimension = 0;
 
+#ifdef TF_LITE_MICRO_HOST_THREADS
+// Below this many multiply-accumulates per thread, waking the host thread
+// pool costs more than it saves.
+constexpr int64_t kMinMacsPerThread = 1 << 16;
+#endif
+
 // This file has 2 implementation of Conv.
 
 struct OpData {
@@ -55,6 +68,27 @@ struct OpData {
   // uint8_t these would be 0 and 255.
   int32_t output_activation_min;
   int32_t output_activation_max;
+
+  // Quantization parameters, which are only available in Prepare().
+  int32_t input_zero_point;
+  int32_t filter_zero_point;
+  int32_t output_zero_point;
+
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  // Threads used by ParallelConv(). With more than one, the scratch buffer
+  // `patches_index` holds one im2col patch per thread.
+  int num_threads;
+#endif
+  int patches_index;
+
+  // Set for block-sparse or palettized filters, which take EvalCompressed()
+  // with a single patch in the scratch buffer `patches_index`, and for
+  // palettized ones their tile in `tile_index`.
+  bool is_sparse;
+  tflite::micro::BlockSparseWeights sparse_weights;
+  bool is_palettized;
+  tflite::micro::PalettizedWeights palettized_weights;
+  int tile_index;
 };
 
 inline PaddingType RuntimePaddingType(TfLitePadding padding) {
@@ -145,7 +179,7 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
       reinterpret_cast<void**>(&data->per_channel_output_shift)));
 
   // All per-channel quantized tensors need valid zero point and scale arrays.
-  if (input->type == kTfLiteInt8) {
+  if (input->type == kTfLiteInt8 || input->type == kTfLiteInt16) {
     TF_LITE_ENSURE_EQ(context, filter->quantization.type,
                       kTfLiteAffineQuantization);
 
@@ -163,19 +197,182 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
                       affine_quantization->zero_point->size);
   }
 
+  // 16x8 quantization is symmetric, which the int16 kernels rely on.
+  if (input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, filter->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+  }
+
+  data->input_zero_point = input->params.zero_point;
+  data->filter_zero_point = filter->params.zero_point;
+  data->output_zero_point = output->params.zero_point;
+
+  const int patch_size = filter_height * filter_width * input->dims->data[3];
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  data->num_threads = 1;
+#endif
+  data->is_sparse = filter->sparsity != nullptr;
+  const TfLitePalette* palette;
+  TF_LITE_ENSURE_STATUS(
+      tflite::micro::GetInputPalette(context, node, kFilterTensor, &palette));
+  data->is_palettized = palette != nullptr;
+  if (data->is_sparse || data->is_palettized) {
+    TF_LITE_ENSURE(context, input->type != kTfLiteInt16);
+    // The patch and the tile hold input and filter values: float, or 8-bit
+    // quantized.
+    const size_t value_size =
+        input->type == kTfLiteFloat32 ? sizeof(float) : sizeof(int8_t);
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, patch_size * value_size, &data->patches_index));
+    if (data->is_sparse) {
+      TF_LITE_ENSURE_STATUS(tflite::micro::GetBlockSparseWeights(
+          context, filter, num_channels, patch_size, &data->sparse_weights));
+    } else {
+      TF_LITE_ENSURE_STATUS(tflite::micro::GetPalettizedWeights(
+          context, filter, palette, num_channels, patch_size,
+          &data->palettized_weights));
+      TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+          context,
+          data->palettized_weights.tile_rows * patch_size * value_size,
+          &data->tile_index));
+    }
+  }
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  // int16 always takes the reference kernel.
+  if (!data->is_sparse && !data->is_palettized &&
+      input->type != kTfLiteInt16) {
+    data->num_threads = tflite::micro::ThreadsForWork(
+        context->recommended_num_threads,
+        static_cast<int64_t>(NumElements(output)) * patch_size,
+        kMinMacsPerThread);
+  }
+  if (data->num_threads > 1) {
+    // Float and quantized patches both hold 32-bit values.
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context, data->num_threads * patch_size * sizeof(int32_t),
+        &data->patches_index));
+  }
+#endif
+
   return CalculateOpData(context, node, params, input_width, input_height,
                          filter_width, filter_height, output_width,
                          output_height, input->type, data);
 }  // namespace conv
 
+#ifdef TF_LITE_MICRO_HOST_THREADS
+// Smallest filter tap t >= 0 for which origin + dilation * t >= 0.
+inline int FirstTapAtOrAfterZero(int origin, int dilation) {
+  return origin >= 0 ? 0 : (dilation - 1 - origin) / dilation;
+}
+
+// Multithreaded version of the reference convolutions for host builds. The
+// output pixels are split over the threads, each of which gathers the
+// in-image taps of a pixel's receptive field into its own patch, then
+// accumulates every output channel over them in the reference kernels'
+// (filter_y, filter_x, in_channel) order, skipping the padding like they do,
+// so results are bit-exact. `output_stage(acc, out_channel)` adds the bias
+// and requantizes or clamps.
+template <typename T, typename AccT, typename OutputStage>
+void ParallelConv(int num_threads, const ConvParams& params,
+                  AccT input_offset, AccT filter_offset,
+                  const RuntimeShape& input_shape, const T* input_data,
+                  const RuntimeShape& filter_shape, const T* filter_data,
+                  const RuntimeShape& output_shape, T* output_data,
+                  AccT* patches, const OutputStage& output_stage) {
+  const int stride_width = params.stride_width;
+  const int stride_height = params.stride_height;
+  const int dilation_width_factor = params.dilation_width_factor;
+  const int dilation_height_factor = params.dilation_height_factor;
+  const int pad_width = params.padding_values.width;
+  const int pad_height = params.padding_values.height;
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int input_height = input_shape.Dims(1);
+  const int input_width = input_shape.Dims(2);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int patch_size = filter_height * filter_width * input_depth;
+
+  tflite::micro::ParallelFor(
+      num_threads, batches * output_height * output_width,
+      [&](int thread_index, int begin, int end) {
+        AccT* patch = patches + thread_index * patch_size;
+        for (int i = begin; i < end; ++i) {
+          const int out_x = i % output_width;
+          const int out_y = (i / output_width) % output_height;
+          const int batch = i / (output_width * output_height);
+          const int in_x_origin = (out_x * stride_width) - pad_width;
+          const int in_y_origin = (out_y * stride_height) - pad_height;
+          // The taps inside the image form a rectangle of the filter.
+          const int filter_y_start =
+              FirstTapAtOrAfterZero(in_y_origin, dilation_height_factor);
+          const int filter_y_end = std::max(
+              filter_y_start,
+              std::min(filter_height,
+                       FirstTapAtOrAfterZero(in_y_origin - input_height,
+                                             dilation_height_factor)));
+          const int filter_x_start =
+              FirstTapAtOrAfterZero(in_x_origin, dilation_width_factor);
+          const int filter_x_end = std::max(
+              filter_x_start,
+              std::min(filter_width,
+                       FirstTapAtOrAfterZero(in_x_origin - input_width,
+                                             dilation_width_factor)));
+
+          int k = 0;
+          for (int filter_y = filter_y_start; filter_y < filter_y_end;
+               ++filter_y) {
+            const int in_y = in_y_origin + dilation_height_factor * filter_y;
+            for (int filter_x = filter_x_start; filter_x < filter_x_end;
+                 ++filter_x) {
+              const int in_x = in_x_origin + dilation_width_factor * filter_x;
+              const T* input_pixel =
+                  &input_data[Offset(input_shape, batch, in_y, in_x, 0)];
+              for (int in_channel = 0; in_channel < input_depth;
+                   ++in_channel) {
+                patch[k++] = tflite::micro::AccumulatorTerm(
+                    input_pixel[in_channel], input_offset);
+              }
+            }
+          }
+
+          const int row_size = (filter_x_end - filter_x_start) * input_depth;
+          T* output_pixel = output_data + i * output_depth;
+          for (int out_channel = 0; out_channel < output_depth;
+               ++out_channel) {
+            AccT acc = 0;
+            const AccT* patch_value = patch;
+            for (int filter_y = filter_y_start; filter_y < filter_y_end;
+                 ++filter_y) {
+              const T* filter_row = &filter_data[Offset(
+                  filter_shape, out_channel, filter_y, filter_x_start, 0)];
+              for (int j = 0; j < row_size; ++j) {
+                acc += *patch_value++ * tflite::micro::AccumulatorTerm(
+                                            filter_row[j], filter_offset);
+              }
+            }
+            output_pixel[out_channel] = output_stage(acc, out_channel);
+          }
+        }
+      });
+}
+#endif  // TF_LITE_MICRO_HOST_THREADS
+
 void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
                    TfLiteConvParams* params, const OpData& data,
-                   const TfLiteTensor* input, const TfLiteTensor* filter,
-                   const TfLiteTensor* bias, TfLiteTensor* im2col,
-                   TfLiteTensor* hwcn_weights, TfLiteTensor* output) {
-  const int32_t input_offset = -input->params.zero_point;
-  const int32_t filter_offset = -filter->params.zero_point;
-  const int32_t output_offset = output->params.zero_point;
+                   const TfLiteEvalTensor* input,
+                   const TfLiteEvalTensor* filter,
+                   const TfLiteEvalTensor* bias, TfLiteEvalTensor* output) {
+  const int32_t input_offset = -data.input_zero_point;
+  const int32_t filter_offset = -data.filter_zero_point;
+  const int32_t output_offset = data.output_zero_point;
 
   // TODO(b/154032858): Investigate removing extra copies.
   ConvParams op_params;
@@ -193,24 +390,116 @@ void EvalQuantized(TfLiteContext* context, TfLiteNode* node,
   op_params.output_shift = -data.output_shift;
   op_params.quantized_activation_min = data.output_activation_min;
   op_params.quantized_activation_max = data.output_activation_max;
-  reference_ops::Conv(op_params, GetTensorShape(input),
-                      GetTensorData<uint8_t>(input), GetTensorShape(filter),
-                      GetTensorData<uint8_t>(filter), GetTensorShape(bias),
-                      GetTensorData<int32_t>(bias), GetTensorShape(output),
-                      GetTensorData<uint8_t>(output), GetTensorShape(im2col),
-                      GetTensorData<uint8_t>(im2col), nullptr);
+
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  if (data.num_threads > 1) {
+    const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+    ParallelConv(
+        data.num_threads, op_params, input_offset, filter_offset,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<uint8_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<uint8_t>(filter),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<uint8_t>(output),
+        static_cast<int32_t*>(
+            context->GetScratchBuffer(context, data.patches_index)),
+        [&](int32_t acc, int out_channel) {
+          if (bias_data) {
+            acc += bias_data[out_channel];
+          }
+          acc = MultiplyByQuantizedMultiplier(acc, op_params.output_multiplier,
+                                              op_params.output_shift);
+          acc += output_offset;
+          acc = std::max(acc, op_params.quantized_activation_min);
+          acc = std::min(acc, op_params.quantized_activation_max);
+          return static_cast<uint8_t>(acc);
+        });
+    return;
+  }
+#endif
+
+  reference_ops::Conv(op_params, tflite::micro::GetTensorShape(input),
+                      tflite::micro::GetTensorData<uint8_t>(input),
+                      tflite::micro::GetTensorShape(filter),
+                      tflite::micro::GetTensorData<uint8_t>(filter),
+                      tflite::micro::GetTensorShape(bias),
+                      tflite::micro::GetTensorData<int32_t>(bias),
+                      tflite::micro::GetTensorShape(output),
+                      tflite::micro::GetTensorData<uint8_t>(output),
+                      RuntimeShape(), nullptr, nullptr);
 }
 
 void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
                              TfLiteConvParams* params, const OpData& data,
-                             const TfLiteTensor* input,
-                             const TfLiteTensor* filter,
-                             const TfLiteTensor* bias, TfLiteTensor* output,
-                             TfLiteTensor* im2col) {
+                             const TfLiteEvalTensor* input,
+                             const TfLiteEvalTensor* filter,
+                             const TfLiteEvalTensor* bias,
+                             TfLiteEvalTensor* output) {
+  // TODO(b/154032858): Investigate removing extra copies.
+  ConvParams op_params;
+  op_params.input_offset = -data.input_zero_point;
+  op_params.output_offset = data.output_zero_point;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.padding_values.height = data.padding.height;
+  op_params.padding_values.width = data.padding.width;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
+
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  if (data.num_threads > 1) {
+    const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+    ParallelConv(
+        data.num_threads, op_params, op_params.input_offset, 0,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<int8_t>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<int8_t>(filter),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<int8_t>(output),
+        static_cast<int32_t*>(
+            context->GetScratchBuffer(context, data.patches_index)),
+        [&](int32_t acc, int out_channel) {
+          if (bias_data) {
+            acc += bias_data[out_channel];
+          }
+          acc = MultiplyByQuantizedMultiplier(
+              acc, data.per_channel_output_multiplier[out_channel],
+              data.per_channel_output_shift[out_channel]);
+          acc += op_params.output_offset;
+          acc = std::max(acc, op_params.quantized_activation_min);
+          acc = std::min(acc, op_params.quantized_activation_max);
+          return static_cast<int8_t>(acc);
+        });
+    return;
+  }
+#endif
+
+  reference_integer_ops::ConvPerChannel(
+      op_params, data.per_channel_output_multiplier,
+      data.per_channel_output_shift, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int32_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
+}
+
+void EvalQuantizedPerChannel16x8(TfLiteContext* context, TfLiteNode* node,
+                                 TfLiteConvParams* params, const OpData& data,
+                                 const TfLiteEvalTensor* input,
+                                 const TfLiteEvalTensor* filter,
+                                 const TfLiteEvalTensor* bias,
+                                 TfLiteEvalTensor* output) {
   // TODO(b/154032858): Investigate removing extra copies.
   ConvParams op_params;
-  op_params.input_offset = -input->params.zero_point;
-  op_params.output_offset = output->params.zero_point;
+  op_params.input_offset = 0;
+  op_params.output_offset = 0;
   op_params.stride_height = params->stride_height;
   op_params.stride_width = params->stride_width;
   op_params.dilation_height_factor = params->dilation_height_factor;
@@ -222,18 +511,20 @@ void EvalQuantizedPerChannel(TfLiteContext* context, TfLiteNode* node,
 
   reference_integer_ops::ConvPerChannel(
       op_params, data.per_channel_output_multiplier,
-      data.per_channel_output_shift, GetTensorShape(input),
-      GetTensorData<int8>(input), GetTensorShape(filter),
-      GetTensorData<int8>(filter), GetTensorShape(bias),
-      GetTensorData<int32>(bias), GetTensorShape(output),
-      GetTensorData<int8>(output));
+      data.per_channel_output_shift, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int16_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int64_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int16_t>(output));
 }
 
 void EvalFloat(TfLiteContext* context, TfLiteNode* node,
                TfLiteConvParams* params, const OpData& data,
-               const TfLiteTensor* input, const TfLiteTensor* filter,
-               const TfLiteTensor* bias, TfLiteTensor* im2col,
-               TfLiteTensor* hwcn_weights, TfLiteTensor* output) {
+               const TfLiteEvalTensor* input, const TfLiteEvalTensor* filter,
+               const TfLiteEvalTensor* bias, TfLiteEvalTensor* output) {
   float output_activation_min, output_activation_max;
   CalculateActivationRange(params->activation, &output_activation_min,
                            &output_activation_max);
@@ -249,37 +540,185 @@ void EvalFloat(TfLiteContext* context, TfLiteNode* node,
   op_params.float_activation_min = output_activation_min;
   op_params.float_activation_max = output_activation_max;
 
-  reference_ops::Conv(op_params, GetTensorShape(input),
-                      GetTensorData<float>(input), GetTensorShape(filter),
-                      GetTensorData<float>(filter), GetTensorShape(bias),
-                      GetTensorData<float>(bias), GetTensorShape(output),
-                      GetTensorData<float>(output), GetTensorShape(im2col),
-                      GetTensorData<float>(im2col));
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  if (data.num_threads > 1) {
+    const float* bias_data = tflite::micro::GetTensorData<float>(bias);
+    ParallelConv(
+        data.num_threads, op_params, 0.0f, 0.0f,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<float>(input),
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorData<float>(filter),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<float>(output),
+        static_cast<float*>(
+            context->GetScratchBuffer(context, data.patches_index)),
+        [&](float total, int out_channel) {
+          const float bias_value = bias_data ? bias_data[out_channel] : 0.0f;
+          return ActivationFunctionWithMinMax(total + bias_value,
+                                              output_activation_min,
+                                              output_activation_max);
+        });
+    return;
+  }
+#endif
+
+  reference_ops::Conv(op_params, tflite::micro::GetTensorShape(input),
+                      tflite::micro::GetTensorData<float>(input),
+                      tflite::micro::GetTensorShape(filter),
+                      tflite::micro::GetTensorData<float>(filter),
+                      tflite::micro::GetTensorShape(bias),
+                      tflite::micro::GetTensorData<float>(bias),
+                      tflite::micro::GetTensorShape(output),
+                      tflite::micro::GetTensorData<float>(output),
+                      RuntimeShape(), nullptr);
+}
+
+// Block-sparse or palettized filters, whose kernels accumulate the stored
+// values in the same order as the dense ones.
+template <typename T, typename AccT, typename OutputStage>
+void CompressedConv(TfLiteContext* context, const ConvParams& op_params,
+                    const OpData& data, const TfLiteEvalTensor* input,
+                    AccT input_offset, T pad_value,
+                    const TfLiteEvalTensor* filter, AccT filter_offset,
+                    TfLiteEvalTensor* output,
+                    const OutputStage& output_stage) {
+  T* patch =
+      static_cast<T*>(context->GetScratchBuffer(context, data.patches_index));
+  if (data.is_sparse) {
+    tflite::micro::BlockSparseConv(
+        op_params, data.sparse_weights,
+        tflite::micro::GetTensorData<T>(filter), filter_offset,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<T>(input), input_offset, pad_value,
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<T>(output), patch, output_stage);
+  } else {
+    tflite::micro::PalettizedConv(
+        op_params, data.palettized_weights, filter_offset,
+        tflite::micro::GetTensorShape(input),
+        tflite::micro::GetTensorData<T>(input), input_offset, pad_value,
+        tflite::micro::GetTensorShape(filter),
+        tflite::micro::GetTensorShape(output),
+        tflite::micro::GetTensorData<T>(output),
+        static_cast<T*>(context->GetScratchBuffer(context, data.tile_index)),
+        patch, output_stage);
+  }
+}
+
+// Block-sparse or palettized filters, single-threaded. The missing blocks are
+// skipped and the palettized rows decoded a tile at a time, and the others
+// accumulated in the same order as the dense kernels.
+TfLiteStatus EvalCompressed(TfLiteContext* context, TfLiteNode* node,
+                            TfLiteConvParams* params, const OpData& data,
+                            const TfLiteEvalTensor* input,
+                            const TfLiteEvalTensor* filter,
+                            const TfLiteEvalTensor* bias,
+                            TfLiteEvalTensor* output) {
+  ConvParams op_params;
+  op_params.stride_height = params->stride_height;
+  op_params.stride_width = params->stride_width;
+  op_params.dilation_height_factor = params->dilation_height_factor;
+  op_params.dilation_width_factor = params->dilation_width_factor;
+  op_params.padding_values.height = data.padding.height;
+  op_params.padding_values.width = data.padding.width;
+
+  switch (input->type) {
+    case kTfLiteFloat32: {
+      float output_activation_min, output_activation_max;
+      CalculateActivationRange(params->activation, &output_activation_min,
+                               &output_activation_max);
+      const float* bias_data = tflite::micro::GetTensorData<float>(bias);
+      CompressedConv(
+          context, op_params, data, input, 0.0f, 0.0f, filter, 0.0f, output,
+          [&](float total, int out_channel) {
+            const float bias_value =
+                bias_data ? bias_data[out_channel] : 0.0f;
+            return ActivationFunctionWithMinMax(total + bias_value,
+                                                output_activation_min,
+                                                output_activation_max);
+          });
+      return kTfLiteOk;
+    }
+    case kTfLiteInt8: {
+      const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+      CompressedConv(
+          context, op_params, data, input, -data.input_zero_point,
+          static_cast<int8_t>(data.input_zero_point), filter, 0, output,
+          [&](int32_t acc, int out_channel) {
+            if (bias_data) {
+              acc += bias_data[out_channel];
+            }
+            acc = MultiplyByQuantizedMultiplier(
+                acc, data.per_channel_output_multiplier[out_channel],
+                data.per_channel_output_shift[out_channel]);
+            acc += data.output_zero_point;
+            acc = std::max(acc, data.output_activation_min);
+            acc = std::min(acc, data.output_activation_max);
+            return static_cast<int8_t>(acc);
+          });
+      return kTfLiteOk;
+    }
+    case kTfLiteUInt8: {
+      const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+      CompressedConv(
+          context, op_params, data, input, -data.input_zero_point,
+          static_cast<uint8_t>(data.input_zero_point), filter,
+          -data.filter_zero_point, output, [&](int32_t acc, int out_channel) {
+            if (bias_data) {
+              acc += bias_data[out_channel];
+            }
+            acc = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                                -data.output_shift);
+            acc += data.output_zero_point;
+            acc = std::max(acc, data.output_activation_min);
+            acc = std::min(acc, data.output_activation_max);
+            return static_cast<uint8_t>(acc);
+          });
+      return kTfLiteOk;
+    }
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(input->type), input->type);
+      return kTfLiteError;
+  }
 }
 
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   auto* params = reinterpret_cast<TfLiteConvParams*>(node->builtin_data);
 
-  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
-  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
-  const TfLiteTensor* filter = GetInput(context, node, kFilterTensor);
-  const TfLiteTensor* bias = GetOptionalInputTensor(context, node, kBiasTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kFilterTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, kBiasTensor);
 
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
 
+  if (data.is_sparse || data.is_palettized) {
+    return EvalCompressed(context, node, params, data, input, filter, bias,
+                          output);
+  }
+
   switch (input->type) {  // Already know in/out types are same.
     case kTfLiteFloat32:
-      EvalFloat(context, node, params, data, input, filter, bias, nullptr,
-                nullptr, output);
+      EvalFloat(context, node, params, data, input, filter, bias, output);
       break;
     case kTfLiteInt8:
       EvalQuantizedPerChannel(context, node, params, data, input, filter, bias,
-                              output, nullptr);
+                              output);
+      break;
+    case kTfLiteInt16:
+      EvalQuantizedPerChannel16x8(context, node, params, data, input, filter,
+                                  bias, output);
       break;
     case kTfLiteUInt8:
-      EvalQuantized(context, node, params, data, input, filter, bias, nullptr,
-                    nullptr, output);
+      EvalQuantized(context, node, params, data, input, filter, bias, output);
       break;
     default:
       TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
@@ -22,6 +22,12 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/reference/integer_ops/fully_connected.h"
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/block_sparse.h"
+#include "tensorflow/lite/micro/kernels/kernel_util.h"
+#include "tensorflow/lite/micro/kernels/palettized.h"
+#ifdef TF_LITE_MICRO_HOST_THREADS
+#include "tensorflow/lite/micro/linux/host_thread_pool.h"
+#endif
 
 namespace tflite {
 namespace ops {
@@ -40,6 +46,18 @@ struct OpData {
   int32_t output_activation_max;
   // The index of the temporary tensor where the quantized inputs are cached.
   int input_quantized_index;
+  // Quantization parameters, which are only available in Prepare().
+  int32_t input_zero_point;
+  int32_t filter_zero_point;
+  int32_t output_zero_point;
+  // Set for block-sparse weights, which take EvalCompressed().
+  bool is_sparse;
+  tflite::micro::BlockSparseWeights sparse_weights;
+  // Set for palettized weights, which take EvalCompressed() with their tile
+  // in the scratch buffer `tile_index`.
+  bool is_palettized;
+  tflite::micro::PalettizedWeights palettized_weights;
+  int tile_index;
 };
 
 constexpr int kInputTensor = 0;
@@ -47,6 +65,97 @@ constexpr int kWeightsTensor = 1;
 constexpr int kBiasTensor = 2;
 constexpr int kOutputTensor = 0;
 
+#ifdef TF_LITE_MICRO_HOST_THREADS
+// Below this many multiply-accumulates per thread, waking the host thread
+// pool costs more than it saves.
+constexpr int64_t kMinMacsPerThread = 1 << 16;
+
+// Threads to use for an op with the given shapes, 1 meaning the reference
+// kernel.
+int NumThreads(const TfLiteContext* context, const RuntimeShape& filter_shape,
+               const RuntimeShape& output_shape) {
+  const int64_t macs =
+      static_cast<int64_t>(output_shape.FlatSize()) *
+      filter_shape.Dims(filter_shape.DimensionsCount() - 1);
+  return tflite::micro::ThreadsForWork(context->recommended_num_threads, macs,
+                                       kMinMacsPerThread);
+}
+
+// Multithreaded versions of reference_ops::FullyConnected() (uint8) and
+// reference_integer_ops::FullyConnected() (int8). The flattened
+// [batches, output_depth] outputs are split over the threads, and each is
+// accumulated in the reference kernels' order, so results are bit-exact.
+template <typename T>
+void ParallelFullyConnected(int num_threads,
+                            const FullyConnectedParams& params,
+                            const RuntimeShape& filter_shape,
+                            const T* input_data, const T* filter_data,
+                            const int32_t* bias_data,
+                            const RuntimeShape& output_shape, T* output_data) {
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  const int output_depth = output_shape.Dims(output_dim_count - 1);
+  const int accum_depth =
+      filter_shape.Dims(filter_shape.DimensionsCount() - 1);
+  tflite::micro::ParallelFor(
+      num_threads, batches * output_depth, [&](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+          const int b = i / output_depth;
+          const int out_c = i % output_depth;
+          const T* input_row = input_data + b * accum_depth;
+          const T* filter_row = filter_data + out_c * accum_depth;
+          int32_t acc = 0;
+          for (int d = 0; d < accum_depth; ++d) {
+            const int32_t input_val = input_row[d];
+            const int32_t filter_val = filter_row[d];
+            acc += (filter_val + params.weights_offset) *
+                   (input_val + params.input_offset);
+          }
+          if (bias_data) {
+            acc += bias_data[out_c];
+          }
+          acc = MultiplyByQuantizedMultiplier(acc, params.output_multiplier,
+                                              params.output_shift);
+          acc += params.output_offset;
+          acc = std::max(acc, params.quantized_activation_min);
+          acc = std::min(acc, params.quantized_activation_max);
+          output_data[i] = static_cast<T>(acc);
+        }
+      });
+}
+
+void ParallelFullyConnected(int num_threads,
+                            const FullyConnectedParams& params,
+                            const RuntimeShape& filter_shape,
+                            const float* input_data, const float* filter_data,
+                            const float* bias_data,
+                            const RuntimeShape& output_shape,
+                            float* output_data) {
+  const int output_dim_count = output_shape.DimensionsCount();
+  const int batches = FlatSizeSkipDim(output_shape, output_dim_count - 1);
+  const int output_depth = output_shape.Dims(output_dim_count - 1);
+  const int accum_depth =
+      filter_shape.Dims(filter_shape.DimensionsCount() - 1);
+  tflite::micro::ParallelFor(
+      num_threads, batches * output_depth, [&](int, int begin, int end) {
+        for (int i = begin; i < end; ++i) {
+          const int b = i / output_depth;
+          const int out_c = i % output_depth;
+          const float* input_row = input_data + b * accum_depth;
+          const float* filter_row = filter_data + out_c * accum_depth;
+          float total = 0.f;
+          for (int d = 0; d < accum_depth; ++d) {
+            total += input_row[d] * filter_row[d];
+          }
+          const float bias_value = bias_data ? bias_data[out_c] : 0.0f;
+          output_data[i] = ActivationFunctionWithMinMax(
+              total + bias_value, params.float_activation_min,
+              params.float_activation_max);
+        }
+      });
+}
+#endif  // TF_LITE_MICRO_HOST_THREADS
+
 TfLiteStatus CalculateOpData(TfLiteContext* context,
                              TfLiteFusedActivation activation,
                              TfLiteType data_type, const TfLiteTensor* input,
@@ -94,42 +203,132 @@ TfLiteStatus Prepare(TfLiteContext* context, TfLiteNode* node) {
   TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
 
   TF_LITE_ENSURE_EQ(context, input->type, output->type);
-  TF_LITE_ENSURE_MSG(context, input->type == filter->type,
+  TF_LITE_ENSURE_MSG(context,
+                     input->type == filter->type ||
+                         (input->type == kTfLiteInt16 &&
+                          filter->type == kTfLiteInt8),
                      "Hybrid models are not supported on TFLite Micro.");
 
+  // 16x8 quantization is symmetric, which the int16 kernels rely on.
+  if (input->type == kTfLiteInt16) {
+    TF_LITE_ENSURE_EQ(context, filter->type, kTfLiteInt8);
+    TF_LITE_ENSURE_EQ(context, input->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, filter->params.zero_point, 0);
+    TF_LITE_ENSURE_EQ(context, output->params.zero_point, 0);
+  }
+
+  data->input_zero_point = input->params.zero_point;
+  data->filter_zero_point = filter->params.zero_point;
+  data->output_zero_point = output->params.zero_point;
+
+  data->is_sparse = filter->sparsity != nullptr;
+  if (data->is_sparse) {
+    TF_LITE_ENSURE(context, input->type != kTfLiteInt16);
+    TF_LITE_ENSURE_EQ(context, NumDimensions(filter), 2);
+    TF_LITE_ENSURE_STATUS(tflite::micro::GetBlockSparseWeights(
+        context, filter, SizeOfDimension(filter, 0),
+        SizeOfDimension(filter, 1), &data->sparse_weights));
+  }
+  const TfLitePalette* palette;
+  TF_LITE_ENSURE_STATUS(
+      tflite::micro::GetInputPalette(context, node, kWeightsTensor, &palette));
+  data->is_palettized = palette != nullptr;
+  if (data->is_palettized) {
+    TF_LITE_ENSURE(context, input->type != kTfLiteInt16);
+    TF_LITE_ENSURE_EQ(context, NumDimensions(filter), 2);
+    TF_LITE_ENSURE_STATUS(tflite::micro::GetPalettizedWeights(
+        context, filter, palette, SizeOfDimension(filter, 0),
+        SizeOfDimension(filter, 1), &data->palettized_weights));
+    // The tile holds weight values: float, or 8-bit quantized.
+    const tflite::micro::PalettizedWeights& weights = data->palettized_weights;
+    TF_LITE_ENSURE_STATUS(context->RequestScratchBufferInArena(
+        context,
+        weights.tile_rows * weights.cols *
+            (input->type == kTfLiteFloat32 ? sizeof(float) : sizeof(int8_t)),
+        &data->tile_index));
+  }
+
   return CalculateOpData(context, params->activation, input->type, input,
                          filter, bias, output, data);
 }
 
 TfLiteStatus EvalQuantizedInt8(TfLiteContext* context, TfLiteNode* node,
-                               const OpData& data, const TfLiteTensor* input,
-                               const TfLiteTensor* filter,
-                               const TfLiteTensor* bias, TfLiteTensor* output) {
+                               const OpData& data,
+                               const TfLiteEvalTensor* input,
+                               const TfLiteEvalTensor* filter,
+                               const TfLiteEvalTensor* bias,
+                               TfLiteEvalTensor* output) {
   tflite::FullyConnectedParams op_params;
-  op_params.input_offset = -input->params.zero_point;
-  op_params.weights_offset = -filter->params.zero_point;
-  op_params.output_offset = output->params.zero_point;
+  op_params.input_offset = -data.input_zero_point;
+  op_params.weights_offset = -data.filter_zero_point;
+  op_params.output_offset = data.output_zero_point;
   op_params.output_multiplier = data.output_multiplier;
   // TODO(b/138810107): Figure out whether output shift should be inverted
   op_params.output_shift = -data.output_shift;
   op_params.quantized_activation_min = data.output_activation_min;
   op_params.quantized_activation_max = data.output_activation_max;
 
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  const int num_threads =
+      NumThreads(context, tflite::micro::GetTensorShape(filter),
+                 tflite::micro::GetTensorShape(output));
+  if (num_threads > 1) {
+    ParallelFullyConnected(num_threads, op_params,
+                           tflite::micro::GetTensorShape(filter),
+                           tflite::micro::GetTensorData<int8_t>(input),
+                           tflite::micro::GetTensorData<int8_t>(filter),
+                           tflite::micro::GetTensorData<int32_t>(bias),
+                           tflite::micro::GetTensorShape(output),
+                           tflite::micro::GetTensorData<int8_t>(output));
+    return kTfLiteOk;
+  }
+#endif
+
+  reference_integer_ops::FullyConnected(
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int8_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int32_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int8_t>(output));
+  return kTfLiteOk;
+}
+
+TfLiteStatus EvalQuantizedInt16(TfLiteContext* context, TfLiteNode* node,
+                                const OpData& data,
+                                const TfLiteEvalTensor* input,
+                                const TfLiteEvalTensor* filter,
+                                const TfLiteEvalTensor* bias,
+                                TfLiteEvalTensor* output) {
+  tflite::FullyConnectedParams op_params;
+  op_params.weights_offset = 0;
+  op_params.output_multiplier = data.output_multiplier;
+  op_params.output_shift = -data.output_shift;
+  op_params.quantized_activation_min = data.output_activation_min;
+  op_params.quantized_activation_max = data.output_activation_max;
+
   reference_integer_ops::FullyConnected(
-      op_params, GetTensorShape(input), GetTensorData<int8_t>(input),
-      GetTensorShape(filter), GetTensorData<int8_t>(filter),
-      GetTensorShape(bias), GetTensorData<int32_t>(bias),
-      GetTensorShape(output), GetTensorData<int8_t>(output));
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<int16_t>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<int8_t>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<int64_t>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<int16_t>(output));
   return kTfLiteOk;
 }
 
 TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
-                           const OpData& data, const TfLiteTensor* input,
-                           const TfLiteTensor* filter, const TfLiteTensor* bias,
-                           TfLiteTensor* output) {
-  const int32_t input_offset = -input->params.zero_point;
-  const int32_t filter_offset = -filter->params.zero_point;
-  const int32_t output_offset = output->params.zero_point;
+                           const OpData& data, const TfLiteEvalTensor* input,
+                           const TfLiteEvalTensor* filter,
+                           const TfLiteEvalTensor* bias,
+                           TfLiteEvalTensor* output) {
+  const int32_t input_offset = -data.input_zero_point;
+  const int32_t filter_offset = -data.filter_zero_point;
+  const int32_t output_offset = data.output_zero_point;
 
   tflite::FullyConnectedParams op_params;
   op_params.input_offset = input_offset;
@@ -141,16 +340,36 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
   op_params.quantized_activation_min = data.output_activation_min;
   op_params.quantized_activation_max = data.output_activation_max;
 
-#define TF_LITE_FULLY_CONNECTED(output_data_type)                      \
-  reference_ops::FullyConnected(                                       \
-      op_params, GetTensorShape(input), GetTensorData<uint8_t>(input), \
-      GetTensorShape(filter), GetTensorData<uint8_t>(filter),          \
-      GetTensorShape(bias), GetTensorData<int32_t>(bias),              \
-      GetTensorShape(output), GetTensorData<output_data_type>(output))
+#define TF_LITE_FULLY_CONNECTED(output_data_type)      \
+  reference_ops::FullyConnected(                       \
+      op_params, tflite::micro::GetTensorShape(input), \
+      tflite::micro::GetTensorData<uint8_t>(input),    \
+      tflite::micro::GetTensorShape(filter),           \
+      tflite::micro::GetTensorData<uint8_t>(filter),   \
+      tflite::micro::GetTensorShape(bias),             \
+      tflite::micro::GetTensorData<int32_t>(bias),     \
+      tflite::micro::GetTensorShape(output),           \
+      tflite::micro::GetTensorData<output_data_type>(output))
   switch (output->type) {
-    case kTfLiteUInt8:
+    case kTfLiteUInt8: {
+#ifdef TF_LITE_MICRO_HOST_THREADS
+      const int num_threads =
+          NumThreads(context, tflite::micro::GetTensorShape(filter),
+                     tflite::micro::GetTensorShape(output));
+      if (num_threads > 1) {
+        ParallelFullyConnected(num_threads, op_params,
+                               tflite::micro::GetTensorShape(filter),
+                               tflite::micro::GetTensorData<uint8_t>(input),
+                               tflite::micro::GetTensorData<uint8_t>(filter),
+                               tflite::micro::GetTensorData<int32_t>(bias),
+                               tflite::micro::GetTensorShape(output),
+                               tflite::micro::GetTensorData<uint8_t>(output));
+        break;
+      }
+#endif
       TF_LITE_FULLY_CONNECTED(uint8_t);
       break;
+    }
     case kTfLiteInt16:
       TF_LITE_FULLY_CONNECTED(int16_t);
       break;
@@ -165,36 +384,160 @@ TfLiteStatus EvalQuantized(TfLiteContext* context, TfLiteNode* node,
 
 TfLiteStatus EvalFloat(TfLiteContext* context, TfLiteNode* node,
                        TfLiteFusedActivation activation,
-                       const TfLiteTensor* input, const TfLiteTensor* filter,
-                       const TfLiteTensor* bias, TfLiteTensor* output) {
+                       const TfLiteEvalTensor* input,
+                       const TfLiteEvalTensor* filter,
+                       const TfLiteEvalTensor* bias, TfLiteEvalTensor* output) {
   float output_activation_min, output_activation_max;
   CalculateActivationRange(activation, &output_activation_min,
                            &output_activation_max);
   tflite::FullyConnectedParams op_params;
   op_params.float_activation_min = output_activation_min;
   op_params.float_activation_max = output_activation_max;
+#ifdef TF_LITE_MICRO_HOST_THREADS
+  const int num_threads =
+      NumThreads(context, tflite::micro::GetTensorShape(filter),
+                 tflite::micro::GetTensorShape(output));
+  if (num_threads > 1) {
+    ParallelFullyConnected(num_threads, op_params,
+                           tflite::micro::GetTensorShape(filter),
+                           tflite::micro::GetTensorData<float>(input),
+                           tflite::micro::GetTensorData<float>(filter),
+                           tflite::micro::GetTensorData<float>(bias),
+                           tflite::micro::GetTensorShape(output),
+                           tflite::micro::GetTensorData<float>(output));
+    return kTfLiteOk;
+  }
+#endif
   tflite::reference_ops::FullyConnected(
-      op_params, GetTensorShape(input), GetTensorData<float>(input),
-      GetTensorShape(filter), GetTensorData<float>(filter),
-      GetTensorShape(bias), GetTensorData<float>(bias), GetTensorShape(output),
-      GetTensorData<float>(output));
+      op_params, tflite::micro::GetTensorShape(input),
+      tflite::micro::GetTensorData<float>(input),
+      tflite::micro::GetTensorShape(filter),
+      tflite::micro::GetTensorData<float>(filter),
+      tflite::micro::GetTensorShape(bias),
+      tflite::micro::GetTensorData<float>(bias),
+      tflite::micro::GetTensorShape(output),
+      tflite::micro::GetTensorData<float>(output));
   return kTfLiteOk;
 }
 
+// Block-sparse or palettized weights, whose kernels accumulate the stored
+// values in the same order as the dense ones.
+template <typename T, typename AccT, typename OutputStage>
+void CompressedFullyConnected(TfLiteContext* context, const OpData& data,
+                              const TfLiteEvalTensor* filter,
+                              AccT filter_offset, int batches,
+                              const T* input_data, AccT input_offset,
+                              T* output_data,
+                              const OutputStage& output_stage) {
+  if (data.is_sparse) {
+    tflite::micro::BlockSparseFullyConnected(
+        data.sparse_weights, tflite::micro::GetTensorData<T>(filter),
+        filter_offset, batches, input_data, input_offset, output_data,
+        output_stage);
+  } else {
+    tflite::micro::PalettizedFullyConnected(
+        data.palettized_weights, filter_offset, batches, input_data,
+        input_offset, output_data,
+        static_cast<T*>(context->GetScratchBuffer(context, data.tile_index)),
+        output_stage);
+  }
+}
+
+// Block-sparse or palettized weights, single-threaded. The missing blocks are
+// skipped and the palettized rows decoded a tile at a time, and the others
+// accumulated in the same order as the dense kernels.
+TfLiteStatus EvalCompressed(TfLiteContext* context, TfLiteNode* node,
+                            TfLiteFusedActivation activation,
+                            const OpData& data, const TfLiteEvalTensor* input,
+                            const TfLiteEvalTensor* filter,
+                            const TfLiteEvalTensor* bias,
+                            TfLiteEvalTensor* output) {
+  const int rows = data.is_sparse ? data.sparse_weights.rows
+                                  : data.palettized_weights.rows;
+  const int batches = tflite::micro::GetTensorShape(output).FlatSize() / rows;
+
+  if (input->type == kTfLiteFloat32) {
+    float output_activation_min, output_activation_max;
+    CalculateActivationRange(activation, &output_activation_min,
+                             &output_activation_max);
+    const float* bias_data = tflite::micro::GetTensorData<float>(bias);
+    CompressedFullyConnected(
+        context, data, filter, 0.0f, batches,
+        tflite::micro::GetTensorData<float>(input), 0.0f,
+        tflite::micro::GetTensorData<float>(output),
+        [&](float total, int out_channel) {
+          const float bias_value = bias_data ? bias_data[out_channel] : 0.0f;
+          return ActivationFunctionWithMinMax(total + bias_value,
+                                              output_activation_min,
+                                              output_activation_max);
+        });
+    return kTfLiteOk;
+  }
+
+  const int32_t* bias_data = tflite::micro::GetTensorData<int32_t>(bias);
+  // Output shift is +ve-means-left, like in the dense kernels' params.
+  auto output_stage = [&](int32_t acc, int out_channel) {
+    if (bias_data) {
+      acc += bias_data[out_channel];
+    }
+    acc = MultiplyByQuantizedMultiplier(acc, data.output_multiplier,
+                                        -data.output_shift);
+    acc += data.output_zero_point;
+    acc = std::max(acc, data.output_activation_min);
+    return std::min(acc, data.output_activation_max);
+  };
+  switch (input->type) {
+    case kTfLiteInt8:
+      CompressedFullyConnected(
+          context, data, filter, -data.filter_zero_point, batches,
+          tflite::micro::GetTensorData<int8_t>(input), -data.input_zero_point,
+          tflite::micro::GetTensorData<int8_t>(output),
+          [&](int32_t acc, int out_channel) {
+            return static_cast<int8_t>(output_stage(acc, out_channel));
+          });
+      return kTfLiteOk;
+    case kTfLiteUInt8:
+      TF_LITE_ENSURE_EQ(context, output->type, kTfLiteUInt8);
+      CompressedFullyConnected(
+          context, data, filter, -data.filter_zero_point, batches,
+          tflite::micro::GetTensorData<uint8_t>(input),
+          -data.input_zero_point,
+          tflite::micro::GetTensorData<uint8_t>(output),
+          [&](int32_t acc, int out_channel) {
+            return static_cast<uint8_t>(output_stage(acc, out_channel));
+          });
+      return kTfLiteOk;
+    default:
+      TF_LITE_KERNEL_LOG(context, "Type %s (%d) not supported.",
+                         TfLiteTypeGetName(input->type), input->type);
+      return kTfLiteError;
+  }
+}
+
 TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
   TFLITE_DCHECK(node->builtin_data != nullptr);
   const auto* params =
       static_cast<const TfLiteFullyConnectedParams*>(node->builtin_data);
 
-  const TfLiteTensor* input = GetInput(context, node, kInputTensor);
-  const TfLiteTensor* filter = GetInput(context, node, kWeightsTensor);
-  const TfLiteTensor* bias = GetOptionalInputTensor(context, node, kBiasTensor);
-  TfLiteTensor* output = GetOutput(context, node, kOutputTensor);
+  const TfLiteEvalTensor* input =
+      tflite::micro::GetEvalInput(context, node, kInputTensor);
+  const TfLiteEvalTensor* filter =
+      tflite::micro::GetEvalInput(context, node, kWeightsTensor);
+  const TfLiteEvalTensor* bias =
+      tflite::micro::GetEvalInput(context, node, kBiasTensor);
+  TfLiteEvalTensor* output =
+      tflite::micro::GetEvalOutput(context, node, kOutputTensor);
 
   TFLITE_DCHECK(node->user_data != nullptr);
   const OpData& data = *(static_cast<const OpData*>(node->user_data));
 
-  // Checks in Prepare ensure input, output and filter types are all the same.
+  if (data.is_sparse || data.is_palettized) {
+    return EvalCompressed(context, node, params->activation, data, input,
+                          filter, bias, output);
+  }
+
+  // Checks in Prepare ensure input, output and filter types are all the same,
+  // except for the int8 filter of 16x8 models.
   switch (input->type) {
     case kTfLiteFloat32:
       return EvalFloat(context, node, params->activation, input, filter, bias,
@@ -202,6 +545,9 @@ TfLiteStatus Eval(TfLiteContext* context, TfLiteNode* node) {
     case kTfLiteInt8:
       return EvalQuantizedInt8(context, node, data, input, filter, bias,
                                output);
+    case kTfLiteInt16:
+      return EvalQuantizedInt16(context, node, data, input, filter, bias,
+                                output);
 
     case kTfLiteUInt8:
       return EvalQuantized(context, node, data, input, filter, bias, output);
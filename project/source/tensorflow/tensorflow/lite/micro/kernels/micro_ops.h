@@ -40,11 +40,15 @@ TfLiteRegistration* Register_AVERAGE_POOL_2D();
 TfLiteRegistration* Register_CEIL();
 TfLiteRegistration* Register_CIRCULAR_BUFFER();
 TfLiteRegistration* Register_CONV_2D();
+// Not a builtin operator, see MicroInterpreter::EnableConvPoolFusion().
+TfLiteRegistration* Register_CONV_2D_MAX_POOL_2D();
 TfLiteRegistration* Register_CONCATENATION();
 TfLiteRegistration* Register_COS();
 TfLiteRegistration* Register_DEPTHWISE_CONV_2D();
 TfLiteRegistration* Register_DEQUANTIZE();
+TfLiteRegistration* Register_DIV();
 TfLiteRegistration* Register_EQUAL();
+TfLiteRegistration* Register_EXPAND_DIMS();
 TfLiteRegistration* Register_FLOOR();
 TfLiteRegistration* Register_FULLY_CONNECTED();
 TfLiteRegistration* Register_GREATER();
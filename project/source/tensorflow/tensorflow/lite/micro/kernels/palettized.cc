@@ -0,0 +1,68 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/kernels/palettized.h"
+
+#include <algorithm>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
+#include "tensorflow/lite/kernels/kernel_util.h"
+
+namespace tflite {
+namespace micro {
+
+TfLiteStatus GetInputPalette(TfLiteContext* context, const TfLiteNode* node,
+                             int index, const TfLitePalette** palette) {
+  *palette = nullptr;
+  if (context->GetTensorPalette == nullptr) {
+    return kTfLiteOk;
+  }
+  return context->GetTensorPalette(context, node->inputs->data[index],
+                                   palette);
+}
+
+TfLiteStatus GetPalettizedWeights(TfLiteContext* context,
+                                  const TfLiteTensor* tensor,
+                                  const TfLitePalette* palette, int rows,
+                                  int cols, PalettizedWeights* result) {
+  TF_LITE_ENSURE(context, palette != nullptr);
+  TF_LITE_ENSURE(context, tensor->sparsity == nullptr);
+  TF_LITE_ENSURE_EQ(context, tensor->allocation_type, kTfLiteMmapRo);
+  TF_LITE_ENSURE_MSG(context,
+                     tensor->type == kTfLiteFloat32 ||
+                         tensor->type == kTfLiteInt8 ||
+                         tensor->type == kTfLiteUInt8,
+                     "Palettized weights must be float32, int8 or uint8.");
+  const int bits = palette->bits_per_index;
+  TF_LITE_ENSURE(context, bits == 1 || bits == 2 || bits == 4 || bits == 8);
+  TF_LITE_ENSURE(context, rows > 0 && cols > 0);
+  TF_LITE_ENSURE_EQ(context, NumElements(tensor),
+                    static_cast<int64_t>(rows) * cols);
+
+  const int row_bytes =
+      cols * (tensor->type == kTfLiteFloat32 ? sizeof(float) : sizeof(int8_t));
+  result->rows = rows;
+  result->cols = cols;
+  result->bits_per_index = bits;
+  result->indices = GetTensorData<uint8_t>(tensor);
+  result->palette = palette->values;
+  result->tile_rows =
+      std::max(1, std::min(rows, kMaxPalettizedTileBytes / row_bytes));
+  return kTfLiteOk;
+}
+
+}  // namespace micro
+}  // namespace tflite
@@ -0,0 +1,203 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_KERNELS_PALETTIZED_H_
+#define TENSORFLOW_LITE_MICRO_KERNELS_PALETTIZED_H_
+
+#include <algorithm>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/kernels/internal/common.h"
+#include "tensorflow/lite/kernels/internal/types.h"
+#include "tensorflow/lite/micro/kernels/conv_patch.h"
+
+namespace tflite {
+namespace micro {
+
+// Palettized weights of FULLY_CONNECTED and CONV_2D, as written by
+// tools/palette_converter.cc.
+//
+// A palettized tensor keeps its type and dense shape, but its buffer holds an
+// index per value into a palette of 1 << bits_per_index values, with
+// bits_per_index 1, 2, 4 or 8, packed from the low bits of each byte up.
+// Packed int4 weights are the case of 16 evenly spaced values. The palette is
+// stored in the tensor's CustomQuantization details, after an 8-byte header:
+//
+//   'P' 'A' 'L' kPaletteVersion  bits_per_index  0 0 0  values...
+//
+// with the 1 << bits_per_index values of the tensor's type, little-endian.
+// Int8 and uint8 tensors keep their scale and zero point as usual, and the
+// palette holds quantized values. Kernels read the header with
+// GetInputPalette(), see TfLiteContext::GetTensorPalette.
+//
+// Like block_sparse.h, the kernels see the weights as a [rows, cols] matrix,
+// rows being the output channels. They decode `tile_rows` rows at a time into
+// a scratch buffer of the arena right before using them, so every weight is
+// read once from flash per invocation, and then accumulate them exactly as the
+// dense kernels do: results are those of the dense model with the palette
+// values.
+struct PalettizedWeights {
+  int rows;
+  int cols;
+  int bits_per_index;
+  const uint8_t* indices;
+  // 1 << bits_per_index values of the tensor's type.
+  const void* palette;
+  // Rows decoded at a time, which the kernels' tile buffer must hold.
+  int tile_rows;
+};
+
+constexpr char kPaletteMagic[3] = {'P', 'A', 'L'};
+constexpr uint8_t kPaletteVersion = 1;
+constexpr int kPaletteHeaderSize = 8;
+
+// Largest tile the kernels decode, unless a single row is bigger.
+constexpr int kMaxPalettizedTileBytes = 4096;
+
+// Sets `palette` to the palette of input `index` of `node`, or to null if
+// the tensor stores its values or the runtime has no palettes. Valid in
+// prepare only.
+TfLiteStatus GetInputPalette(TfLiteContext* context, const TfLiteNode* node,
+                             int index, const TfLitePalette** palette);
+
+// Reads the palettized `tensor`, whose palette GetInputPalette() returned, as
+// a [rows, cols] matrix into `result`, reporting an error if it is not a
+// float32, int8 or uint8 constant in the format above.
+TfLiteStatus GetPalettizedWeights(TfLiteContext* context,
+                                  const TfLiteTensor* tensor,
+                                  const TfLitePalette* palette, int rows,
+                                  int cols, PalettizedWeights* result);
+
+// Writes the values of rows `begin_row` to `end_row` - 1 to `values`.
+template <typename T>
+inline void DecodePalettizedRows(const PalettizedWeights& weights,
+                                 int begin_row, int end_row, T* values) {
+  const T* palette = static_cast<const T*>(weights.palette);
+  const int bits = weights.bits_per_index;
+  const int count = (end_row - begin_row) * weights.cols;
+  const int64_t first_bit =
+      static_cast<int64_t>(begin_row) * weights.cols * bits;
+  const uint8_t* packed = weights.indices + first_bit / 8;
+  if (bits == 8) {
+    for (int i = 0; i < count; ++i) {
+      values[i] = palette[packed[i]];
+    }
+    return;
+  }
+  const int mask = (1 << bits) - 1;
+  int shift = static_cast<int>(first_bit % 8);
+  for (int i = 0; i < count; ++i) {
+    values[i] = palette[(*packed >> shift) & mask];
+    shift += bits;
+    if (shift == 8) {
+      shift = 0;
+      ++packed;
+    }
+  }
+}
+
+// Accumulates a decoded row of `cols` values against `input` in ascending
+// order, like the dense reference kernels.
+template <typename T, typename AccT>
+inline AccT PalettizedDot(const T* row, AccT filter_offset, const T* input,
+                          AccT input_offset, int cols) {
+  AccT acc = 0;
+  for (int i = 0; i < cols; ++i) {
+    acc += AccumulatorTerm(row[i], filter_offset) *
+           AccumulatorTerm(input[i], input_offset);
+  }
+  return acc;
+}
+
+// Fully connected layer over `batches` input rows of `weights.cols` values,
+// decoding the weights into `tile`. `output_stage(acc, out_channel)` adds the
+// bias and requantizes or clamps.
+template <typename T, typename AccT, typename OutputStage>
+inline void PalettizedFullyConnected(const PalettizedWeights& weights,
+                                     AccT filter_offset, int batches,
+                                     const T* input_data, AccT input_offset,
+                                     T* output_data, T* tile,
+                                     const OutputStage& output_stage) {
+  const int cols = weights.cols;
+  for (int begin = 0; begin < weights.rows; begin += weights.tile_rows) {
+    const int end = std::min(begin + weights.tile_rows, weights.rows);
+    DecodePalettizedRows(weights, begin, end, tile);
+    for (int b = 0; b < batches; ++b) {
+      const T* input_row = input_data + b * cols;
+      T* output_row = output_data + b * weights.rows;
+      for (int out_channel = begin; out_channel < end; ++out_channel) {
+        const AccT acc =
+            PalettizedDot(tile + (out_channel - begin) * cols, filter_offset,
+                          input_row, input_offset, cols);
+        output_row[out_channel] = output_stage(acc, out_channel);
+      }
+    }
+  }
+}
+
+// Convolution with palettized filters of shape `filter_shape`, decoding them
+// into `tile`. For each tile, the receptive field of every output pixel is
+// gathered into `patch` (weights.cols values) as in BlockSparseConv(), then
+// multiplied by the decoded rows.
+template <typename T, typename AccT, typename OutputStage>
+inline void PalettizedConv(const ConvParams& params,
+                           const PalettizedWeights& weights,
+                           AccT filter_offset, const RuntimeShape& input_shape,
+                           const T* input_data, AccT input_offset, T pad_value,
+                           const RuntimeShape& filter_shape,
+                           const RuntimeShape& output_shape, T* output_data,
+                           T* tile, T* patch,
+                           const OutputStage& output_stage) {
+  TFLITE_DCHECK_EQ(input_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(filter_shape.DimensionsCount(), 4);
+  TFLITE_DCHECK_EQ(output_shape.DimensionsCount(), 4);
+  const int batches = MatchingDim(input_shape, 0, output_shape, 0);
+  const int input_depth = MatchingDim(input_shape, 3, filter_shape, 3);
+  const int output_depth = MatchingDim(filter_shape, 0, output_shape, 3);
+  const int filter_height = filter_shape.Dims(1);
+  const int filter_width = filter_shape.Dims(2);
+  const int output_height = output_shape.Dims(1);
+  const int output_width = output_shape.Dims(2);
+  const int cols = weights.cols;
+  TFLITE_DCHECK_EQ(weights.rows, output_depth);
+  TFLITE_DCHECK_EQ(cols, filter_height * filter_width * input_depth);
+
+  for (int begin = 0; begin < output_depth; begin += weights.tile_rows) {
+    const int end = std::min(begin + weights.tile_rows, output_depth);
+    DecodePalettizedRows(weights, begin, end, tile);
+    for (int batch = 0; batch < batches; ++batch) {
+      for (int out_y = 0; out_y < output_height; ++out_y) {
+        for (int out_x = 0; out_x < output_width; ++out_x) {
+          GatherConvPatch(params, input_shape, input_data, filter_height,
+                          filter_width, batch, out_y, out_x, pad_value, patch);
+          T* output_pixel =
+              &output_data[Offset(output_shape, batch, out_y, out_x, 0)];
+          for (int out_channel = begin; out_channel < end; ++out_channel) {
+            const AccT acc =
+                PalettizedDot(tile + (out_channel - begin) * cols,
+                              filter_offset, patch, input_offset, cols);
+            output_pixel[out_channel] = output_stage(acc, out_channel);
+          }
+        }
+      }
+    }
+  }
+}
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_KERNELS_PALETTIZED_H_
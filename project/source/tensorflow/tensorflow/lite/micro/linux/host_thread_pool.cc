@@ -0,0 +1,136 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/linux/host_thread_pool.h"
+
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace tflite {
+namespace micro {
+namespace {
+
+class HostThreadPool {
+ public:
+  ~HostThreadPool() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+    work_cv_.notify_all();
+    for (std::thread& worker : workers_) {
+      worker.join();
+    }
+  }
+
+  void Run(int num_threads, int count, void (*fn)(void*, int, int, int),
+           void* arg) {
+    std::lock_guard<std::mutex> run_lock(run_mutex_);
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (static_cast<int>(workers_.size()) < num_threads - 1) {
+      const int thread_index = static_cast<int>(workers_.size()) + 1;
+      workers_.emplace_back(&HostThreadPool::WorkerLoop, this, thread_index);
+    }
+    fn_ = fn;
+    arg_ = arg;
+    num_threads_ = num_threads;
+    count_ = count;
+    pending_ = num_threads - 1;
+    ++generation_;
+    lock.unlock();
+    work_cv_.notify_all();
+
+    int begin, end;
+    Range(0, &begin, &end);
+    fn(arg, 0, begin, end);
+
+    lock.lock();
+    done_cv_.wait(lock, [this]() { return pending_ == 0; });
+    fn_ = nullptr;
+    arg_ = nullptr;
+  }
+
+ private:
+  // Thread `thread_index` gets an equal share of [0, count_), the first
+  // count_ % num_threads_ threads one item more.
+  void Range(int thread_index, int* begin, int* end) const {
+    const int share = count_ / num_threads_;
+    const int extra = count_ % num_threads_;
+    *begin = thread_index * share +
+             (thread_index < extra ? thread_index : extra);
+    *end = *begin + share + (thread_index < extra ? 1 : 0);
+  }
+
+  void WorkerLoop(int thread_index) {
+    unsigned seen_generation = 0;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+      work_cv_.wait(lock, [this, seen_generation]() {
+        return stop_ || generation_ != seen_generation;
+      });
+      if (stop_) {
+        return;
+      }
+      seen_generation = generation_;
+      if (thread_index >= num_threads_) {
+        continue;
+      }
+      void (*fn)(void*, int, int, int) = fn_;
+      void* arg = arg_;
+      int begin, end;
+      Range(thread_index, &begin, &end);
+      lock.unlock();
+      fn(arg, thread_index, begin, end);
+      lock.lock();
+      if (--pending_ == 0) {
+        done_cv_.notify_one();
+      }
+    }
+  }
+
+  std::mutex run_mutex_;
+  std::mutex mutex_;
+  std::condition_variable work_cv_;
+  std::condition_variable done_cv_;
+  std::vector<std::thread> workers_;
+  void (*fn_)(void*, int, int, int) = nullptr;
+  void* arg_ = nullptr;
+  int num_threads_ = 0;
+  int count_ = 0;
+  int pending_ = 0;
+  unsigned generation_ = 0;
+  bool stop_ = false;
+};
+
+}  // namespace
+
+void ParallelFor(int num_threads, int count,
+                 void (*fn)(void* arg, int thread_index, int begin, int end),
+                 void* arg) {
+  if (num_threads > count) {
+    num_threads = count;
+  }
+  if (num_threads <= 1) {
+    fn(arg, 0, 0, count);
+    return;
+  }
+  static HostThreadPool pool;
+  pool.Run(num_threads, count, fn, arg);
+}
+
+}  // namespace micro
+}  // namespace tflite
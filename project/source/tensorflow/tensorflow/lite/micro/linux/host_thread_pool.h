@@ -0,0 +1,64 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_LINUX_HOST_THREAD_POOL_H_
+#define TENSORFLOW_LITE_MICRO_LINUX_HOST_THREAD_POOL_H_
+
+#include <cstdint>
+
+namespace tflite {
+namespace micro {
+
+// Splits [0, count) into at most `num_threads` contiguous ranges and calls
+// `fn(arg, thread_index, begin, end)` for each of them in parallel, with
+// thread_index in [0, num_threads). Returns once all ranges are done. The
+// first range runs on the calling thread, the others on a process-wide pool
+// of worker threads that is grown on demand and reused across calls.
+//
+// Only available in host builds that define TF_LITE_MICRO_HOST_THREADS, where
+// the kernels in kernels/linux use it when the interpreter was given more
+// than one thread (see MicroInterpreter::SetNumThreads()). Calls from
+// different threads are serialized; `fn` must not call ParallelFor() itself.
+void ParallelFor(int num_threads, int count,
+                 void (*fn)(void* arg, int thread_index, int begin, int end),
+                 void* arg);
+
+// Same for a callable `fn(thread_index, begin, end)`, typically a lambda.
+// Nothing is allocated per call.
+template <typename Fn>
+void ParallelFor(int num_threads, int count, const Fn& fn) {
+  ParallelFor(
+      num_threads, count,
+      [](void* arg, int thread_index, int begin, int end) {
+        (*static_cast<const Fn*>(arg))(thread_index, begin, end);
+      },
+      const_cast<Fn*>(&fn));
+}
+
+// Number of threads worth waking for `work` units (e.g. multiply-accumulates)
+// when up to `max_threads` are allowed: each thread gets at least
+// `min_work_per_thread` units.
+inline int ThreadsForWork(int max_threads, int64_t work,
+                          int64_t min_work_per_thread) {
+  int64_t threads = work / min_work_per_thread;
+  if (threads > max_threads) {
+    threads = max_threads;
+  }
+  return threads < 1 ? 1 : static_cast<int>(threads);
+}
+
+}  // namespace micro
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_LINUX_HOST_THREAD_POOL_H_
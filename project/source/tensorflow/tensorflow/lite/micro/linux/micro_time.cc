@@ -0,0 +1,37 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Host implementation of the timer functions, used when the library is built
+// for Linux to run benchmarks and profile models off-target. Ticks are
+// microseconds of the monotonic clock, truncated to 32 bits; differences
+// between two readings stay valid across the wrap-around.
+
+#include <time.h>
+
+#include "tensorflow/lite/micro/micro_time.h"
+
+namespace tflite {
+
+int32_t ticks_per_second() { return 1000000; }
+
+int32_t GetCurrentTimeTicks() {
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  const uint64_t us = static_cast<uint64_t>(ts.tv_sec) * 1000000u +
+                      static_cast<uint64_t>(ts.tv_nsec) / 1000u;
+  return static_cast<int32_t>(static_cast<uint32_t>(us));
+}
+
+}  // namespace tflite
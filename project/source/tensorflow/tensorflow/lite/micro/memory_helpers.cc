@@ -22,6 +22,7 @@ limitations under the License.
 #include "tensorflow/lite/c/common.h"
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/flatbuffer_conversions.h"
+#include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 namespace tflite {
@@ -73,8 +74,10 @@ TfLiteStatus TfLiteTypeSizeOf(TfLiteType type, size_t* size,
       *size = sizeof(float) * 2;
       break;
     default:
-      reporter->Report("Type %s (%d) not is not supported",
-                       TfLiteTypeGetName(type), type);
+      if (reporter != nullptr) {
+        reporter->Report("Type %s (%d) not is not supported",
+                         TfLiteTypeGetName(type), type);
+      }
       return kTfLiteError;
   }
   return kTfLiteOk;
@@ -101,4 +104,21 @@ TfLiteStatus BytesRequiredForTensor(const tflite::Tensor& flatbuffer_tensor,
   return kTfLiteOk;
 }
 
+TfLiteStatus TfLiteEvalTensorByteLength(const TfLiteEvalTensor* eval_tensor,
+                                        size_t* out_bytes) {
+  TFLITE_DCHECK(out_bytes != nullptr);
+  int element_count = 1;
+  // If eval_tensor->dims == nullptr, then tensor is a scalar so has 1 element.
+  if (eval_tensor->dims != nullptr) {
+    for (int n = 0; n < eval_tensor->dims->size; ++n) {
+      element_count *= eval_tensor->dims->data[n];
+    }
+  }
+  size_t type_size;
+  TF_LITE_ENSURE_STATUS(
+      TfLiteTypeSizeOf(eval_tensor->type, &type_size, /*reporter=*/nullptr));
+  *out_bytes = element_count * type_size;
+  return kTfLiteOk;
+}
+
 }  // namespace tflite
@@ -33,7 +33,7 @@ uint8_t* AlignPointerDown(uint8_t* data, size_t alignment);
 // Returns an increased size that's a multiple of alignment.
 size_t AlignSizeUp(size_t size, size_t alignment);
 
-// Returns size in bytes for a given TfLiteType.
+// Returns size in bytes for a given TfLiteType. `reporter` may be nullptr.
 TfLiteStatus TfLiteTypeSizeOf(TfLiteType type, size_t* size,
                               ErrorReporter* reporter);
 
@@ -42,6 +42,10 @@ TfLiteStatus BytesRequiredForTensor(const tflite::Tensor& flatbuffer_tensor,
                                     size_t* bytes, size_t* type_size,
                                     ErrorReporter* error_reporter);
 
+// How many bytes the data of an eval tensor takes, from its dims and type.
+TfLiteStatus TfLiteEvalTensorByteLength(const TfLiteEvalTensor* eval_tensor,
+                                        size_t* out_bytes);
+
 }  // namespace tflite
 
 #endif  // TENSORFLOW_LITE_MICRO_MEMORY_HELPERS_H_
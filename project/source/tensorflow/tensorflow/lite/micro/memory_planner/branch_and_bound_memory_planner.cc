@@ -0,0 +1,285 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/memory_planner/branch_and_bound_memory_planner.h"
+
+#include <climits>
+
+namespace tflite {
+
+// Defined in greedy_memory_planner.cc.
+void ReverseSortInPlace(int* values, int* ids, int size);
+
+BranchAndBoundMemoryPlanner::BranchAndBoundMemoryPlanner(
+    unsigned char* scratch_buffer, int scratch_buffer_size,
+    int max_search_steps)
+    : buffer_count_(0),
+      max_search_steps_(max_search_steps),
+      best_size_(0),
+      lower_bound_(0),
+      search_steps_(0),
+      search_truncated_(false),
+      need_to_calculate_offsets_(true) {
+  // Allocate the arrays we need within the scratch buffer arena.
+  max_buffer_count_ = scratch_buffer_size / per_buffer_size();
+
+  unsigned char* next_free = scratch_buffer;
+  requirements_ = reinterpret_cast<BufferRequirements*>(next_free);
+  next_free += sizeof(BufferRequirements) * max_buffer_count_;
+
+  buffer_sizes_sorted_by_size_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  buffer_ids_sorted_by_size_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  offsets_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  best_offsets_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  high_water_marks_ = reinterpret_cast<int*>(next_free);
+  next_free += sizeof(int) * max_buffer_count_;
+
+  candidates_ = reinterpret_cast<int*>(next_free);
+}
+
+BranchAndBoundMemoryPlanner::~BranchAndBoundMemoryPlanner() {
+  // We don't own the scratch buffer, so don't deallocate anything.
+}
+
+TfLiteStatus BranchAndBoundMemoryPlanner::AddBuffer(
+    tflite::ErrorReporter* error_reporter, int size, int first_time_used,
+    int last_time_used) {
+  return AddBuffer(error_reporter, size, first_time_used, last_time_used,
+                   kOnlinePlannedBuffer);
+}
+
+TfLiteStatus BranchAndBoundMemoryPlanner::AddBuffer(
+    tflite::ErrorReporter* error_reporter, int size, int first_time_used,
+    int last_time_used, int offline_offset) {
+  if (buffer_count_ >= max_buffer_count_) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Too many buffers (max is %d)",
+                         max_buffer_count_);
+    return kTfLiteError;
+  }
+  BufferRequirements* current = &requirements_[buffer_count_];
+  current->size = size;
+  current->first_time_used = first_time_used;
+  current->last_time_used = last_time_used;
+  current->offline_offset = offline_offset;
+  ++buffer_count_;
+  need_to_calculate_offsets_ = true;
+  return kTfLiteOk;
+}
+
+bool BranchAndBoundMemoryPlanner::DoBuffersOverlapInTime(int a, int b) const {
+  return requirements_[a].first_time_used <= requirements_[b].last_time_used &&
+         requirements_[b].first_time_used <= requirements_[a].last_time_used;
+}
+
+int BranchAndBoundMemoryPlanner::NextCandidateOffset(int buffer_id, int after,
+                                                     int limit) const {
+  const int size = requirements_[buffer_id].size;
+  int result = -1;
+  // Candidates are offset zero and the end of every placed buffer that is
+  // active at the same time. Only the lowest one that fits is kept.
+  for (int i = -1; i < buffer_count_; ++i) {
+    int candidate = 0;
+    if (i >= 0) {
+      if (offsets_[i] == -1 || !DoBuffersOverlapInTime(i, buffer_id)) {
+        continue;
+      }
+      candidate = offsets_[i] + requirements_[i].size;
+    }
+    if (candidate <= after || candidate >= limit - size ||
+        (result != -1 && candidate >= result)) {
+      continue;
+    }
+    bool fits = true;
+    for (int j = 0; j < buffer_count_; ++j) {
+      if (offsets_[j] == -1 || j == buffer_id ||
+          !DoBuffersOverlapInTime(j, buffer_id)) {
+        continue;
+      }
+      if (candidate < offsets_[j] + requirements_[j].size &&
+          offsets_[j] < candidate + size) {
+        fits = false;
+        break;
+      }
+    }
+    if (fits) {
+      result = candidate;
+    }
+  }
+  return result;
+}
+
+void BranchAndBoundMemoryPlanner::CalculateOffsetsIfNeeded() {
+  if (!need_to_calculate_offsets_ || (buffer_count_ == 0)) {
+    return;
+  }
+  need_to_calculate_offsets_ = false;
+
+  // Same order as GreedyMemoryPlanner: offline buffers first, in the order
+  // they were added, then the others by descending size.
+  int offline_buffer_count = 0;
+  int offline_high_water_mark = 0;
+  for (int i = 0; i < buffer_count_; ++i) {
+    offsets_[i] = -1;
+    const BufferRequirements& requirements = requirements_[i];
+    if (requirements.offline_offset != kOnlinePlannedBuffer) {
+      buffer_sizes_sorted_by_size_[offline_buffer_count] = requirements.size;
+      buffer_ids_sorted_by_size_[offline_buffer_count] = i;
+      ++offline_buffer_count;
+      offsets_[i] = requirements.offline_offset;
+      const int end = requirements.offline_offset + requirements.size;
+      if (end > offline_high_water_mark) {
+        offline_high_water_mark = end;
+      }
+    }
+  }
+  int online_index = offline_buffer_count;
+  for (int i = 0; i < buffer_count_; ++i) {
+    if (requirements_[i].offline_offset == kOnlinePlannedBuffer) {
+      buffer_sizes_sorted_by_size_[online_index] = requirements_[i].size;
+      buffer_ids_sorted_by_size_[online_index] = i;
+      ++online_index;
+    }
+  }
+  ReverseSortInPlace(&buffer_sizes_sorted_by_size_[offline_buffer_count],
+                     &buffer_ids_sorted_by_size_[offline_buffer_count],
+                     buffer_count_ - offline_buffer_count);
+
+  // The memory in use is highest at the time some buffer is first used, so
+  // only those times need to be checked for the lower bound.
+  lower_bound_ = offline_high_water_mark;
+  for (int i = 0; i < buffer_count_; ++i) {
+    const int time = requirements_[i].first_time_used;
+    int live_bytes = 0;
+    for (int j = 0; j < buffer_count_; ++j) {
+      if (requirements_[j].first_time_used <= time &&
+          time <= requirements_[j].last_time_used) {
+        live_bytes += requirements_[j].size;
+      }
+    }
+    if (live_bytes > lower_bound_) {
+      lower_bound_ = live_bytes;
+    }
+  }
+
+  search_steps_ = 0;
+  search_truncated_ = false;
+  const int online_buffer_count = buffer_count_ - offline_buffer_count;
+  if (online_buffer_count == 0) {
+    best_size_ = offline_high_water_mark;
+    for (int i = 0; i < buffer_count_; ++i) {
+      best_offsets_[i] = offsets_[i];
+    }
+    return;
+  }
+
+  // Depth-first search over the online buffers. candidates_[depth] holds the
+  // offset last tried for the buffer at that depth, so the search resumes
+  // from the next higher one after backtracking. The step limit only applies
+  // once a first, greedy, plan exists.
+  best_size_ = INT_MAX;
+  int depth = 0;
+  candidates_[0] = -1;
+  while (depth >= 0) {
+    const int buffer_id = buffer_ids_sorted_by_size_[offline_buffer_count +
+                                                     depth];
+    const int prior_high_water_mark =
+        depth == 0 ? offline_high_water_mark : high_water_marks_[depth - 1];
+    int offset = -1;
+    if (prior_high_water_mark < best_size_) {
+      if (best_size_ != INT_MAX && search_steps_ >= max_search_steps_) {
+        search_truncated_ = true;
+        break;
+      }
+      offset = NextCandidateOffset(buffer_id, candidates_[depth], best_size_);
+    }
+    if (offset == -1) {
+      // Nothing better below this depth, so backtrack.
+      offsets_[buffer_id] = -1;
+      --depth;
+      continue;
+    }
+    ++search_steps_;
+    candidates_[depth] = offset;
+    offsets_[buffer_id] = offset;
+    const int end = offset + requirements_[buffer_id].size;
+    high_water_marks_[depth] =
+        end > prior_high_water_mark ? end : prior_high_water_mark;
+
+    if (depth < online_buffer_count - 1) {
+      ++depth;
+      candidates_[depth] = -1;
+      continue;
+    }
+    // Every buffer is placed, and the plan is better than the last one.
+    best_size_ = high_water_marks_[depth];
+    for (int i = 0; i < buffer_count_; ++i) {
+      best_offsets_[i] = offsets_[i];
+    }
+    if (best_size_ <= lower_bound_) {
+      break;
+    }
+  }
+}
+
+size_t BranchAndBoundMemoryPlanner::GetMaximumMemorySize() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return best_size_;
+}
+
+size_t BranchAndBoundMemoryPlanner::GetLowerBound() {
+  CalculateOffsetsIfNeeded();
+  if (buffer_count_ == 0) {
+    return 0;
+  }
+  return lower_bound_;
+}
+
+int BranchAndBoundMemoryPlanner::search_steps() {
+  CalculateOffsetsIfNeeded();
+  return search_steps_;
+}
+
+bool BranchAndBoundMemoryPlanner::search_truncated() {
+  CalculateOffsetsIfNeeded();
+  return search_truncated_;
+}
+
+int BranchAndBoundMemoryPlanner::GetBufferCount() { return buffer_count_; }
+
+TfLiteStatus BranchAndBoundMemoryPlanner::GetOffsetForBuffer(
+    tflite::ErrorReporter* error_reporter, int buffer_index, int* offset) {
+  CalculateOffsetsIfNeeded();
+  if ((buffer_index < 0) || (buffer_index >= buffer_count_)) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "buffer index %d is outside range 0 to %d",
+                         buffer_index, buffer_count_);
+    return kTfLiteError;
+  }
+  *offset = best_offsets_[buffer_index];
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
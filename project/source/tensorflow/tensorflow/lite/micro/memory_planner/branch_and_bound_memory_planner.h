@@ -0,0 +1,133 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#ifndef TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BRANCH_AND_BOUND_MEMORY_PLANNER_H_
+#define TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BRANCH_AND_BOUND_MEMORY_PLANNER_H_
+
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/memory_planner/memory_planner.h"
+
+namespace tflite {
+
+// A memory planner that searches for a smaller arena than GreedyMemoryPlanner
+// with a bounded depth-first branch-and-bound.
+//
+// Buffers are placed in the same order as in GreedyMemoryPlanner: offline
+// planned buffers at their fixed offsets first, then the others by descending
+// size. Every buffer may go at offset zero or right after any placed buffer
+// that is active at the same time, as long as it does not overlap one of
+// them. The search tries these offsets from the lowest up, so its first
+// complete plan is exactly the greedy one, and then backtracks to look for
+// plans with a lower high-water mark:
+//  - A branch is cut as soon as its high-water mark reaches the best plan.
+//  - The search stops when the best plan reaches the lower bound, the
+//    largest sum of sizes of the buffers active at one time, which no plan
+//    can beat.
+//  - Otherwise it stops after `max_search_steps` placements.
+//
+// The result is never worse than the greedy plan, and is optimal for the
+// placement order whenever the search completes. Each step costs O(N^2) in
+// the number of buffers, so on the device the step limit bounds the time
+// spent in AllocateTensors(). To keep the search out of boot altogether, plan
+// the model on the host with micro/tools/offline_memory_plan.cc.
+class BranchAndBoundMemoryPlanner : public MemoryPlanner {
+ public:
+  static constexpr int kOnlinePlannedBuffer = -1;
+  static constexpr int kDefaultMaxSearchSteps = 20000;
+
+  // As with GreedyMemoryPlanner, the arrays used for planning live in
+  // `scratch_buffer`, which must outlive the planner. Each buffer requires
+  // about 40 bytes of scratch.
+  BranchAndBoundMemoryPlanner(unsigned char* scratch_buffer,
+                              int scratch_buffer_size,
+                              int max_search_steps = kDefaultMaxSearchSteps);
+  ~BranchAndBoundMemoryPlanner() override;
+
+  TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
+                         int first_time_used, int last_time_used) override;
+  TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
+                         int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
+  size_t GetMaximumMemorySize() override;
+  int GetBufferCount() override;
+  TfLiteStatus GetOffsetForBuffer(ErrorReporter* error_reporter,
+                                  int buffer_index, int* offset) override;
+
+  // The lower bound described above. No plan can use less memory.
+  size_t GetLowerBound();
+
+  // Number of placements tried by the last search, and whether it stopped
+  // because of the step limit rather than finishing or reaching the bound.
+  int search_steps();
+  bool search_truncated();
+
+  // Number of bytes required in order to plan a buffer.
+  static size_t per_buffer_size() {
+    const int per_buffer_size = sizeof(BufferRequirements) +  // requirements_
+                                sizeof(int) +  // buffer_sizes_sorted_by_size_
+                                sizeof(int) +  // buffer_ids_sorted_by_size_
+                                sizeof(int) +  // offsets_
+                                sizeof(int) +  // best_offsets_
+                                sizeof(int) +  // high_water_marks_
+                                sizeof(int);   // candidates_
+    return per_buffer_size;
+  }
+
+ private:
+  struct BufferRequirements {
+    int size;
+    int first_time_used;
+    int last_time_used;
+    int offline_offset;
+  };
+
+  bool DoBuffersOverlapInTime(int a, int b) const;
+
+  // Returns the lowest offset above `after` at which `buffer_id` fits between
+  // the placed buffers, or -1 if there is none below `limit` - size.
+  int NextCandidateOffset(int buffer_id, int after, int limit) const;
+
+  // If there isn't an up to date plan, calculate a new one.
+  void CalculateOffsetsIfNeeded();
+
+  int max_buffer_count_;
+  int buffer_count_;
+  int max_search_steps_;
+
+  BufferRequirements* requirements_;
+  int* buffer_sizes_sorted_by_size_;
+  int* buffer_ids_sorted_by_size_;
+  // Offsets of the buffers placed so far in the search, -1 if not placed.
+  int* offsets_;
+  // The best plan found.
+  int* best_offsets_;
+  // High-water mark of the partial plan after each search depth.
+  int* high_water_marks_;
+  // Offset tried last at each search depth.
+  int* candidates_;
+
+  int best_size_;
+  int lower_bound_;
+  int search_steps_;
+  bool search_truncated_;
+  bool need_to_calculate_offsets_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MEMORY_PLANNER_BRANCH_AND_BOUND_MEMORY_PLANNER_H_
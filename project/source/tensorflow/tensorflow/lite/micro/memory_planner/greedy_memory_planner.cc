@@ -40,7 +40,9 @@ void ReverseSortInPlace(int* values, int* ids, int size) {
 
 GreedyMemoryPlanner::GreedyMemoryPlanner(unsigned char* scratch_buffer,
                                          int scratch_buffer_size)
-    : buffer_count_(0), need_to_calculate_offsets_(true) {
+    : buffer_count_(0),
+      first_entry_index_(-1),
+      need_to_calculate_offsets_(true) {
   // Allocate the arrays we need within the scratch buffer arena.
   max_buffer_count_ = scratch_buffer_size / per_buffer_size();
 
@@ -67,6 +69,13 @@ GreedyMemoryPlanner::~GreedyMemoryPlanner() {
 TfLiteStatus GreedyMemoryPlanner::AddBuffer(
     tflite::ErrorReporter* error_reporter, int size, int first_time_used,
     int last_time_used) {
+  return AddBuffer(error_reporter, size, first_time_used, last_time_used,
+                   kOnlinePlannedBuffer);
+}
+
+TfLiteStatus GreedyMemoryPlanner::AddBuffer(
+    tflite::ErrorReporter* error_reporter, int size, int first_time_used,
+    int last_time_used, int offline_offset) {
   if (buffer_count_ >= max_buffer_count_) {
     TF_LITE_REPORT_ERROR(error_reporter, "Too many buffers (max is %d)",
                          max_buffer_count_);
@@ -76,6 +85,7 @@ TfLiteStatus GreedyMemoryPlanner::AddBuffer(
   current->size = size;
   current->first_time_used = first_time_used;
   current->last_time_used = last_time_used;
+  current->offline_offset = offline_offset;
   ++buffer_count_;
   need_to_calculate_offsets_ = true;
   return kTfLiteOk;
@@ -102,7 +112,10 @@ GreedyMemoryPlanner::NextSimultaneouslyActiveBuffer(
   ListEntry* result = nullptr;
   ListEntry* candidate_next_entry;
   if (start == nullptr) {
-    candidate_next_entry = &buffers_sorted_by_offset_[0];
+    if (first_entry_index_ == -1) {
+      return nullptr;
+    }
+    candidate_next_entry = &buffers_sorted_by_offset_[first_entry_index_];
   } else {
     if (start->next_entry_index == -1) {
       return nullptr;
@@ -124,37 +137,88 @@ GreedyMemoryPlanner::NextSimultaneouslyActiveBuffer(
   return result;
 }
 
+void GreedyMemoryPlanner::InsertEntry(int buffer_id, int offset) {
+  ListEntry* new_entry = &buffers_sorted_by_offset_[next_free_entry_];
+  new_entry->offset = offset;
+  new_entry->requirements_index = buffer_id;
+  const int new_entry_index = next_free_entry_;
+  ++next_free_entry_;
+  if (first_entry_index_ == -1 ||
+      buffers_sorted_by_offset_[first_entry_index_].offset > offset) {
+    // The list is empty, or the new entry comes before all others.
+    new_entry->next_entry_index = first_entry_index_;
+    first_entry_index_ = new_entry_index;
+    return;
+  }
+  ListEntry* current_entry = &buffers_sorted_by_offset_[first_entry_index_];
+  // Make sure that we insert the buffer at the correct place in the ordered
+  // list.
+  while (true) {
+    const int next_entry_index = current_entry->next_entry_index;
+    if (next_entry_index == -1) {
+      // We're at the end of the list, so just add the new entry here.
+      current_entry->next_entry_index = new_entry_index;
+      new_entry->next_entry_index = -1;
+      break;
+    }
+    ListEntry* next_entry = &buffers_sorted_by_offset_[next_entry_index];
+    if (next_entry->offset > offset) {
+      // We're at the right spot to do an insertion and retain the sorting
+      // order, so place the new entry here.
+      new_entry->next_entry_index = current_entry->next_entry_index;
+      current_entry->next_entry_index = new_entry_index;
+      break;
+    }
+    current_entry = next_entry;
+  }
+}
+
 void GreedyMemoryPlanner::CalculateOffsetsIfNeeded() {
   if (!need_to_calculate_offsets_ || (buffer_count_ == 0)) {
     return;
   }
   need_to_calculate_offsets_ = false;
 
-  // Start off by ordering the buffers in descending order of size.
-  // This helps find a more compact layout. Intuitively, you can think
-  // about putting the large buffers in place first, and then the
-  // smaller buffers can fit in the gaps, rather than fragmenting the
-  // gaps with small buffers at the beginning.
+  // Buffers with an offline offset go first, in the order they were added.
+  // The others are ordered by descending size, which helps find a more
+  // compact layout. Intuitively, you can think about putting the large buffers
+  // in place first, and then the smaller buffers can fit in the gaps, rather
+  // than fragmenting the gaps with small buffers at the beginning.
+  int offline_buffer_count = 0;
   for (int i = 0; i < buffer_count_; ++i) {
-    buffer_sizes_sorted_by_size_[i] = requirements_[i].size;
-    buffer_ids_sorted_by_size_[i] = i;
+    if (requirements_[i].offline_offset != kOnlinePlannedBuffer) {
+      buffer_sizes_sorted_by_size_[offline_buffer_count] =
+          requirements_[i].size;
+      buffer_ids_sorted_by_size_[offline_buffer_count] = i;
+      ++offline_buffer_count;
+    }
     buffer_offsets_[i] = -1;
   }
+  int online_index = offline_buffer_count;
+  for (int i = 0; i < buffer_count_; ++i) {
+    if (requirements_[i].offline_offset == kOnlinePlannedBuffer) {
+      buffer_sizes_sorted_by_size_[online_index] = requirements_[i].size;
+      buffer_ids_sorted_by_size_[online_index] = i;
+      ++online_index;
+    }
+  }
   // This sorting algorithm is naive, and may end up taking a very long time
   // with hundreds of buffers.
-  ReverseSortInPlace(buffer_sizes_sorted_by_size_, buffer_ids_sorted_by_size_,
-                     buffer_count_);
+  ReverseSortInPlace(&buffer_sizes_sorted_by_size_[offline_buffer_count],
+                     &buffer_ids_sorted_by_size_[offline_buffer_count],
+                     buffer_count_ - offline_buffer_count);
 
-  // Put the largest buffer at offset zero to start the process.
-  ListEntry* first_entry = &buffers_sorted_by_offset_[0];
-  first_entry->offset = 0;
-  first_entry->requirements_index = buffer_ids_sorted_by_size_[0];
-  first_entry->next_entry_index = -1;
-  next_free_entry_ = 1;
-  buffer_offsets_[buffer_ids_sorted_by_size_[0]] = 0;
+  first_entry_index_ = -1;
+  next_free_entry_ = 0;
+  for (int i = 0; i < offline_buffer_count; ++i) {
+    const int buffer_id = buffer_ids_sorted_by_size_[i];
+    buffer_offsets_[buffer_id] = requirements_[buffer_id].offline_offset;
+    InsertEntry(buffer_id, buffer_offsets_[buffer_id]);
+  }
 
   // Work through the rest of the buffers to find a good gap to place each one.
-  for (int i = 1; i < buffer_count_; ++i) {
+  // Without offline buffers, the first and largest one ends up at offset zero.
+  for (int i = offline_buffer_count; i < buffer_count_; ++i) {
     // The id is the order the buffer was originally added by the client.
     const int buffer_id = buffer_ids_sorted_by_size_[i];
     // Look at what size and time range the buffer needs to be active.
@@ -207,32 +271,7 @@ void GreedyMemoryPlanner::CalculateOffsetsIfNeeded() {
     buffer_offsets_[buffer_id] = candidate_offset;
     // Add the newly-placed buffer to our offset-ordered list, so that
     // subsequent passes can fit in their buffers around it.
-    ListEntry* new_entry = &buffers_sorted_by_offset_[next_free_entry_];
-    new_entry->offset = candidate_offset;
-    new_entry->requirements_index = buffer_id;
-    const int new_entry_index = next_free_entry_;
-    ++next_free_entry_;
-    ListEntry* current_entry = first_entry;
-    // Make sure that we insert the buffer at the correct place in the ordered
-    // list.
-    while (true) {
-      const int next_entry_index = current_entry->next_entry_index;
-      if (next_entry_index == -1) {
-        // We're at the end of the list, so just add the new entry here.
-        current_entry->next_entry_index = new_entry_index;
-        new_entry->next_entry_index = -1;
-        break;
-      }
-      ListEntry* next_entry = &buffers_sorted_by_offset_[next_entry_index];
-      if (next_entry->offset > candidate_offset) {
-        // We're at the right spot to do an insertion and retain the sorting
-        // order, so place the new entry here.
-        new_entry->next_entry_index = current_entry->next_entry_index;
-        current_entry->next_entry_index = new_entry_index;
-        break;
-      }
-      current_entry = next_entry;
-    }
+    InsertEntry(buffer_id, candidate_offset);
   }
 }
 
@@ -241,7 +280,7 @@ size_t GreedyMemoryPlanner::GetMaximumMemorySize() {
   if (buffer_count_ == 0) {
     return 0;
   }
-  ListEntry* entry = &buffers_sorted_by_offset_[0];
+  ListEntry* entry = &buffers_sorted_by_offset_[first_entry_index_];
   size_t max_size = 0;
   while (entry) {
     BufferRequirements* requirements =
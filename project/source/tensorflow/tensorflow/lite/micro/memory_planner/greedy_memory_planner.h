@@ -39,10 +39,15 @@ namespace tflite {
 //    last buffer that's simultaneously active.
 //  - This continues until all buffers are placed, and the offsets stored.
 //
+// Buffers added with an offline offset are placed at that offset before any
+// other buffer, and the rest are fitted into the gaps around them.
+//
 // This is not guaranteed to produce the best placement, since that's an
 // NP-Complete problem, but in practice it should produce one that's decent.
 class GreedyMemoryPlanner : public MemoryPlanner {
  public:
+  static constexpr int kOnlinePlannedBuffer = -1;
+
   // You need to pass in an area of memory to be used for planning. This memory
   // needs to have a lifetime as long as the planner, but isn't owned by this
   // object, so management should be handled by the client. This is so it can be
@@ -51,7 +56,7 @@ class GreedyMemoryPlanner : public MemoryPlanner {
   // this scratch memory, so you should enlarge it if you see an error when
   // calling AddBuffer(). The memory can be reused once you're done with the
   // planner, as long as you copy the calculated offsets to another location.
-  // Each buffer requires about 36 bytes of scratch.
+  // Each buffer requires about 40 bytes of scratch.
   GreedyMemoryPlanner(unsigned char* scratch_buffer, int scratch_buffer_size);
   ~GreedyMemoryPlanner() override;
 
@@ -59,6 +64,11 @@ class GreedyMemoryPlanner : public MemoryPlanner {
   TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
                          int first_time_used, int last_time_used) override;
 
+  // Record details of a buffer that must be placed at `offline_offset`.
+  TfLiteStatus AddBuffer(ErrorReporter* error_reporter, int size,
+                         int first_time_used, int last_time_used,
+                         int offline_offset) override;
+
   // Returns the high-water mark of used memory. This is the minimum size of a
   // memory arena you'd need to allocate to hold these buffers.
   size_t GetMaximumMemorySize() override;
@@ -108,6 +118,9 @@ class GreedyMemoryPlanner : public MemoryPlanner {
                                             const int first_time_used,
                                             const int last_time_used);
 
+  // Adds a placed buffer to the offset-ordered list.
+  void InsertEntry(int buffer_id, int offset);
+
   // If there isn't an up to date plan, calculate a new one.
   void CalculateOffsetsIfNeeded();
 
@@ -123,6 +136,8 @@ class GreedyMemoryPlanner : public MemoryPlanner {
     int size;
     int first_time_used;
     int last_time_used;
+    // Offset fixed by an offline plan, or kOnlinePlannedBuffer.
+    int offline_offset;
   };
 
   // Working arrays used during the layout algorithm.
@@ -131,6 +146,8 @@ class GreedyMemoryPlanner : public MemoryPlanner {
   int* buffer_ids_sorted_by_size_;
   ListEntry* buffers_sorted_by_offset_;
   int next_free_entry_;
+  // Head of the list in buffers_sorted_by_offset_, -1 while it is empty.
+  int first_entry_index_;
 
   // Stores the outcome of the plan, the location of each buffer in the arena.
   int* buffer_offsets_;
@@ -28,6 +28,8 @@ class LinearMemoryPlanner : public MemoryPlanner {
   LinearMemoryPlanner();
   ~LinearMemoryPlanner() override;
 
+  using MemoryPlanner::AddBuffer;
+
   TfLiteStatus AddBuffer(tflite::ErrorReporter* error_reporter, int size,
                          int first_time_used, int last_time_used) override;
 
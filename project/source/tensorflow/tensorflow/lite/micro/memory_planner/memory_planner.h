@@ -57,6 +57,17 @@ class MemoryPlanner {
                                  int size, int first_time_used,
                                  int last_time_used) = 0;
 
+  // Same as above for a buffer whose offset was fixed ahead of time, e.g. by
+  // an offline memory plan stored in the model. Planners that support this
+  // place the other buffers around it.
+  virtual TfLiteStatus AddBuffer(tflite::ErrorReporter* error_reporter,
+                                 int size, int first_time_used,
+                                 int last_time_used, int offline_offset) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Planner does not support offline offsets");
+    return kTfLiteError;
+  }
+
   // The largest contiguous block of memory that's needed to hold the layout.
   virtual size_t GetMaximumMemorySize() = 0;
   // How many buffers have been added to the planner.
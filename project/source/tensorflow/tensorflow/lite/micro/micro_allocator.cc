@@ -17,6 +17,7 @@ limitations under the License.
 
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/c/common.h"
@@ -26,10 +27,14 @@ limitations under the License.
 #include "tensorflow/lite/core/api/tensor_utils.h"
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/kernels/conv_pool.h"
+#include "tensorflow/lite/micro/kernels/palettized.h"
 #include "tensorflow/lite/micro/memory_helpers.h"
+#include "tensorflow/lite/micro/memory_planner/branch_and_bound_memory_planner.h"
 #include "tensorflow/lite/micro/memory_planner/greedy_memory_planner.h"
 #include "tensorflow/lite/micro/memory_planner/memory_planner.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/micro/micro_utils.h"
 #include "tensorflow/lite/micro/simple_memory_allocator.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
@@ -43,12 +48,32 @@ struct AllocationInfo {
   int last_used;
   bool needs_allocating;
   void** output_ptr;
+  // Offset from an offline memory plan, or -1 if the buffer is planned online.
+  int offline_offset;
+  // Index of the tensor whose buffer this one shares, or -1.
+  int alias_of;
 };
 
 // We align tensor buffers to 16-byte boundaries, since this is a common
 // requirement for SIMD extensions.
 constexpr int kBufferAlignment = 16;
 
+#ifdef MICRO_RUNTIME
+// The DynamicAgent works on the TfLiteTensors of the context at invoke time,
+// so they are kept for the lifetime of the model. The interpreter copies the
+// data pointers the agent sets to the TfLiteEvalTensors around every node.
+constexpr bool kKeepTfLiteTensors = true;
+#else
+constexpr bool kKeepTfLiteTensors = false;
+#endif
+
+// Name of the model metadata that holds an offline memory plan. Its buffer is
+// an int32 array: [version, subgraph index, tensor count, offset of tensor 0,
+// ..., offset of tensor n-1], where -1 leaves a tensor to the online planner.
+constexpr char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
+constexpr int kOfflineMemAllocVersion = 1;
+constexpr int kOfflineMemAllocHeaderSize = 3;
+
 // Instance of a zero-length int to pass as tensor dims for a flatbuffer
 // Tensor with no shape. Note that the second member of a TfLiteArray is a
 // flexible array member, which is not strictly valid C++. However it is
@@ -58,6 +83,236 @@ constexpr int kBufferAlignment = 16;
 // the flexible array element to be initialized.
 const TfLiteIntArray kZeroLengthIntArray = {0};
 
+uint8_t* Allocate(SimpleMemoryAllocator* allocator, bool allocate_temp,
+                  size_t size, size_t alignment) {
+  return allocate_temp ? allocator->AllocateTemp(size, alignment)
+                       : allocator->AllocateFromTail(size, alignment);
+}
+
+// Returns the serialized data of a tensor, or null if its contents are
+// allocated at runtime.
+void* GetFlatbufferTensorData(
+    const tflite::Tensor& flatbuffer_tensor,
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers) {
+  // We need to figure out where the actual contents of this tensor are stored
+  // in memory. We'll check to see if there's a serialized buffer (pretty much
+  // the same as a constant op in TensorFlow) associated with this tensor first,
+  // and if there is update the runtime structure to point to its location in
+  // memory.
+  // First see if there's any buffer information in the serialized tensor.
+  // TODO(petewarden): It's not clear in what circumstances we could have a
+  // buffer in the serialized tensor, but it doesn't have any data in it. Is
+  // that a validly-generated file, and if so what does it mean, or is it an
+  // error condition? It would be good to tighten up the specification to make
+  // it less ambiguous.
+  if (auto* buffer = (*buffers)[flatbuffer_tensor.buffer()]) {
+    // If we've found a buffer, does it have any data?
+    if (auto* array = buffer->data()) {
+      // If it has any data, is the data size larger than zero?
+      if (array->size()) {
+        // We've found a buffer with valid data.
+        return const_cast<void*>(static_cast<const void*>(array->data()));
+      }
+    }
+  }
+  return nullptr;
+}
+
+// Ops whose output has the same bytes as their first input, in a different
+// shape. Their output can share the buffer of the input, which makes them
+// no-ops at invoke time.
+bool IsShapeOnlyOp(BuiltinOperator builtin_code) {
+  return builtin_code == BuiltinOperator_RESHAPE ||
+         builtin_code == BuiltinOperator_EXPAND_DIMS ||
+         builtin_code == BuiltinOperator_SQUEEZE;
+}
+
+BuiltinOperator GetBuiltinCode(const Model* model, const Operator* op) {
+  return model->operator_codes()->Get(op->opcode_index())->builtin_code();
+}
+
+// Kernel of the nodes that were merged into a neighbouring node. Without init,
+// prepare and invoke functions, the interpreter passes over them.
+const TfLiteRegistration kFusedNodeRegistration = {
+    /*init=*/nullptr,
+    /*free=*/nullptr,
+    /*prepare=*/nullptr,
+    /*invoke=*/nullptr,
+    /*profiling_string=*/nullptr,
+    /*builtin_code=*/BuiltinOperator_CUSTOM,
+    /*custom_name=*/"FUSED",
+    /*version=*/0};
+
+// Kernel of the nodes that SimplifyGraph() removed because their output holds
+// the same bytes as their first input, which AddAliases() lets them share.
+const TfLiteRegistration kForwardingNodeRegistration = {
+    /*init=*/nullptr,
+    /*free=*/nullptr,
+    /*prepare=*/nullptr,
+    /*invoke=*/nullptr,
+    /*profiling_string=*/nullptr,
+    /*builtin_code=*/BuiltinOperator_CUSTOM,
+    /*custom_name=*/"FORWARD",
+    /*version=*/0};
+
+// Kernel of the nodes that FoldConstantNodes() evaluated at load time. Their
+// outputs stay in persistent buffers.
+const TfLiteRegistration kFoldedNodeRegistration = {
+    /*init=*/nullptr,
+    /*free=*/nullptr,
+    /*prepare=*/nullptr,
+    /*invoke=*/nullptr,
+    /*profiling_string=*/nullptr,
+    /*builtin_code=*/BuiltinOperator_CUSTOM,
+    /*custom_name=*/"FOLDED",
+    /*version=*/0};
+
+bool IsGraphOutput(const SubGraph* subgraph, int tensor_index) {
+  for (size_t i = 0; i < subgraph->outputs()->size(); ++i) {
+    if (subgraph->outputs()->Get(i) == tensor_index) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Returns the index of the only operator that reads tensor `tensor_index`, or
+// -1 if it is read by none or several operators, or is a graph output.
+int GetSingleConsumer(const SubGraph* subgraph, int tensor_index) {
+  if (IsGraphOutput(subgraph, tensor_index)) {
+    return -1;
+  }
+  int consumer = -1;
+  for (size_t i = 0; i < subgraph->operators()->size(); ++i) {
+    const auto* inputs = subgraph->operators()->Get(i)->inputs();
+    for (size_t n = 0; n < inputs->size(); ++n) {
+      if (inputs->Get(n) != tensor_index) {
+        continue;
+      }
+      if (consumer != -1 && consumer != static_cast<int>(i)) {
+        return -1;
+      }
+      consumer = i;
+    }
+  }
+  return consumer;
+}
+
+// Whether tensor `tensor_index` can live inside a fused node: a float32, int8
+// or int16 activation that is neither a weight nor a variable.
+bool IsFusableActivation(const SubGraph* subgraph,
+                         const flatbuffers::Vector<flatbuffers::Offset<Buffer>>*
+                             buffers,
+                         int tensor_index) {
+  const Tensor* tensor = subgraph->tensors()->Get(tensor_index);
+  if (tensor->is_variable() ||
+      GetFlatbufferTensorData(*tensor, buffers) != nullptr) {
+    return false;
+  }
+  return tensor->type() == TensorType_FLOAT32 ||
+         tensor->type() == TensorType_INT8 ||
+         tensor->type() == TensorType_INT16;
+}
+
+// Returns the index of the operator that writes tensor `tensor_index`, or -1
+// if the tensor is a graph input, a weight or a variable.
+int GetProducer(const SubGraph* subgraph, int tensor_index) {
+  for (size_t i = 0; i < subgraph->operators()->size(); ++i) {
+    const auto* outputs = subgraph->operators()->Get(i)->outputs();
+    for (size_t n = 0; n < outputs->size(); ++n) {
+      if (outputs->Get(n) == tensor_index) {
+        return i;
+      }
+    }
+  }
+  return -1;
+}
+
+// Returns the number of elements of `tensor`, or -1 if its shape is unknown.
+int GetElementCount(const Tensor* tensor) {
+  if (tensor->shape() == nullptr) {
+    return -1;
+  }
+  int element_count = 1;
+  for (size_t i = 0; i < tensor->shape()->size(); ++i) {
+    const int dim = tensor->shape()->Get(i);
+    if (dim <= 0) {
+      return -1;
+    }
+    element_count *= dim;
+  }
+  return element_count;
+}
+
+bool IsQuantized(const Tensor* tensor) {
+  return tensor->quantization() != nullptr &&
+         tensor->quantization()->scale() != nullptr &&
+         tensor->quantization()->scale()->size() > 0;
+}
+
+// Reads the scale and zero point of a tensor quantized per tensor, or returns
+// false if it is quantized per channel.
+bool GetPerTensorQuantization(const Tensor* tensor, float* scale,
+                              int64_t* zero_point) {
+  const QuantizationParameters* params = tensor->quantization();
+  if (params->scale()->size() != 1) {
+    return false;
+  }
+  *scale = params->scale()->Get(0);
+  *zero_point = params->zero_point() != nullptr &&
+                        params->zero_point()->size() == 1
+                    ? params->zero_point()->Get(0)
+                    : 0;
+  return true;
+}
+
+// Whether tensors `a` and `b` are both unquantized or share one per-tensor
+// scale and zero point.
+bool HasSameQuantization(const Tensor* a, const Tensor* b) {
+  if (!IsQuantized(a) || !IsQuantized(b)) {
+    return !IsQuantized(a) && !IsQuantized(b);
+  }
+  float a_scale, b_scale;
+  int64_t a_zero_point, b_zero_point;
+  return GetPerTensorQuantization(a, &a_scale, &a_zero_point) &&
+         GetPerTensorQuantization(b, &b_scale, &b_zero_point) &&
+         a_scale == b_scale && a_zero_point == b_zero_point;
+}
+
+// Whether the output `output_index` of a removed node can share the buffer of
+// `input_index` during the whole invocation.
+bool CanForward(const SubGraph* subgraph,
+                const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+                int input_index, int output_index) {
+  const Tensor* input = subgraph->tensors()->Get(input_index);
+  const Tensor* output = subgraph->tensors()->Get(output_index);
+  // Graph outputs may get caller-owned buffers.
+  return !input->is_variable() && !output->is_variable() &&
+         GetFlatbufferTensorData(*output, buffers) == nullptr &&
+         !IsGraphOutput(subgraph, output_index) &&
+         GetElementCount(input) == GetElementCount(output) &&
+         GetElementCount(input) != -1 && input->type() == output->type();
+}
+
+// Whether tensor `tensor_index` holds the same data in every invocation: a
+// weight, or an output of a node that FoldConstantNodes() evaluated, possibly
+// forwarded by removed nodes.
+bool IsConstantTensor(const Model* model, const SubGraph* subgraph,
+                      const NodeAndRegistration* node_and_registrations,
+                      const TfLiteEvalTensor* eval_tensors, int tensor_index) {
+  const int producer = GetProducer(subgraph, tensor_index);
+  if (producer == -1) {
+    const Tensor* tensor = subgraph->tensors()->Get(tensor_index);
+    return !tensor->is_variable() &&
+           GetFlatbufferTensorData(*tensor, model->buffers()) != nullptr;
+  }
+  const TfLiteRegistration* registration =
+      node_and_registrations[producer].registration;
+  return registration == &kFoldedNodeRegistration ||
+         (registration == &kForwardingNodeRegistration &&
+          eval_tensors[tensor_index].data.data != nullptr);
+}
+
 class MicroBuiltinDataAllocator : public BuiltinDataAllocator {
  public:
   explicit MicroBuiltinDataAllocator(SimpleMemoryAllocator* memory_allocator)
@@ -94,9 +349,21 @@ class AllocationInfoBuilder {
     return Allocate();
   }
 
-  // Add allocaiton information for the tensors.
+  // Add allocaiton information for the tensors. Their lifetimes follow the
+  // inputs and outputs of the nodes, which differ from the operators of the
+  // flatbuffer where nodes were fused. `offline_offsets` may be null if the
+  // model has no offline memory plan. The planned buffers are written to
+  // `eval_tensors`.
   TfLiteStatus AddTensors(const SubGraph* subgraph,
-                          TfLiteTensor* runtime_tensors);
+                          const NodeAndRegistration* node_and_registrations,
+                          const int32_t* offline_offsets,
+                          const TfLiteTensor* runtime_tensors,
+                          TfLiteEvalTensor* eval_tensors);
+  // Lets the outputs of shape-only ops and of the nodes removed by
+  // SimplifyGraph() share the buffer of their input. Must be called after
+  // AddTensors().
+  void AddAliases(const Model* model, const SubGraph* subgraph,
+                  const NodeAndRegistration* node_and_registrations);
   // Add allocation information for the scratch buffers.
   TfLiteStatus AddScratchBuffers(internal::ScratchBufferHandle* buffer_handles);
 
@@ -129,18 +396,23 @@ TfLiteStatus AllocationInfoBuilder::Allocate() {
   return kTfLiteOk;
 }
 
-TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
-                                               TfLiteTensor* runtime_tensors) {
+TfLiteStatus AllocationInfoBuilder::AddTensors(
+    const SubGraph* subgraph, const NodeAndRegistration* node_and_registrations,
+    const int32_t* offline_offsets, const TfLiteTensor* runtime_tensors,
+    TfLiteEvalTensor* eval_tensors) {
   // Set up allocation info for all tensors.
   for (size_t i = 0; i < tensor_count_; ++i) {
     AllocationInfo* current = &info_[i];
     // TfLiteTensor.uint8 field is deprecated so use .data field instead.
-    current->output_ptr = &(runtime_tensors[i].data.data);
+    current->output_ptr = &(eval_tensors[i].data.data);
     current->bytes = runtime_tensors[i].bytes;
     current->first_created = -1;
     current->last_used = -1;
-    current->needs_allocating = (runtime_tensors[i].data.data == nullptr) &&
+    current->needs_allocating = (eval_tensors[i].data.data == nullptr) &&
                                 (!subgraph->tensors()->Get(i)->is_variable());
+    current->offline_offset =
+        offline_offsets != nullptr ? offline_offsets[i] : -1;
+    current->alias_of = -1;
   }
 
   for (size_t i = 0; i < subgraph->inputs()->size(); ++i) {
@@ -158,16 +430,16 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
 
   // Figure out when the first and last use of each tensor is.
   for (int i = (subgraph->operators()->size() - 1); i >= 0; --i) {
-    const auto* op = subgraph->operators()->Get(i);
-    for (size_t n = 0; n < op->inputs()->size(); ++n) {
-      const int tensor_index = op->inputs()->Get(n);
+    const TfLiteNode& node = node_and_registrations[i].node;
+    for (int n = 0; n < node.inputs->size; ++n) {
+      const int tensor_index = node.inputs->data[n];
       AllocationInfo* current = &info_[tensor_index];
       if (((current->last_used == -1) || (current->last_used < i))) {
         current->last_used = i;
       }
     }
-    for (size_t n = 0; n < op->outputs()->size(); ++n) {
-      const int tensor_index = op->outputs()->Get(n);
+    for (int n = 0; n < node.outputs->size; ++n) {
+      const int tensor_index = node.outputs->data[n];
       AllocationInfo* current = &info_[tensor_index];
       if ((current->first_created == -1) || (current->first_created > i)) {
         current->first_created = i;
@@ -178,6 +450,10 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
   // Work out which tensors need to be allocated.
   for (size_t i = 0; i < tensor_count_; ++i) {
     AllocationInfo* current = &info_[i];
+    // No node touches the activations inside a fused node.
+    if ((current->first_created == -1) && (current->last_used == -1)) {
+      current->needs_allocating = false;
+    }
     const bool is_read_only =
         (current->first_created == -1) && (current->last_used != -1);
     if (is_read_only) {
@@ -198,6 +474,52 @@ TfLiteStatus AllocationInfoBuilder::AddTensors(const SubGraph* subgraph,
   return kTfLiteOk;
 }
 
+void AllocationInfoBuilder::AddAliases(
+    const Model* model, const SubGraph* subgraph,
+    const NodeAndRegistration* node_and_registrations) {
+  for (size_t i = 0; i < subgraph->operators()->size(); ++i) {
+    const TfLiteNode& node = node_and_registrations[i].node;
+    const bool is_forwarding = node_and_registrations[i].registration ==
+                               &kForwardingNodeRegistration;
+    const auto* op = subgraph->operators()->Get(i);
+    if ((!is_forwarding && !IsShapeOnlyOp(GetBuiltinCode(model, op))) ||
+        node.inputs->size < 1 || node.outputs->size != 1) {
+      continue;
+    }
+    const int input_index = node.inputs->data[0];
+    const int output_index = node.outputs->data[0];
+    if (input_index < 0) {
+      continue;
+    }
+    // Chains of shape-only ops all share the buffer of the first input.
+    const int root_index = info_[input_index].alias_of != -1
+                               ? info_[input_index].alias_of
+                               : input_index;
+    AllocationInfo* root = &info_[root_index];
+    AllocationInfo* output = &info_[output_index];
+    if (!output->needs_allocating || output->bytes != root->bytes) {
+      continue;
+    }
+    if (root->needs_allocating) {
+      // An offline plan either placed both tensors at the same offset, or did
+      // not expect the input to live longer.
+      if (root->offline_offset != output->offline_offset) {
+        continue;
+      }
+      if (output->last_used > root->last_used) {
+        root->last_used = output->last_used;
+      }
+    } else if (*root->output_ptr == nullptr ||
+               subgraph->tensors()->Get(root_index)->is_variable()) {
+      // Only buffers that do not change while the output is read can be
+      // shared: weights, and streaming caches that are already persistent.
+      continue;
+    }
+    output->needs_allocating = false;
+    output->alias_of = root_index;
+  }
+}
+
 TfLiteStatus AllocationInfoBuilder::AddScratchBuffers(
     internal::ScratchBufferHandle* buffer_handles) {
   // Set up allocation info for buffers.
@@ -210,6 +532,8 @@ TfLiteStatus AllocationInfoBuilder::AddScratchBuffers(
     current->first_created = handle->node_idx;
     current->last_used = handle->node_idx;
     current->needs_allocating = true;
+    current->offline_offset = -1;
+    current->alias_of = -1;
   }
   return kTfLiteOk;
 }
@@ -223,9 +547,15 @@ TfLiteStatus CreatePlan(ErrorReporter* error_reporter, MemoryPlanner* planner,
     if (current->needs_allocating) {
       size_t aligned_bytes_required =
           AlignSizeUp(current->bytes, kBufferAlignment);
-      TF_LITE_ENSURE_STATUS(
-          planner->AddBuffer(error_reporter, aligned_bytes_required,
-                             current->first_created, current->last_used));
+      if (current->offline_offset == -1) {
+        TF_LITE_ENSURE_STATUS(
+            planner->AddBuffer(error_reporter, aligned_bytes_required,
+                               current->first_created, current->last_used));
+      } else {
+        TF_LITE_ENSURE_STATUS(planner->AddBuffer(
+            error_reporter, aligned_bytes_required, current->first_created,
+            current->last_used, current->offline_offset));
+      }
     }
   }
   return kTfLiteOk;
@@ -249,6 +579,156 @@ TfLiteStatus CommitPlan(ErrorReporter* error_reporter, MemoryPlanner* planner,
   }
   return kTfLiteOk;
 }
+
+// Plans the buffers with `planner`, checks that the plan fits in
+// `available_size` bytes and commits it at `starting_point`.
+TfLiteStatus PlanAndCommit(ErrorReporter* error_reporter,
+                           MemoryPlanner* planner,
+                           const AllocationInfo* allocation_info,
+                           size_t allocation_info_size,
+                           uint8_t* starting_point, size_t available_size,
+                           size_t* plan_size) {
+  TF_LITE_ENSURE_STATUS(CreatePlan(error_reporter, planner, allocation_info,
+                                   allocation_info_size));
+
+  *plan_size = planner->GetMaximumMemorySize();
+  // Make sure we have enough arena size.
+  if (*plan_size > available_size) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter,
+        "Arena size is too small for activation buffers. Needed %d but "
+        "only %d was available.",
+        *plan_size, available_size);
+    return kTfLiteError;
+  }
+
+  // Commit the plan.
+  return CommitPlan(error_reporter, planner, starting_point, allocation_info,
+                    allocation_info_size);
+}
+
+// Points every aliased buffer at the buffer it shares, once those are placed.
+void CommitAliases(const AllocationInfo* allocation_info,
+                   size_t allocation_info_size) {
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* current = &allocation_info[i];
+    if (current->alias_of != -1) {
+      *current->output_ptr = *allocation_info[current->alias_of].output_ptr;
+    }
+  }
+}
+
+// Returns the per-tensor offsets of the offline memory plan stored in the
+// model metadata, or null in `offline_offsets` if the model has none.
+TfLiteStatus GetOfflinePlannedOffsets(ErrorReporter* error_reporter,
+                                      const Model* model,
+                                      const SubGraph* subgraph,
+                                      const int32_t** offline_offsets) {
+  *offline_offsets = nullptr;
+  if (model->metadata() == nullptr) {
+    return kTfLiteOk;
+  }
+  for (size_t i = 0; i < model->metadata()->size(); ++i) {
+    const Metadata* metadata = model->metadata()->Get(i);
+    if (metadata->name() == nullptr ||
+        strncmp(metadata->name()->c_str(), kOfflineMemAllocMetadata,
+                sizeof(kOfflineMemAllocMetadata)) != 0) {
+      continue;
+    }
+    const flatbuffers::Vector<uint8_t>* data =
+        model->buffers()->Get(metadata->buffer())->data();
+    const size_t tensor_count = subgraph->tensors()->size();
+    // Offsets are little-endian int32 values, like the tensor shapes.
+    const int32_t* values =
+        data != nullptr ? reinterpret_cast<const int32_t*>(data->data())
+                        : nullptr;
+    if (values == nullptr ||
+        data->size() < kOfflineMemAllocHeaderSize * sizeof(int32_t) ||
+        values[0] != kOfflineMemAllocVersion || values[1] != 0 ||
+        static_cast<size_t>(values[2]) != tensor_count ||
+        data->size() !=
+            (kOfflineMemAllocHeaderSize + tensor_count) * sizeof(int32_t)) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Invalid %s metadata, expected version %d for "
+                           "subgraph 0 with %d tensors",
+                           kOfflineMemAllocMetadata, kOfflineMemAllocVersion,
+                           tensor_count);
+      return kTfLiteError;
+    }
+    *offline_offsets = values + kOfflineMemAllocHeaderSize;
+    return kTfLiteOk;
+  }
+  return kTfLiteOk;
+}
+
+// Checks that no two offline planned buffers that are alive at the same time
+// share memory, and that all of them are aligned and fit into `arena_size`.
+// This is O(N^2) in the number of buffers.
+TfLiteStatus VerifyOfflinePlan(ErrorReporter* error_reporter,
+                               const AllocationInfo* allocation_info,
+                               size_t allocation_info_size,
+                               size_t arena_size) {
+  bool ok = true;
+  for (size_t i = 0; i < allocation_info_size; ++i) {
+    const AllocationInfo* a = &allocation_info[i];
+    if (!a->needs_allocating || a->offline_offset == -1) {
+      continue;
+    }
+    const size_t a_end =
+        a->offline_offset + AlignSizeUp(a->bytes, kBufferAlignment);
+    if (a->offline_offset < 0 || a->offline_offset % kBufferAlignment != 0 ||
+        a_end > arena_size) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Offline plan: buffer %d at offset %d (%d bytes) "
+                           "is misaligned or outside of the %d byte arena",
+                           i, a->offline_offset, a->bytes, arena_size);
+      ok = false;
+      continue;
+    }
+    for (size_t j = i + 1; j < allocation_info_size; ++j) {
+      const AllocationInfo* b = &allocation_info[j];
+      if (!b->needs_allocating || b->offline_offset == -1) {
+        continue;
+      }
+      const size_t b_end =
+          b->offline_offset + AlignSizeUp(b->bytes, kBufferAlignment);
+      if (a->first_created > b->last_used ||
+          b->first_created > a->last_used ||
+          static_cast<size_t>(a->offline_offset) >= b_end ||
+          static_cast<size_t>(b->offline_offset) >= a_end) {
+        continue;
+      }
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Offline plan: buffers %d (%d=>%d, %d->%d) and %d "
+                           "(%d=>%d, %d->%d) overlap",
+                           i, a->first_created, a->last_used,
+                           a->offline_offset, a_end, j, b->first_created,
+                           b->last_used, b->offline_offset, b_end);
+      ok = false;
+    }
+  }
+  return ok ? kTfLiteOk : kTfLiteError;
+}
+
+// Returns the serialized palette of a palettized tensor (see
+// kernels/palettized.h), or null for other tensors.
+const flatbuffers::Vector<uint8_t>* GetSerializedPalette(
+    const tflite::Tensor& flatbuffer_tensor) {
+  const auto* src_quantization = flatbuffer_tensor.quantization();
+  const CustomQuantization* details =
+      src_quantization == nullptr
+          ? nullptr
+          : src_quantization->details_as_CustomQuantization();
+  const flatbuffers::Vector<uint8_t>* custom =
+      details == nullptr ? nullptr : details->custom();
+  if (custom == nullptr || custom->size() < micro::kPaletteHeaderSize ||
+      std::memcmp(custom->data(), micro::kPaletteMagic,
+                  sizeof(micro::kPaletteMagic)) != 0) {
+    return nullptr;
+  }
+  return custom;
+}
+
 }  // namespace
 
 namespace internal {
@@ -257,12 +737,13 @@ namespace internal {
 // into it.
 template <class T>
 TfLiteStatus FlatBufferIntArrayToTfLiteIntArray(
-    SimpleMemoryAllocator* allocator, ErrorReporter* error_reporter,
-    const flatbuffers::Vector<T>* flat_array, TfLiteIntArray** result) {
-  TfLiteIntArray* ret =
-      reinterpret_cast<TfLiteIntArray*>(allocator->AllocateFromTail(
-          TfLiteIntArrayGetSizeInBytes(flat_array->Length()),
-          alignof(TfLiteIntArray)));
+    SimpleMemoryAllocator* allocator, bool allocate_temp,
+    ErrorReporter* error_reporter, const flatbuffers::Vector<T>* flat_array,
+    TfLiteIntArray** result) {
+  TfLiteIntArray* ret = reinterpret_cast<TfLiteIntArray*>(
+      Allocate(allocator, allocate_temp,
+               TfLiteIntArrayGetSizeInBytes(flat_array->Length()),
+               alignof(TfLiteIntArray)));
   if (nullptr == ret) {
     TF_LITE_REPORT_ERROR(
         error_reporter,
@@ -278,8 +759,202 @@ TfLiteStatus FlatBufferIntArrayToTfLiteIntArray(
   return kTfLiteOk;
 }
 
+// Points `result` at the shape of a serialized tensor.
+TfLiteStatus InitializeDimsFromFlatbuffer(
+    SimpleMemoryAllocator* allocator, bool allocate_temp,
+    const tflite::Tensor& flatbuffer_tensor, ErrorReporter* error_reporter,
+    TfLiteIntArray** result) {
+  if (flatbuffer_tensor.shape() == nullptr) {
+    // flatbuffer_tensor.shape() can return a nullptr in the case of a scalar
+    // tensor.
+    *result = const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
+  } else if (!FLATBUFFERS_LITTLEENDIAN) {
+    // Big-endian architecture. Copy and byte-swap the little-endian shape
+    // data.
+    TF_LITE_ENSURE_STATUS(FlatBufferIntArrayToTfLiteIntArray(
+        allocator, allocate_temp, error_reporter, flatbuffer_tensor.shape(),
+        result));
+  } else {
+    // On little-endian machines, TfLiteIntArray happens to have the same
+    // memory layout as flatbuffers:Vector<int>, so we can reinterpret_cast the
+    // tensor shape vector and avoid a copy.
+    // TFLM doesn't allow reshaping the tensor which requires dynamic memory
+    // allocation so it is safe to drop the const qualifier. In the future, if
+    // we really want to update the tensor shape, we can always pass in a new
+    // TfLiteIntArray - especially we have to do so if the dimension is changed.
+    *result = const_cast<TfLiteIntArray*>(
+        reinterpret_cast<const TfLiteIntArray*>(flatbuffer_tensor.shape()));
+  }
+  return kTfLiteOk;
+}
+
+// Points `result` at a serialized int32 vector, copying it like
+// InitializeDimsFromFlatbuffer() does only on big-endian machines. A missing
+// vector gives an empty array.
+TfLiteStatus IntArrayFromFlatbuffer(SimpleMemoryAllocator* allocator,
+                                    bool allocate_temp,
+                                    const flatbuffers::Vector<int32_t>* vector,
+                                    ErrorReporter* error_reporter,
+                                    TfLiteIntArray** result) {
+  if (vector == nullptr) {
+    *result = const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
+  } else if (!FLATBUFFERS_LITTLEENDIAN) {
+    TF_LITE_ENSURE_STATUS(FlatBufferIntArrayToTfLiteIntArray(
+        allocator, allocate_temp, error_reporter, vector, result));
+  } else {
+    *result = const_cast<TfLiteIntArray*>(
+        reinterpret_cast<const TfLiteIntArray*>(vector));
+  }
+  return kTfLiteOk;
+}
+
+// Populates `result` from the sparsity parameters of a serialized tensor. The
+// index arrays stay in the flatbuffer, so only int32 ones are supported.
+TfLiteStatus InitializeSparsityFromFlatbuffer(
+    SimpleMemoryAllocator* allocator, bool allocate_temp,
+    const SparsityParameters& src_sparsity, ErrorReporter* error_reporter,
+    TfLiteSparsity** result) {
+  const auto* src_dim_metadata = src_sparsity.dim_metadata();
+  const int dim_metadata_size =
+      src_dim_metadata == nullptr ? 0 : src_dim_metadata->size();
+  TfLiteSparsity* sparsity = reinterpret_cast<TfLiteSparsity*>(
+      Allocate(allocator, allocate_temp, sizeof(TfLiteSparsity),
+               alignof(TfLiteSparsity)));
+  TfLiteDimensionMetadata* dim_metadata =
+      reinterpret_cast<TfLiteDimensionMetadata*>(
+          Allocate(allocator, allocate_temp,
+                   dim_metadata_size * sizeof(TfLiteDimensionMetadata),
+                   alignof(TfLiteDimensionMetadata)));
+  if (sparsity == nullptr || dim_metadata == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Unable to allocate TfLiteSparsity.");
+    return kTfLiteError;
+  }
+  TF_LITE_ENSURE_STATUS(IntArrayFromFlatbuffer(
+      allocator, allocate_temp, src_sparsity.traversal_order(), error_reporter,
+      &sparsity->traversal_order));
+  TF_LITE_ENSURE_STATUS(
+      IntArrayFromFlatbuffer(allocator, allocate_temp,
+                             src_sparsity.block_map(), error_reporter,
+                             &sparsity->block_map));
+  for (int i = 0; i < dim_metadata_size; ++i) {
+    const DimensionMetadata* src = src_dim_metadata->Get(i);
+    TfLiteDimensionMetadata* dst = &dim_metadata[i];
+    dst->dense_size = src->dense_size();
+    dst->array_segments = const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
+    dst->array_indices = const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
+    if (src->format() == DimensionType_DENSE) {
+      dst->format = kTfLiteDimDense;
+      continue;
+    }
+    dst->format = kTfLiteDimSparseCSR;
+    const Int32Vector* segments = src->array_segments_as_Int32Vector();
+    const Int32Vector* indices = src->array_indices_as_Int32Vector();
+    if (segments == nullptr || indices == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Sparse dimension %d must use int32 segments and "
+                           "indices.",
+                           i);
+      return kTfLiteError;
+    }
+    // Kernels keep pointers to the index arrays after prepare, so copies of
+    // them (big-endian only) are never temporary.
+    TF_LITE_ENSURE_STATUS(IntArrayFromFlatbuffer(
+        allocator, /*allocate_temp=*/false, segments->values(), error_reporter,
+        &dst->array_segments));
+    TF_LITE_ENSURE_STATUS(IntArrayFromFlatbuffer(
+        allocator, /*allocate_temp=*/false, indices->values(), error_reporter,
+        &dst->array_indices));
+  }
+  sparsity->dim_metadata = dim_metadata;
+  sparsity->dim_metadata_size = dim_metadata_size;
+  *result = sparsity;
+  return kTfLiteOk;
+}
+
+// Populates `result` from the palette of a serialized tensor (see
+// kernels/palettized.h), leaving it null for tensors without one. The values
+// stay in the flatbuffer, except on big-endian machines.
+TfLiteStatus InitializePaletteFromFlatbuffer(
+    SimpleMemoryAllocator* allocator, bool allocate_temp,
+    const tflite::Tensor& flatbuffer_tensor,
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+    size_t type_size, ErrorReporter* error_reporter,
+    const TfLitePalette** result) {
+  const flatbuffers::Vector<uint8_t>* custom =
+      GetSerializedPalette(flatbuffer_tensor);
+  if (custom == nullptr) {
+    return kTfLiteOk;
+  }
+
+  const uint8_t* header = custom->data();
+  const int bits = header[4];
+  if (header[3] != micro::kPaletteVersion ||
+      (bits != 1 && bits != 2 && bits != 4 && bits != 8)) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Unsupported palette version %d with %d-bit indices.",
+                         header[3], bits);
+    return kTfLiteError;
+  }
+  const size_t values_size = (size_t{1} << bits) * type_size;
+  if (custom->size() != micro::kPaletteHeaderSize + values_size) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Palette of %d bytes, %d expected.",
+                         custom->size() - micro::kPaletteHeaderSize,
+                         values_size);
+    return kTfLiteError;
+  }
+
+  // The kernels read every packed index of the dense shape.
+  size_t element_count = 1;
+  if (flatbuffer_tensor.shape() != nullptr) {
+    for (size_t i = 0; i < flatbuffer_tensor.shape()->size(); ++i) {
+      element_count *= flatbuffer_tensor.shape()->Get(i);
+    }
+  }
+  const Buffer* buffer = buffers->Get(flatbuffer_tensor.buffer());
+  const size_t packed_size = (element_count * bits + 7) / 8;
+  if (buffer == nullptr || buffer->data() == nullptr ||
+      buffer->data()->size() < packed_size) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Palettized tensor needs %d bytes of indices.",
+                         packed_size);
+    return kTfLiteError;
+  }
+
+  TfLitePalette* palette = reinterpret_cast<TfLitePalette*>(
+      Allocate(allocator, allocate_temp, sizeof(TfLitePalette),
+               alignof(TfLitePalette)));
+  if (palette == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Unable to allocate TfLitePalette.");
+    return kTfLiteError;
+  }
+  palette->bits_per_index = bits;
+  palette->values = header + micro::kPaletteHeaderSize;
+  if (!FLATBUFFERS_LITTLEENDIAN) {
+    // Kernels keep a pointer to the values after prepare, so the byte-swapped
+    // copy is never temporary.
+    uint8_t* values = allocator->AllocateFromTail(values_size, type_size);
+    if (values == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Failed to allocate %d bytes for a palette.",
+                           values_size);
+      return kTfLiteError;
+    }
+    const uint8_t* src = header + micro::kPaletteHeaderSize;
+    for (size_t i = 0; i < values_size; i += type_size) {
+      for (size_t j = 0; j < type_size; ++j) {
+        values[i + j] = src[i + type_size - 1 - j];
+      }
+    }
+    palette->values = values;
+  }
+  *result = palette;
+  return kTfLiteOk;
+}
+
 TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
-    SimpleMemoryAllocator* allocator, const tflite::Tensor& flatbuffer_tensor,
+    SimpleMemoryAllocator* allocator, bool allocate_temp,
+    const tflite::Tensor& flatbuffer_tensor,
     const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
     ErrorReporter* error_reporter, TfLiteTensor* result) {
   *result = {};
@@ -290,32 +965,7 @@ TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
   // Make sure we remember if the serialized tensor is designated as a variable.
   result->is_variable = flatbuffer_tensor.is_variable();
 
-  // We need to figure out where the actual contents of this tensor are stored
-  // in memory. We'll check to see if there's a serialized buffer (pretty much
-  // the same as a constant op in TensorFlow) associated with this tensor first,
-  // and if there is update the runtime structure to point to its location in
-  // memory.
-  // First see if there's any buffer information in the serialized tensor.
-  if (auto* buffer = (*buffers)[flatbuffer_tensor.buffer()]) {
-    // If we've found a buffer, does it have any data?
-    if (auto* array = buffer->data()) {
-      // If it has any data, is the data size larger than zero?
-      if (array->size()) {
-        // We've found a buffer with valid data, so update the runtime tensor
-        // data structure to point to it.
-        result->data.data =
-            const_cast<void*>(static_cast<const void*>(array->data()));
-        // We set the data from a serialized buffer, so record tha.
-        result->allocation_type = kTfLiteMmapRo;
-      }
-    }
-    // TODO(petewarden): It's not clear in what circumstances we could have a
-    // buffer in the serialized tensor, but it doesn't have any data in it. Is
-    // that a validly-generated file, and if so what does it mean, or is it an
-    // error condition? It would be good to tighten up the specification to make
-    // it less ambiguous.
-  }
-
+  result->data.data = GetFlatbufferTensorData(flatbuffer_tensor, buffers);
   // TODO(petewarden): Some of these paths aren't getting enough testing
   // coverage, so we should figure out some tests that exercise them.
   if (result->data.data == nullptr) {
@@ -323,6 +973,9 @@ TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
     // make a note that they will be allocated from memory. The actual
     // allocation won't happen until later.
     result->allocation_type = kTfLiteArenaRw;
+  } else {
+    // We set the data from a serialized buffer, so record tha.
+    result->allocation_type = kTfLiteMmapRo;
   }
 
   // Figure out what the size in bytes of the buffer is and store it.
@@ -330,26 +983,9 @@ TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
   TF_LITE_ENSURE_STATUS(BytesRequiredForTensor(
       flatbuffer_tensor, &result->bytes, &type_size, error_reporter));
 
-  if (flatbuffer_tensor.shape() == nullptr) {
-    // flatbuffer_tensor.shape() can return a nullptr in the case of a scalar
-    // tensor.
-    result->dims = const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
-  } else if (!FLATBUFFERS_LITTLEENDIAN) {
-    // Big-endian architecture. Copy and byte-swap the little-endian shape
-    // data.
-    TF_LITE_ENSURE_STATUS(FlatBufferIntArrayToTfLiteIntArray(
-        allocator, error_reporter, flatbuffer_tensor.shape(), &(result->dims)));
-  } else {
-    // On little-endian machines, TfLiteIntArray happens to have the same
-    // memory layout as flatbuffers:Vector<int>, so we can reinterpret_cast the
-    // tensor shape vector and avoid a copy.
-    // TFLM doesn't allow reshaping the tensor which requires dynamic memory
-    // allocation so it is safe to drop the const qualifier. In the future, if
-    // we really want to update the tensor shape, we can always pass in a new
-    // TfLiteIntArray - especially we have to do so if the dimension is changed.
-    result->dims = const_cast<TfLiteIntArray*>(
-        reinterpret_cast<const TfLiteIntArray*>(flatbuffer_tensor.shape()));
-  }
+  TF_LITE_ENSURE_STATUS(InitializeDimsFromFlatbuffer(
+      allocator, allocate_temp, flatbuffer_tensor, error_reporter,
+      &result->dims));
 
   // Copy the quantization information from the serialized data.
   const auto* src_quantization = flatbuffer_tensor.quantization();
@@ -370,16 +1006,18 @@ TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
     int channels = src_quantization->scale()->size();
     TfLiteAffineQuantization* quantization =
         reinterpret_cast<TfLiteAffineQuantization*>(
-            allocator->AllocateFromTail(sizeof(TfLiteAffineQuantization),
-                                        alignof(TfLiteAffineQuantization)));
+            Allocate(allocator, allocate_temp,
+                     sizeof(TfLiteAffineQuantization),
+                     alignof(TfLiteAffineQuantization)));
     if (quantization == nullptr) {
       TF_LITE_REPORT_ERROR(error_reporter,
                            "Unable to allocate TfLiteAffineQuantization.\n");
       return kTfLiteError;
     }
-    quantization->zero_point =
-        reinterpret_cast<TfLiteIntArray*>(allocator->AllocateFromTail(
-            TfLiteIntArrayGetSizeInBytes(channels), alignof(TfLiteIntArray)));
+    quantization->zero_point = reinterpret_cast<TfLiteIntArray*>(
+        Allocate(allocator, allocate_temp,
+                 TfLiteIntArrayGetSizeInBytes(channels),
+                 alignof(TfLiteIntArray)));
     if (quantization->zero_point == nullptr) {
       TF_LITE_REPORT_ERROR(error_reporter,
                            "Unable to allocate quantization->zero_point.\n");
@@ -387,8 +1025,9 @@ TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
     }
 
     quantization->scale = reinterpret_cast<TfLiteFloatArray*>(
-        allocator->AllocateFromTail(TfLiteFloatArrayGetSizeInBytes(channels),
-                                    alignof(TfLiteFloatArray)));
+        Allocate(allocator, allocate_temp,
+                 TfLiteFloatArrayGetSizeInBytes(channels),
+                 alignof(TfLiteFloatArray)));
     if (quantization->scale == nullptr) {
       TF_LITE_REPORT_ERROR(error_reporter,
                            "Unable to allocate quantization->scale.\n");
@@ -409,21 +1048,53 @@ TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
 
     result->quantization = {kTfLiteAffineQuantization, quantization};
   }
+
+  // Block-sparse weights (see kernels/block_sparse.h) keep their dense shape
+  // and list the stored blocks here.
+  if (flatbuffer_tensor.sparsity() != nullptr) {
+    TF_LITE_ENSURE_STATUS(InitializeSparsityFromFlatbuffer(
+        allocator, allocate_temp, *flatbuffer_tensor.sparsity(),
+        error_reporter, &result->sparsity));
+  }
+
+  // Palettized weights keep their dense shape too, with packed indices as
+  // their data. Their palette is read on request, see
+  // MicroAllocator::AllocateTempTfLitePalette().
   return kTfLiteOk;
 }
 
+TfLiteStatus InitializeTfLiteEvalTensorFromFlatbuffer(
+    SimpleMemoryAllocator* allocator, const tflite::Tensor& flatbuffer_tensor,
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+    ErrorReporter* error_reporter, TfLiteEvalTensor* result) {
+  *result = {};
+  TF_LITE_ENSURE_STATUS(ConvertTensorType(flatbuffer_tensor.type(),
+                                          &result->type, error_reporter));
+  result->data.data = GetFlatbufferTensorData(flatbuffer_tensor, buffers);
+  return InitializeDimsFromFlatbuffer(allocator, /*allocate_temp=*/false,
+                                      flatbuffer_tensor, error_reporter,
+                                      &result->dims);
+}
+
+bool IsPalettizedTensor(const tflite::Tensor& flatbuffer_tensor) {
+  return GetSerializedPalette(flatbuffer_tensor) != nullptr;
+}
+
 }  // namespace internal
 
 MicroAllocator::MicroAllocator(SimpleMemoryAllocator* memory_allocator,
-                               ErrorReporter* error_reporter)
+                               ErrorReporter* error_reporter,
+                               MemoryPlannerType planner_type)
     : memory_allocator_(memory_allocator),
       error_reporter_(error_reporter),
-      model_is_allocating_(false) {}
+      model_is_allocating_(false),
+      planner_type_(planner_type) {}
 
 MicroAllocator::~MicroAllocator() {}
 
 MicroAllocator* MicroAllocator::Create(uint8_t* tensor_arena, size_t arena_size,
-                                       ErrorReporter* error_reporter) {
+                                       ErrorReporter* error_reporter,
+                                       MemoryPlannerType planner_type) {
   uint8_t* aligned_arena = AlignPointerUp(tensor_arena, kBufferAlignment);
   if (aligned_arena != tensor_arena) {
     TF_LITE_REPORT_ERROR(
@@ -435,25 +1106,28 @@ MicroAllocator* MicroAllocator::Create(uint8_t* tensor_arena, size_t arena_size,
   size_t aligned_arena_size = tensor_arena + arena_size - aligned_arena;
   return Create(SimpleMemoryAllocator::Create(error_reporter, aligned_arena,
                                               aligned_arena_size),
-                error_reporter);
+                error_reporter, planner_type);
 }
 
 MicroAllocator* MicroAllocator::Create(SimpleMemoryAllocator* memory_allocator,
-                                       ErrorReporter* error_reporter) {
+                                       ErrorReporter* error_reporter,
+                                       MemoryPlannerType planner_type) {
   TFLITE_DCHECK(memory_allocator != nullptr);
   TFLITE_DCHECK(error_reporter != nullptr);
 
   uint8_t* allocator_buffer = memory_allocator->AllocateFromTail(
       sizeof(MicroAllocator), alignof(MicroAllocator));
   MicroAllocator* allocator =
-      new (allocator_buffer) MicroAllocator(memory_allocator, error_reporter);
+      new (allocator_buffer)
+          MicroAllocator(memory_allocator, error_reporter, planner_type);
   return allocator;
 }
 
 TfLiteStatus MicroAllocator::StartModelAllocation(
     const Model* model, TfLiteContext* context,
     const MicroOpResolver& op_resolver,
-    NodeAndRegistration** node_and_registrations) {
+    NodeAndRegistration** node_and_registrations,
+    TfLiteEvalTensor** eval_tensors) {
   TFLITE_DCHECK(model != nullptr);
   TFLITE_DCHECK(context != nullptr);
 
@@ -470,17 +1144,335 @@ TfLiteStatus MicroAllocator::StartModelAllocation(
   model_is_allocating_ = true;
 
   TF_LITE_ENSURE_STATUS(
-      InitGraphAndContextTensorData(model, context, subgraph));
+      AllocateTfLiteEvalTensors(model, subgraph, eval_tensors));
+  TF_LITE_ENSURE_STATUS(
+      InitGraphAndContextTensorData(model, context, subgraph, *eval_tensors));
   TF_LITE_ENSURE_STATUS(
       AllocateNodeAndRegistrations(subgraph, node_and_registrations));
   TF_LITE_ENSURE_STATUS(PrepareNodeAndRegistrationDataFromFlatbuffer(
       model, subgraph, op_resolver, *node_and_registrations));
+  node_and_registrations_ = *node_and_registrations;
+
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::FuseConvPoolChains(
+    const Model* model, const TfLiteRegistration* registration,
+    int* fused_count) {
+  *fused_count = 0;
+  if (!model_is_allocating_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "MicroAllocator: FuseConvPoolChains() called outside "
+                         "of a model allocation");
+    return kTfLiteError;
+  }
+  const SubGraph* subgraph = GetSubGraphFromModel(model);
+  TFLITE_DCHECK(subgraph != nullptr);
+
+  // The fused node writes the pool output when the conv runs, earlier than an
+  // offline plan expects it to be alive.
+  const int32_t* offline_offsets = nullptr;
+  TF_LITE_ENSURE_STATUS(GetOfflinePlannedOffsets(error_reporter_, model,
+                                                 subgraph, &offline_offsets));
+  if (offline_offsets != nullptr) {
+    return kTfLiteOk;
+  }
+
+  const auto* operators = subgraph->operators();
+  for (size_t i = 0; i < operators->size(); ++i) {
+    const auto* conv_op = operators->Get(i);
+    if (GetBuiltinCode(model, conv_op) != BuiltinOperator_CONV_2D ||
+        conv_op->outputs()->size() != 1) {
+      continue;
+    }
+    // The fused kernel reads dense filters only.
+    const auto* filter = subgraph->tensors()->Get(conv_op->inputs()->Get(1));
+    if (filter->sparsity() != nullptr ||
+        GetSerializedPalette(*filter) != nullptr) {
+      continue;
+    }
+
+    // Follows the conv output through shape-only ops to a MAX_POOL_2D, with
+    // every tensor on the way read by the next operator only.
+    const int conv_output = conv_op->outputs()->Get(0);
+    int pool_input = conv_output;
+    int pool_index = -1;
+    while (IsFusableActivation(subgraph, model->buffers(), pool_input)) {
+      const int consumer = GetSingleConsumer(subgraph, pool_input);
+      if (consumer == -1) {
+        break;
+      }
+      const auto* op = operators->Get(consumer);
+      const BuiltinOperator builtin_code = GetBuiltinCode(model, op);
+      if (builtin_code == BuiltinOperator_MAX_POOL_2D) {
+        pool_index = consumer;
+        break;
+      }
+      if (!IsShapeOnlyOp(builtin_code) || op->inputs()->Get(0) != pool_input ||
+          op->outputs()->size() != 1) {
+        break;
+      }
+      pool_input = op->outputs()->Get(0);
+    }
+    if (pool_index == -1) {
+      continue;
+    }
+
+    const auto* pool_op = operators->Get(pool_index);
+    const int pool_output = pool_op->outputs()->Get(0);
+    const Tensor* conv_tensor = subgraph->tensors()->Get(conv_output);
+    const Tensor* input_tensor = subgraph->tensors()->Get(pool_input);
+    const Tensor* output_tensor = subgraph->tensors()->Get(pool_output);
+    const auto* pool_params = static_cast<const TfLitePoolParams*>(
+        node_and_registrations_[pool_index].node.builtin_data);
+    // The kernel maps the pool input onto the conv output by element index,
+    // and overlapping windows would compute conv outputs more than once.
+    if (conv_tensor->shape() == nullptr || conv_tensor->shape()->size() != 4 ||
+        input_tensor->shape() == nullptr ||
+        input_tensor->shape()->size() != 4 ||
+        output_tensor->type() != conv_tensor->type() ||
+        input_tensor->type() != conv_tensor->type() ||
+        conv_tensor->shape()->Get(0) != input_tensor->shape()->Get(0) ||
+        conv_tensor->shape()->Get(3) != input_tensor->shape()->Get(3) ||
+        pool_params->stride_width < pool_params->filter_width ||
+        pool_params->stride_height < pool_params->filter_height) {
+      continue;
+    }
+
+    TfLiteConvPoolParams* params = reinterpret_cast<TfLiteConvPoolParams*>(
+        memory_allocator_->AllocateFromTail(sizeof(TfLiteConvPoolParams),
+                                            alignof(TfLiteConvPoolParams)));
+    TfLiteIntArray* outputs =
+        reinterpret_cast<TfLiteIntArray*>(memory_allocator_->AllocateFromTail(
+            TfLiteIntArrayGetSizeInBytes(1), alignof(TfLiteIntArray)));
+    TfLiteIntArray* intermediates =
+        reinterpret_cast<TfLiteIntArray*>(memory_allocator_->AllocateFromTail(
+            TfLiteIntArrayGetSizeInBytes(2), alignof(TfLiteIntArray)));
+    if (params == nullptr || outputs == nullptr || intermediates == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to allocate memory for fused node %d", i);
+      return kTfLiteError;
+    }
+    TfLiteNode* conv_node = &node_and_registrations_[i].node;
+    params->conv =
+        *static_cast<const TfLiteConvParams*>(conv_node->builtin_data);
+    params->pool = *pool_params;
+    outputs->size = 1;
+    outputs->data[0] = pool_output;
+    intermediates->size = 2;
+    intermediates->data[0] = conv_output;
+    intermediates->data[1] = pool_input;
+    conv_node->builtin_data = params;
+    conv_node->outputs = outputs;
+    conv_node->intermediates = intermediates;
+    node_and_registrations_[i].registration = registration;
+
+    // The nodes of the chain lose their inputs and outputs, which leaves the
+    // tensors between the conv and the pool out of the memory plan.
+    TfLiteIntArray* empty =
+        const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
+    int tensor_index = conv_output;
+    int node_index;
+    do {
+      node_index = GetSingleConsumer(subgraph, tensor_index);
+      tensor_index = operators->Get(node_index)->outputs()->Get(0);
+      TfLiteNode* node = &node_and_registrations_[node_index].node;
+      node->inputs = empty;
+      node->outputs = empty;
+      node_and_registrations_[node_index].registration =
+          &kFusedNodeRegistration;
+    } while (node_index != pool_index);
+    ++*fused_count;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::SimplifyGraph(const Model* model,
+                                           int* removed_count) {
+  *removed_count = 0;
+  if (!model_is_allocating_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "MicroAllocator: SimplifyGraph() called outside of a "
+                         "model allocation");
+    return kTfLiteError;
+  }
+  const SubGraph* subgraph = GetSubGraphFromModel(model);
+  TFLITE_DCHECK(subgraph != nullptr);
+
+  // An offline plan may place the output of a removed node elsewhere than its
+  // input.
+  const int32_t* offline_offsets = nullptr;
+  TF_LITE_ENSURE_STATUS(GetOfflinePlannedOffsets(error_reporter_, model,
+                                                 subgraph, &offline_offsets));
+  if (offline_offsets != nullptr) {
+    return kTfLiteOk;
+  }
+
+  const auto* operators = subgraph->operators();
+  for (size_t i = 0; i < operators->size(); ++i) {
+    const auto* op = operators->Get(i);
+    if (op->inputs()->size() < 1 || op->outputs()->size() != 1 ||
+        op->inputs()->Get(0) < 0) {
+      continue;
+    }
+    const BuiltinOperator builtin_code = GetBuiltinCode(model, op);
+    const int input_index = op->inputs()->Get(0);
+    const int output_index = op->outputs()->Get(0);
+    const Tensor* input = subgraph->tensors()->Get(input_index);
+    const Tensor* output = subgraph->tensors()->Get(output_index);
+
+    if (IsShapeOnlyOp(builtin_code) ||
+        (builtin_code == BuiltinOperator_QUANTIZE &&
+         HasSameQuantization(input, output))) {
+      // RESHAPE, EXPAND_DIMS, SQUEEZE and a QUANTIZE to the same scale and
+      // zero point leave the bytes as they are.
+      if (!CanForward(subgraph, model->buffers(), input_index, output_index)) {
+        continue;
+      }
+      node_and_registrations_[i].registration = &kForwardingNodeRegistration;
+      ++*removed_count;
+      continue;
+    }
+
+    if (builtin_code != BuiltinOperator_QUANTIZE) {
+      continue;
+    }
+    // A DEQUANTIZE whose float output is only quantized back to the same
+    // scale and zero point: the QUANTIZE forwards the DEQUANTIZE input and
+    // the float tensor is left out of the memory plan.
+    const int dequantize_index = GetProducer(subgraph, input_index);
+    if (dequantize_index == -1 ||
+        GetBuiltinCode(model, operators->Get(dequantize_index)) !=
+            BuiltinOperator_DEQUANTIZE ||
+        GetSingleConsumer(subgraph, input_index) != static_cast<int>(i)) {
+      continue;
+    }
+    const int quantized_index =
+        operators->Get(dequantize_index)->inputs()->Get(0);
+    const Tensor* quantized = subgraph->tensors()->Get(quantized_index);
+    if (!HasSameQuantization(quantized, output) ||
+        !CanForward(subgraph, model->buffers(), quantized_index,
+                    output_index)) {
+      continue;
+    }
+    TfLiteIntArray* inputs =
+        reinterpret_cast<TfLiteIntArray*>(memory_allocator_->AllocateFromTail(
+            TfLiteIntArrayGetSizeInBytes(1), alignof(TfLiteIntArray)));
+    if (inputs == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to allocate memory for node %d", i);
+      return kTfLiteError;
+    }
+    inputs->size = 1;
+    inputs->data[0] = quantized_index;
+    TfLiteIntArray* empty = const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
+    TfLiteNode* dequantize_node =
+        &node_and_registrations_[dequantize_index].node;
+    dequantize_node->inputs = empty;
+    dequantize_node->outputs = empty;
+    node_and_registrations_[dequantize_index].registration =
+        &kFusedNodeRegistration;
+    node_and_registrations_[i].node.inputs = inputs;
+    node_and_registrations_[i].registration = &kForwardingNodeRegistration;
+    *removed_count += 2;
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAllocator::FoldConstantNodes(const Model* model,
+                                               TfLiteContext* context,
+                                               TfLiteEvalTensor* eval_tensors,
+                                               int* folded_count) {
+  *folded_count = 0;
+  if (!model_is_allocating_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "MicroAllocator: FoldConstantNodes() called outside "
+                         "of a model allocation");
+    return kTfLiteError;
+  }
+  const SubGraph* subgraph = GetSubGraphFromModel(model);
+  TFLITE_DCHECK(subgraph != nullptr);
+
+  for (size_t i = 0; i < subgraph->operators()->size(); ++i) {
+    TfLiteNode* node = &node_and_registrations_[i].node;
+    const TfLiteRegistration* registration =
+        node_and_registrations_[i].registration;
+
+    // A removed node whose input is constant has a constant output as well.
+    if (registration == &kForwardingNodeRegistration) {
+      const int input_index = node->inputs->data[0];
+      const int output_index = node->outputs->data[0];
+      if (IsConstantTensor(model, subgraph, node_and_registrations_,
+                           eval_tensors, input_index)) {
+        eval_tensors[output_index].data = eval_tensors[input_index].data;
+        context->tensors[output_index].data = eval_tensors[input_index].data;
+      }
+      continue;
+    }
+
+    if (registration->invoke == nullptr || node->outputs->size == 0) {
+      continue;
+    }
+    // Scratch buffers are only placed by the memory plan.
+    bool uses_scratch_buffer = false;
+    for (size_t n = 0; n < scratch_buffer_count_; ++n) {
+      if (scratch_buffer_handles_[n].node_idx == static_cast<int>(i)) {
+        uses_scratch_buffer = true;
+      }
+    }
+    bool is_constant = !uses_scratch_buffer;
+    bool has_input = false;
+    for (int n = 0; n < node->inputs->size && is_constant; ++n) {
+      const int tensor_index = node->inputs->data[n];
+      if (tensor_index == -1) {
+        continue;
+      }
+      has_input = true;
+      is_constant = IsConstantTensor(model, subgraph, node_and_registrations_,
+                           eval_tensors, tensor_index);
+    }
+    for (int n = 0; n < node->outputs->size && is_constant; ++n) {
+      const int tensor_index = node->outputs->data[n];
+      is_constant = !subgraph->tensors()->Get(tensor_index)->is_variable() &&
+                    !IsGraphOutput(subgraph, tensor_index) &&
+                    eval_tensors[tensor_index].data.data == nullptr;
+    }
+    if (!is_constant || !has_input) {
+      continue;
+    }
 
+    // The outputs are computed once, into buffers that outlive every
+    // invocation.
+    for (int n = 0; n < node->outputs->size; ++n) {
+      const int tensor_index = node->outputs->data[n];
+      size_t bytes;
+      TF_LITE_ENSURE_STATUS(
+          TfLiteEvalTensorByteLength(&eval_tensors[tensor_index], &bytes));
+      void* data = memory_allocator_->AllocateFromTail(bytes, kBufferAlignment);
+      if (data == nullptr) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Failed to allocate memory for folded tensor %d",
+                             tensor_index);
+        return kTfLiteError;
+      }
+      eval_tensors[tensor_index].data.data = data;
+      context->tensors[tensor_index].data.data = data;
+    }
+    if (registration->invoke(context, node) != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_, "Failed to fold node %d", i);
+      return kTfLiteError;
+    }
+    // The outputs are kept so that later nodes find their producer.
+    node->inputs = const_cast<TfLiteIntArray*>(&kZeroLengthIntArray);
+    node_and_registrations_[i].registration = &kFoldedNodeRegistration;
+    ++*folded_count;
+  }
   return kTfLiteOk;
 }
 
-TfLiteStatus MicroAllocator::FinishModelAllocation(const Model* model,
-                                                   TfLiteContext* context) {
+TfLiteStatus MicroAllocator::FinishModelAllocation(
+    const Model* model, TfLiteContext* context,
+    TfLiteEvalTensor* eval_tensors) {
   if (!model_is_allocating_) {
     TF_LITE_REPORT_ERROR(error_reporter_,
                          "MicroAllocator: Model allocation finished before "
@@ -491,16 +1483,133 @@ TfLiteStatus MicroAllocator::FinishModelAllocation(const Model* model,
   const SubGraph* subgraph = GetSubGraphFromModel(model);
   TFLITE_DCHECK(subgraph != nullptr);
 
-  TF_LITE_ENSURE_STATUS(CommitStaticMemoryPlan(context, subgraph));
   TF_LITE_ENSURE_STATUS(AllocateVariables(context, subgraph));
+  // Weights, variables, caller-owned and streamed buffers are known by now,
+  // only the buffers of the memory plan are missing.
+  for (size_t i = 0; i < context->tensors_size; ++i) {
+    eval_tensors[i].data = context->tensors[i].data;
+  }
+  TF_LITE_ENSURE_STATUS(
+      CommitStaticMemoryPlan(model, context, subgraph, eval_tensors));
+  if (kKeepTfLiteTensors) {
+    for (size_t i = 0; i < context->tensors_size; ++i) {
+      context->tensors[i].data = eval_tensors[i].data;
+    }
+  } else {
+    // The TfLiteTensors were temp allocations, which the plan reuses.
+    context->tensors = nullptr;
+  }
 
   model_is_allocating_ = false;
   return kTfLiteOk;
 }
 
+TfLiteTensor* MicroAllocator::AllocatePersistentTfLiteTensor(
+    const Model* model, const TfLiteEvalTensor* eval_tensors,
+    int tensor_index) {
+  TfLiteTensor* tensor =
+      reinterpret_cast<TfLiteTensor*>(memory_allocator_->AllocateFromTail(
+          sizeof(TfLiteTensor), alignof(TfLiteTensor)));
+  if (tensor == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate memory for persistent tensor %d",
+                         tensor_index);
+    return nullptr;
+  }
+  if (PopulateTfLiteTensorFromEvalTensor(model, eval_tensors, tensor_index,
+                                         /*allocate_temp=*/false,
+                                         tensor) != kTfLiteOk) {
+    return nullptr;
+  }
+  return tensor;
+}
+
+TfLiteTensor* MicroAllocator::AllocateTempTfLiteTensor(
+    const Model* model, const TfLiteEvalTensor* eval_tensors,
+    int tensor_index) {
+  TfLiteTensor* tensor = reinterpret_cast<TfLiteTensor*>(
+      memory_allocator_->AllocateTemp(sizeof(TfLiteTensor),
+                                      alignof(TfLiteTensor)));
+  if (tensor == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate memory for temp tensor %d",
+                         tensor_index);
+    return nullptr;
+  }
+  if (PopulateTfLiteTensorFromEvalTensor(model, eval_tensors, tensor_index,
+                                         /*allocate_temp=*/true,
+                                         tensor) != kTfLiteOk) {
+    return nullptr;
+  }
+  return tensor;
+}
+
+TfLiteStatus MicroAllocator::AllocateTempTfLitePalette(
+    const Model* model, int tensor_index, const TfLitePalette** palette) {
+  *palette = nullptr;
+  const SubGraph* subgraph = GetSubGraphFromModel(model);
+  TF_LITE_ENSURE(error_reporter_, subgraph != nullptr);
+  const tflite::Tensor& flatbuffer_tensor =
+      *subgraph->tensors()->Get(tensor_index);
+  TfLiteType type;
+  size_t type_size;
+  TF_LITE_ENSURE_STATUS(
+      ConvertTensorType(flatbuffer_tensor.type(), &type, error_reporter_));
+  TF_LITE_ENSURE_STATUS(TfLiteTypeSizeOf(type, &type_size, error_reporter_));
+  return internal::InitializePaletteFromFlatbuffer(
+      memory_allocator_, /*allocate_temp=*/true, flatbuffer_tensor,
+      model->buffers(), type_size, error_reporter_, palette);
+}
+
+void MicroAllocator::ResetTempAllocations() {
+  memory_allocator_->ResetTempAllocations();
+}
+
+TfLiteStatus MicroAllocator::PopulateTfLiteTensorFromEvalTensor(
+    const Model* model, const TfLiteEvalTensor* eval_tensors, int tensor_index,
+    bool allocate_temp, TfLiteTensor* tensor) {
+  const SubGraph* subgraph = GetSubGraphFromModel(model);
+  TF_LITE_ENSURE(error_reporter_, subgraph != nullptr);
+  TF_LITE_ENSURE_STATUS(internal::InitializeTfLiteTensorFromFlatbuffer(
+      memory_allocator_, allocate_temp, *subgraph->tensors()->Get(tensor_index),
+      model->buffers(), error_reporter_, tensor));
+  const TfLiteEvalTensor& eval_tensor = eval_tensors[tensor_index];
+  tensor->data = eval_tensor.data;
+  if (tensor->dims != eval_tensor.dims) {
+    // E.g. the window of a streamed tensor (see MicroStreamingPlan).
+    size_t type_size;
+    TF_LITE_ENSURE_STATUS(
+        TfLiteTypeSizeOf(tensor->type, &type_size, error_reporter_));
+    tensor->dims = eval_tensor.dims;
+    tensor->bytes = ElementCount(*tensor->dims) * type_size;
+  }
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroAllocator::AllocatePersistentBuffer(size_t bytes,
                                                       void** ptr) {
-  uint8_t* data = memory_allocator_->AllocateFromTail(bytes, kBufferAlignment);
+  uint8_t* data = nullptr;
+  uint8_t* handles = reinterpret_cast<uint8_t*>(scratch_buffer_handles_);
+  if (handles == nullptr || handles != memory_allocator_->GetTail()) {
+    data = memory_allocator_->AllocateFromTail(bytes, kBufferAlignment);
+  } else {
+    // A kernel allocating in Prepare after an earlier node requested a scratch
+    // buffer. The handles have to stay contiguous at the tail, so the buffer
+    // takes their place and they move down below it.
+    const size_t handles_bytes =
+        sizeof(internal::ScratchBufferHandle) * scratch_buffer_count_;
+    uint8_t* buffer =
+        AlignPointerDown(handles + handles_bytes - bytes, kBufferAlignment);
+    uint8_t* moved_handles = AlignPointerDown(
+        buffer - handles_bytes, alignof(internal::ScratchBufferHandle));
+    if (memory_allocator_->AllocateFromTail(handles - moved_handles, 1) !=
+        nullptr) {
+      std::memmove(moved_handles, handles, handles_bytes);
+      scratch_buffer_handles_ =
+          reinterpret_cast<internal::ScratchBufferHandle*>(moved_handles);
+      data = buffer;
+    }
+  }
   if (data == nullptr) {
     TF_LITE_REPORT_ERROR(error_reporter_,
                          "Failed to allocate persistent buffer of size %d",
@@ -563,12 +1672,53 @@ size_t MicroAllocator::used_bytes() const {
   return memory_allocator_->GetUsedBytes();
 }
 
+uint8_t* MicroAllocator::arena_start() const {
+  return memory_allocator_->GetHead() - memory_allocator_->GetHeadUsedBytes();
+}
+
+uint8_t* MicroAllocator::arena_end() const {
+  return memory_allocator_->GetTail() + memory_allocator_->GetTailUsedBytes();
+}
+
+size_t MicroAllocator::persistent_bytes() const {
+  return memory_allocator_->GetTailUsedBytes();
+}
+
+TfLiteStatus MicroAllocator::AllocateTfLiteEvalTensors(
+    const Model* model, const SubGraph* subgraph,
+    TfLiteEvalTensor** eval_tensors) {
+  const size_t tensors_size = subgraph->tensors()->size();
+  TfLiteEvalTensor* tensors =
+      reinterpret_cast<TfLiteEvalTensor*>(memory_allocator_->AllocateFromTail(
+          sizeof(TfLiteEvalTensor) * tensors_size, alignof(TfLiteEvalTensor)));
+  if (tensors == nullptr) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter_,
+        "Failed to allocate memory for eval tensors, %d bytes required",
+        sizeof(TfLiteEvalTensor) * tensors_size);
+    return kTfLiteError;
+  }
+  for (size_t i = 0; i < tensors_size; ++i) {
+    TfLiteStatus status = internal::InitializeTfLiteEvalTensorFromFlatbuffer(
+        memory_allocator_, *subgraph->tensors()->Get(i), model->buffers(),
+        error_reporter_, &tensors[i]);
+    if (status != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Failed to initialize eval tensor %d", i);
+      return kTfLiteError;
+    }
+  }
+  *eval_tensors = tensors;
+  return kTfLiteOk;
+}
+
 TfLiteStatus MicroAllocator::AllocateTfLiteTensorArray(
     TfLiteContext* context, const SubGraph* subgraph) {
   context->tensors_size = subgraph->tensors()->size();
-  context->tensors =
-      reinterpret_cast<TfLiteTensor*>(memory_allocator_->AllocateFromTail(
-          sizeof(TfLiteTensor) * context->tensors_size, alignof(TfLiteTensor)));
+  context->tensors = reinterpret_cast<TfLiteTensor*>(
+      Allocate(memory_allocator_, !kKeepTfLiteTensors,
+               sizeof(TfLiteTensor) * context->tensors_size,
+               alignof(TfLiteTensor)));
   if (context->tensors == nullptr) {
     TF_LITE_REPORT_ERROR(
         error_reporter_,
@@ -580,17 +1730,20 @@ TfLiteStatus MicroAllocator::AllocateTfLiteTensorArray(
 }
 
 TfLiteStatus MicroAllocator::PopulateTfLiteTensorArrayFromFlatbuffer(
-    const Model* model, TfLiteContext* context, const SubGraph* subgraph) {
+    const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+    const TfLiteEvalTensor* eval_tensors) {
   // Initialize tensors in context_ using the flatbuffer for quantization data.
   for (size_t i = 0; i < subgraph->tensors()->size(); ++i) {
     TfLiteStatus status = internal::InitializeTfLiteTensorFromFlatbuffer(
-        memory_allocator_, *subgraph->tensors()->Get(i), model->buffers(),
-        error_reporter_, &context->tensors[i]);
+        memory_allocator_, !kKeepTfLiteTensors, *subgraph->tensors()->Get(i),
+        model->buffers(), error_reporter_, &context->tensors[i]);
     if (status != kTfLiteOk) {
       TF_LITE_REPORT_ERROR(error_reporter_, "Failed to initialize tensor %d",
                            i);
       return kTfLiteError;
     }
+    // Kernels that update a shape in prepare update the eval tensor as well.
+    context->tensors[i].dims = eval_tensors[i].dims;
   }
   return kTfLiteOk;
 }
@@ -722,10 +1875,11 @@ ErrorReporter* MicroAllocator::error_reporter() const {
 }
 
 TfLiteStatus MicroAllocator::InitGraphAndContextTensorData(
-    const Model* model, TfLiteContext* context, const SubGraph* subgraph) {
+    const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+    const TfLiteEvalTensor* eval_tensors) {
   TF_LITE_ENSURE_STATUS(AllocateTfLiteTensorArray(context, subgraph));
-  TF_LITE_ENSURE_STATUS(
-      PopulateTfLiteTensorArrayFromFlatbuffer(model, context, subgraph));
+  TF_LITE_ENSURE_STATUS(PopulateTfLiteTensorArrayFromFlatbuffer(
+      model, context, subgraph, eval_tensors));
   return kTfLiteOk;
 }
 
@@ -739,56 +1893,143 @@ const SubGraph* MicroAllocator::GetSubGraphFromModel(const Model* model) {
   return (*subgraphs)[0];
 }
 
-TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(TfLiteContext* context,
-                                                    const SubGraph* subgraph) {
+TfLiteStatus MicroAllocator::CommitStaticMemoryPlan(
+    const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+    TfLiteEvalTensor* eval_tensors) {
   // Create static memory plan
   // 1. Calculate AllocationInfo to know the lifetime of each tensor/buffer.
   // 2. Add them into the planner (such as the GreedyMemoryPlanner).
   // 3. Static memory planning using the planner.
   // 4. Set tensor/buffer pointers based on the offsets from the previous step.
+  // If the model carries an offline plan that covers every buffer, steps 2 and
+  // 3 are skipped and its offsets are used as they are.
+  // Outputs of shape-only ops (RESHAPE, EXPAND_DIMS, SQUEEZE) and of the
+  // nodes removed by SimplifyGraph() are not planned but share the buffer of
+  // their input, whose lifetime is extended instead. Tensors that only lived
+  // inside a chain of FuseConvPoolChains() or between the nodes of a pair
+  // removed by SimplifyGraph() are not planned at all, and neither are the
+  // persistent outputs of FoldConstantNodes().
   // Note that AllocationInfo is only needed for creating the plan. It will be
   // thrown away when the child allocator (tmp_allocator) goes out of scope.
+  // The child allocator works above the temp allocations, which hold the
+  // TfLiteTensors of the model. The plan itself may cover them, as nothing
+  // reads them once it is committed.
+
+  // A shared non-persistent section is planned from its start again, over the
+  // buffers of the models allocated before, and keeps the largest size.
+  size_t shared_head_bytes = 0;
+  if (share_non_persistent_memory_) {
+    shared_head_bytes = memory_allocator_->GetHeadUsedBytes();
+    memory_allocator_->ResetHead();
+  }
   {
-    SimpleMemoryAllocator tmp_allocator(error_reporter_,
-                                        memory_allocator_->GetHead(),
-                                        memory_allocator_->GetTail());
+    const size_t tmp_allocator_size = memory_allocator_->GetAvailableMemory();
+    uint8_t* tmp_allocator_buffer =
+        memory_allocator_->AllocateTemp(tmp_allocator_size, /*alignment=*/1);
+    TF_LITE_ENSURE(error_reporter_, tmp_allocator_buffer != nullptr);
+    SimpleMemoryAllocator tmp_allocator(error_reporter_, tmp_allocator_buffer,
+                                        tmp_allocator_size);
+
+    const int32_t* offline_offsets = nullptr;
+    TF_LITE_ENSURE_STATUS(GetOfflinePlannedOffsets(error_reporter_, model,
+                                                   subgraph, &offline_offsets));
 
     AllocationInfoBuilder builder(error_reporter_, &tmp_allocator);
     TF_LITE_ENSURE_STATUS(
         builder.Init(subgraph->tensors()->size(), scratch_buffer_count_));
-    TF_LITE_ENSURE_STATUS(builder.AddTensors(subgraph, context->tensors));
+    TF_LITE_ENSURE_STATUS(builder.AddTensors(subgraph, node_and_registrations_,
+                                             offline_offsets, context->tensors,
+                                             eval_tensors));
+    builder.AddAliases(model, subgraph, node_and_registrations_);
     TF_LITE_ENSURE_STATUS(builder.AddScratchBuffers(scratch_buffer_handles_));
     const AllocationInfo* allocation_info = builder.Finish();
 
-    // Remaining arena size that memory planner can use for calculating offsets.
-    size_t remaining_arena_size = tmp_allocator.GetAvailableMemory();
-    uint8_t* planner_arena =
-        tmp_allocator.AllocateFromHead(remaining_arena_size, /*alignment=*/1);
-    TF_LITE_ENSURE(error_reporter_, planner_arena != nullptr);
-    GreedyMemoryPlanner planner(planner_arena, remaining_arena_size);
-    TF_LITE_ENSURE_STATUS(
-        CreatePlan(error_reporter_, &planner, allocation_info, builder.Size()));
-
     size_t actual_available_arena_size =
-        memory_allocator_->GetAvailableMemory();
-    // Make sure we have enough arena size.
-    if (planner.GetMaximumMemorySize() > actual_available_arena_size) {
-      TF_LITE_REPORT_ERROR(
-          error_reporter_,
-          "Arena size is too small for activation buffers. Needed %d but only "
-          "%d was available.",
-          planner.GetMaximumMemorySize(), actual_available_arena_size);
-      return kTfLiteError;
+        memory_allocator_->GetTail() - memory_allocator_->GetHead();
+    if (offline_offsets != nullptr && verify_offline_plan_) {
+      TF_LITE_ENSURE_STATUS(VerifyOfflinePlan(error_reporter_, allocation_info,
+                                              builder.Size(),
+                                              actual_available_arena_size));
+    }
+
+    bool fully_offline_planned = offline_offsets != nullptr;
+    size_t offline_plan_size = 0;
+    for (size_t i = 0; i < builder.Size(); ++i) {
+      const AllocationInfo* current = &allocation_info[i];
+      if (!current->needs_allocating) {
+        continue;
+      }
+      if (current->offline_offset == -1) {
+        fully_offline_planned = false;
+        break;
+      }
+      const size_t end = current->offline_offset +
+                         AlignSizeUp(current->bytes, kBufferAlignment);
+      if (end > offline_plan_size) {
+        offline_plan_size = end;
+      }
     }
 
-    // Commit the plan.
-    TF_LITE_ENSURE_STATUS(CommitPlan(error_reporter_, &planner,
-                                     memory_allocator_->GetHead(),
-                                     allocation_info, builder.Size()));
+    size_t plan_size;
+    if (fully_offline_planned) {
+      plan_size = offline_plan_size;
+      if (plan_size > actual_available_arena_size) {
+        TF_LITE_REPORT_ERROR(
+            error_reporter_,
+            "Arena size is too small for activation buffers. Needed %d but "
+            "only %d was available.",
+            plan_size, actual_available_arena_size);
+        return kTfLiteError;
+      }
+      uint8_t* starting_point = memory_allocator_->GetHead();
+      for (size_t i = 0; i < builder.Size(); ++i) {
+        const AllocationInfo* current = &allocation_info[i];
+        if (current->needs_allocating) {
+          *current->output_ptr =
+              reinterpret_cast<void*>(starting_point + current->offline_offset);
+        }
+      }
+    } else {
+      // Remaining arena size that memory planner can use for calculating
+      // offsets.
+      size_t remaining_arena_size = tmp_allocator.GetAvailableMemory();
+      uint8_t* planner_arena =
+          tmp_allocator.AllocateFromHead(remaining_arena_size, /*alignment=*/1);
+      TF_LITE_ENSURE(error_reporter_, planner_arena != nullptr);
+      if (planner_type_ == MemoryPlannerType::kBranchAndBound) {
+        BranchAndBoundMemoryPlanner planner(planner_arena,
+                                            remaining_arena_size);
+        TF_LITE_ENSURE_STATUS(PlanAndCommit(
+            error_reporter_, &planner, allocation_info, builder.Size(),
+            memory_allocator_->GetHead(), actual_available_arena_size,
+            &plan_size));
+      } else {
+        GreedyMemoryPlanner planner(planner_arena, remaining_arena_size);
+        TF_LITE_ENSURE_STATUS(PlanAndCommit(
+            error_reporter_, &planner, allocation_info, builder.Size(),
+            memory_allocator_->GetHead(), actual_available_arena_size,
+            &plan_size));
+      }
+    }
+    CommitAliases(allocation_info, builder.Size());
+    for (size_t i = 0; i < subgraph->operators()->size(); ++i) {
+      const TfLiteNode& node = node_and_registrations_[i].node;
+      if (node_and_registrations_[i].registration ==
+              &kForwardingNodeRegistration &&
+          eval_tensors[node.outputs->data[0]].data.data !=
+              eval_tensors[node.inputs->data[0]].data.data) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Node %d was removed, but its output does not "
+                             "share the buffer of its input",
+                             i);
+        return kTfLiteError;
+      }
+    }
+    memory_allocator_->ResetTempAllocations();
     // Allocate the planned area, so the allocator knows it's used.
-    uint8_t* allocated_tensor_memory =
-        memory_allocator_->AllocateFromHead(planner.GetMaximumMemorySize(),
-                                            /*alignment=*/1);
+    uint8_t* allocated_tensor_memory = memory_allocator_->AllocateFromHead(
+        plan_size > shared_head_bytes ? plan_size : shared_head_bytes,
+        /*alignment=*/1);
     TF_LITE_ENSURE(error_reporter_, allocated_tensor_memory != nullptr);
   }
   return kTfLiteOk;
@@ -32,12 +32,26 @@ namespace tflite {
 namespace internal {
 
 // Sets up all of the data structure members for a TfLiteTensor based on the
-// contents of a serialized tensor in the flatbuffer.
+// contents of a serialized tensor in the flatbuffer. The quantization
+// parameters are allocated as temp allocations if `allocate_temp` is set, and
+// from the tail otherwise.
 TfLiteStatus InitializeTfLiteTensorFromFlatbuffer(
-    SimpleMemoryAllocator* allocator, const tflite::Tensor& flatbuffer_tensor,
+    SimpleMemoryAllocator* allocator, bool allocate_temp,
+    const tflite::Tensor& flatbuffer_tensor,
     const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
     ErrorReporter* error_reporter, TfLiteTensor* result);
 
+// Sets up a TfLiteEvalTensor based on the contents of a serialized tensor in
+// the flatbuffer. Only big-endian targets allocate, from the tail.
+TfLiteStatus InitializeTfLiteEvalTensorFromFlatbuffer(
+    SimpleMemoryAllocator* allocator, const tflite::Tensor& flatbuffer_tensor,
+    const flatbuffers::Vector<flatbuffers::Offset<Buffer>>* buffers,
+    ErrorReporter* error_reporter, TfLiteEvalTensor* result);
+
+// Returns whether a serialized tensor holds palettized weights (see
+// kernels/palettized.h), whose data are packed indices.
+bool IsPalettizedTensor(const tflite::Tensor& flatbuffer_tensor);
+
 // A handle tracking scratch buffer allocation. This handle is created by
 // `RequestScratchBufferInArena`. `data` field is populated in
 // `FinishTensorAllocation` after static memory planning.
@@ -62,6 +76,15 @@ typedef struct {
   const TfLiteRegistration* registration;
 } NodeAndRegistration;
 
+// Memory planner used for the non-persistent buffers of a model.
+enum class MemoryPlannerType {
+  // GreedyMemoryPlanner: first fit in descending size order.
+  kGreedy,
+  // BranchAndBoundMemoryPlanner: searches for a smaller arena than the greedy
+  // plan, at the cost of a slower AllocateTensors().
+  kBranchAndBound,
+};
+
 // Allocator responsible for allocating memory for all intermediate tensors
 // necessary to invoke a model.
 //
@@ -80,11 +103,24 @@ typedef struct {
 // ************** .memory_allocator->GetBuffer()
 // Tensors/Scratch buffers (head)
 // ************** .head_watermark
+// temp allocations
+// ************** .temp_watermark
 // unused memory
 // ************** .memory_allocator->GetBuffer() + ->GetMaxBufferSize()
 //                                               - ->GetDataSize()
 // persistent area (tail)
 // ************** .memory_allocator->GetBuffer() + ->GetMaxBufferSize()
+//
+// Every tensor of a model keeps a TfLiteEvalTensor (data, dims and type) in the
+// persistent area. The full TfLiteTensor structs and their quantization
+// parameters are only needed by the kernels' prepare functions: they are temp
+// allocations from StartModelAllocation() to FinishModelAllocation(), whose
+// memory plan then reuses their space. After that, a TfLiteTensor is only
+// built on request, either temporarily for a kernel that still reads
+// TfLiteTensors at invoke time (AllocateTempTfLiteTensor()) or for the
+// lifetime of the model for the interpreter API
+// (AllocatePersistentTfLiteTensor()). Under MICRO_RUNTIME, whose DynamicAgent
+// works on `context->tensors`, the TfLiteTensors stay in the persistent area.
 class MicroAllocator {
  public:
   // Creates a MicroAllocator instance from a given tensor arena. This arena
@@ -92,46 +128,112 @@ class MicroAllocator {
   // Note: Please use __declspec(align(16)) to make sure tensor_arena is 16
   // bytes aligned, otherwise some head room will be wasted.
   // TODO(b/157615197): Cleanup constructor + factory usage.
-  static MicroAllocator* Create(uint8_t* tensor_arena, size_t arena_size,
-                                ErrorReporter* error_reporter);
+  static MicroAllocator* Create(
+      uint8_t* tensor_arena, size_t arena_size, ErrorReporter* error_reporter,
+      MemoryPlannerType planner_type = MemoryPlannerType::kGreedy);
 
   // Creates a MicroAllocator instance using the provided SimpleMemoryAllocator
   // intance. This allocator instance will use the SimpleMemoryAllocator
   // instance to manage allocations internally.
-  static MicroAllocator* Create(SimpleMemoryAllocator* memory_allocator,
-                                ErrorReporter* error_reporter);
+  static MicroAllocator* Create(
+      SimpleMemoryAllocator* memory_allocator, ErrorReporter* error_reporter,
+      MemoryPlannerType planner_type = MemoryPlannerType::kGreedy);
 
   // Begin allocating internal resources required for model inference.
   // This method will run through the flatbuffer data supplied in the model to
-  // properly allocate tensor, node, and op registration data. This method is
-  // expected to be followed with a call to FinishModelAllocation() before
-  // resuming allocation with another model.
+  // properly allocate tensor, node, and op registration data. The
+  // TfLiteTensors in `context->tensors` are temporary and only valid until
+  // FinishModelAllocation(); `eval_tensors` lives as long as the allocator.
+  // This method is expected to be followed with a call to
+  // FinishModelAllocation() before resuming allocation with another model.
   TfLiteStatus StartModelAllocation(
       const Model* model, TfLiteContext* context,
       const MicroOpResolver& op_resolver,
-      NodeAndRegistration** node_and_registrations);
+      NodeAndRegistration** node_and_registrations,
+      TfLiteEvalTensor** eval_tensors);
+
+  // Fuses every CONV_2D whose output is only read by a MAX_POOL_2D, directly
+  // or through RESHAPE, EXPAND_DIMS and SQUEEZE ops, into one node that runs
+  // `registration` (ops::micro::Register_CONV_2D_MAX_POOL_2D()) and writes
+  // the pooled output only. The other nodes of the chain are left without a
+  // kernel, and the tensors between the conv and the pool without a buffer.
+  // Only non-overlapping pool windows over float32, int8 and int16
+  // activations are fused. Models with an offline memory plan are left as
+  // they are. Must be called after StartModelAllocation() and before the
+  // kernels are initialized. `fused_count` receives the number of fused
+  // chains.
+  TfLiteStatus FuseConvPoolChains(const Model* model,
+                                  const TfLiteRegistration* registration,
+                                  int* fused_count);
+
+  // Removes the nodes that leave the bytes of their input as they are:
+  // RESHAPE, EXPAND_DIMS, SQUEEZE, QUANTIZE to the scale and zero point of
+  // its input, and DEQUANTIZE followed by a QUANTIZE back to the same scale
+  // and zero point. Their output shares the buffer of the input instead of
+  // being written, so readers of the output see the same data under their own
+  // shape. Graph outputs, variables and models with an offline memory plan
+  // are left as they are. Must be called after StartModelAllocation() and
+  // before FuseConvPoolChains() and the kernels are initialized.
+  // `removed_count` receives the number of removed nodes.
+  TfLiteStatus SimplifyGraph(const Model* model, int* removed_count);
+
+  // Evaluates once every node whose inputs are all weights or outputs of
+  // other folded nodes, into persistent buffers, and removes it. Nodes that
+  // write a graph output or a variable, or use a scratch buffer, are kept.
+  // Must be called after the kernels are prepared and before
+  // FinishModelAllocation(). `folded_count` receives the number of folded
+  // nodes.
+  TfLiteStatus FoldConstantNodes(const Model* model, TfLiteContext* context,
+                                 TfLiteEvalTensor* eval_tensors,
+                                 int* folded_count);
 
   // Finish allocating internal resources required for model inference.
   // This method will plan non-persistent buffers and commit a memory plan to
   // the 'head' section of the memory arena. All variable tensor data will also
-  // be allocated. This method should be called after assigning model resources
-  // in StartModelAllocation().
+  // be allocated. The data of the tensors is then only held by
+  // `eval_tensors`, and `context->tensors` is cleared. This method should be
+  // called after assigning model resources in StartModelAllocation().
   TfLiteStatus FinishModelAllocation(const Model* model,
-                                     TfLiteContext* context);
+                                     TfLiteContext* context,
+                                     TfLiteEvalTensor* eval_tensors);
+
+  // Builds the TfLiteTensor of tensor `tensor_index` from the flatbuffer and
+  // its eval tensor, in the persistent area. The tensor shares the data of
+  // the eval tensor, but is not updated when the eval tensor changes.
+  virtual TfLiteTensor* AllocatePersistentTfLiteTensor(
+      const Model* model, const TfLiteEvalTensor* eval_tensors,
+      int tensor_index);
+
+  // Same as AllocatePersistentTfLiteTensor(), as a temp allocation that is
+  // valid until the next ResetTempAllocations() call.
+  TfLiteTensor* AllocateTempTfLiteTensor(const Model* model,
+                                         const TfLiteEvalTensor* eval_tensors,
+                                         int tensor_index);
+
+  // Sets `palette` to the palette of tensor `tensor_index` (see
+  // kernels/palettized.h) as a temp allocation, or to null if the tensor
+  // stores its values. TfLiteTensor has no room for it, see
+  // TfLiteContext::GetTensorPalette.
+  TfLiteStatus AllocateTempTfLitePalette(const Model* model, int tensor_index,
+                                         const TfLitePalette** palette);
+
+  // Frees all temp allocations, see AllocateTempTfLiteTensor().
+  void ResetTempAllocations();
 
   // Allocates persistent buffer which has the same life time as the allocator.
   // The memory is immediately available and is allocated from the tail of the
   // arena.
-  TfLiteStatus AllocatePersistentBuffer(size_t bytes, void** ptr);
+  virtual TfLiteStatus AllocatePersistentBuffer(size_t bytes, void** ptr);
 
   // Register a scratch buffer of size `bytes` for Node with `node_id`.
   // This method only allocates a BufferHandle holding information for memory
   // planning. The buffer ptr is ready after `FinishTensorAllocation` and can
   // be retrieved by `GetScratchBuffer` method using the returned buffer_idx.
   // Note that there should be no tail allocation between two consecutive
-  // `RequestScratchBufferInArena` calls.
-  TfLiteStatus RequestScratchBufferInArena(int node_id, size_t bytes,
-                                           int* buffer_idx);
+  // `RequestScratchBufferInArena` calls other than AllocatePersistentBuffer,
+  // which moves the handles below the new buffer.
+  virtual TfLiteStatus RequestScratchBufferInArena(int node_id, size_t bytes,
+                                                   int* buffer_idx);
   // Returns the pointer to the planned scratch buffer.
   void* GetScratchBuffer(int buffer_idx) const;
 
@@ -143,23 +245,61 @@ class MicroAllocator {
   // `FinishTensorAllocation`. Otherwise, it will return 0.
   size_t used_bytes() const;
 
+  // Bounds of the (aligned) arena. The persistent section of
+  // `persistent_bytes()` ends at arena_end() and holds everything allocated
+  // from the tail, including this allocator.
+  uint8_t* arena_start() const;
+  uint8_t* arena_end() const;
+  size_t persistent_bytes() const;
+
+  // Models may carry an offline memory plan in their "OfflineMemoryAllocation"
+  // metadata (see micro/tools/offline_memory_plan.cc). When it covers every
+  // non-persistent buffer, the planner is skipped and the offsets are trusted
+  // as they are. With verification on, the offsets are first checked for
+  // overlapping lifetimes, alignment and arena bounds, which costs O(N^2).
+  void set_verify_offline_plan(bool verify) { verify_offline_plan_ = verify; }
+
+  // Lets the models allocated with this allocator share one non-persistent
+  // section. Each model plans its activation and scratch buffers from the
+  // start of the arena, over those of the models allocated before it, and
+  // the section keeps the size of the largest plan. The persistent sections
+  // of the models are stacked at the tail as usual.
+  // The models must then run one after another, and a model's non-persistent
+  // tensors are only valid while no other model runs: write its inputs right
+  // before and read its outputs right after it runs (see MicroModelScheduler),
+  // or bind them to caller-owned buffers with MicroInterpreter::SetInputBuffer
+  // and SetOutputBuffer. Under MICRO_RUNTIME, the dynamic agent cache takes
+  // the memory left free after AllocateTensors(), so only the model allocated
+  // last may enable it.
+  void set_share_non_persistent_memory(bool share) {
+    share_non_persistent_memory_ = share;
+  }
+
  protected:
   MicroAllocator(SimpleMemoryAllocator* memory_allocator,
-                 ErrorReporter* error_reporter);
+                 ErrorReporter* error_reporter,
+                 MemoryPlannerType planner_type = MemoryPlannerType::kGreedy);
   virtual ~MicroAllocator();
 
-  // Allocates an array in the arena to hold pointers to the tensors required
-  // to initialize and prepare a model. These allocations are stored and
-  // populated on the context.
+  // Allocates and populates the TfLiteEvalTensor of every tensor in the
+  // persistent area.
+  virtual TfLiteStatus AllocateTfLiteEvalTensors(
+      const Model* model, const SubGraph* subgraph,
+      TfLiteEvalTensor** eval_tensors);
+
+  // Allocates an array in the arena to hold the tensors required to
+  // initialize and prepare a model. These allocations are stored on the
+  // context, as temp allocations.
   virtual TfLiteStatus AllocateTfLiteTensorArray(TfLiteContext* context,
                                                  const SubGraph* subgraph);
 
-  // Populates content on the list of tensor pointers required to initialize and
+  // Populates content on the list of tensors required to initialize and
   // prepare a model from data in the flatbuffer (loaded from the TfLiteModel
-  // instance). Persistent data (e.g. quantization params) is allocated from the
-  // arena.
+  // instance). The tensors share the dims of `eval_tensors`. Their
+  // quantization params are temp allocations as well.
   virtual TfLiteStatus PopulateTfLiteTensorArrayFromFlatbuffer(
-      const Model* model, TfLiteContext* context, const SubGraph* subgraph);
+      const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+      const TfLiteEvalTensor* eval_tensors);
 
   // Allocates an array in the arena to hold pointers to the node and
   // registration pointers required to represent the inference graph of the
@@ -180,27 +320,39 @@ class MicroAllocator {
   virtual TfLiteStatus AllocateVariables(TfLiteContext* context,
                                          const SubGraph* subgraph);
 
+  // Commits a memory plan for all non-persistent buffer allocations in the
+  // 'head' section of the memory arena. Offsets from an offline plan in the
+  // model metadata are used as they are (see set_verify_offline_plan()).
+  virtual TfLiteStatus CommitStaticMemoryPlan(const Model* model,
+                                              TfLiteContext* context,
+                                              const SubGraph* subgraph,
+                                              TfLiteEvalTensor* eval_tensors);
+
   ErrorReporter* error_reporter() const;
 
  private:
   // Initializes the graph and allocates TfLiteContext tensor data.
-  TfLiteStatus InitGraphAndContextTensorData(const Model* model,
-                                             TfLiteContext* context,
-                                             const SubGraph* subgraph);
+  TfLiteStatus InitGraphAndContextTensorData(
+      const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+      const TfLiteEvalTensor* eval_tensors);
+
+  // Fills in `tensor` from the flatbuffer and the eval tensor of
+  // `tensor_index`, see AllocatePersistentTfLiteTensor().
+  TfLiteStatus PopulateTfLiteTensorFromEvalTensor(
+      const Model* model, const TfLiteEvalTensor* eval_tensors,
+      int tensor_index, bool allocate_temp, TfLiteTensor* tensor);
 
   // Returns the first subgraph from the model.
   const SubGraph* GetSubGraphFromModel(const Model* model);
 
-  // Commits a memory plan for all non-persistent buffer allocations in the
-  // 'head' section of the memory arena.
-  virtual TfLiteStatus CommitStaticMemoryPlan(TfLiteContext* context,
-                                              const SubGraph* subgraph);
-
   // A simple memory allocator that always allocate from the arena tail or head.
   SimpleMemoryAllocator* memory_allocator_;
 
   ErrorReporter* error_reporter_;
   bool model_is_allocating_;
+  // Nodes of the model being allocated, whose inputs and outputs give the
+  // lifetimes of the tensors.
+  NodeAndRegistration* node_and_registrations_ = nullptr;
 
   // In reverse order for efficiency.
   // i.e. scratch_buffer_handles_[0] is the handle for the last buffer,
@@ -209,6 +361,11 @@ class MicroAllocator {
   // How many scratch buffers have been allocated.
   size_t scratch_buffer_count_ = 0;
 
+  bool verify_offline_plan_ = false;
+  bool share_non_persistent_memory_ = false;
+
+  MemoryPlannerType planner_type_;
+
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
@@ -0,0 +1,189 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_aot_runtime.h"
+
+#include <cstdarg>
+
+#include "tensorflow/lite/micro/memory_helpers.h"
+
+namespace tflite {
+namespace {
+
+// Same alignment as the persistent buffers of MicroAllocator.
+constexpr size_t kBufferAlignment = 16;
+
+}  // namespace
+
+void AotInitTensor(TfLiteTensor* tensor, TfLiteType type,
+                   TfLiteAllocationType allocation_type, void* data,
+                   size_t bytes, TfLiteIntArray* dims) {
+  *tensor = {};
+  tensor->type = type;
+  tensor->allocation_type = allocation_type;
+  tensor->data.data = data;
+  tensor->bytes = bytes;
+  tensor->dims = dims;
+}
+
+void AotSetQuantization(TfLiteTensor* tensor,
+                        TfLiteAffineQuantization* quantization,
+                        TfLiteFloatArray* scale, TfLiteIntArray* zero_point,
+                        int32_t quantized_dimension) {
+  quantization->scale = scale;
+  quantization->zero_point = zero_point;
+  quantization->quantized_dimension = quantized_dimension;
+  tensor->params.scale = scale->data[0];
+  tensor->params.zero_point = zero_point->data[0];
+  tensor->quantization = {kTfLiteAffineQuantization, quantization};
+}
+
+MicroAotRuntime::MicroAotRuntime(TfLiteTensor* tensors, size_t tensors_size,
+                                 uint8_t* arena,
+                                 AotScratchBuffer* scratch_buffers,
+                                 int scratch_buffers_size, uint8_t* persistent,
+                                 size_t persistent_size,
+                                 ErrorReporter* error_reporter)
+    : arena_(arena),
+      scratch_buffers_(scratch_buffers),
+      scratch_buffers_size_(scratch_buffers_size),
+      persistent_(persistent),
+      persistent_size_(persistent_size),
+      error_reporter_(error_reporter) {
+  context_.impl_ = static_cast<void*>(this);
+  context_.ReportError = ReportOpError;
+  context_.tensors = tensors;
+  context_.tensors_size = tensors_size;
+  context_.recommended_num_threads = 1;
+}
+
+TfLiteStatus MicroAotRuntime::Prepare(
+    TfLiteNode* nodes, const TfLiteRegistration* const* registrations,
+    int nodes_size) {
+  void* raw;
+  TF_LITE_ENSURE_STATUS(AllocatePersistentBuffer(
+      &context_, sizeof(TfLiteEvalTensor) * context_.tensors_size, &raw));
+  eval_tensors_ = static_cast<TfLiteEvalTensor*>(raw);
+  for (size_t i = 0; i < context_.tensors_size; ++i) {
+    eval_tensors_[i].data = context_.tensors[i].data;
+    eval_tensors_[i].dims = context_.tensors[i].dims;
+    eval_tensors_[i].type = context_.tensors[i].type;
+  }
+  context_.GetEvalTensor = GetEvalTensor;
+
+  // Same staging of the allocation callbacks as MicroInterpreter.
+  context_.AllocatePersistentBuffer = AllocatePersistentBuffer;
+  context_.RequestScratchBufferInArena = nullptr;
+  context_.GetScratchBuffer = nullptr;
+  for (int i = 0; i < nodes_size; ++i) {
+    if (registrations[i]->init) {
+      nodes[i].user_data = registrations[i]->init(
+          &context_, reinterpret_cast<const char*>(nodes[i].builtin_data), 0);
+    }
+  }
+
+  context_.RequestScratchBufferInArena = RequestScratchBufferInArena;
+  for (int i = 0; i < nodes_size; ++i) {
+    if (registrations[i]->prepare) {
+      TfLiteStatus prepare_status =
+          registrations[i]->prepare(&context_, &nodes[i]);
+      if (prepare_status != kTfLiteOk) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Node %d failed to prepare with status %d", i,
+                             prepare_status);
+        return kTfLiteError;
+      }
+    }
+  }
+
+  context_.AllocatePersistentBuffer = nullptr;
+  context_.RequestScratchBufferInArena = nullptr;
+  context_.GetScratchBuffer = GetScratchBuffer;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroAotRuntime::AllocatePersistentBuffer(TfLiteContext* ctx,
+                                                       size_t bytes,
+                                                       void** ptr) {
+  MicroAotRuntime* runtime = static_cast<MicroAotRuntime*>(ctx->impl_);
+  uint8_t* data =
+      AlignPointerUp(runtime->persistent_ + runtime->persistent_used_,
+                     kBufferAlignment);
+  const size_t used = (data - runtime->persistent_) + bytes;
+  if (used > runtime->persistent_size_) {
+    TF_LITE_REPORT_ERROR(runtime->error_reporter_,
+                         "Failed to allocate persistent buffer of size %d "
+                         "(%d of %d bytes used)",
+                         bytes, runtime->persistent_used_,
+                         runtime->persistent_size_);
+    return kTfLiteError;
+  }
+  runtime->persistent_used_ = used;
+  *ptr = data;
+  return kTfLiteOk;
+}
+
+TfLiteEvalTensor* MicroAotRuntime::GetEvalTensor(
+    const struct TfLiteContext* context, int tensor_idx) {
+  return &static_cast<MicroAotRuntime*>(context->impl_)
+              ->eval_tensors_[tensor_idx];
+}
+
+TfLiteStatus MicroAotRuntime::RequestScratchBufferInArena(TfLiteContext* ctx,
+                                                          size_t bytes,
+                                                          int* buffer_idx) {
+  MicroAotRuntime* runtime = static_cast<MicroAotRuntime*>(ctx->impl_);
+  const int index = runtime->scratch_buffers_requested_;
+  if (index >= runtime->scratch_buffers_size_) {
+    TF_LITE_REPORT_ERROR(runtime->error_reporter_,
+                         "Scratch buffer %d was not planned. %d buffers "
+                         "available.",
+                         index, runtime->scratch_buffers_size_);
+    return kTfLiteError;
+  }
+  AotScratchBuffer& buffer = runtime->scratch_buffers_[index];
+  if (runtime->arena_ == nullptr) {
+    buffer.offset = 0;
+    buffer.bytes = bytes;
+  } else if (bytes > buffer.bytes) {
+    TF_LITE_REPORT_ERROR(runtime->error_reporter_,
+                         "Scratch buffer %d needs %d bytes, %d were planned.",
+                         index, bytes, buffer.bytes);
+    return kTfLiteError;
+  }
+  runtime->scratch_buffers_requested_ = index + 1;
+  *buffer_idx = index;
+  return kTfLiteOk;
+}
+
+void* MicroAotRuntime::GetScratchBuffer(TfLiteContext* ctx, int buffer_idx) {
+  MicroAotRuntime* runtime = static_cast<MicroAotRuntime*>(ctx->impl_);
+  if (buffer_idx < 0 || buffer_idx >= runtime->scratch_buffers_requested_ ||
+      runtime->arena_ == nullptr) {
+    return nullptr;
+  }
+  return runtime->arena_ + runtime->scratch_buffers_[buffer_idx].offset;
+}
+
+void MicroAotRuntime::ReportOpError(struct TfLiteContext* context,
+                                    const char* format, ...) {
+  MicroAotRuntime* runtime = static_cast<MicroAotRuntime*>(context->impl_);
+  va_list args;
+  va_start(args, format);
+  runtime->error_reporter_->Report(format, args);
+  va_end(args);
+}
+
+}  // namespace tflite
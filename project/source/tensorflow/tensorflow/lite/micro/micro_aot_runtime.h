@@ -0,0 +1,121 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_AOT_RUNTIME_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_AOT_RUNTIME_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+
+namespace tflite {
+
+// Statically initialized TfLiteIntArray / TfLiteFloatArray of N elements.
+// They share the layout of the flexible array structs they stand in for.
+template <int N>
+struct AotIntArray {
+  int size;
+  int data[N];
+
+  TfLiteIntArray* array() { return reinterpret_cast<TfLiteIntArray*>(this); }
+};
+
+template <int N>
+struct AotFloatArray {
+  int size;
+  float data[N];
+
+  TfLiteFloatArray* array() {
+    return reinterpret_cast<TfLiteFloatArray*>(this);
+  }
+};
+
+// A scratch buffer placed in the arena by the AOT compiler.
+struct AotScratchBuffer {
+  uint32_t offset;
+  uint32_t bytes;
+};
+
+// Fills in `tensor` as MicroAllocator does for a tensor of the flatbuffer.
+void AotInitTensor(TfLiteTensor* tensor, TfLiteType type,
+                   TfLiteAllocationType allocation_type, void* data,
+                   size_t bytes, TfLiteIntArray* dims);
+
+// Attaches affine quantization parameters to `tensor`, using `quantization`
+// as storage. As in MicroAllocator, `tensor->params` holds the first channel.
+void AotSetQuantization(TfLiteTensor* tensor,
+                        TfLiteAffineQuantization* quantization,
+                        TfLiteFloatArray* scale, TfLiteIntArray* zero_point,
+                        int32_t quantized_dimension);
+
+// Minimal TfLiteContext for models that were compiled ahead of time by
+// micro/tools/aot_compiler.cc. The compiler emits the tensors, nodes and
+// builtin options of the graph as static C++ data and fixes the offset of
+// every activation and scratch buffer in the arena, so neither the flatbuffer,
+// an op resolver nor the memory planner is needed on the device. This class
+// only runs the init and prepare functions of the kernels once, handing out
+// persistent buffers from a static pool and scratch buffers at their planned
+// offsets; the generated Invoke() then calls the kernels directly.
+//
+// If `arena` is null, scratch buffer requests are recorded into
+// `scratch_buffers` instead of being checked against it. The compiler uses
+// this to size the scratch buffers and the persistent pool.
+class MicroAotRuntime {
+ public:
+  MicroAotRuntime(TfLiteTensor* tensors, size_t tensors_size, uint8_t* arena,
+                  AotScratchBuffer* scratch_buffers, int scratch_buffers_size,
+                  uint8_t* persistent, size_t persistent_size,
+                  ErrorReporter* error_reporter);
+
+  // Calls init and then prepare of every node, in execution order. The
+  // TfLiteEvalTensors of the kernels are allocated from the persistent pool
+  // first.
+  TfLiteStatus Prepare(TfLiteNode* nodes,
+                       const TfLiteRegistration* const* registrations,
+                       int nodes_size);
+
+  TfLiteContext* context() { return &context_; }
+
+  size_t persistent_used_bytes() const { return persistent_used_; }
+  int scratch_buffers_requested() const { return scratch_buffers_requested_; }
+
+ private:
+  static TfLiteStatus AllocatePersistentBuffer(TfLiteContext* ctx,
+                                               size_t bytes, void** ptr);
+  static TfLiteStatus RequestScratchBufferInArena(TfLiteContext* ctx,
+                                                  size_t bytes,
+                                                  int* buffer_idx);
+  static void* GetScratchBuffer(TfLiteContext* ctx, int buffer_idx);
+  static TfLiteEvalTensor* GetEvalTensor(const struct TfLiteContext* context,
+                                         int tensor_idx);
+  static void ReportOpError(struct TfLiteContext* context, const char* format,
+                            ...);
+
+  TfLiteContext context_ = {};
+  TfLiteEvalTensor* eval_tensors_ = nullptr;
+  uint8_t* arena_;
+  AotScratchBuffer* scratch_buffers_;
+  int scratch_buffers_size_;
+  int scratch_buffers_requested_ = 0;
+  uint8_t* persistent_;
+  size_t persistent_size_;
+  size_t persistent_used_ = 0;
+  ErrorReporter* error_reporter_;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_AOT_RUNTIME_H_
@@ -17,6 +17,7 @@ limitations under the License.
 #include <cstdarg>
 #include <cstddef>
 #include <cstdint>
+#include <cstring>
 
 #include "flatbuffers/flatbuffers.h"  // from @flatbuffers
 #include "tensorflow/lite/c/common.h"
@@ -25,11 +26,65 @@ limitations under the License.
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
 #include "tensorflow/lite/micro/micro_profiler.h"
+#include "tensorflow/lite/micro/micro_time.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 
 namespace tflite {
 namespace {
 
+// Same alignment as the buffers planned by MicroAllocator.
+constexpr size_t kBufferAlignment = 16;
+
+#ifndef MICRO_RUNTIME
+// "TFSS", in front of every snapshot written by SaveSnapshot().
+constexpr uint32_t kSnapshotMagic = 0x53534654;
+constexpr uint32_t kSnapshotVersion = 2;
+
+// A snapshot is this header, followed by the interpreter state and then the
+// persistent section of the arena. The checksum covers everything but itself.
+struct SnapshotHeader {
+  uint32_t magic;
+  uint32_t version;
+  uint64_t checksum;
+  uint32_t state_bytes;
+  uint32_t persistent_bytes;
+  uint32_t operators_size;
+  uintptr_t model;
+  uintptr_t interpreter;
+  uintptr_t arena_start;
+  uintptr_t arena_end;
+};
+
+// Fletcher-64 style checksum over 32-bit words (sums wrap at 2^32), which
+// costs little more than the memcpy of the snapshot, continuing from `sums`.
+// The words are read with memcpy, as the data may be unaligned.
+void UpdateChecksum(uint32_t sums[2], const uint8_t* data, size_t size) {
+  const size_t word_bytes = size - size % sizeof(uint32_t);
+  for (size_t i = 0; i < word_bytes; i += sizeof(uint32_t)) {
+    uint32_t word;
+    memcpy(&word, data + i, sizeof(word));
+    sums[0] += word;
+    sums[1] += sums[0];
+  }
+  for (size_t i = word_bytes; i < size; ++i) {
+    sums[0] += data[i];
+    sums[1] += sums[0];
+  }
+}
+
+uint64_t SnapshotChecksum(const SnapshotHeader& header, const uint8_t* state,
+                          const uint8_t* persistent) {
+  SnapshotHeader unchecked = header;
+  unchecked.checksum = 0;
+  uint32_t sums[2] = {0, 0};
+  UpdateChecksum(sums, reinterpret_cast<const uint8_t*>(&unchecked),
+                 sizeof(unchecked));
+  UpdateChecksum(sums, state, header.state_bytes);
+  UpdateChecksum(sums, persistent, header.persistent_bytes);
+  return (static_cast<uint64_t>(sums[1]) << 32) | sums[0];
+}
+#endif  // MICRO_RUNTIME
+
 const char* OpNameFromRegistration(const TfLiteRegistration* registration) {
   if (registration->builtin_code == BuiltinOperator_CUSTOM) {
     return registration->custom_name;
@@ -70,6 +125,27 @@ void ContextHelper::ReportOpError(struct TfLiteContext* context,
   va_end(args);
 }
 
+TfLiteTensor* ContextHelper::GetTensor(const struct TfLiteContext* context,
+                                       int tensor_idx) {
+  ContextHelper* helper = static_cast<ContextHelper*>(context->impl_);
+  return helper->allocator_->AllocateTempTfLiteTensor(
+      helper->model_, helper->eval_tensors_, tensor_idx);
+}
+
+TfLiteStatus ContextHelper::GetTensorPalette(
+    const struct TfLiteContext* context, int tensor_idx,
+    const TfLitePalette** palette) {
+  ContextHelper* helper = static_cast<ContextHelper*>(context->impl_);
+  return helper->allocator_->AllocateTempTfLitePalette(helper->model_,
+                                                       tensor_idx, palette);
+}
+
+TfLiteEvalTensor* ContextHelper::GetEvalTensor(
+    const struct TfLiteContext* context, int tensor_idx) {
+  ContextHelper* helper = static_cast<ContextHelper*>(context->impl_);
+  return &helper->eval_tensors_[tensor_idx];
+}
+
 }  // namespace internal
 
 MicroInterpreter::MicroInterpreter(const Model* model,
@@ -83,7 +159,7 @@ MicroInterpreter::MicroInterpreter(const Model* model,
       error_reporter_(error_reporter),
       allocator_(*MicroAllocator::Create(tensor_arena, tensor_arena_size,
                                          error_reporter)),
-      context_helper_(error_reporter_, &allocator_) {
+      context_helper_(error_reporter_, &allocator_, model_) {
   Init(profiler);
 }
 
@@ -96,7 +172,7 @@ MicroInterpreter::MicroInterpreter(const Model* model,
       op_resolver_(*op_resolver),
       error_reporter_(error_reporter),
       allocator_(*allocator),
-      context_helper_(error_reporter_, &allocator_) {
+      context_helper_(error_reporter_, &allocator_, model_) {
   Init(profiler);
 }
 
@@ -128,6 +204,9 @@ void MicroInterpreter::Init(tflite::Profiler* profiler) {
 
   context_.impl_ = static_cast<void*>(&context_helper_);
   context_.ReportError = context_helper_.ReportOpError;
+  context_.GetTensor = context_helper_.GetTensor;
+  context_.GetEvalTensor = context_helper_.GetEvalTensor;
+  context_.GetTensorPalette = context_helper_.GetTensorPalette;
   context_.recommended_num_threads = 1;
   context_.profiler = profiler;
 
@@ -147,6 +226,18 @@ void MicroInterpreter::CorrectTensorEndianness(TfLiteTensor* tensorCorr) {
   int32_t tensorSize = 1;
   for (int d = 0; d < tensorCorr->dims->size; ++d)
     tensorSize *= reinterpret_cast<const int32_t*>(tensorCorr->dims->data)[d];
+  // Sparse tensors hold the stored values only: a sparse dimension gives the
+  // count of everything before it.
+  if (tensorCorr->sparsity != nullptr) {
+    const TfLiteSparsity* sparsity = tensorCorr->sparsity;
+    tensorSize = 1;
+    for (int i = 0; i < sparsity->dim_metadata_size; ++i) {
+      const TfLiteDimensionMetadata& dim = sparsity->dim_metadata[i];
+      tensorSize = dim.format == kTfLiteDimDense
+                       ? tensorSize * dim.dense_size
+                       : dim.array_indices->size;
+    }
+  }
 
   switch (tensorCorr->type) {
     case TfLiteType::kTfLiteFloat32:
@@ -182,12 +273,27 @@ void MicroInterpreter::CorrectTensorDataEndianness(T* data, int32_t size) {
 
 TfLiteStatus MicroInterpreter::AllocateTensors() {
   if (allocator_.StartModelAllocation(model_, &context_, op_resolver_,
-                                      &node_and_registrations_) != kTfLiteOk) {
+                                      &node_and_registrations_,
+                                      &eval_tensors_) != kTfLiteOk) {
     TF_LITE_REPORT_ERROR(error_reporter_,
                          "Failed starting model allocation.\n");
     initialization_status_ = kTfLiteError;
     return kTfLiteError;
   }
+  context_helper_.SetTfLiteEvalTensors(eval_tensors_);
+  persistent_tensors_ = nullptr;
+
+  int removed_count = 0;
+  if (simplify_graph_) {
+    TF_LITE_ENSURE_OK(&context_,
+                      allocator_.SimplifyGraph(model_, &removed_count));
+  }
+  if (conv_pool_registration_ != nullptr) {
+    int fused_count;
+    TF_LITE_ENSURE_OK(&context_, allocator_.FuseConvPoolChains(
+                                     model_, conv_pool_registration_,
+                                     &fused_count));
+  }
 
   // If the system is big endian then convert weights from the flatbuffer from
   // little to big endian on startup so that it does not need to be done during
@@ -197,11 +303,30 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
   if (!FLATBUFFERS_LITTLEENDIAN) {
     for (size_t t = 0; t < tensors_size(); ++t) {
       TfLiteTensor* thisTensor = &context_.tensors[t];
-      if (thisTensor->allocation_type == kTfLiteMmapRo)
+      // Palettized tensors hold byte indices, and the allocator swaps their
+      // palette.
+      if (thisTensor->allocation_type == kTfLiteMmapRo &&
+          !internal::IsPalettizedTensor(*subgraph_->tensors()->Get(t)))
         CorrectTensorEndianness(thisTensor);
     }
   }
 
+  // Caller-owned buffers already have data, so the memory planner skips them.
+  for (int i = 0; i < buffer_bindings_size_; ++i) {
+    const BufferBinding& binding = buffer_bindings_[i];
+    TfLiteTensor* tensor = &context_.tensors[binding.tensor_index];
+    if (binding.bytes != tensor->bytes) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Buffer of %d bytes bound to tensor %d, which has "
+                           "%d bytes",
+                           binding.bytes, binding.tensor_index,
+                           tensor->bytes);
+      initialization_status_ = kTfLiteError;
+      return kTfLiteError;
+    }
+    tensor->data.data = binding.data;
+  }
+
   // Only allow AllocatePersistentBuffer in Init stage.
   context_.AllocatePersistentBuffer = context_helper_.AllocatePersistentBuffer;
   context_.RequestScratchBufferInArena = nullptr;
@@ -249,14 +374,40 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
   }
   context_helper_.SetNodeIndex(-1);
 
+  if (simplify_graph_) {
+    int folded_count;
+    TF_LITE_ENSURE_OK(&context_,
+                      allocator_.FoldConstantNodes(model_, &context_,
+                                                   eval_tensors_,
+                                                   &folded_count));
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Graph simplification removed %d and folded %d of "
+                         "%d nodes",
+                         removed_count, folded_count,
+                         static_cast<int>(operators_size()));
+  }
+
+  // Streamed activations must survive between invocations, so they are moved
+  // into persistent buffers before the non-persistent memory plan is made.
+  if (streaming_hop_ > 0) {
+    TF_LITE_ENSURE_OK(&context_,
+                      streaming_plan_.Init(&allocator_, error_reporter_,
+                                           &context_, eval_tensors_,
+                                           node_and_registrations_,
+                                           operators_size(), inputs().Get(0),
+                                           outputs().data(), outputs_size(),
+                                           streaming_time_axis_,
+                                           streaming_hop_));
+  }
+
   // Prepare is done, we're ready for Invoke. Memory allocation is no longer
   // allowed. Kernels can only fetch scratch buffers via GetScratchBuffer.
   context_.AllocatePersistentBuffer = nullptr;
   context_.RequestScratchBufferInArena = nullptr;
   context_.GetScratchBuffer = context_helper_.GetScratchBuffer;
 
-  TF_LITE_ENSURE_OK(&context_,
-                    allocator_.FinishModelAllocation(model_, &context_));
+  TF_LITE_ENSURE_OK(&context_, allocator_.FinishModelAllocation(
+                                   model_, &context_, eval_tensors_));
   tensors_allocated_ = true;
 
 #ifdef MICRO_RUNTIME
@@ -267,6 +418,12 @@ TfLiteStatus MicroInterpreter::AllocateTensors() {
     dynamic_agent_.RegisterCache(aligned_cache, aligned_size);
   }
   dynamic_agent_.Finalize(node_and_registrations_, operators_size());
+  // Fine-grained loading hands CONV_2D a part of its weights at a time, and
+  // only the kernel of the prebuilt library loads the rest, through
+  // LoadFromExternal(). The kernels built from source read whole tensors, so
+  // the agent loads the weights of a node whole or leaves them in flash.
+  // Finalize() turns it on, as IsFineGrainedOPSupport() does on the MT3620.
+  dynamic_agent_.SetFineGrainedEnable(false);
 #endif
   return kTfLiteOk;
 }
@@ -283,43 +440,353 @@ TfLiteStatus MicroInterpreter::Invoke() {
   if (!tensors_allocated_) {
     TF_LITE_ENSURE_OK(&context_, AllocateTensors());
   }
+  if (streaming_plan_.enabled()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "The streaming caches do not hold the whole window, "
+                         "use InvokeStreaming()\n");
+    return kTfLiteError;
+  }
 
   for (size_t i = 0; i < operators_size(); ++i) {
-    auto* node = &(node_and_registrations_[i].node);
-    auto* registration = node_and_registrations_[i].registration;
+    TF_LITE_ENSURE_OK(&context_, InvokeNode(i));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::EnableStreaming(int hop, int time_axis) {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "EnableStreaming() must precede AllocateTensors()\n");
+    return kTfLiteError;
+  }
+  if (conv_pool_registration_ != nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Streaming cannot be combined with conv/pool "
+                         "fusion\n");
+    return kTfLiteError;
+  }
+  if (simplify_graph_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Streaming cannot be combined with graph "
+                         "simplification\n");
+    return kTfLiteError;
+  }
+  streaming_hop_ = hop;
+  streaming_time_axis_ = time_axis;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::EnableConvPoolFusion(
+    const TfLiteRegistration* registration) {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter_,
+        "EnableConvPoolFusion() must precede AllocateTensors()\n");
+    return kTfLiteError;
+  }
+  if (streaming_hop_ > 0) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Streaming cannot be combined with conv/pool "
+                         "fusion\n");
+    return kTfLiteError;
+  }
+  conv_pool_registration_ = registration;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::EnableGraphSimplification() {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter_,
+        "EnableGraphSimplification() must precede AllocateTensors()\n");
+    return kTfLiteError;
+  }
+  if (streaming_hop_ > 0) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Streaming cannot be combined with graph "
+                         "simplification\n");
+    return kTfLiteError;
+  }
+  simplify_graph_ = true;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::SetNumThreads(int num_threads) {
+  if (tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "SetNumThreads() must precede AllocateTensors()\n");
+    return kTfLiteError;
+  }
+  if (num_threads < 1) {
+    TF_LITE_REPORT_ERROR(error_reporter_, "Invalid thread count %d\n",
+                         num_threads);
+    return kTfLiteError;
+  }
+  context_.recommended_num_threads = num_threads;
+  return kTfLiteOk;
+}
+
+size_t MicroInterpreter::removed_operators_size() const {
+  size_t removed = 0;
+  for (size_t i = 0; i < operators_size(); ++i) {
+    if (node_and_registrations_[i].registration->invoke == nullptr) {
+      ++removed;
+    }
+  }
+  return removed;
+}
+
+TfLiteStatus MicroInterpreter::InvokeStreaming(const void* frames,
+                                               size_t frames_bytes) {
+  if (initialization_status_ != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Invoke() called after initialization failed\n");
+    return kTfLiteError;
+  }
+  if (!tensors_allocated_) {
+    TF_LITE_ENSURE_OK(&context_, AllocateTensors());
+  }
+  if (!streaming_plan_.enabled()) {
+    TF_LITE_REPORT_ERROR(
+        error_reporter_, "InvokeStreaming() called without EnableStreaming()\n");
+    return kTfLiteError;
+  }
+  if (frames_bytes != streaming_plan_.hop_bytes()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "InvokeStreaming() got %d bytes of frames, the hop "
+                         "of %d frames is %d bytes\n",
+                         static_cast<int>(frames_bytes),
+                         streaming_plan_.hop(),
+                         static_cast<int>(streaming_plan_.hop_bytes()));
+    return kTfLiteError;
+  }
+
+  if (!streaming_plan_.primed()) {
+    // Fill the caches from a window of zeros, the frames that were never
+    // pushed, with the same tail updates as below.
+    streaming_plan_.ClearInput();
+    for (int i = 0; i < streaming_plan_.prime_passes(); ++i) {
+      TF_LITE_ENSURE_OK(&context_, InvokeStreamingPass());
+    }
+    streaming_plan_.set_primed(true);
+  }
+  streaming_plan_.PushInputFrames(frames);
+  return InvokeStreamingPass();
+}
+
+TfLiteStatus MicroInterpreter::InvokeStreamingPass() {
+  for (size_t i = 0; i < operators_size(); ++i) {
+    if (streaming_plan_.IsTailNode(i)) {
+      streaming_plan_.BeginTailNode(i);
+      TfLiteStatus invoke_status = InvokeNode(i);
+      streaming_plan_.EndTailNode(i);
+      if (invoke_status != kTfLiteOk) {
+        // A partial update leaves the caches out of sync with the input.
+        streaming_plan_.set_primed(false);
+        return invoke_status;
+      }
+    } else {
+      TF_LITE_ENSURE_OK(&context_, InvokeNode(i));
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroInterpreter::InvokeNode(size_t i) {
+  auto* node = &(node_and_registrations_[i].node);
+  auto* registration = node_and_registrations_[i].registration;
+
+  if (registration->invoke) {
+    TfLiteStatus invoke_status;
+#ifdef TF_LITE_MICRO_PROFILE  // Omit profiler overhead unless requested.
+    tflite::Profiler* profiler =
+        reinterpret_cast<tflite::Profiler*>(context_.profiler);
+    uint32_t event_handle = 0;
+    if (profiler != nullptr) {
+      event_handle = profiler->BeginEvent(
+          OpNameFromRegistration(registration),
+          Profiler::EventType::OPERATOR_INVOKE_EVENT, i);
+    }
+#endif
 
-    if (registration->invoke) {
-      TfLiteStatus invoke_status;
-#ifndef NDEBUG  // Omit profiler overhead from release builds.
-      // The case where profiler == nullptr is handled by ScopedOperatorProfile.
-      tflite::Profiler* profiler =
-          reinterpret_cast<tflite::Profiler*>(context_.profiler);
-      ScopedOperatorProfile scoped_profiler(
-          profiler, OpNameFromRegistration(registration), i);
+#ifdef MICRO_RUNTIME
+    int32_t start_ticks = GetCurrentTimeTicks();
+    dynamic_agent_.MicroRuntimePreprocess(i);
+    // The agent moves the inputs it loads, e.g. weights into its cache, in
+    // context_.tensors only.
+    SyncEvalTensorData(node->inputs);
+    const int32_t preprocess_ticks = GetCurrentTimeTicks() - start_ticks;
+    invoke_status = registration->invoke(&context_, node);
+    start_ticks = GetCurrentTimeTicks();
+    dynamic_agent_.MicroRuntimePostprocess(i);
+    SyncEvalTensorData(node->inputs);
+    const int32_t postprocess_ticks = GetCurrentTimeTicks() - start_ticks;
+#else
+    invoke_status = registration->invoke(&context_, node);
 #endif
+    // TfLiteTensors fetched by the kernel through GetTensor() are dropped.
+    allocator_.ResetTempAllocations();
 
+#ifdef TF_LITE_MICRO_PROFILE
+    if (profiler != nullptr) {
 #ifdef MICRO_RUNTIME
-      dynamic_agent_.MicroRuntimePreprocess(i);
-      invoke_status = registration->invoke(&context_, node);
-      dynamic_agent_.MicroRuntimePostprocess(i);
+      // The DynamicAgent time is reported as the event metadata.
+      profiler->EndEvent(event_handle, preprocess_ticks, postprocess_ticks);
 #else
-      invoke_status = registration->invoke(&context_, node);
+      profiler->EndEvent(event_handle);
+#endif
+    }
 #endif
 
-      if (invoke_status == kTfLiteError) {
-        TF_LITE_REPORT_ERROR(
-            error_reporter_,
-            "Node %s (number %d) failed to invoke with status %d",
-            OpNameFromRegistration(registration), i, invoke_status);
+    if (invoke_status == kTfLiteError) {
+      TF_LITE_REPORT_ERROR(
+          error_reporter_,
+          "Node %s (number %d) failed to invoke with status %d",
+          OpNameFromRegistration(registration), i, invoke_status);
+      return kTfLiteError;
+    } else if (invoke_status != kTfLiteOk) {
+      return invoke_status;
+    }
+  }
+  return kTfLiteOk;
+}
+
+#ifdef MICRO_RUNTIME
+void MicroInterpreter::SyncEvalTensorData(
+    const TfLiteIntArray* tensor_indices) {
+  for (int i = 0; i < tensor_indices->size; ++i) {
+    const int tensor_index = tensor_indices->data[i];
+    if (tensor_index >= 0) {
+      eval_tensors_[tensor_index].data = context_.tensors[tensor_index].data;
+    }
+  }
+}
+#endif  // MICRO_RUNTIME
+
+TfLiteStatus MicroInterpreter::SetInputBuffer(size_t index, void* data,
+                                              size_t bytes) {
+  if (index >= inputs_size()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Input index %d out of range (length is %d)", index,
+                         inputs_size());
+    return kTfLiteError;
+  }
+  return BindTensorBuffer(inputs().Get(index), data, bytes);
+}
+
+TfLiteStatus MicroInterpreter::SetOutputBuffer(size_t index, void* data,
+                                               size_t bytes) {
+  if (index >= outputs_size()) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Output index %d out of range (length is %d)", index,
+                         outputs_size());
+    return kTfLiteError;
+  }
+  return BindTensorBuffer(outputs().Get(index), data, bytes);
+}
+
+TfLiteStatus MicroInterpreter::BindTensorBuffer(int tensor_index, void* data,
+                                                size_t bytes) {
+  if (data == nullptr ||
+      reinterpret_cast<uintptr_t>(data) % kBufferAlignment != 0) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Buffer bound to tensor %d must be %d byte aligned",
+                         tensor_index, kBufferAlignment);
+    return kTfLiteError;
+  }
+  BufferBinding* binding = nullptr;
+  for (int i = 0; i < buffer_bindings_size_; ++i) {
+    if (buffer_bindings_[i].tensor_index == tensor_index) {
+      binding = &buffer_bindings_[i];
+    }
+  }
+
+  if (!tensors_allocated_) {
+    // Checked against the tensor size in AllocateTensors().
+    if (binding == nullptr) {
+      if (buffer_bindings_size_ >= kMaxBufferBindings) {
+        TF_LITE_REPORT_ERROR(error_reporter_,
+                             "Too many bound buffers (max is %d)",
+                             kMaxBufferBindings);
         return kTfLiteError;
-      } else if (invoke_status != kTfLiteOk) {
-        return invoke_status;
       }
+      binding = &buffer_bindings_[buffer_bindings_size_++];
+      binding->tensor_index = tensor_index;
+    }
+    binding->data = data;
+    binding->bytes = bytes;
+    return kTfLiteOk;
+  }
+
+  // The arena slot of a tensor that was not bound is shared with other
+  // tensors, so it cannot be moved out anymore.
+  if (binding == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Tensor %d was not bound before AllocateTensors()",
+                         tensor_index);
+    return kTfLiteError;
+  }
+  if (bytes != binding->bytes) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Buffer of %d bytes bound to tensor %d, which has "
+                         "%d bytes",
+                         bytes, tensor_index, binding->bytes);
+    return kTfLiteError;
+  }
+  // Outputs of shape-only ops may share the bound buffer, so every tensor
+  // that points at it moves along.
+  for (size_t i = 0; i < context_.tensors_size; ++i) {
+    if (eval_tensors_[i].data.data == binding->data) {
+      eval_tensors_[i].data.data = data;
+    }
+    if (context_.tensors != nullptr &&
+        context_.tensors[i].data.data == binding->data) {
+      context_.tensors[i].data.data = data;
+    }
+  }
+  for (PersistentTensor* persistent = persistent_tensors_;
+       persistent != nullptr; persistent = persistent->next) {
+    if (persistent->tensor->data.data == binding->data) {
+      persistent->tensor->data.data = data;
     }
   }
+  binding->data = data;
   return kTfLiteOk;
 }
 
+TfLiteTensor* MicroInterpreter::GetPersistentTensor(int tensor_index) {
+  if (context_.tensors != nullptr) {
+    return &context_.tensors[tensor_index];
+  }
+  if (!tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Tensor %d requested before AllocateTensors()",
+                         tensor_index);
+    return nullptr;
+  }
+  for (PersistentTensor* persistent = persistent_tensors_;
+       persistent != nullptr; persistent = persistent->next) {
+    if (persistent->tensor_index == tensor_index) {
+      return persistent->tensor;
+    }
+  }
+  void* raw;
+  if (allocator_.AllocatePersistentBuffer(sizeof(PersistentTensor), &raw) !=
+      kTfLiteOk) {
+    return nullptr;
+  }
+  PersistentTensor* persistent = reinterpret_cast<PersistentTensor*>(raw);
+  persistent->tensor = allocator_.AllocatePersistentTfLiteTensor(
+      model_, eval_tensors_, tensor_index);
+  if (persistent->tensor == nullptr) {
+    return nullptr;
+  }
+  persistent->tensor_index = tensor_index;
+  persistent->next = persistent_tensors_;
+  persistent_tensors_ = persistent;
+  return persistent->tensor;
+}
+
 TfLiteTensor* MicroInterpreter::input(size_t index) {
   const size_t length = inputs_size();
   if ((index < 0) || (index >= length)) {
@@ -328,7 +795,7 @@ TfLiteTensor* MicroInterpreter::input(size_t index) {
                          length);
     return nullptr;
   }
-  return &(context_.tensors[inputs().Get(index)]);
+  return GetPersistentTensor(inputs().Get(index));
 }
 
 TfLiteTensor* MicroInterpreter::output(size_t index) {
@@ -339,7 +806,7 @@ TfLiteTensor* MicroInterpreter::output(size_t index) {
                          length);
     return nullptr;
   }
-  return &(context_.tensors[outputs().Get(index)]);
+  return GetPersistentTensor(outputs().Get(index));
 }
 
 TfLiteTensor* MicroInterpreter::tensor(size_t index) {
@@ -350,15 +817,158 @@ TfLiteTensor* MicroInterpreter::tensor(size_t index) {
                          length);
     return nullptr;
   }
-  return &context_.tensors[index];
+  return GetPersistentTensor(index);
+}
+
+TfLiteStatus MicroInterpreter::SaveSnapshot(uint8_t* buffer,
+                                          size_t buffer_size,
+                                          size_t* snapshot_size) {
+#ifdef MICRO_RUNTIME
+  // The DynamicAgent state lives outside the arena and is not saved.
+  TF_LITE_REPORT_ERROR(error_reporter_,
+                       "Snapshots are not supported with MICRO_RUNTIME.");
+  return kTfLiteError;
+#else
+  if (!tensors_allocated_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "SaveSnapshot() called before AllocateTensors()");
+    return kTfLiteError;
+  }
+  const size_t persistent_bytes = allocator_.persistent_bytes();
+  *snapshot_size =
+      sizeof(SnapshotHeader) + sizeof(SnapshotState) + persistent_bytes;
+  if (buffer == nullptr) {
+    return kTfLiteOk;
+  }
+  if (buffer_size < *snapshot_size) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Snapshot needs %d bytes, buffer has %d",
+                         *snapshot_size, buffer_size);
+    return kTfLiteError;
+  }
+
+  SnapshotState state;
+  state.node_and_registrations = node_and_registrations_;
+  state.tensors = context_.tensors;
+  state.tensors_size = context_.tensors_size;
+  state.eval_tensors = eval_tensors_;
+  state.persistent_tensors = persistent_tensors_;
+  memcpy(state.buffer_bindings, buffer_bindings_, sizeof(buffer_bindings_));
+  state.buffer_bindings_size = buffer_bindings_size_;
+  state.streaming_hop = streaming_hop_;
+  state.streaming_time_axis = streaming_time_axis_;
+  state.streaming_plan = streaming_plan_;
+
+  SnapshotHeader header;
+  header.magic = kSnapshotMagic;
+  header.version = kSnapshotVersion;
+  header.state_bytes = sizeof(SnapshotState);
+  header.persistent_bytes = persistent_bytes;
+  header.operators_size = operators_size();
+  header.model = reinterpret_cast<uintptr_t>(model_);
+  header.interpreter = reinterpret_cast<uintptr_t>(this);
+  header.arena_start = reinterpret_cast<uintptr_t>(allocator_.arena_start());
+  header.arena_end = reinterpret_cast<uintptr_t>(allocator_.arena_end());
+  const uint8_t* persistent = allocator_.arena_end() - persistent_bytes;
+  header.checksum = SnapshotChecksum(
+      header, reinterpret_cast<const uint8_t*>(&state), persistent);
+
+  memcpy(buffer, &header, sizeof(header));
+  memcpy(buffer + sizeof(header), &state, sizeof(state));
+  memcpy(buffer + sizeof(header) + sizeof(state), persistent,
+         persistent_bytes);
+  return kTfLiteOk;
+#endif  // MICRO_RUNTIME
+}
+
+TfLiteStatus MicroInterpreter::RestoreSnapshot(const uint8_t* snapshot,
+                                             size_t snapshot_size) {
+#ifdef MICRO_RUNTIME
+  TF_LITE_REPORT_ERROR(error_reporter_,
+                       "Snapshots are not supported with MICRO_RUNTIME.");
+  return kTfLiteError;
+#else
+  if (initialization_status_ != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "RestoreSnapshot() called after initialization "
+                         "failed");
+    return kTfLiteError;
+  }
+  // The snapshot may sit unaligned in flash, so it is only read with memcpy.
+  SnapshotHeader header;
+  if (snapshot == nullptr || snapshot_size < sizeof(header)) {
+    TF_LITE_REPORT_ERROR(error_reporter_, "Snapshot is truncated");
+    return kTfLiteError;
+  }
+  memcpy(&header, snapshot, sizeof(header));
+  if (header.magic != kSnapshotMagic || header.version != kSnapshotVersion ||
+      header.state_bytes != sizeof(SnapshotState) ||
+      snapshot_size != sizeof(header) + header.state_bytes +
+                           header.persistent_bytes) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Snapshot format or size does not match");
+    return kTfLiteError;
+  }
+  uint8_t* arena_start = allocator_.arena_start();
+  uint8_t* arena_end = allocator_.arena_end();
+  if (header.model != reinterpret_cast<uintptr_t>(model_) ||
+      header.interpreter != reinterpret_cast<uintptr_t>(this) ||
+      header.arena_start != reinterpret_cast<uintptr_t>(arena_start) ||
+      header.arena_end != reinterpret_cast<uintptr_t>(arena_end) ||
+      header.operators_size != operators_size() ||
+      header.persistent_bytes >
+          static_cast<size_t>(arena_end - arena_start)) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Snapshot was taken for another model, arena or "
+                         "interpreter");
+    return kTfLiteError;
+  }
+  const uint8_t* state_data = snapshot + sizeof(header);
+  const uint8_t* persistent = state_data + header.state_bytes;
+  if (SnapshotChecksum(header, state_data, persistent) != header.checksum) {
+    TF_LITE_REPORT_ERROR(error_reporter_, "Snapshot checksum mismatch");
+    return kTfLiteError;
+  }
+
+  // This also overwrites the allocators, which live in the persistent
+  // section, with their state after AllocateTensors().
+  memcpy(arena_end - header.persistent_bytes, persistent,
+         header.persistent_bytes);
+  SnapshotState state;
+  memcpy(&state, state_data, sizeof(state));
+  node_and_registrations_ = state.node_and_registrations;
+  context_.tensors = state.tensors;
+  context_.tensors_size = state.tensors_size;
+  eval_tensors_ = state.eval_tensors;
+  context_helper_.SetTfLiteEvalTensors(eval_tensors_);
+  persistent_tensors_ = state.persistent_tensors;
+  memcpy(buffer_bindings_, state.buffer_bindings, sizeof(buffer_bindings_));
+  buffer_bindings_size_ = state.buffer_bindings_size;
+  streaming_hop_ = state.streaming_hop;
+  streaming_time_axis_ = state.streaming_time_axis;
+  streaming_plan_ = state.streaming_plan;
+
+  context_.AllocatePersistentBuffer = nullptr;
+  context_.RequestScratchBufferInArena = nullptr;
+  context_.GetScratchBuffer = context_helper_.GetScratchBuffer;
+  tensors_allocated_ = true;
+  return kTfLiteOk;
+#endif  // MICRO_RUNTIME
 }
 
 TfLiteStatus MicroInterpreter::ResetVariableTensors() {
   const size_t length = tensors_size();
   for (size_t i = 0; i < length; ++i) {
-    TfLiteTensor* cur_tensor = tensor(i);
-    if (cur_tensor->is_variable) {
+    if (subgraph_->tensors()->Get(i)->is_variable()) {
+      TfLiteTensor* cur_tensor =
+          context_.tensors != nullptr
+              ? &context_.tensors[i]
+              : allocator_.AllocateTempTfLiteTensor(model_, eval_tensors_, i);
+      if (cur_tensor == nullptr) {
+        return kTfLiteError;
+      }
       TfLiteStatus status = tflite::ResetVariableTensor(cur_tensor);
+      allocator_.ResetTempAllocations();
       if (status != kTfLiteOk) {
         TF_LITE_REPORT_ERROR(error_reporter_,
                              "Failed to reset variable tensor at index: %d", i);
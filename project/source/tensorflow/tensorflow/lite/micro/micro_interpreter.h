@@ -25,6 +25,7 @@ limitations under the License.
 #include "tensorflow/lite/kernels/internal/tensor_ctypes.h"
 #include "tensorflow/lite/micro/micro_allocator.h"
 #include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/micro/micro_streaming.h"
 #include "tensorflow/lite/schema/schema_generated.h"
 #include "tensorflow/lite/type_to_tflitetype.h"
 
@@ -43,8 +44,8 @@ namespace internal {
 class ContextHelper {
  public:
   explicit ContextHelper(ErrorReporter* error_reporter,
-                         MicroAllocator* allocator)
-      : allocator_(allocator), error_reporter_(error_reporter) {}
+                         MicroAllocator* allocator, const Model* model)
+      : allocator_(allocator), error_reporter_(error_reporter), model_(model) {}
 
   static TfLiteStatus AllocatePersistentBuffer(TfLiteContext* ctx, size_t bytes,
                                                void** ptr);
@@ -58,11 +59,29 @@ class ContextHelper {
   static void ReportOpError(struct TfLiteContext* context, const char* format,
                             ...);
 
+  // Returns a temp TfLiteTensor, valid until the node returns.
+  static TfLiteTensor* GetTensor(const struct TfLiteContext* context,
+                                 int tensor_idx);
+
+  static TfLiteEvalTensor* GetEvalTensor(const struct TfLiteContext* context,
+                                         int tensor_idx);
+
+  // Returns a temp palette, valid until the node returns.
+  static TfLiteStatus GetTensorPalette(const struct TfLiteContext* context,
+                                       int tensor_idx,
+                                       const TfLitePalette** palette);
+
   void SetNodeIndex(int idx) { current_node_idx_ = idx; }
 
+  void SetTfLiteEvalTensors(TfLiteEvalTensor* eval_tensors) {
+    eval_tensors_ = eval_tensors;
+  }
+
  private:
   MicroAllocator* allocator_;
   ErrorReporter* error_reporter_;
+  const Model* model_;
+  TfLiteEvalTensor* eval_tensors_ = nullptr;
   int current_node_idx_ = -1;
 };
 
@@ -102,6 +121,84 @@ class MicroInterpreter {
   // TODO(b/149795762): Add this to the TfLiteStatus enum.
   TfLiteStatus Invoke();
 
+  // Enables incremental execution of a sliding window over `time_axis` of
+  // input 0. Each InvokeStreaming() call shifts `hop` new frames into the input
+  // and only recomputes the activations that depend on them (see
+  // MicroStreamingPlan). Must be called before AllocateTensors(). The caches
+  // only keep the frames the next update needs, so Invoke() is no longer
+  // available and input(0) holds just the newest frames.
+  TfLiteStatus EnableStreaming(int hop, int time_axis = 1);
+
+  // Appends `hop` frames of input data, `frames_bytes` bytes of the input
+  // tensor's type, and runs the graph incrementally. The result is that of
+  // the whole window, with the frames that were never pushed reading as zero.
+  TfLiteStatus InvokeStreaming(const void* frames, size_t frames_bytes);
+
+  bool streaming_enabled() const { return streaming_hop_ > 0; }
+
+  // Runs every CONV_2D that only feeds a MAX_POOL_2D, possibly through
+  // shape-only ops, as one node that pools the conv outputs as it computes
+  // them, with `registration` as its kernel (usually
+  // tflite::ops::micro::Register_CONV_2D_MAX_POOL_2D(), which only binaries
+  // that enable the fusion link). The full resolution conv output then never
+  // takes arena memory (see MicroAllocator::FuseConvPoolChains()). Must be
+  // called before AllocateTensors(), and cannot be combined with streaming,
+  // whose caches hold full resolution conv outputs.
+  TfLiteStatus EnableConvPoolFusion(const TfLiteRegistration* registration);
+
+  // Drops the nodes that do not change the bytes of their input (shape-only
+  // ops and cancelling QUANTIZE/DEQUANTIZE) and evaluates the nodes whose
+  // inputs are all constant once at load time (see
+  // MicroAllocator::SimplifyGraph() and FoldConstantNodes()), then reports
+  // how many nodes were removed. The removed nodes keep their index but are
+  // passed over by Invoke(). Must be called before AllocateTensors(), and
+  // cannot be combined with streaming.
+  TfLiteStatus EnableGraphSimplification();
+
+  // Lets kernels split their work over `num_threads` threads, through
+  // TfLiteContext::recommended_num_threads. Only the host kernels in
+  // kernels/linux use more than one thread (FULLY_CONNECTED and CONV_2D), and
+  // only when built with TF_LITE_MICRO_HOST_THREADS; the results are
+  // bit-exact with a single thread. Must be called before
+  // AllocateTensors(), which sizes the per-thread scratch buffers.
+  TfLiteStatus SetNumThreads(int num_threads);
+
+  // Uses the caller-owned `data` as the buffer of input `index`, so that e.g.
+  // a DMA transfer can write the input in place instead of it being copied
+  // into the arena. `data` must be 16 byte aligned, hold exactly the `bytes`
+  // of the tensor and outlive the interpreter.
+  // Called before AllocateTensors(), the tensor is left out of the memory
+  // plan. Afterwards, only a tensor that was bound before AllocateTensors()
+  // can be moved to another buffer, e.g. to switch between DMA buffers.
+  TfLiteStatus SetInputBuffer(size_t index, void* data, size_t bytes);
+
+  // Same as SetInputBuffer(), for output `index`.
+  TfLiteStatus SetOutputBuffer(size_t index, void* data, size_t bytes);
+
+  // Writes the prepared state left by AllocateTensors() to `buffer`, to be
+  // kept e.g. in flash and handed to RestoreSnapshot() on the next boot. The
+  // snapshot is the persistent section of the arena (eval tensors, node
+  // registrations, kernel OpData, variables and streaming caches) plus the
+  // interpreter fields that point into it. With `buffer` set to nullptr, only
+  // the size is returned in `snapshot_size`.
+  //
+  // Snapshots are host-only for now: MICRO_RUNTIME builds, i.e. the
+  // NeuroPilot device runtime, fail both calls, as the DynamicAgent keeps
+  // state outside the arena that a snapshot cannot restore.
+  TfLiteStatus SaveSnapshot(uint8_t* buffer, size_t buffer_size,
+                            size_t* snapshot_size);
+
+  // Restores a snapshot taken by SaveSnapshot() in place of AllocateTensors(),
+  // or to re-initialize an allocated interpreter. The state holds raw
+  // pointers, so the snapshot is only valid for the same firmware image,
+  // model, arena and interpreter addresses; the addresses and a checksum of
+  // the snapshot are checked, the firmware image is not. The interpreter must own
+  // its arena, i.e. not share its allocator with another model.
+  TfLiteStatus RestoreSnapshot(const uint8_t* snapshot, size_t snapshot_size);
+
+  // The TfLiteTensors returned by tensor(), input() and output() are only
+  // available after AllocateTensors(). Each is allocated in the persistent
+  // section of the arena on first use.
   size_t tensors_size() const { return context_.tensors_size; }
   TfLiteTensor* tensor(size_t tensor_index);
   template <class T>
@@ -157,6 +254,10 @@ class MicroInterpreter {
   size_t operators_size() const { return subgraph_->operators()->size(); }
 #endif
 
+  // Number of nodes that Invoke() passes over because graph simplification
+  // or conv/pool fusion removed them. Only available after AllocateTensors().
+  size_t removed_operators_size() const;
+
   // For debugging only.
   const NodeAndRegistration node_and_registration(int node_index) const {
     return node_and_registrations_[node_index];
@@ -184,6 +285,24 @@ class MicroInterpreter {
 
   void CorrectTensorEndianness(TfLiteTensor* tensorCorr);
 
+  // Runs a single node, with profiling and runtime hooks.
+  TfLiteStatus InvokeNode(size_t node_index);
+  // Runs every node once, tail nodes only on their newest frames.
+  TfLiteStatus InvokeStreamingPass();
+
+  // Records or moves the caller-owned buffer of a tensor, see
+  // SetInputBuffer().
+  TfLiteStatus BindTensorBuffer(int tensor_index, void* data, size_t bytes);
+
+  // Returns the TfLiteTensor of `tensor_index` handed out to the caller.
+  TfLiteTensor* GetPersistentTensor(int tensor_index);
+
+#ifdef MICRO_RUNTIME
+  // Copies the data pointers the DynamicAgent set in the kept TfLiteTensors
+  // of `tensor_indices` to their TfLiteEvalTensors, which the kernels read.
+  void SyncEvalTensorData(const TfLiteIntArray* tensor_indices);
+#endif
+
   template <class T>
   void CorrectTensorDataEndianness(T* data, int32_t size);
 
@@ -194,12 +313,55 @@ class MicroInterpreter {
   ErrorReporter* error_reporter_;
   TfLiteContext context_ = {};
   MicroAllocator& allocator_;
-  bool tensors_allocated_;
+  bool tensors_allocated_ = false;
 
   TfLiteStatus initialization_status_;
 
   const SubGraph* subgraph_;
   internal::ContextHelper context_helper_;
+
+  TfLiteEvalTensor* eval_tensors_ = nullptr;
+
+  // TfLiteTensors handed out by tensor(), input() and output(), allocated
+  // on first use.
+  struct PersistentTensor {
+    int tensor_index;
+    TfLiteTensor* tensor;
+    PersistentTensor* next;
+  };
+  PersistentTensor* persistent_tensors_ = nullptr;
+
+  // Caller-owned buffers of input and output tensors.
+  struct BufferBinding {
+    int tensor_index;
+    void* data;
+    size_t bytes;
+  };
+  static constexpr int kMaxBufferBindings = 4;
+  BufferBinding buffer_bindings_[kMaxBufferBindings];
+  int buffer_bindings_size_ = 0;
+
+  int streaming_hop_ = 0;
+  int streaming_time_axis_ = 1;
+  MicroStreamingPlan streaming_plan_;
+
+  const TfLiteRegistration* conv_pool_registration_ = nullptr;
+  bool simplify_graph_ = false;
+
+  // Interpreter fields saved by SaveSnapshot() next to the arena.
+  struct SnapshotState {
+    NodeAndRegistration* node_and_registrations;
+    TfLiteTensor* tensors;
+    size_t tensors_size;
+    TfLiteEvalTensor* eval_tensors;
+    PersistentTensor* persistent_tensors;
+    BufferBinding buffer_bindings[kMaxBufferBindings];
+    int buffer_bindings_size;
+    int streaming_hop;
+    int streaming_time_axis;
+    MicroStreamingPlan streaming_plan;
+  };
+
 #ifdef MICRO_RUNTIME
   DynamicAgent dynamic_agent_;
 #endif
@@ -0,0 +1,91 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+#include "tensorflow/lite/micro/micro_model_scheduler.h"
+
+namespace tflite {
+
+MicroModelScheduler::MicroModelScheduler(ErrorReporter* error_reporter)
+    : error_reporter_(error_reporter), models_size_(0) {}
+
+TfLiteStatus MicroModelScheduler::AddModel(MicroInterpreter* interpreter,
+                                           ModelCallback fill_inputs,
+                                           ModelCallback read_outputs,
+                                           void* user_data, int* model_index) {
+  if (models_size_ >= kMaxModels) {
+    TF_LITE_REPORT_ERROR(error_reporter_, "Too many models (max is %d)",
+                         kMaxModels);
+    return kTfLiteError;
+  }
+  if (interpreter == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter_, "Model interpreter is null.");
+    return kTfLiteError;
+  }
+  ScheduledModel& model = models_[models_size_];
+  model.interpreter = interpreter;
+  model.fill_inputs = fill_inputs;
+  model.read_outputs = read_outputs;
+  model.user_data = user_data;
+  if (model_index != nullptr) {
+    *model_index = models_size_;
+  }
+  ++models_size_;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroModelScheduler::Invoke(int model_index, const void* frames,
+                                         size_t frames_bytes) {
+  if (model_index < 0 || model_index >= models_size_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Model index %d is outside range 0 to %d",
+                         model_index, models_size_);
+    return kTfLiteError;
+  }
+  const ScheduledModel& model = models_[model_index];
+  if (model.fill_inputs != nullptr) {
+    TF_LITE_ENSURE_STATUS(model.fill_inputs(model.interpreter, model.user_data));
+  }
+  if (model.interpreter->streaming_enabled()) {
+    if (frames == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Model %d is streaming and needs input frames.",
+                           model_index);
+      return kTfLiteError;
+    }
+    TF_LITE_ENSURE_STATUS(
+        model.interpreter->InvokeStreaming(frames, frames_bytes));
+  } else {
+    TF_LITE_ENSURE_STATUS(model.interpreter->Invoke());
+  }
+  if (model.read_outputs != nullptr) {
+    TF_LITE_ENSURE_STATUS(
+        model.read_outputs(model.interpreter, model.user_data));
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroModelScheduler::InvokeAll() {
+  for (int i = 0; i < models_size_; ++i) {
+    if (models_[i].interpreter->streaming_enabled()) {
+      TF_LITE_REPORT_ERROR(error_reporter_,
+                           "Model %d is streaming, run it with Invoke().", i);
+      return kTfLiteError;
+    }
+    TF_LITE_ENSURE_STATUS(Invoke(i));
+  }
+  return kTfLiteOk;
+}
+
+}  // namespace tflite
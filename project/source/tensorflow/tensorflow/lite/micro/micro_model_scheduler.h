@@ -0,0 +1,93 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_MODEL_SCHEDULER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_MODEL_SCHEDULER_H_
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+
+namespace tflite {
+
+// Runs several models, one at a time, that share the non-persistent section
+// of one tensor arena (see MicroAllocator::set_share_non_persistent_memory).
+//
+// Typical usage:
+//   MicroAllocator* allocator = MicroAllocator::Create(arena, arena_size,
+//                                                      error_reporter);
+//   allocator->set_share_non_persistent_memory(true);
+//   MicroInterpreter kws(kws_model, resolver, allocator, error_reporter);
+//   MicroInterpreter imu(imu_model, resolver, allocator, error_reporter);
+//   kws.AllocateTensors();
+//   imu.AllocateTensors();
+//   MicroModelScheduler scheduler(error_reporter);
+//   scheduler.AddModel(&kws, FillKwsInput, ReadKwsOutput, &kws_state);
+//   scheduler.AddModel(&imu, FillImuInput, ReadImuOutput, &imu_state);
+//   scheduler.InvokeAll();
+//
+// Another model overwrites the activations, so inputs are written by the
+// `fill_inputs` callback right before a model runs and outputs are read by
+// `read_outputs` right after it. Inputs and outputs bound to caller-owned
+// buffers with MicroInterpreter::SetInputBuffer() and SetOutputBuffer() stay
+// valid in between, and need no callback.
+// Models with streaming enabled run with InvokeStreaming(); their caches are
+// persistent and survive the other models.
+class MicroModelScheduler {
+ public:
+  // Called with the interpreter of the model and the `user_data` given to
+  // AddModel().
+  typedef TfLiteStatus (*ModelCallback)(MicroInterpreter* interpreter,
+                                        void* user_data);
+
+  static constexpr int kMaxModels = 8;
+
+  explicit MicroModelScheduler(ErrorReporter* error_reporter);
+
+  // Adds a model whose tensors are already allocated. Either callback may be
+  // nullptr. The index to pass to Invoke() is returned in `model_index`.
+  TfLiteStatus AddModel(MicroInterpreter* interpreter,
+                        ModelCallback fill_inputs, ModelCallback read_outputs,
+                        void* user_data, int* model_index = nullptr);
+
+  // Runs one model. `frames` holds the next hop of input frames of a
+  // streaming model, `frames_bytes` long, and is ignored otherwise.
+  TfLiteStatus Invoke(int model_index, const void* frames = nullptr,
+                      size_t frames_bytes = 0);
+
+  // Runs all the models in the order they were added. Streaming models must
+  // be run with Invoke() instead.
+  TfLiteStatus InvokeAll();
+
+  int models_size() const { return models_size_; }
+
+ private:
+  struct ScheduledModel {
+    MicroInterpreter* interpreter;
+    ModelCallback fill_inputs;
+    ModelCallback read_outputs;
+    void* user_data;
+  };
+
+  ErrorReporter* error_reporter_;
+  ScheduledModel models_[kMaxModels];
+  int models_size_;
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_MODEL_SCHEDULER_H_
@@ -15,10 +15,25 @@ limitations under the License.
 
 #include "tensorflow/lite/micro/micro_profiler.h"
 
+#include <cstring>
+
 #include "tensorflow/lite/kernels/internal/compatibility.h"
 #include "tensorflow/lite/micro/micro_time.h"
 
 namespace tflite {
+namespace {
+
+// Converts ticks to microseconds, or returns the ticks unchanged on platforms
+// without a timer frequency.
+int32_t TicksToMicros(int64_t ticks) {
+  const int32_t tps = ticks_per_second();
+  if (tps <= 0) {
+    return static_cast<int32_t>(ticks);
+  }
+  return static_cast<int32_t>(ticks * 1000000 / tps);
+}
+
+}  // namespace
 
 MicroProfiler::MicroProfiler(tflite::ErrorReporter* reporter)
     : reporter_(reporter) {}
@@ -26,16 +41,107 @@ MicroProfiler::MicroProfiler(tflite::ErrorReporter* reporter)
 uint32_t MicroProfiler::BeginEvent(const char* tag, EventType event_type,
                                    int64_t event_metadata1,
                                    int64_t event_metadata2) {
-  start_time_ = GetCurrentTimeTicks();
   TFLITE_DCHECK(tag != nullptr);
-  event_tag_ = tag;
-  return 0;
+  const uint32_t handle = next_handle_++;
+  Event& event = events_[handle % kMaxEvents];
+  event.tag = tag;
+  event.op_index = event_type == EventType::OPERATOR_INVOKE_EVENT
+                       ? static_cast<int32_t>(event_metadata1)
+                       : -1;
+  event.preprocess_ticks = 0;
+  event.postprocess_ticks = 0;
+  event.start_ticks = GetCurrentTimeTicks();
+  event.end_ticks = event.start_ticks;
+  return handle;
 }
 
 void MicroProfiler::EndEvent(uint32_t event_handle) {
-  int32_t end_time = GetCurrentTimeTicks();
-  TF_LITE_REPORT_ERROR(reporter_, "%s took %d cycles\n", event_tag_,
-                       end_time - start_time_);
+  EndEvent(event_handle, 0, 0);
+}
+
+void MicroProfiler::EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                             int64_t event_metadata2) {
+  const int32_t end_ticks = GetCurrentTimeTicks();
+  // Unsigned arithmetic keeps this correct when the handles wrap around.
+  if (next_handle_ - event_handle - 1 >= static_cast<uint32_t>(kMaxEvents)) {
+    return;
+  }
+  Event& event = events_[event_handle % kMaxEvents];
+  event.end_ticks = end_ticks;
+  event.preprocess_ticks = static_cast<int32_t>(event_metadata1);
+  event.postprocess_ticks = static_cast<int32_t>(event_metadata2);
+}
+
+int MicroProfiler::num_events() const {
+  return next_handle_ < static_cast<uint32_t>(kMaxEvents)
+             ? static_cast<int>(next_handle_)
+             : kMaxEvents;
+}
+
+const MicroProfiler::Event& MicroProfiler::event(int i) const {
+  TFLITE_DCHECK(i >= 0 && i < num_events());
+  const uint32_t handle = next_handle_ - num_events() + i;
+  return events_[handle % kMaxEvents];
+}
+
+void MicroProfiler::ClearEvents() { next_handle_ = 0; }
+
+void MicroProfiler::Log() const {
+  for (int i = 0; i < num_events(); ++i) {
+    const Event& e = event(i);
+    TF_LITE_REPORT_ERROR(reporter_,
+                         "%s (op %d) start %d end %d: %d us, "
+                         "pre %d us, post %d us",
+                         e.tag, e.op_index, e.start_ticks, e.end_ticks,
+                         TicksToMicros(e.end_ticks - e.start_ticks),
+                         TicksToMicros(e.preprocess_ticks),
+                         TicksToMicros(e.postprocess_ticks));
+  }
+}
+
+void MicroProfiler::LogSummary() const {
+  struct TagTotal {
+    const char* tag;
+    int count;
+    int64_t ticks;
+    int64_t preprocess_ticks;
+    int64_t postprocess_ticks;
+  };
+  TagTotal totals[kMaxSummaryTags];
+  int num_tags = 0;
+  int64_t total_ticks = 0;
+
+  for (int i = 0; i < num_events(); ++i) {
+    const Event& e = event(i);
+    int t = 0;
+    while (t < num_tags && strcmp(totals[t].tag, e.tag) != 0) {
+      ++t;
+    }
+    if (t == num_tags) {
+      if (num_tags == kMaxSummaryTags) {
+        continue;
+      }
+      totals[t] = {e.tag, 0, 0, 0, 0};
+      ++num_tags;
+    }
+    const int32_t ticks = e.end_ticks - e.start_ticks;
+    ++totals[t].count;
+    totals[t].ticks += ticks;
+    totals[t].preprocess_ticks += e.preprocess_ticks;
+    totals[t].postprocess_ticks += e.postprocess_ticks;
+    total_ticks += ticks;
+  }
+
+  for (int t = 0; t < num_tags; ++t) {
+    TF_LITE_REPORT_ERROR(reporter_,
+                         "%s: %d events, %d us total, pre %d us, post %d us",
+                         totals[t].tag, totals[t].count,
+                         TicksToMicros(totals[t].ticks),
+                         TicksToMicros(totals[t].preprocess_ticks),
+                         TicksToMicros(totals[t].postprocess_ticks));
+  }
+  TF_LITE_REPORT_ERROR(reporter_, "Total: %d events, %d us", num_events(),
+                       TicksToMicros(total_ticks));
 }
 
 }  // namespace tflite
@@ -16,6 +16,8 @@ limitations under the License.
 #ifndef TENSORFLOW_LITE_MICRO_MICRO_PROFILER_H_
 #define TENSORFLOW_LITE_MICRO_MICRO_PROFILER_H_
 
+#include <cstdint>
+
 #include "tensorflow/lite/core/api/error_reporter.h"
 #include "tensorflow/lite/core/api/profiler.h"
 #include "tensorflow/lite/micro/compatibility.h"
@@ -38,8 +40,34 @@ namespace tflite {
 // int event_handle = profiler->BeginEvent(op_name, EventType::DEFAULT, 0)
 // work_to_profile();
 // profiler->EndEvent(event_handle)
+//
+// Every event is recorded into a fixed-size ring buffer that keeps the last
+// kMaxEvents events, so events may nest or overlap. When the profiler is
+// passed to the MicroInterpreter, every operator invocation is recorded with
+// its node index and, on MICRO_RUNTIME builds, the time spent in the
+// DynamicAgent pre- and post-processing around it.
 class MicroProfiler : public tflite::Profiler {
  public:
+#ifdef TF_LITE_MICRO_PROFILER_MAX_EVENTS
+  static constexpr int kMaxEvents = TF_LITE_MICRO_PROFILER_MAX_EVENTS;
+#else
+  static constexpr int kMaxEvents = 64;
+#endif
+  // Maximum number of distinct tags in LogSummary().
+  static constexpr int kMaxSummaryTags = 32;
+
+  struct Event {
+    const char* tag;
+    // Node index for operator events, -1 otherwise.
+    int32_t op_index;
+    int32_t start_ticks;
+    // Equal to start_ticks until the event has ended.
+    int32_t end_ticks;
+    // DynamicAgent pre- and post-processing time included in the event.
+    int32_t preprocess_ticks;
+    int32_t postprocess_ticks;
+  };
+
   explicit MicroProfiler(tflite::ErrorReporter* reporter);
   ~MicroProfiler() override = default;
 
@@ -49,20 +77,44 @@ class MicroProfiler : public tflite::Profiler {
                 int64_t event_metadata2) override{};
 
   // BeginEvent followed by code followed by EndEvent will profile the code
-  // enclosed. Multiple concurrent events are unsupported, so the return value
-  // is always 0. Event_metadata1 and event_metadata2 are unused. The tag
-  // pointer must be valid until EndEvent is called.
+  // enclosed. For OPERATOR_INVOKE_EVENT, event_metadata1 is the node index.
+  // The tag pointer must stay valid until the event is dumped.
   uint32_t BeginEvent(const char* tag, EventType event_type,
                       int64_t event_metadata1,
                       int64_t event_metadata2) override;
 
-  // Event_handle is ignored since TF Micro does not support concurrent events.
+  // Ends the event. Handles of events that have already been overwritten in
+  // the ring buffer are ignored.
   void EndEvent(uint32_t event_handle) override;
 
+  // Same as above, and records event_metadata1 and event_metadata2 as the
+  // pre- and post-processing ticks of the event.
+  void EndEvent(uint32_t event_handle, int64_t event_metadata1,
+                int64_t event_metadata2) override;
+
+  // Number of events currently held, at most kMaxEvents.
+  int num_events() const;
+
+  // Returns the i-th oldest event held, 0 <= i < num_events().
+  const Event& event(int i) const;
+
+  // Drops all recorded events.
+  void ClearEvents();
+
+  // Logs every recorded event.
+  void Log() const;
+
+  // Logs, for every distinct tag, the number of events and their total time,
+  // followed by the total of all events. Time spent in nested events is also
+  // part of every enclosing event.
+  void LogSummary() const;
+
  private:
   tflite::ErrorReporter* reporter_;
-  int32_t start_time_;
-  const char* event_tag_;
+  Event events_[kMaxEvents];
+  // Handle of the next event. Event `handle` lives in events_[handle %
+  // kMaxEvents] until kMaxEvents newer events have begun.
+  uint32_t next_handle_ = 0;
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
 
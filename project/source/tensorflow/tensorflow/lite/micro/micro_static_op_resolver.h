@@ -0,0 +1,89 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
+
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/compatibility.h"
+#include "tensorflow/lite/micro/micro_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+
+// A builtin operator of a MicroStaticOpResolver, with the function returning
+// its kernel registration and the parser of its builtin options.
+struct MicroStaticOp {
+  BuiltinOperator op;
+  TfLiteRegistration* (*registration)();
+  MicroOpResolver::BuiltinParseFunction parser;
+};
+
+// Number of entries of the table that maps every BuiltinOperator to its op.
+constexpr int kMicroStaticOpSlots = BuiltinOperator_MAX + 1;
+
+// An op resolver over a fixed list of builtin operators, as generated from the
+// operator codes of a model by micro/tools/op_resolver_generator.cc.
+//
+// Unlike MicroMutableOpResolver, which searches its registrations for every
+// node, FindOp() and GetOpDataParser() are a lookup in `op_slots`, a constant
+// table that holds the index into `ops` of every BuiltinOperator, or -1. Only
+// the kernels in `ops` are referenced, so the linker drops the others.
+// Custom operators are not supported.
+template <unsigned int tOpCount>
+class MicroStaticOpResolver : public MicroOpResolver {
+ public:
+  MicroStaticOpResolver(const MicroStaticOp (&ops)[tOpCount],
+                        const int8_t (&op_slots)[kMicroStaticOpSlots])
+      : ops_(ops), op_slots_(op_slots) {
+    for (unsigned int i = 0; i < tOpCount; ++i) {
+      registrations_[i] = *ops[i].registration();
+      registrations_[i].builtin_code = ops[i].op;
+    }
+  }
+
+  const TfLiteRegistration* FindOp(BuiltinOperator op) const override {
+    const int slot = Slot(op);
+    return slot < 0 ? nullptr : &registrations_[slot];
+  }
+
+  const TfLiteRegistration* FindOp(const char* op) const override {
+    return nullptr;
+  }
+
+  BuiltinParseFunction GetOpDataParser(BuiltinOperator op) const override {
+    const int slot = Slot(op);
+    return slot < 0 ? nullptr : ops_[slot].parser;
+  }
+
+ private:
+  int Slot(BuiltinOperator op) const {
+    if (op < 0 || op >= kMicroStaticOpSlots) {
+      return -1;
+    }
+    return op_slots_[op];
+  }
+
+  const MicroStaticOp (&ops_)[tOpCount];
+  const int8_t (&op_slots_)[kMicroStaticOpSlots];
+  TfLiteRegistration registrations_[tOpCount];
+
+  TF_LITE_REMOVE_VIRTUAL_DELETE
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_STATIC_OP_RESOLVER_H_
@@ -0,0 +1,516 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#include "tensorflow/lite/micro/micro_streaming.h"
+
+#include <cstring>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+
+namespace tflite {
+namespace {
+
+// Ops whose output frame t only depends on input frame t.
+bool IsElementwise(int32_t builtin_code) {
+  switch (builtin_code) {
+    case BuiltinOperator_ABS:
+    case BuiltinOperator_ADD:
+    case BuiltinOperator_CEIL:
+    case BuiltinOperator_DEQUANTIZE:
+    case BuiltinOperator_DIV:
+    case BuiltinOperator_FLOOR:
+    case BuiltinOperator_LOGISTIC:
+    case BuiltinOperator_MAXIMUM:
+    case BuiltinOperator_MINIMUM:
+    case BuiltinOperator_MUL:
+    case BuiltinOperator_NEG:
+    case BuiltinOperator_PRELU:
+    case BuiltinOperator_QUANTIZE:
+    case BuiltinOperator_RELU:
+    case BuiltinOperator_RELU6:
+    case BuiltinOperator_RELU_N1_TO_1:
+    case BuiltinOperator_ROUND:
+    case BuiltinOperator_RSQRT:
+    case BuiltinOperator_SQRT:
+    case BuiltinOperator_SQUARE:
+    case BuiltinOperator_SUB:
+    case BuiltinOperator_TANH:
+      return true;
+    default:
+      return false;
+  }
+}
+
+// Ops that only change the shape of their first input.
+bool IsShapeOnly(int32_t builtin_code) {
+  return builtin_code == BuiltinOperator_RESHAPE ||
+         builtin_code == BuiltinOperator_EXPAND_DIMS ||
+         builtin_code == BuiltinOperator_SQUEEZE;
+}
+
+// Product of the dimensions in front of `axis`. Frames along `axis` are only
+// contiguous in memory if this is 1.
+int OuterSize(const TfLiteIntArray* dims, int axis) {
+  int size = 1;
+  for (int i = 0; i < axis; ++i) {
+    size *= dims->data[i];
+  }
+  return size;
+}
+
+}  // namespace
+
+TfLiteStatus MicroStreamingPlan::Init(
+    MicroAllocator* allocator, ErrorReporter* error_reporter,
+    TfLiteContext* context, TfLiteEvalTensor* eval_tensors,
+    NodeAndRegistration* node_and_registrations, size_t operators_size,
+    int input_tensor_index, const int32_t* output_tensor_indices,
+    size_t outputs_size, int time_axis, int hop) {
+  allocator_ = allocator;
+  error_reporter_ = error_reporter;
+  context_ = context;
+  eval_tensors_ = eval_tensors;
+  node_and_registrations_ = node_and_registrations;
+  input_tensor_index_ = input_tensor_index;
+  hop_ = hop;
+  prime_passes_ = 0;
+  primed_ = false;
+
+  const TfLiteTensor& input = context->tensors[input_tensor_index];
+  if (time_axis < 0 || time_axis >= input.dims->size ||
+      OuterSize(input.dims, time_axis) != 1) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Streaming input needs a contiguous time axis, got "
+                         "axis %d.",
+                         time_axis);
+    return kTfLiteError;
+  }
+  const int input_frames = input.dims->data[time_axis];
+  if (hop <= 0 || hop > input_frames) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Streaming hop %d is outside of [1, %d].", hop,
+                         input_frames);
+    return kTfLiteError;
+  }
+
+  void* raw;
+  TF_LITE_ENSURE_STATUS(allocator->AllocatePersistentBuffer(
+      sizeof(TensorState) * context->tensors_size, &raw));
+  tensors_ = reinterpret_cast<TensorState*>(raw);
+  for (size_t i = 0; i < context->tensors_size; ++i) {
+    tensors_[i].axis = -1;
+  }
+  TF_LITE_ENSURE_STATUS(allocator->AllocatePersistentBuffer(
+      sizeof(NodeState) * operators_size, &raw));
+  NodeState* nodes = reinterpret_cast<NodeState*>(raw);
+  memset(nodes, 0, sizeof(NodeState) * operators_size);
+
+  TensorState& input_state = tensors_[input_tensor_index];
+  input_state.axis = time_axis;
+  input_state.frames = input_frames;
+  input_state.hop = hop;
+  input_state.frame_bytes = input.bytes / input_frames;
+  input_state.cache_frames = 0;
+  input_state.cache_tensor = input_tensor_index;
+  input_state.prime_passes = 0;
+
+  nodes_ = nodes;
+  for (size_t i = 0; i < operators_size; ++i) {
+    int out_axis, out_hop, in_start, in_frames;
+    if (PlanNode(i, &out_axis, &out_hop, &in_start, &in_frames) != kTfLiteOk) {
+      continue;
+    }
+
+    const TfLiteNode& node = node_and_registrations[i].node;
+    const int output_index = node.outputs->data[0];
+    TfLiteTensor& output = context->tensors[output_index];
+    TensorState& output_state = tensors_[output_index];
+    output_state.axis = out_axis;
+    output_state.frames = output.dims->data[out_axis];
+    output_state.hop = out_hop;
+    output_state.frame_bytes = output.bytes / output_state.frames;
+    output_state.cache_frames = 0;
+    output_state.cache_tensor = output_index;
+    output_state.prime_passes = 0;
+
+    const bool shape_only =
+        IsShapeOnly(node_and_registrations[i].registration->builtin_code);
+    if (shape_only) {
+      // The frame layout is unchanged, so the output shares the cache of the
+      // input. The node is not a tail node, and runs as a no-op.
+      output_state.cache_tensor =
+          tensors_[node.inputs->data[0]].cache_tensor;
+      continue;
+    }
+    int view_count = 1;
+    for (int j = 0; j < node.inputs->size; ++j) {
+      const int tensor_index = node.inputs->data[j];
+      if (tensor_index >= 0 && tensors_[tensor_index].axis >= 0) {
+        ++view_count;
+      }
+    }
+
+    NodeState* node_state = &nodes[i];
+    TF_LITE_ENSURE_STATUS(allocator->AllocatePersistentBuffer(
+        sizeof(TensorView) * view_count, &raw));
+    node_state->views = reinterpret_cast<TensorView*>(raw);
+    TF_LITE_ENSURE_STATUS(AddView(node_state, output_index,
+                                  output_state.frames - out_hop, out_hop));
+    for (int j = 0; j < node.inputs->size; ++j) {
+      const int tensor_index = node.inputs->data[j];
+      if (tensor_index >= 0 && tensors_[tensor_index].axis >= 0) {
+        TF_LITE_ENSURE_STATUS(
+            AddView(node_state, tensor_index, in_start, in_frames));
+      }
+    }
+  }
+
+  // Size every cache by the windows its readers look at. The producer of a
+  // tensor writes its newest `hop` frames, a tail node reads from the start of
+  // its view to the end of the window, and every other reader, like a graph
+  // output, sees the whole window.
+  for (size_t i = 0; i < context->tensors_size; ++i) {
+    if (tensors_[i].axis >= 0) {
+      RequireFrames(i, tensors_[i].hop);
+    }
+  }
+  for (size_t i = 0; i < operators_size; ++i) {
+    const TfLiteNode& node = node_and_registrations[i].node;
+    if (nodes[i].view_count > 0) {
+      for (int j = 1; j < nodes[i].view_count; ++j) {
+        const TensorView& view = nodes[i].views[j];
+        RequireFrames(view.tensor_index,
+                      tensors_[view.tensor_index].frames - view.start);
+      }
+      continue;
+    }
+    const int output_index =
+        node.outputs->size == 1 ? node.outputs->data[0] : -1;
+    if (output_index >= 0 && tensors_[output_index].axis >= 0) {
+      // A streamed shape-only op reads nothing.
+      continue;
+    }
+    for (int j = 0; j < node.inputs->size; ++j) {
+      const int tensor_index = node.inputs->data[j];
+      if (tensor_index >= 0 && tensors_[tensor_index].axis >= 0) {
+        RequireFrames(tensor_index, tensors_[tensor_index].frames);
+      }
+    }
+  }
+  for (size_t i = 0; i < outputs_size; ++i) {
+    const int tensor_index = output_tensor_indices[i];
+    if (tensors_[tensor_index].axis >= 0) {
+      RequireFrames(tensor_index, tensors_[tensor_index].frames);
+    }
+  }
+
+  for (size_t i = 0; i < context->tensors_size; ++i) {
+    if (tensors_[i].axis >= 0 &&
+        tensors_[i].cache_tensor == static_cast<int32_t>(i)) {
+      TF_LITE_ENSURE_STATUS(AllocateCache(i));
+    }
+  }
+  for (size_t i = 0; i < context->tensors_size; ++i) {
+    TensorState& state = tensors_[i];
+    if (state.axis < 0) continue;
+    const TensorState& cache_state = tensors_[state.cache_tensor];
+    state.cache_frames = cache_state.cache_frames;
+    TfLiteTensor* tensor = &context->tensors[i];
+    tensor->data.data = context->tensors[state.cache_tensor].data.data;
+    if (state.cache_frames == state.frames) continue;
+
+    TF_LITE_ENSURE_STATUS(allocator->AllocatePersistentBuffer(
+        TfLiteIntArrayGetSizeInBytes(tensor->dims->size), &raw));
+    TfLiteIntArray* dims = reinterpret_cast<TfLiteIntArray*>(raw);
+    dims->size = tensor->dims->size;
+    for (int j = 0; j < dims->size; ++j) {
+      dims->data[j] = tensor->dims->data[j];
+    }
+    dims->data[state.axis] = state.cache_frames;
+    tensor->dims = dims;
+    tensor->bytes = state.cache_frames * state.frame_bytes;
+    eval_tensors[i].dims = dims;
+  }
+
+  // A tail node writes correct frames once the caches of its inputs are
+  // primed, and its own cache is primed after enough of those to fill it.
+  for (size_t i = 0; i < operators_size; ++i) {
+    const TfLiteNode& node = node_and_registrations[i].node;
+    NodeState& node_state = nodes[i];
+    if (node_state.view_count == 0) {
+      if (node.outputs->size == 1 &&
+          tensors_[node.outputs->data[0]].axis >= 0) {
+        tensors_[node.outputs->data[0]].prime_passes =
+            tensors_[node.inputs->data[0]].prime_passes;
+      }
+      continue;
+    }
+    int input_prime_passes = 1;
+    for (int j = 0; j < node_state.view_count; ++j) {
+      TensorView& view = node_state.views[j];
+      const TensorState& state = tensors_[view.tensor_index];
+      const int cache_start = state.frames - state.cache_frames;
+      view.offset = (view.start - cache_start) * state.frame_bytes;
+      if (j > 0 && state.prime_passes > input_prime_passes) {
+        input_prime_passes = state.prime_passes;
+      }
+    }
+    TensorState& output_state = tensors_[node_state.views[0].tensor_index];
+    const int fills =
+        (output_state.cache_frames + output_state.hop - 1) / output_state.hop;
+    output_state.prime_passes = input_prime_passes + fills - 1;
+    if (output_state.prime_passes > prime_passes_) {
+      prime_passes_ = output_state.prime_passes;
+    }
+  }
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroStreamingPlan::PlanNode(size_t node_index, int* out_axis,
+                                          int* out_hop, int* in_start,
+                                          int* in_frames) {
+  const TfLiteNode& node = node_and_registrations_[node_index].node;
+  const int32_t builtin_code =
+      node_and_registrations_[node_index].registration->builtin_code;
+  if (node.outputs->size != 1 || node.inputs->size < 1) {
+    return kTfLiteError;
+  }
+  const int input_index = node.inputs->data[0];
+  const TfLiteTensor& output = context_->tensors[node.outputs->data[0]];
+  if (input_index < 0 || tensors_[input_index].axis < 0 ||
+      output.is_variable) {
+    return kTfLiteError;
+  }
+  const TensorState& in = tensors_[input_index];
+
+  if (IsShapeOnly(builtin_code)) {
+    // The frame layout is unchanged as long as the time axis survives with
+    // nothing but unit dimensions in front of it.
+    for (int axis = 0; axis < output.dims->size; ++axis) {
+      if (OuterSize(output.dims, axis) != 1) break;
+      if (output.dims->data[axis] == in.frames &&
+          output.bytes / in.frames == in.frame_bytes) {
+        *out_axis = axis;
+        *out_hop = in.hop;
+        *in_start = in.frames - in.hop;
+        *in_frames = in.hop;
+        return kTfLiteOk;
+      }
+    }
+    return kTfLiteError;
+  }
+
+  if (IsElementwise(builtin_code)) {
+    const int axis = in.axis + output.dims->size -
+                     context_->tensors[input_index].dims->size;
+    if (axis < 0 || output.dims->data[axis] != in.frames ||
+        OuterSize(output.dims, axis) != 1) {
+      return kTfLiteError;
+    }
+    for (int j = 1; j < node.inputs->size; ++j) {
+      const int tensor_index = node.inputs->data[j];
+      if (tensor_index < 0) continue;
+      const TfLiteTensor& other = context_->tensors[tensor_index];
+      const TensorState& other_state = tensors_[tensor_index];
+      const int other_axis = axis - (output.dims->size - other.dims->size);
+      if (other_state.axis >= 0) {
+        // Both operands stream; they must advance in lockstep.
+        if (other_state.axis != other_axis ||
+            other_state.frames != in.frames || other_state.hop != in.hop) {
+          return kTfLiteError;
+        }
+      } else if (other_axis >= 0 && other.dims->data[other_axis] != 1) {
+        // Non-streamed operands may only broadcast along the time axis.
+        return kTfLiteError;
+      }
+    }
+    *out_axis = axis;
+    *out_hop = in.hop;
+    *in_start = in.frames - in.hop;
+    *in_frames = in.hop;
+    return kTfLiteOk;
+  }
+
+  // Windowed ops over the spatial axes of NHWC tensors.
+  TfLitePadding padding;
+  int stride, kernel_size;
+  if (builtin_code == BuiltinOperator_CONV_2D ||
+      builtin_code == BuiltinOperator_DEPTHWISE_CONV_2D) {
+    if (in.axis != 1 && in.axis != 2) return kTfLiteError;
+    int dilation;
+    if (builtin_code == BuiltinOperator_CONV_2D) {
+      const auto* params =
+          reinterpret_cast<const TfLiteConvParams*>(node.builtin_data);
+      padding = params->padding;
+      stride = in.axis == 1 ? params->stride_height : params->stride_width;
+      dilation = in.axis == 1 ? params->dilation_height_factor
+                              : params->dilation_width_factor;
+    } else {
+      const auto* params =
+          reinterpret_cast<const TfLiteDepthwiseConvParams*>(
+              node.builtin_data);
+      padding = params->padding;
+      stride = in.axis == 1 ? params->stride_height : params->stride_width;
+      dilation = in.axis == 1 ? params->dilation_height_factor
+                              : params->dilation_width_factor;
+    }
+    // Both OHWI and 1HWO filters keep their spatial dimensions at 1 and 2.
+    const TfLiteTensor& filter = context_->tensors[node.inputs->data[1]];
+    kernel_size = (filter.dims->data[in.axis] - 1) * dilation + 1;
+  } else if (builtin_code == BuiltinOperator_AVERAGE_POOL_2D ||
+             builtin_code == BuiltinOperator_MAX_POOL_2D) {
+    if (in.axis != 1 && in.axis != 2) return kTfLiteError;
+    const auto* params =
+        reinterpret_cast<const TfLitePoolParams*>(node.builtin_data);
+    padding = params->padding;
+    stride = in.axis == 1 ? params->stride_height : params->stride_width;
+    kernel_size = in.axis == 1 ? params->filter_height : params->filter_width;
+  } else {
+    return kTfLiteError;
+  }
+
+  // SAME padding depends on the window length, so only VALID streams.
+  if (padding != kTfLitePaddingValid || stride <= 0 || in.hop % stride != 0 ||
+      output.dims->size != 4 || OuterSize(output.dims, in.axis) != 1) {
+    return kTfLiteError;
+  }
+  const int output_frames = output.dims->data[in.axis];
+  const int hop = in.hop / stride;
+  if (hop > output_frames) {
+    return kTfLiteError;
+  }
+  *out_axis = in.axis;
+  *out_hop = hop;
+  *in_start = (output_frames - hop) * stride;
+  *in_frames = (hop - 1) * stride + kernel_size;
+  return kTfLiteOk;
+}
+
+TfLiteStatus MicroStreamingPlan::AddView(NodeState* node_state,
+                                         int tensor_index, int start,
+                                         int frames) {
+  for (int i = 0; i < node_state->view_count; ++i) {
+    // Ops like MUL(x, x) read the same window twice.
+    if (node_state->views[i].tensor_index == tensor_index) return kTfLiteOk;
+  }
+  const TfLiteTensor& tensor = context_->tensors[tensor_index];
+  const TensorState& state = tensors_[tensor_index];
+
+  void* raw;
+  TF_LITE_ENSURE_STATUS(allocator_->AllocatePersistentBuffer(
+      TfLiteIntArrayGetSizeInBytes(tensor.dims->size), &raw));
+  TfLiteIntArray* dims = reinterpret_cast<TfLiteIntArray*>(raw);
+  dims->size = tensor.dims->size;
+  for (int i = 0; i < dims->size; ++i) {
+    dims->data[i] = tensor.dims->data[i];
+  }
+  dims->data[state.axis] = frames;
+
+  TensorView& view = node_state->views[node_state->view_count++];
+  view.tensor_index = tensor_index;
+  view.start = start;
+  view.bytes = frames * state.frame_bytes;
+  view.dims = dims;
+  return kTfLiteOk;
+}
+
+void MicroStreamingPlan::RequireFrames(int tensor_index, int frames) {
+  TensorState& state = tensors_[tensors_[tensor_index].cache_tensor];
+  if (frames > state.cache_frames) {
+    state.cache_frames = frames;
+  }
+}
+
+TfLiteStatus MicroStreamingPlan::AllocateCache(int tensor_index) {
+  TfLiteTensor* tensor = &context_->tensors[tensor_index];
+  TensorState& state = tensors_[tensor_index];
+  if (tensor->data.data != nullptr) {
+    // A caller-owned buffer holds the whole window.
+    state.cache_frames = state.frames;
+    return kTfLiteOk;
+  }
+  // A persistent buffer keeps the frames alive between invocations; the
+  // memory planner skips tensors that already have data.
+  const size_t bytes = state.cache_frames * state.frame_bytes;
+  TF_LITE_ENSURE_STATUS(
+      allocator_->AllocatePersistentBuffer(bytes, &tensor->data.data));
+  memset(tensor->data.data, 0, bytes);
+  return kTfLiteOk;
+}
+
+void MicroStreamingPlan::ClearInput() {
+  const TensorState& state = tensors_[input_tensor_index_];
+  memset(eval_tensors_[input_tensor_index_].data.data, 0,
+         state.cache_frames * state.frame_bytes);
+}
+
+void MicroStreamingPlan::PushInputFrames(const void* frames) {
+  TfLiteEvalTensor* input = &eval_tensors_[input_tensor_index_];
+  const TensorState& state = tensors_[input_tensor_index_];
+  const size_t bytes = state.cache_frames * state.frame_bytes;
+  const size_t hop_bytes = state.hop * state.frame_bytes;
+  memmove(input->data.raw, input->data.raw + hop_bytes, bytes - hop_bytes);
+  memcpy(input->data.raw + bytes - hop_bytes, frames, hop_bytes);
+}
+
+void MicroStreamingPlan::BeginTailNode(size_t node_index) {
+  NodeState& node_state = nodes_[node_index];
+
+  // Drop the oldest frames of the output cache; the node overwrites the
+  // trailing `hop` frames below.
+  TfLiteEvalTensor* output =
+      &eval_tensors_[node_state.views[0].tensor_index];
+  const size_t keep_bytes = node_state.views[0].offset;
+  memmove(output->data.raw, output->data.raw + node_state.views[0].bytes,
+          keep_bytes);
+
+  for (int i = 0; i < node_state.view_count; ++i) {
+    TensorView& view = node_state.views[i];
+    TfLiteEvalTensor* tensor = &eval_tensors_[view.tensor_index];
+    view.saved_data = tensor->data.data;
+    view.saved_dims = tensor->dims;
+    tensor->data.raw = tensor->data.raw + view.offset;
+    tensor->dims = view.dims;
+    if (context_->tensors != nullptr) {
+      // Kept TfLiteTensors (see MicroAllocator) see the same window.
+      TfLiteTensor* full_tensor = &context_->tensors[view.tensor_index];
+      full_tensor->data.data = tensor->data.data;
+      full_tensor->dims = view.dims;
+      full_tensor->bytes = view.bytes;
+    }
+  }
+}
+
+void MicroStreamingPlan::EndTailNode(size_t node_index) {
+  NodeState& node_state = nodes_[node_index];
+  // Restore in reverse order in case a tensor is viewed more than once.
+  for (int i = node_state.view_count - 1; i >= 0; --i) {
+    TensorView& view = node_state.views[i];
+    TfLiteEvalTensor* tensor = &eval_tensors_[view.tensor_index];
+    tensor->data.data = view.saved_data;
+    tensor->dims = view.saved_dims;
+    if (context_->tensors != nullptr) {
+      const TensorState& state = tensors_[view.tensor_index];
+      TfLiteTensor* full_tensor = &context_->tensors[view.tensor_index];
+      full_tensor->data.data = view.saved_data;
+      full_tensor->dims = view.saved_dims;
+      full_tensor->bytes = state.cache_frames * state.frame_bytes;
+    }
+  }
+}
+
+}  // namespace tflite
@@ -0,0 +1,162 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+#ifndef TENSORFLOW_LITE_MICRO_MICRO_STREAMING_H_
+#define TENSORFLOW_LITE_MICRO_MICRO_STREAMING_H_
+
+#include <cstddef>
+#include <cstdint>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/core/api/error_reporter.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+
+namespace tflite {
+
+// Plans incremental ("streaming") execution of a graph whose input is a
+// sliding window over a time axis, e.g. the raw audio window of a conv1d
+// classifier.
+//
+// Every tensor that is derived from the streaming input only through
+// time-local ops (elementwise ops, shape-only ops, and VALID-padded CONV_2D,
+// DEPTHWISE_CONV_2D, AVERAGE_POOL_2D and MAX_POOL_2D) is kept as a persistent
+// per-layer cache of activations. When `hop` new input frames arrive, every
+// cache is shifted by the number of frames that its producer advances, and the
+// producer is only invoked on the trailing window that covers the new output
+// frames. The output of a shape-only op shares the cache of its input instead
+// of getting one of its own. Ops that mix the whole time axis (e.g. a
+// flattening RESHAPE followed by FULLY_CONNECTED) are run in full on the
+// up-to-date caches, so the results are identical to re-running the whole
+// window.
+//
+// A cache only holds the newest frames that its readers look at: the tail of
+// the receptive field of a windowed op, (kernel - 1) * dilation + hop frames
+// for a stride of 1, or the `hop` frames of an elementwise op. Only tensors
+// read by an op that mixes the time axis, and graph outputs, keep the whole
+// window. The dims of a shortened tensor, including input 0, describe the
+// frames it holds.
+//
+// A layer stops streaming if its stride does not divide the hop it receives;
+// it and everything downstream of it is then recomputed in full.
+class MicroStreamingPlan {
+ public:
+  // Analyzes the prepared graph and moves all streamed tensors out of the
+  // non-persistent arena into persistent buffers. Must be called after all
+  // kernels have been prepared and before FinishModelAllocation(). The plan
+  // works on `eval_tensors` at invoke time.
+  TfLiteStatus Init(MicroAllocator* allocator, ErrorReporter* error_reporter,
+                    TfLiteContext* context, TfLiteEvalTensor* eval_tensors,
+                    NodeAndRegistration* node_and_registrations,
+                    size_t operators_size, int input_tensor_index,
+                    const int32_t* output_tensor_indices, size_t outputs_size,
+                    int time_axis, int hop);
+
+  bool enabled() const { return nodes_ != nullptr; }
+
+  // Whether the caches hold the result of a complete invocation.
+  bool primed() const { return primed_; }
+  void set_primed(bool primed) { primed_ = primed; }
+
+  // Number of streaming passes over an all-zero input after which every
+  // cache holds what a full invocation on a zero window would have computed.
+  int prime_passes() const { return prime_passes_; }
+
+  // Zeroes the cached input frames, to prime the caches from scratch.
+  void ClearInput();
+
+  // Returns true if node `node_index` only needs to compute its newest output
+  // frames.
+  bool IsTailNode(size_t node_index) const {
+    return nodes_[node_index].view_count > 0;
+  }
+
+  // Shifts the streaming input left by `hop` frames and appends `frames`,
+  // which must hold hop_bytes() bytes of the input tensor's type.
+  void PushInputFrames(const void* frames);
+
+  // Shifts the cached output of a tail node and points the node's streamed
+  // tensors at the windows it needs to compute the new frames.
+  void BeginTailNode(size_t node_index);
+
+  // Restores the full tensors after BeginTailNode().
+  void EndTailNode(size_t node_index);
+
+  // Number of new input frames consumed by every streaming invocation.
+  int hop() const { return hop_; }
+
+  // Size in bytes of the `hop` frames passed to PushInputFrames().
+  size_t hop_bytes() const {
+    return hop_ * tensors_[input_tensor_index_].frame_bytes;
+  }
+
+ private:
+  // Time axis state of a tensor. A tensor is streamed iff axis >= 0.
+  struct TensorState {
+    int8_t axis;
+    // Frames of the full window.
+    int32_t frames;
+    int32_t hop;
+    size_t frame_bytes;
+    // Newest frames kept in the cache, at most `frames`.
+    int32_t cache_frames;
+    // Tensor that owns the cache; differs for the output of a shape-only op.
+    int32_t cache_tensor;
+    // Passes over a zero input until the cache is primed, see prime_passes().
+    int32_t prime_passes;
+  };
+
+  // A window of a streamed tensor seen by a tail node.
+  struct TensorView {
+    int tensor_index;
+    // First frame of the window in the full tensor.
+    int start;
+    // Byte offset of the window in the cache.
+    size_t offset;
+    size_t bytes;
+    TfLiteIntArray* dims;
+    // Full tensor fields saved while the view is applied.
+    void* saved_data;
+    TfLiteIntArray* saved_dims;
+  };
+
+  // views[0] is always the output of the node. A node without views is run in
+  // full.
+  struct NodeState {
+    int view_count;
+    TensorView* views;
+  };
+
+  TfLiteStatus PlanNode(size_t node_index, int* out_axis, int* out_hop,
+                        int* in_start, int* in_frames);
+  TfLiteStatus AddView(NodeState* node_state, int tensor_index, int start,
+                       int frames);
+  void RequireFrames(int tensor_index, int frames);
+  TfLiteStatus AllocateCache(int tensor_index);
+
+  MicroAllocator* allocator_ = nullptr;
+  ErrorReporter* error_reporter_ = nullptr;
+  TfLiteContext* context_ = nullptr;
+  TfLiteEvalTensor* eval_tensors_ = nullptr;
+  NodeAndRegistration* node_and_registrations_ = nullptr;
+  TensorState* tensors_ = nullptr;
+  NodeState* nodes_ = nullptr;
+  int input_tensor_index_ = -1;
+  int hop_ = 0;
+  int prime_passes_ = 0;
+  bool primed_ = false;
+};
+
+}  // namespace tflite
+
+#endif  // TENSORFLOW_LITE_MICRO_MICRO_STREAMING_H_
@@ -0,0 +1,62 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// MT3620 Cortex-M4F implementation of the timer functions. Ticks are CPU
+// cycles counted by the DWT cycle counter, which is free-running and needs no
+// peripheral or interrupt. The BSP clocks the core at 197.6 MHz, so the
+// counter wraps every ~21.7 s; differences between two readings stay valid
+// across the wrap-around.
+
+#include "tensorflow/lite/micro/micro_time.h"
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace tflite {
+namespace {
+
+constexpr int32_t kCoreClockHz = 197600000;
+
+constexpr uintptr_t kCoreDebugDemcr = 0xE000EDFC;
+constexpr uint32_t kDemcrTrcEna = 1u << 24;
+constexpr uintptr_t kDwtCtrl = 0xE0001000;
+constexpr uint32_t kDwtCtrlCycCntEna = 1u << 0;
+constexpr uintptr_t kDwtCycCnt = 0xE0001004;
+
+inline volatile uint32_t& Reg32(uintptr_t addr) {
+  return *reinterpret_cast<volatile uint32_t*>(addr);
+}
+
+bool cycle_counter_enabled = false;
+
+void EnableCycleCounter() {
+  Reg32(kCoreDebugDemcr) |= kDemcrTrcEna;
+  Reg32(kDwtCycCnt) = 0;
+  Reg32(kDwtCtrl) |= kDwtCtrlCycCntEna;
+  cycle_counter_enabled = true;
+}
+
+}  // namespace
+
+int32_t ticks_per_second() { return kCoreClockHz; }
+
+int32_t GetCurrentTimeTicks() {
+  if (!cycle_counter_enabled) {
+    EnableCycleCounter();
+  }
+  return static_cast<int32_t>(Reg32(kDwtCycCnt));
+}
+
+}  // namespace tflite
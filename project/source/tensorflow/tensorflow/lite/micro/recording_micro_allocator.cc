@@ -47,6 +47,8 @@ RecordingMicroAllocator* RecordingMicroAllocator::Create(
 RecordedAllocation RecordingMicroAllocator::GetRecordedAllocation(
     RecordedAllocationType allocation_type) const {
   switch (allocation_type) {
+    case RecordedAllocationType::kTfLiteEvalTensorData:
+      return recorded_tflite_eval_tensor_data_;
     case RecordedAllocationType::kTfLiteTensorArray:
       return recorded_tflite_tensor_array_data_;
     case RecordedAllocationType::kTfLiteTensorArrayQuantizationData:
@@ -57,6 +59,14 @@ RecordedAllocation RecordingMicroAllocator::GetRecordedAllocation(
       return recorded_node_and_registration_array_data_;
     case RecordedAllocationType::kOpData:
       return recorded_op_data_;
+    case RecordedAllocationType::kPersistentTfLiteTensorData:
+      return recorded_persistent_tflite_tensor_data_;
+    case RecordedAllocationType::kPersistentBufferData:
+      return recorded_persistent_buffer_data_;
+    case RecordedAllocationType::kScratchBufferHandles:
+      return recorded_scratch_buffer_handles_;
+    case RecordedAllocationType::kNonPersistentPlan:
+      return recorded_non_persistent_plan_;
   }
   TF_LITE_REPORT_ERROR(error_reporter(), "Invalid allocation type supplied: %d",
                        allocation_type);
@@ -81,6 +91,8 @@ void RecordingMicroAllocator::PrintAllocations() const {
       error_reporter(),
       "[RecordingMicroAllocator] Arena allocation tail %d bytes",
       recording_memory_allocator_->GetTailUsedBytes());
+  PrintRecordedAllocation(RecordedAllocationType::kTfLiteEvalTensorData,
+                          "TfLiteEvalTensor data", "allocations");
   PrintRecordedAllocation(RecordedAllocationType::kTfLiteTensorArray,
                           "TfLiteTensor struct", "tensors");
   PrintRecordedAllocation(
@@ -94,6 +106,14 @@ void RecordingMicroAllocator::PrintAllocations() const {
                           "NodeAndRegistration structs");
   PrintRecordedAllocation(RecordedAllocationType::kOpData,
                           "Operator runtime data", "OpData structs");
+  PrintRecordedAllocation(RecordedAllocationType::kPersistentTfLiteTensorData,
+                          "Persistent TfLiteTensor data", "tensors");
+  PrintRecordedAllocation(RecordedAllocationType::kPersistentBufferData,
+                          "Persistent buffer data", "buffers");
+  PrintRecordedAllocation(RecordedAllocationType::kScratchBufferHandles,
+                          "Scratch buffer handles", "handles");
+  PrintRecordedAllocation(RecordedAllocationType::kNonPersistentPlan,
+                          "Non-persistent memory plan", "plans");
 }
 
 void RecordingMicroAllocator::PrintRecordedAllocation(
@@ -108,37 +128,90 @@ void RecordingMicroAllocator::PrintRecordedAllocation(
       allocation.count, allocation_description);
 }
 
+TfLiteTensor* RecordingMicroAllocator::AllocatePersistentTfLiteTensor(
+    const Model* model, const TfLiteEvalTensor* eval_tensors,
+    int tensor_index) {
+  RecordedAllocation allocations = SnapshotAllocationUsage();
+
+  TfLiteTensor* result = MicroAllocator::AllocatePersistentTfLiteTensor(
+      model, eval_tensors, tensor_index);
+
+  const size_t tensor_count = recorded_persistent_tflite_tensor_data_.count;
+  RecordAllocationUsage(allocations, recorded_persistent_tflite_tensor_data_);
+  // Counts tensors, not the allocations of their quantization data.
+  recorded_persistent_tflite_tensor_data_.count =
+      tensor_count + (result != nullptr ? 1 : 0);
+  return result;
+}
+
+TfLiteStatus RecordingMicroAllocator::AllocatePersistentBuffer(size_t bytes,
+                                                               void** ptr) {
+  RecordedAllocation allocations = SnapshotAllocationUsage();
+
+  TfLiteStatus status = MicroAllocator::AllocatePersistentBuffer(bytes, ptr);
+
+  RecordAllocationUsage(allocations, recorded_persistent_buffer_data_);
+  return status;
+}
+
+TfLiteStatus RecordingMicroAllocator::RequestScratchBufferInArena(
+    int node_id, size_t bytes, int* buffer_idx) {
+  RecordedAllocation allocations = SnapshotAllocationUsage();
+
+  TfLiteStatus status =
+      MicroAllocator::RequestScratchBufferInArena(node_id, bytes, buffer_idx);
+
+  RecordAllocationUsage(allocations, recorded_scratch_buffer_handles_);
+  return status;
+}
+
+TfLiteStatus RecordingMicroAllocator::AllocateTfLiteEvalTensors(
+    const Model* model, const SubGraph* subgraph,
+    TfLiteEvalTensor** eval_tensors) {
+  RecordedAllocation allocations = SnapshotAllocationUsage();
+
+  TfLiteStatus status =
+      MicroAllocator::AllocateTfLiteEvalTensors(model, subgraph, eval_tensors);
+
+  RecordAllocationUsage(allocations, recorded_tflite_eval_tensor_data_);
+  recorded_tflite_eval_tensor_data_.count = subgraph->tensors()->size();
+  return status;
+}
+
 TfLiteStatus RecordingMicroAllocator::AllocateTfLiteTensorArray(
     TfLiteContext* context, const SubGraph* subgraph) {
-  SnapshotAllocationUsage(recorded_tflite_tensor_array_data_);
+  RecordedAllocation allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status =
       MicroAllocator::AllocateTfLiteTensorArray(context, subgraph);
 
-  RecordAllocationUsage(recorded_tflite_tensor_array_data_);
+  RecordAllocationUsage(allocations, recorded_tflite_tensor_array_data_);
   recorded_tflite_tensor_array_data_.count = context->tensors_size;
   return status;
 }
 
 TfLiteStatus RecordingMicroAllocator::PopulateTfLiteTensorArrayFromFlatbuffer(
-    const Model* model, TfLiteContext* context, const SubGraph* subgraph) {
-  SnapshotAllocationUsage(recorded_tflite_tensor_array_quantization_data_);
+    const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+    const TfLiteEvalTensor* eval_tensors) {
+  RecordedAllocation allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status = MicroAllocator::PopulateTfLiteTensorArrayFromFlatbuffer(
-      model, context, subgraph);
+      model, context, subgraph, eval_tensors);
 
-  RecordAllocationUsage(recorded_tflite_tensor_array_quantization_data_);
+  RecordAllocationUsage(allocations,
+                        recorded_tflite_tensor_array_quantization_data_);
   return status;
 }
 
 TfLiteStatus RecordingMicroAllocator::AllocateNodeAndRegistrations(
     const SubGraph* subgraph, NodeAndRegistration** node_and_registrations) {
-  SnapshotAllocationUsage(recorded_node_and_registration_array_data_);
+  RecordedAllocation allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status = MicroAllocator::AllocateNodeAndRegistrations(
       subgraph, node_and_registrations);
 
-  RecordAllocationUsage(recorded_node_and_registration_array_data_);
+  RecordAllocationUsage(allocations,
+                        recorded_node_and_registration_array_data_);
   recorded_node_and_registration_array_data_.count =
       subgraph->operators()->size();
   return status;
@@ -149,43 +222,72 @@ RecordingMicroAllocator::PrepareNodeAndRegistrationDataFromFlatbuffer(
     const Model* model, const SubGraph* subgraph,
     const MicroOpResolver& op_resolver,
     NodeAndRegistration* node_and_registrations) {
-  SnapshotAllocationUsage(recorded_op_data_);
+  RecordedAllocation allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status =
       MicroAllocator::PrepareNodeAndRegistrationDataFromFlatbuffer(
           model, subgraph, op_resolver, node_and_registrations);
 
-  RecordAllocationUsage(recorded_op_data_);
+  RecordAllocationUsage(allocations, recorded_op_data_);
   return status;
 }
 
 TfLiteStatus RecordingMicroAllocator::AllocateVariables(
     TfLiteContext* context, const SubGraph* subgraph) {
-  SnapshotAllocationUsage(recorded_tflite_tensor_variable_buffer_data_);
+  RecordedAllocation allocations = SnapshotAllocationUsage();
 
   TfLiteStatus status = MicroAllocator::AllocateVariables(context, subgraph);
 
-  RecordAllocationUsage(recorded_tflite_tensor_variable_buffer_data_);
+  RecordAllocationUsage(allocations,
+                        recorded_tflite_tensor_variable_buffer_data_);
   return status;
 }
 
-void RecordingMicroAllocator::SnapshotAllocationUsage(
-    RecordedAllocation& recorded_allocation) {
-  recorded_allocation.requested_bytes =
+TfLiteStatus RecordingMicroAllocator::CommitStaticMemoryPlan(
+    const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+    TfLiteEvalTensor* eval_tensors) {
+  // The planner works in temp allocations and may start the head over (see
+  // set_share_non_persistent_memory()), so only the head it leaves behind is
+  // recorded.
+  const size_t head_used_bytes =
+      recording_memory_allocator_->GetHeadUsedBytes();
+
+  TfLiteStatus status = MicroAllocator::CommitStaticMemoryPlan(
+      model, context, subgraph, eval_tensors);
+
+  const size_t plan_bytes = recording_memory_allocator_->GetHeadUsedBytes();
+  if (plan_bytes > head_used_bytes) {
+    recorded_non_persistent_plan_.requested_bytes +=
+        plan_bytes - head_used_bytes;
+    recorded_non_persistent_plan_.used_bytes += plan_bytes - head_used_bytes;
+  }
+  recorded_non_persistent_plan_.count++;
+  return status;
+}
+
+RecordedAllocation RecordingMicroAllocator::SnapshotAllocationUsage() const {
+  RecordedAllocation snapshotted_allocation;
+  snapshotted_allocation.requested_bytes =
       recording_memory_allocator_->GetRequestedBytes();
-  recorded_allocation.used_bytes = recording_memory_allocator_->GetUsedBytes();
-  recorded_allocation.count = recording_memory_allocator_->GetAllocatedCount();
+  snapshotted_allocation.used_bytes =
+      recording_memory_allocator_->GetUsedBytes();
+  snapshotted_allocation.count =
+      recording_memory_allocator_->GetAllocatedCount();
+  return snapshotted_allocation;
 }
 
 void RecordingMicroAllocator::RecordAllocationUsage(
+    const RecordedAllocation& snapshotted_allocation,
     RecordedAllocation& recorded_allocation) {
-  recorded_allocation.requested_bytes =
+  recorded_allocation.requested_bytes +=
       recording_memory_allocator_->GetRequestedBytes() -
-      recorded_allocation.requested_bytes;
-  recorded_allocation.used_bytes = recording_memory_allocator_->GetUsedBytes() -
-                                   recorded_allocation.used_bytes;
-  recorded_allocation.count = recording_memory_allocator_->GetAllocatedCount() -
-                              recorded_allocation.count;
+      snapshotted_allocation.requested_bytes;
+  recorded_allocation.used_bytes +=
+      recording_memory_allocator_->GetUsedBytes() -
+      snapshotted_allocation.used_bytes;
+  recorded_allocation.count +=
+      recording_memory_allocator_->GetAllocatedCount() -
+      snapshotted_allocation.count;
 }
 
 }  // namespace tflite
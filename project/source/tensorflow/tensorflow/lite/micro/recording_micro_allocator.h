@@ -25,11 +25,23 @@ namespace tflite {
 // List of buckets currently recorded by this class. Each type keeps a list of
 // allocated information during model initialization.
 enum class RecordedAllocationType {
+  kTfLiteEvalTensorData,
   kTfLiteTensorArray,
   kTfLiteTensorArrayQuantizationData,
   kTfLiteTensorVariableBufferData,
   kNodeAndRegistrationArray,
   kOpData,
+  // TfLiteTensors of MicroInterpreter::input(), output() and tensor().
+  kPersistentTfLiteTensorData,
+  // Buffers allocated through AllocatePersistentBuffer(): kernel data,
+  // streaming caches and the bookkeeping of the interpreter.
+  kPersistentBufferData,
+  // Handles of the scratch buffers the kernels request; the buffers
+  // themselves are part of the non-persistent plan.
+  kScratchBufferHandles,
+  // The 'head' section committed by CommitStaticMemoryPlan(): activation and
+  // scratch buffers.
+  kNonPersistentPlan,
 };
 
 // Container for holding information about allocation recordings by a given
@@ -56,6 +68,13 @@ class RecordingMicroAllocator : public MicroAllocator {
                                          size_t arena_size,
                                          ErrorReporter* error_reporter);
 
+  TfLiteTensor* AllocatePersistentTfLiteTensor(
+      const Model* model, const TfLiteEvalTensor* eval_tensors,
+      int tensor_index) override;
+  TfLiteStatus AllocatePersistentBuffer(size_t bytes, void** ptr) override;
+  TfLiteStatus RequestScratchBufferInArena(int node_id, size_t bytes,
+                                           int* buffer_idx) override;
+
   // Returns the recorded allocations information for a given allocation type.
   RecordedAllocation GetRecordedAllocation(
       RecordedAllocationType allocation_type) const;
@@ -67,11 +86,14 @@ class RecordingMicroAllocator : public MicroAllocator {
   void PrintAllocations() const;
 
  protected:
+  TfLiteStatus AllocateTfLiteEvalTensors(
+      const Model* model, const SubGraph* subgraph,
+      TfLiteEvalTensor** eval_tensors) override;
   TfLiteStatus AllocateTfLiteTensorArray(TfLiteContext* context,
                                          const SubGraph* subgraph) override;
   TfLiteStatus PopulateTfLiteTensorArrayFromFlatbuffer(
-      const Model* model, TfLiteContext* context,
-      const SubGraph* subgraph) override;
+      const Model* model, TfLiteContext* context, const SubGraph* subgraph,
+      const TfLiteEvalTensor* eval_tensors) override;
   TfLiteStatus AllocateNodeAndRegistrations(
       const SubGraph* subgraph,
       NodeAndRegistration** node_and_registrations) override;
@@ -81,9 +103,16 @@ class RecordingMicroAllocator : public MicroAllocator {
       NodeAndRegistration* node_and_registrations) override;
   TfLiteStatus AllocateVariables(TfLiteContext* context,
                                  const SubGraph* subgraph) override;
+  TfLiteStatus CommitStaticMemoryPlan(const Model* model,
+                                      TfLiteContext* context,
+                                      const SubGraph* subgraph,
+                                      TfLiteEvalTensor* eval_tensors) override;
 
-  void SnapshotAllocationUsage(RecordedAllocation& recorded_allocation);
-  void RecordAllocationUsage(RecordedAllocation& recorded_allocation);
+  RecordedAllocation SnapshotAllocationUsage() const;
+  // Adds the allocations made since `snapshotted_allocation` was taken to
+  // `recorded_allocation`.
+  void RecordAllocationUsage(const RecordedAllocation& snapshotted_allocation,
+                             RecordedAllocation& recorded_allocation);
 
  private:
   RecordingMicroAllocator(RecordingSimpleMemoryAllocator* memory_allocator,
@@ -95,11 +124,16 @@ class RecordingMicroAllocator : public MicroAllocator {
 
   const RecordingSimpleMemoryAllocator* recording_memory_allocator_;
 
+  RecordedAllocation recorded_tflite_eval_tensor_data_;
   RecordedAllocation recorded_tflite_tensor_array_data_;
   RecordedAllocation recorded_tflite_tensor_array_quantization_data_;
   RecordedAllocation recorded_tflite_tensor_variable_buffer_data_;
   RecordedAllocation recorded_node_and_registration_array_data_;
   RecordedAllocation recorded_op_data_;
+  RecordedAllocation recorded_persistent_tflite_tensor_data_;
+  RecordedAllocation recorded_persistent_buffer_data_;
+  RecordedAllocation recorded_scratch_buffer_handles_;
+  RecordedAllocation recorded_non_persistent_plan_;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
@@ -80,4 +80,14 @@ uint8_t* RecordingSimpleMemoryAllocator::AllocateFromTail(size_t size,
   return result;
 }
 
+uint8_t* RecordingSimpleMemoryAllocator::AllocateTemp(size_t size,
+                                                      size_t alignment) {
+  uint8_t* result = SimpleMemoryAllocator::AllocateTemp(size, alignment);
+  if (result != nullptr) {
+    requested_bytes_ += size;
+    alloc_count_++;
+  }
+  return result;
+}
+
 }  // namespace tflite
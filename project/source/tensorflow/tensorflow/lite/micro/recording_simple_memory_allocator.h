@@ -36,19 +36,21 @@ class RecordingSimpleMemoryAllocator : public SimpleMemoryAllocator {
                                                 uint8_t* buffer_head,
                                                 size_t buffer_size);
 
-  // Returns the number of bytes requested from the head or tail.
+  // Returns the number of bytes requested from the head, tail or as temp
+  // allocations.
   size_t GetRequestedBytes() const;
 
   // Returns the number of bytes actually allocated from the head or tail. This
   // value will be >= to the number of requested bytes due to padding and
-  // alignment.
+  // alignment. Temp allocations are released again and not counted.
   size_t GetUsedBytes() const;
 
-  // Returns the number of alloc calls from the head or tail.
+  // Returns the number of alloc calls from the head, tail or temp.
   size_t GetAllocatedCount() const;
 
   uint8_t* AllocateFromHead(size_t size, size_t alignment) override;
   uint8_t* AllocateFromTail(size_t size, size_t alignment) override;
+  uint8_t* AllocateTemp(size_t size, size_t alignment) override;
 
  private:
   size_t requested_bytes_;
@@ -32,7 +32,8 @@ SimpleMemoryAllocator::SimpleMemoryAllocator(ErrorReporter* error_reporter,
       buffer_head_(buffer_head),
       buffer_tail_(buffer_tail),
       head_(buffer_head),
-      tail_(buffer_tail) {}
+      tail_(buffer_tail),
+      temp_(buffer_head) {}
 
 SimpleMemoryAllocator::SimpleMemoryAllocator(ErrorReporter* error_reporter,
                                              uint8_t* buffer,
@@ -60,6 +61,12 @@ SimpleMemoryAllocator::~SimpleMemoryAllocator() {}
 
 uint8_t* SimpleMemoryAllocator::AllocateFromHead(size_t size,
                                                  size_t alignment) {
+  if (temp_ != head_) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Internal error: AllocateFromHead() called while "
+                         "temp allocations are alive.");
+    return nullptr;
+  }
   uint8_t* const aligned_result = AlignPointerUp(head_, alignment);
   const size_t available_memory = tail_ - aligned_result;
   if (available_memory < size) {
@@ -70,14 +77,15 @@ uint8_t* SimpleMemoryAllocator::AllocateFromHead(size_t size,
     return nullptr;
   }
   head_ = aligned_result + size;
+  temp_ = head_;
   return aligned_result;
 }
 
 uint8_t* SimpleMemoryAllocator::AllocateFromTail(size_t size,
                                                  size_t alignment) {
   uint8_t* const aligned_result = AlignPointerDown(tail_ - size, alignment);
-  if (aligned_result < head_) {
-    const size_t missing_memory = head_ - aligned_result;
+  if (aligned_result < temp_) {
+    const size_t missing_memory = temp_ - aligned_result;
     TF_LITE_REPORT_ERROR(
         error_reporter_,
         "Failed to allocate memory. Requested: %u, available %u, missing: %u",
@@ -88,6 +96,29 @@ uint8_t* SimpleMemoryAllocator::AllocateFromTail(size_t size,
   return aligned_result;
 }
 
+uint8_t* SimpleMemoryAllocator::AllocateTemp(size_t size, size_t alignment) {
+  uint8_t* const aligned_result = AlignPointerUp(temp_, alignment);
+  const size_t available_memory = tail_ - aligned_result;
+  if (available_memory < size) {
+    TF_LITE_REPORT_ERROR(error_reporter_,
+                         "Failed to allocate temp memory. Requested: %u, "
+                         "available %u, missing: %u",
+                         size, available_memory, size - available_memory);
+    return nullptr;
+  }
+  temp_ = aligned_result + size;
+  return aligned_result;
+}
+
+void SimpleMemoryAllocator::ResetTempAllocations() { temp_ = head_; }
+
+void SimpleMemoryAllocator::ResetHead() {
+  if (temp_ == head_) {
+    temp_ = buffer_head_;
+  }
+  head_ = buffer_head_;
+}
+
 uint8_t* SimpleMemoryAllocator::GetHead() const { return head_; }
 
 uint8_t* SimpleMemoryAllocator::GetTail() const { return tail_; }
@@ -101,7 +132,7 @@ size_t SimpleMemoryAllocator::GetTailUsedBytes() const {
 }
 
 size_t SimpleMemoryAllocator::GetAvailableMemory() const {
-  return tail_ - head_;
+  return tail_ - temp_;
 }
 
 size_t SimpleMemoryAllocator::GetUsedBytes() const {
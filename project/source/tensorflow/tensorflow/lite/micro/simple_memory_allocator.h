@@ -49,6 +49,20 @@ class SimpleMemoryAllocator {
   // moving downwards).
   virtual uint8_t* AllocateFromTail(size_t size, size_t alignment);
 
+  // Allocates memory right above the head that is only valid until the next
+  // ResetTempAllocations() call. Temp allocations stack on each other, tail
+  // allocations do not reach into them, and the head cannot grow while any
+  // of them is alive.
+  virtual uint8_t* AllocateTemp(size_t size, size_t alignment);
+
+  // Frees all temp allocations.
+  void ResetTempAllocations();
+
+  // Moves the head back to the start of the buffer, so that the memory of all
+  // head allocations is handed out again. Only the tail and the temp
+  // allocations are kept.
+  void ResetHead();
+
   uint8_t* GetHead() const;
   uint8_t* GetTail() const;
 
@@ -66,6 +80,8 @@ class SimpleMemoryAllocator {
   uint8_t* buffer_tail_;
   uint8_t* head_;
   uint8_t* tail_;
+  // End of the temp allocations, head_ if there are none.
+  uint8_t* temp_;
 
   TF_LITE_REMOVE_VIRTUAL_DELETE
 };
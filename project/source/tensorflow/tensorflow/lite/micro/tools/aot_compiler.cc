@@ -0,0 +1,763 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Ahead-of-time compiler for TFLM models.
+//
+// Usage: aot_compiler <model.tflite> <name> <output_dir>
+//
+// Writes <output_dir>/<name>.h and <output_dir>/<name>.cc, which implement the
+// model in namespace <name> as static tensors, nodes and builtin options plus
+// an Invoke() that calls the kernels one after another. The generated code
+// only depends on the kernels it uses and on MicroAotRuntime, so the device
+// does no flatbuffer parsing, op lookup or memory planning:
+//
+//   TfLiteStatus Init(tflite::ErrorReporter* error_reporter);
+//   TfLiteStatus Invoke();
+//   TfLiteTensor* input(int index);
+//   TfLiteTensor* output(int index);
+//
+// The model is planned by running MicroInterpreter::AllocateTensors() on the
+// host, and the offsets of its activations and scratch buffers are copied
+// into the generated code. Init() still calls the init and prepare function
+// of every kernel once, since the layout of their OpData is private to each
+// kernel, but the results of Invoke() are bit-exact with the interpreter's
+// because the same kernels run on the same memory plan.
+//
+// The persistent pool is sized from the host run, where pointers are 8 bytes,
+// so it is an upper bound of what a 32-bit device needs.
+//
+// Only models the micro kernels can run are compiled. The emergency_detect
+// demo model embedded in app/lib_src/emergency_detect/emergency-detect.cc is
+// one of them, the .tflite files next to it are not: emergency-detect.tflite
+// is a hybrid model (float activations with int8 weights in its second conv
+// and its fully connected layer) and emergency-detect-82.tflite uses
+// REDUCE_MAX, which has no micro kernel. Both are reported before planning.
+
+#include <algorithm>
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/c/builtin_op_data.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_aot_runtime.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+constexpr size_t kArenaSize = 16 * 1024 * 1024;
+constexpr size_t kPersistentSize = 1024 * 1024;
+constexpr int kMaxScratchBuffers = 256;
+constexpr size_t kBufferAlignment = 16;
+
+alignas(16) uint8_t tensor_arena[kArenaSize];
+alignas(16) uint8_t persistent_pool[kPersistentSize];
+tflite::AotScratchBuffer scratch_buffers[kMaxScratchBuffers];
+
+// Gives the compiler access to the scratch buffers planned by the allocator.
+class PlanningInterpreter : public tflite::MicroInterpreter {
+ public:
+  using MicroInterpreter::MicroInterpreter;
+
+  uint8_t* scratch_buffer(int buffer_idx) const {
+    return static_cast<uint8_t*>(allocator().GetScratchBuffer(buffer_idx));
+  }
+};
+
+// Everything about the model that goes into the generated code.
+struct CompiledModel {
+  std::vector<TfLiteTensor> tensors;
+  std::vector<TfLiteNode> nodes;
+  std::vector<const TfLiteRegistration*> registrations;
+  std::vector<int> inputs;
+  std::vector<int> outputs;
+  std::vector<tflite::AotScratchBuffer> scratch_buffers;
+  // Offset of every kTfLiteArenaRw tensor, -1 for the other tensors.
+  std::vector<long> tensor_offsets;
+  size_t arena_size;
+  size_t persistent_size;
+};
+
+size_t AlignSize(size_t size) {
+  return (size + kBufferAlignment - 1) / kBufferAlignment * kBufferAlignment;
+}
+
+bool IsIdentifier(const char* name) {
+  if (name[0] == '\0' || (name[0] >= '0' && name[0] <= '9')) {
+    return false;
+  }
+  for (const char* c = name; *c != '\0'; ++c) {
+    if (!(*c == '_' || (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+          (*c >= '0' && *c <= '9'))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data->resize(size > 0 ? size : 0);
+  const bool ok = size > 0 && fread(data->data(), 1, size, file) ==
+                                  static_cast<size_t>(size);
+  fclose(file);
+  return ok;
+}
+
+const char* TypeName(TfLiteType type) {
+  switch (type) {
+    case kTfLiteFloat32:
+      return "kTfLiteFloat32";
+    case kTfLiteInt32:
+      return "kTfLiteInt32";
+    case kTfLiteUInt8:
+      return "kTfLiteUInt8";
+    case kTfLiteInt64:
+      return "kTfLiteInt64";
+    case kTfLiteBool:
+      return "kTfLiteBool";
+    case kTfLiteInt16:
+      return "kTfLiteInt16";
+    case kTfLiteInt8:
+      return "kTfLiteInt8";
+    case kTfLiteFloat16:
+      return "kTfLiteFloat16";
+    case kTfLiteFloat64:
+      return "kTfLiteFloat64";
+    default:
+      return nullptr;
+  }
+}
+
+const char* PaddingName(TfLitePadding padding) {
+  switch (padding) {
+    case kTfLitePaddingSame:
+      return "kTfLitePaddingSame";
+    case kTfLitePaddingValid:
+      return "kTfLitePaddingValid";
+    default:
+      return "kTfLitePaddingUnknown";
+  }
+}
+
+const char* ActivationName(TfLiteFusedActivation activation) {
+  switch (activation) {
+    case kTfLiteActRelu:
+      return "kTfLiteActRelu";
+    case kTfLiteActRelu1:
+      return "kTfLiteActRelu1";
+    case kTfLiteActRelu6:
+      return "kTfLiteActRelu6";
+    case kTfLiteActTanh:
+      return "kTfLiteActTanh";
+    case kTfLiteActSignBit:
+      return "kTfLiteActSignBit";
+    case kTfLiteActSigmoid:
+      return "kTfLiteActSigmoid";
+    default:
+      return "kTfLiteActNone";
+  }
+}
+
+const char* BoolName(bool value) { return value ? "true" : "false"; }
+
+// Prints a float literal that reads back as exactly `value`.
+std::string FloatLiteral(float value) {
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.9g", value);
+  std::string literal = buffer;
+  if (literal.find_first_of(".e") == std::string::npos) {
+    literal += ".0";
+  }
+  return literal + "f";
+}
+
+void PrintIntArray(FILE* out, const char* name, const TfLiteIntArray* array) {
+  fprintf(out, "tflite::AotIntArray<%d> %s = {%d, {", std::max(array->size, 1),
+          name, array->size);
+  for (int i = 0; i < array->size; ++i) {
+    fprintf(out, "%s%d", i == 0 ? "" : ", ", array->data[i]);
+  }
+  fprintf(out, "}};\n");
+}
+
+void PrintFloatArray(FILE* out, const char* name,
+                     const TfLiteFloatArray* array) {
+  fprintf(out, "tflite::AotFloatArray<%d> %s = {%d, {",
+          std::max(array->size, 1), name, array->size);
+  for (int i = 0; i < array->size; ++i) {
+    fprintf(out, "%s%s", i == 0 ? "" : ", ",
+            FloatLiteral(array->data[i]).c_str());
+  }
+  fprintf(out, "}};\n");
+}
+
+void PrintBytes(FILE* out, const char* name, const uint8_t* data,
+                size_t bytes) {
+  fprintf(out, "alignas(16) const uint8_t %s[%zu] = {", name, bytes);
+  for (size_t i = 0; i < bytes; ++i) {
+    fprintf(out, "%s0x%02x,", i % 16 == 0 ? "\n    " : " ", data[i]);
+  }
+  fprintf(out, "\n};\n");
+}
+
+// Prints the builtin options of node `index` as a static struct named
+// node_<index>_params. Options are spelled out field by field so the generated
+// code does not depend on the struct layout of the host.
+bool PrintBuiltinData(FILE* out, int index, int32_t builtin_code,
+                      const void* builtin_data) {
+  switch (builtin_code) {
+    case tflite::BuiltinOperator_CONV_2D: {
+      const auto* p = static_cast<const TfLiteConvParams*>(builtin_data);
+      fprintf(out,
+              "TfLiteConvParams node_%d_params = {%s, %d, %d, %s, %d, %d};\n",
+              index, PaddingName(p->padding), p->stride_width,
+              p->stride_height, ActivationName(p->activation),
+              p->dilation_width_factor, p->dilation_height_factor);
+      return true;
+    }
+    case tflite::BuiltinOperator_DEPTHWISE_CONV_2D: {
+      const auto* p =
+          static_cast<const TfLiteDepthwiseConvParams*>(builtin_data);
+      fprintf(out,
+              "TfLiteDepthwiseConvParams node_%d_params = {%s, %d, %d, %d, "
+              "%s, %d, %d};\n",
+              index, PaddingName(p->padding), p->stride_width,
+              p->stride_height, p->depth_multiplier,
+              ActivationName(p->activation), p->dilation_width_factor,
+              p->dilation_height_factor);
+      return true;
+    }
+    case tflite::BuiltinOperator_AVERAGE_POOL_2D:
+    case tflite::BuiltinOperator_MAX_POOL_2D:
+    case tflite::BuiltinOperator_L2_POOL_2D: {
+      // `computed` is filled in by Prepare().
+      const auto* p = static_cast<const TfLitePoolParams*>(builtin_data);
+      fprintf(out,
+              "TfLitePoolParams node_%d_params = {%s, %d, %d, %d, %d, %s, "
+              "{}};\n",
+              index, PaddingName(p->padding), p->stride_width,
+              p->stride_height, p->filter_width, p->filter_height,
+              ActivationName(p->activation));
+      return true;
+    }
+    case tflite::BuiltinOperator_FULLY_CONNECTED: {
+      const auto* p =
+          static_cast<const TfLiteFullyConnectedParams*>(builtin_data);
+      fprintf(out,
+              "TfLiteFullyConnectedParams node_%d_params = {%s, %s, %s, "
+              "%s};\n",
+              index, ActivationName(p->activation),
+              p->weights_format == kTfLiteFullyConnectedWeightsFormatDefault
+                  ? "kTfLiteFullyConnectedWeightsFormatDefault"
+                  : "kTfLiteFullyConnectedWeightsFormatShuffled4x16Int8",
+              BoolName(p->keep_num_dims),
+              BoolName(p->asymmetric_quantize_inputs));
+      return true;
+    }
+    case tflite::BuiltinOperator_SOFTMAX: {
+      const auto* p = static_cast<const TfLiteSoftmaxParams*>(builtin_data);
+      fprintf(out, "TfLiteSoftmaxParams node_%d_params = {%s};\n", index,
+              FloatLiteral(p->beta).c_str());
+      return true;
+    }
+    case tflite::BuiltinOperator_CONCATENATION: {
+      const auto* p =
+          static_cast<const TfLiteConcatenationParams*>(builtin_data);
+      fprintf(out, "TfLiteConcatenationParams node_%d_params = {%d, %s};\n",
+              index, p->axis, ActivationName(p->activation));
+      return true;
+    }
+    case tflite::BuiltinOperator_ADD:
+    case tflite::BuiltinOperator_SUB:
+    case tflite::BuiltinOperator_MUL:
+    case tflite::BuiltinOperator_DIV: {
+      // All four option structs hold only the fused activation.
+      const char* type =
+          builtin_code == tflite::BuiltinOperator_ADD
+              ? "TfLiteAddParams"
+              : builtin_code == tflite::BuiltinOperator_SUB
+                    ? "TfLiteSubParams"
+                    : builtin_code == tflite::BuiltinOperator_MUL
+                          ? "TfLiteMulParams"
+                          : "TfLiteDivParams";
+      const auto* p = static_cast<const TfLiteAddParams*>(builtin_data);
+      fprintf(out, "%s node_%d_params = {%s};\n", type, index,
+              ActivationName(p->activation));
+      return true;
+    }
+    case tflite::BuiltinOperator_RESHAPE: {
+      const auto* p = static_cast<const TfLiteReshapeParams*>(builtin_data);
+      fprintf(out, "TfLiteReshapeParams node_%d_params = {{", index);
+      for (int i = 0; i < p->num_dimensions; ++i) {
+        fprintf(out, "%s%d", i == 0 ? "" : ", ", p->shape[i]);
+      }
+      fprintf(out, "}, %d};\n", p->num_dimensions);
+      return true;
+    }
+    default:
+      return false;
+  }
+}
+
+// Reports operators without a micro kernel and hybrid operators, whose kernels
+// only fail with a generic message once the model is planned.
+bool CheckOperators(const tflite::Model* model,
+                    const tflite::MicroOpResolver& resolver,
+                    tflite::ErrorReporter* error_reporter) {
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  bool ok = true;
+  for (size_t i = 0; i < subgraph->operators()->size(); ++i) {
+    const tflite::Operator* op = subgraph->operators()->Get(i);
+    const tflite::OperatorCode* opcode =
+        model->operator_codes()->Get(op->opcode_index());
+    const tflite::BuiltinOperator builtin_code = opcode->builtin_code();
+    const char* op_name =
+        builtin_code == tflite::BuiltinOperator_CUSTOM
+            ? (opcode->custom_code() != nullptr ? opcode->custom_code()->c_str()
+                                                : "CUSTOM")
+            : tflite::EnumNameBuiltinOperator(builtin_code);
+    const TfLiteRegistration* registration =
+        builtin_code == tflite::BuiltinOperator_CUSTOM
+            ? resolver.FindOp(op_name)
+            : resolver.FindOp(builtin_code);
+    if (registration == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter, "Node %d: %s has no micro kernel",
+                           i, op_name);
+      ok = false;
+      continue;
+    }
+    if ((builtin_code == tflite::BuiltinOperator_FULLY_CONNECTED ||
+         builtin_code == tflite::BuiltinOperator_CONV_2D ||
+         builtin_code == tflite::BuiltinOperator_DEPTHWISE_CONV_2D) &&
+        op->inputs()->size() >= 2) {
+      const tflite::Tensor* input =
+          subgraph->tensors()->Get(op->inputs()->Get(0));
+      const tflite::Tensor* weights =
+          subgraph->tensors()->Get(op->inputs()->Get(1));
+      if (input->type() == tflite::TensorType_FLOAT32 &&
+          weights->type() != tflite::TensorType_FLOAT32) {
+        TF_LITE_REPORT_ERROR(
+            error_reporter,
+            "Node %d: hybrid %s (float input, %s weights) is not supported, "
+            "keep its weights float or quantize the whole model",
+            i, op_name, tflite::EnumNameTensorType(weights->type()));
+        ok = false;
+      }
+    }
+  }
+  return ok;
+}
+
+// Plans the model with the interpreter and runs the kernels' init and prepare
+// once more through MicroAotRuntime to size its pools.
+bool CompileModel(const tflite::Model* model,
+                  tflite::ErrorReporter* error_reporter,
+                  CompiledModel* compiled) {
+  tflite::AllOpsResolver resolver;
+  if (model->subgraphs()->size() != 1) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Only one subgraph is supported");
+    return false;
+  }
+  if (!CheckOperators(model, resolver, error_reporter)) {
+    return false;
+  }
+  PlanningInterpreter interpreter(model, resolver, tensor_arena, kArenaSize,
+                                  error_reporter);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    TF_LITE_REPORT_ERROR(error_reporter, "AllocateTensors() failed");
+    return false;
+  }
+
+  for (size_t i = 0; i < interpreter.tensors_size(); ++i) {
+    const TfLiteTensor* tensor = interpreter.tensor(i);
+    if (tensor->is_variable) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Tensor %d: variable tensors are not supported", i);
+      return false;
+    }
+    // The generated tensors carry no sparsity parameters or palettes for the
+    // kernels.
+    if (tensor->sparsity != nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Tensor %d: sparse tensors are not supported", i);
+      return false;
+    }
+    if (tflite::internal::IsPalettizedTensor(
+            *model->subgraphs()->Get(0)->tensors()->Get(i))) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Tensor %d: palettized tensors are not supported",
+                           i);
+      return false;
+    }
+    if (TypeName(tensor->type) == nullptr) {
+      TF_LITE_REPORT_ERROR(error_reporter, "Tensor %d: unsupported type %s",
+                           i, TfLiteTypeGetName(tensor->type));
+      return false;
+    }
+    compiled->tensors.push_back(*tensor);
+    long offset = -1;
+    if (tensor->allocation_type == kTfLiteArenaRw) {
+      offset = tensor->data.raw != nullptr
+                   ? static_cast<long>(
+                         reinterpret_cast<uint8_t*>(tensor->data.raw) -
+                         tensor_arena)
+                   : 0;
+    }
+    compiled->tensor_offsets.push_back(offset);
+  }
+  for (size_t i = 0; i < interpreter.inputs_size(); ++i) {
+    compiled->inputs.push_back(interpreter.inputs().Get(i));
+  }
+  for (size_t i = 0; i < interpreter.outputs_size(); ++i) {
+    compiled->outputs.push_back(interpreter.outputs().Get(i));
+  }
+
+  for (size_t i = 0; i < interpreter.operators_size(); ++i) {
+    const tflite::NodeAndRegistration node_and_registration =
+        interpreter.node_and_registration(i);
+    const TfLiteRegistration* registration =
+        node_and_registration.registration;
+    if (registration->builtin_code == tflite::BuiltinOperator_CUSTOM) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Node %d: custom operators are not supported", i);
+      return false;
+    }
+    TfLiteNode node = node_and_registration.node;
+    node.user_data = nullptr;
+    compiled->nodes.push_back(node);
+    compiled->registrations.push_back(registration);
+  }
+
+  tflite::MicroAotRuntime runtime(
+      compiled->tensors.data(), compiled->tensors.size(), nullptr,
+      scratch_buffers, kMaxScratchBuffers, persistent_pool, kPersistentSize,
+      error_reporter);
+  if (runtime.Prepare(compiled->nodes.data(), compiled->registrations.data(),
+                      compiled->nodes.size()) != kTfLiteOk) {
+    return false;
+  }
+  compiled->persistent_size = AlignSize(runtime.persistent_used_bytes());
+
+  size_t arena_size = 0;
+  for (size_t i = 0; i < compiled->tensors.size(); ++i) {
+    if (compiled->tensor_offsets[i] >= 0) {
+      arena_size = std::max(arena_size, compiled->tensor_offsets[i] +
+                                            compiled->tensors[i].bytes);
+    }
+  }
+  for (int i = 0; i < runtime.scratch_buffers_requested(); ++i) {
+    tflite::AotScratchBuffer buffer = scratch_buffers[i];
+    buffer.offset =
+        static_cast<uint32_t>(interpreter.scratch_buffer(i) - tensor_arena);
+    arena_size = std::max<size_t>(arena_size, buffer.offset + buffer.bytes);
+    compiled->scratch_buffers.push_back(buffer);
+  }
+  compiled->arena_size = AlignSize(arena_size);
+  return true;
+}
+
+void WriteHeader(FILE* out, const char* name, const char* model_path,
+                 const CompiledModel& compiled) {
+  fprintf(out, "// Generated by aot_compiler from %s. Do not edit.\n\n",
+          model_path);
+  std::string guard = name;
+  for (char& c : guard) {
+    c = static_cast<char>(toupper(c));
+  }
+  guard += "_H_";
+  fprintf(out, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+  fprintf(out,
+          "#include <cstddef>\n\n"
+          "#include \"tensorflow/lite/c/common.h\"\n"
+          "#include \"tensorflow/lite/core/api/error_reporter.h\"\n\n");
+  fprintf(out, "namespace %s {\n\n", name);
+  fprintf(out, "constexpr int kInputsSize = %zu;\n", compiled.inputs.size());
+  fprintf(out, "constexpr int kOutputsSize = %zu;\n", compiled.outputs.size());
+  fprintf(out, "// Bytes of activations and scratch buffers.\n");
+  fprintf(out, "constexpr size_t kArenaSize = %zu;\n", compiled.arena_size);
+  fprintf(out, "// Bytes of kernel data allocated by Init().\n");
+  fprintf(out, "constexpr size_t kPersistentSize = %zu;\n\n",
+          compiled.persistent_size);
+  fprintf(out,
+          "// Prepares the kernels. Must be called once before Invoke().\n"
+          "TfLiteStatus Init(tflite::ErrorReporter* error_reporter);\n\n"
+          "TfLiteStatus Invoke();\n\n"
+          "TfLiteTensor* input(int index);\n"
+          "TfLiteTensor* output(int index);\n\n");
+  fprintf(out, "}  // namespace %s\n\n#endif  // %s\n", name, guard.c_str());
+}
+
+bool WriteSource(FILE* out, const char* name, const char* model_path,
+                 const CompiledModel& compiled,
+                 tflite::ErrorReporter* error_reporter) {
+  const int tensors_size = static_cast<int>(compiled.tensors.size());
+  const int nodes_size = static_cast<int>(compiled.nodes.size());
+  const int scratch_buffers_size =
+      static_cast<int>(compiled.scratch_buffers.size());
+
+  fprintf(out, "// Generated by aot_compiler from %s. Do not edit.\n\n",
+          model_path);
+  fprintf(out, "#include \"%s.h\"\n\n", name);
+  fprintf(out,
+          "#include <cstdint>\n\n"
+          "#include \"tensorflow/lite/c/builtin_op_data.h\"\n"
+          "#include \"tensorflow/lite/micro/kernels/micro_ops.h\"\n"
+          "#include \"tensorflow/lite/micro/micro_aot_runtime.h\"\n\n");
+  fprintf(out, "namespace %s {\nnamespace {\n\n", name);
+  fprintf(out, "constexpr int kTensorsSize = %d;\n", tensors_size);
+  fprintf(out, "constexpr int kNodesSize = %d;\n", nodes_size);
+  fprintf(out, "constexpr int kScratchBuffersSize = %d;\n\n",
+          std::max(scratch_buffers_size, 1));
+  fprintf(out, "alignas(16) uint8_t arena[kArenaSize];\n");
+  fprintf(out, "alignas(16) uint8_t persistent[kPersistentSize];\n\n");
+
+  fprintf(out, "tflite::AotScratchBuffer scratch_buffers[] = {\n");
+  for (const tflite::AotScratchBuffer& buffer : compiled.scratch_buffers) {
+    fprintf(out, "    {%u, %u},\n", buffer.offset, buffer.bytes);
+  }
+  if (scratch_buffers_size == 0) {
+    fprintf(out, "    {0, 0},\n");
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out, "const int inputs[] = {");
+  for (size_t i = 0; i < compiled.inputs.size(); ++i) {
+    fprintf(out, "%s%d", i == 0 ? "" : ", ", compiled.inputs[i]);
+  }
+  fprintf(out, "};\nconst int outputs[] = {");
+  for (size_t i = 0; i < compiled.outputs.size(); ++i) {
+    fprintf(out, "%s%d", i == 0 ? "" : ", ", compiled.outputs[i]);
+  }
+  fprintf(out, "};\n\n");
+
+  // Constant tensors, shared between tensors that use the same buffer.
+  std::map<const void*, int> constant_owner;
+  for (int i = 0; i < tensors_size; ++i) {
+    const TfLiteTensor& tensor = compiled.tensors[i];
+    if (tensor.allocation_type != kTfLiteMmapRo ||
+        constant_owner.count(tensor.data.data) != 0) {
+      continue;
+    }
+    constant_owner[tensor.data.data] = i;
+    char array_name[32];
+    snprintf(array_name, sizeof(array_name), "tensor_%d_data", i);
+    PrintBytes(out, array_name, static_cast<const uint8_t*>(tensor.data.data),
+               tensor.bytes);
+  }
+  fprintf(out, "\n");
+
+  for (int i = 0; i < tensors_size; ++i) {
+    const TfLiteTensor& tensor = compiled.tensors[i];
+    char array_name[40];
+    snprintf(array_name, sizeof(array_name), "tensor_%d_dims", i);
+    PrintIntArray(out, array_name, tensor.dims);
+    if (tensor.quantization.type == kTfLiteAffineQuantization) {
+      const auto* quantization = static_cast<const TfLiteAffineQuantization*>(
+          tensor.quantization.params);
+      snprintf(array_name, sizeof(array_name), "tensor_%d_scale", i);
+      PrintFloatArray(out, array_name, quantization->scale);
+      snprintf(array_name, sizeof(array_name), "tensor_%d_zero_point", i);
+      PrintIntArray(out, array_name, quantization->zero_point);
+      fprintf(out, "TfLiteAffineQuantization tensor_%d_quantization;\n", i);
+    }
+  }
+  fprintf(out, "\n");
+
+  for (int i = 0; i < nodes_size; ++i) {
+    const TfLiteNode& node = compiled.nodes[i];
+    char array_name[40];
+    snprintf(array_name, sizeof(array_name), "node_%d_inputs", i);
+    PrintIntArray(out, array_name, node.inputs);
+    snprintf(array_name, sizeof(array_name), "node_%d_outputs", i);
+    PrintIntArray(out, array_name, node.outputs);
+    if (node.builtin_data != nullptr &&
+        !PrintBuiltinData(out, i, compiled.registrations[i]->builtin_code,
+                          node.builtin_data)) {
+      TF_LITE_REPORT_ERROR(
+          error_reporter, "Node %d: options of %s are not supported", i,
+          tflite::EnumNameBuiltinOperator(static_cast<tflite::BuiltinOperator>(
+              compiled.registrations[i]->builtin_code)));
+      return false;
+    }
+  }
+  fprintf(out, "\n");
+
+  fprintf(out, "TfLiteTensor tensors[kTensorsSize];\n");
+  fprintf(out, "TfLiteNode nodes[kNodesSize];\n");
+  fprintf(out,
+          "const TfLiteRegistration* registrations[kNodesSize];\n");
+  fprintf(out, "tflite::MicroAotRuntime* runtime = nullptr;\n\n");
+  fprintf(out, "}  // namespace\n\n");
+
+  fprintf(out,
+          "TfLiteStatus Init(tflite::ErrorReporter* error_reporter) {\n"
+          "  if (runtime != nullptr) {\n"
+          "    return kTfLiteOk;\n"
+          "  }\n");
+  for (int i = 0; i < tensors_size; ++i) {
+    const TfLiteTensor& tensor = compiled.tensors[i];
+    std::string data;
+    const char* allocation_type;
+    if (tensor.allocation_type == kTfLiteMmapRo) {
+      allocation_type = "kTfLiteMmapRo";
+      data = "const_cast<uint8_t*>(tensor_" +
+             std::to_string(constant_owner[tensor.data.data]) + "_data)";
+    } else {
+      allocation_type = "kTfLiteArenaRw";
+      data = "arena + " + std::to_string(compiled.tensor_offsets[i]);
+    }
+    fprintf(out,
+            "  tflite::AotInitTensor(&tensors[%d], %s, %s, %s, %zu,\n"
+            "                        tensor_%d_dims.array());\n",
+            i, TypeName(tensor.type), allocation_type, data.c_str(),
+            tensor.bytes, i);
+    if (tensor.quantization.type == kTfLiteAffineQuantization) {
+      const auto* quantization = static_cast<const TfLiteAffineQuantization*>(
+          tensor.quantization.params);
+      fprintf(out,
+              "  tflite::AotSetQuantization(&tensors[%d], "
+              "&tensor_%d_quantization,\n"
+              "                             tensor_%d_scale.array(),\n"
+              "                             tensor_%d_zero_point.array(), "
+              "%d);\n",
+              i, i, i, i, quantization->quantized_dimension);
+    }
+  }
+  fprintf(out, "\n");
+  for (int i = 0; i < nodes_size; ++i) {
+    const TfLiteNode& node = compiled.nodes[i];
+    fprintf(out, "  nodes[%d].inputs = node_%d_inputs.array();\n", i, i);
+    fprintf(out, "  nodes[%d].outputs = node_%d_outputs.array();\n", i, i);
+    if (node.builtin_data != nullptr) {
+      fprintf(out, "  nodes[%d].builtin_data = &node_%d_params;\n", i, i);
+    }
+    fprintf(out, "  registrations[%d] = tflite::ops::micro::Register_%s();\n",
+            i,
+            tflite::EnumNameBuiltinOperator(
+                static_cast<tflite::BuiltinOperator>(
+                    compiled.registrations[i]->builtin_code)));
+  }
+  fprintf(out,
+          "\n"
+          "  static tflite::MicroAotRuntime static_runtime(\n"
+          "      tensors, kTensorsSize, arena, scratch_buffers, "
+          "kScratchBuffersSize,\n"
+          "      persistent, kPersistentSize, error_reporter);\n"
+          "  runtime = &static_runtime;\n"
+          "  return runtime->Prepare(nodes, registrations, kNodesSize);\n"
+          "}\n\n");
+
+  fprintf(out,
+          "TfLiteStatus Invoke() {\n"
+          "  TfLiteContext* context = runtime->context();\n");
+  for (int i = 0; i < nodes_size; ++i) {
+    fprintf(out,
+            "  TF_LITE_ENSURE_OK(context, registrations[%d]->invoke(context, "
+            "&nodes[%d]));  // %s\n",
+            i, i,
+            tflite::EnumNameBuiltinOperator(
+                static_cast<tflite::BuiltinOperator>(
+                    compiled.registrations[i]->builtin_code)));
+  }
+  fprintf(out, "  return kTfLiteOk;\n}\n\n");
+
+  fprintf(out,
+          "TfLiteTensor* input(int index) {\n"
+          "  return index >= 0 && index < kInputsSize ? "
+          "&tensors[inputs[index]]\n"
+          "                                           : nullptr;\n"
+          "}\n\n"
+          "TfLiteTensor* output(int index) {\n"
+          "  return index >= 0 && index < kOutputsSize ? "
+          "&tensors[outputs[index]]\n"
+          "                                            : nullptr;\n"
+          "}\n\n");
+  fprintf(out, "}  // namespace %s\n", name);
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+  if (argc != 4 || !IsIdentifier(argv[2])) {
+    fprintf(stderr, "usage: %s <model.tflite> <name> <output_dir>\n",
+            argv[0]);
+    fprintf(stderr, "<name> must be a C++ identifier.\n");
+    return 1;
+  }
+  const char* model_path = argv[1];
+  const char* name = argv[2];
+  const std::string output_path = std::string(argv[3]) + "/" + name;
+
+  std::vector<uint8_t> model_data;
+  if (!ReadFile(model_path, &model_data)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot read %s", model_path);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Model provided is schema version %d not equal "
+                         "to supported version %d.",
+                         model->version(), TFLITE_SCHEMA_VERSION);
+    return 1;
+  }
+
+  CompiledModel compiled;
+  if (!CompileModel(model, error_reporter, &compiled)) {
+    return 1;
+  }
+
+  FILE* header = fopen((output_path + ".h").c_str(), "w");
+  FILE* source = fopen((output_path + ".cc").c_str(), "w");
+  bool ok = header != nullptr && source != nullptr;
+  if (ok) {
+    WriteHeader(header, name, model_path, compiled);
+    ok = WriteSource(source, name, model_path, compiled, error_reporter);
+  } else {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot write %s.h/.cc",
+                         output_path.c_str());
+  }
+  if (header != nullptr) {
+    fclose(header);
+  }
+  if (source != nullptr) {
+    fclose(source);
+  }
+  if (!ok) {
+    return 1;
+  }
+  fprintf(stderr, "%s: arena %zu bytes, persistent %zu bytes, %zu nodes\n",
+          name, compiled.arena_size, compiled.persistent_size,
+          compiled.nodes.size());
+  return 0;
+}
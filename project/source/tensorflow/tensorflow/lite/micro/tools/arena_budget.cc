@@ -0,0 +1,457 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Measures the tensor arena a model needs and writes it as a build-time
+// budget.
+//
+// Usage: arena_budget <name> <output_dir> <model> [hop]
+//
+// The model is allocated with a RecordingMicroAllocator as in its demo:
+// streaming with `hop` frames per InvokeStreaming() call if given, then
+// input() and output() of every tensor, and one Invoke() or
+// InvokeStreaming(). The arena bytes are printed by category, along with the
+// bytes lost to alignment. The smallest arena this succeeds with is then
+// searched for, and written to
+// <output_dir>/<name>_arena_budget.h as <name>::kArenaMinSize, which the demo
+// checks its static arena against:
+//
+//   static_assert(tensor_arena_size >= emergency_detect::kArenaMinSize, "");
+//
+// The budget includes kBufferAlignment - 1 bytes for an arena that does not
+// start aligned. It is measured on the host, whose structs hold 64-bit
+// pointers, and then corrected for the 32-bit device: the persistent eval
+// tensors, NodeAndRegistrations, TfLiteTensors, their quantization structs
+// and the scratch buffer handles are counted at their 32-bit size. The temp
+// allocations of AllocateTensors() keep their host size, so the budget stays
+// an upper bound for the device as long as the kernels are the same.
+// That is, the CMSIS-NN kernels with the ARM_MATH_DSP paths of the library,
+// whose scratch buffers differ from the portable C paths. CMakeLists.txt
+// defines ARENA_BUDGET_DEVICE_KERNELS for builds with TFLM_USE_CMSIS_NN and
+// CMSIS_DSP_EMULATION, and the tool refuses to run without it.
+// MICRO_RUNTIME builds keep the TfLiteTensors of the
+// model (see MicroAllocator) and give what is left to the dynamic agent
+// cache, so their arena needs <name>::kKeptTensorsSize on top: the 32-bit
+// size of every TfLiteTensor of the model and of its quantization params.
+//
+// A model is either a .tflite file or a C/C++ source that holds the model as
+// an array of hex bytes, as written by xxd -i.
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/c/common.h"
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/micro/recording_micro_allocator.h"
+#include "tensorflow/lite/micro/recording_micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+// Same as the alignment of the buffers in MicroAllocator.
+constexpr size_t kBufferAlignment = 16;
+
+constexpr size_t kMaxArenaSize = 16 * 1024 * 1024;
+
+// Sizes of the structs that hold pointers or size_t on the 32-bit device,
+// field by field from c/common.h and micro_allocator.h.
+constexpr size_t kDeviceEvalTensorSize = 12;
+constexpr size_t kDeviceNodeAndRegistrationSize = 40;
+constexpr size_t kDeviceTensorSize = 64;
+constexpr size_t kDeviceAffineQuantizationSize = 12;
+constexpr size_t kDeviceScratchBufferHandleSize = 12;
+
+static_assert(sizeof(void*) != 8 ||
+                  (sizeof(TfLiteEvalTensor) == 24 &&
+                   sizeof(tflite::NodeAndRegistration) == 80 &&
+                   sizeof(TfLiteTensor) == 112 &&
+                   sizeof(TfLiteAffineQuantization) == 24 &&
+                   sizeof(tflite::internal::ScratchBufferHandle) == 24),
+              "An arena struct changed, update its 32-bit size above");
+
+// Keeps the failed allocations of the search for the smallest arena quiet.
+class SilentErrorReporter : public tflite::ErrorReporter {
+ public:
+  int Report(const char* format, va_list args) override { return 0; }
+};
+
+struct Category {
+  tflite::RecordedAllocationType type;
+  const char* name;
+  // Temp allocations are released again during AllocateTensors() and do not
+  // count towards the used bytes.
+  bool temp;
+};
+
+const Category kCategories[] = {
+    {tflite::RecordedAllocationType::kTfLiteEvalTensorData,
+     "TfLiteEvalTensor data", false},
+    {tflite::RecordedAllocationType::kTfLiteTensorArray,
+     "TfLiteTensor struct", true},
+    {tflite::RecordedAllocationType::kTfLiteTensorArrayQuantizationData,
+     "TfLiteTensor quantization data", true},
+    {tflite::RecordedAllocationType::kTfLiteTensorVariableBufferData,
+     "Variable buffer data", false},
+    {tflite::RecordedAllocationType::kNodeAndRegistrationArray,
+     "NodeAndRegistration struct", false},
+    {tflite::RecordedAllocationType::kOpData, "Operator builtin data", false},
+    {tflite::RecordedAllocationType::kPersistentTfLiteTensorData,
+     "Persistent TfLiteTensor data", false},
+    {tflite::RecordedAllocationType::kPersistentBufferData,
+     "Persistent buffer data", false},
+    {tflite::RecordedAllocationType::kScratchBufferHandles,
+     "Scratch buffer handles", false},
+    {tflite::RecordedAllocationType::kNonPersistentPlan,
+     "Non-persistent memory plan", false},
+};
+
+bool IsIdentifier(const char* name) {
+  if (name[0] == '\0' || (name[0] >= '0' && name[0] <= '9')) {
+    return false;
+  }
+  for (const char* c = name; *c != '\0'; ++c) {
+    if (!(*c == '_' || (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+          (*c >= '0' && *c <= '9'))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EndsWith(const std::string& text, const char* suffix) {
+  const size_t length = strlen(suffix);
+  return text.size() >= length &&
+         text.compare(text.size() - length, length, suffix) == 0;
+}
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data->resize(size > 0 ? size : 0);
+  const bool ok = size > 0 && fread(data->data(), 1, size, file) ==
+                                  static_cast<size_t>(size);
+  fclose(file);
+  return ok;
+}
+
+// Reads the bytes of the first array initializer in a C/C++ source.
+bool ParseSourceArray(const std::vector<uint8_t>& source,
+                      std::vector<uint8_t>* data) {
+  const std::string text(source.begin(), source.end());
+  size_t position = text.find("= {");
+  if (position == std::string::npos) {
+    return false;
+  }
+  const size_t end = text.find('}', position);
+  data->clear();
+  while ((position = text.find("0x", position)) < end) {
+    char* number_end;
+    const unsigned long value =
+        strtoul(text.c_str() + position + 2, &number_end, 16);
+    if (value > 0xff) {
+      return false;
+    }
+    data->push_back(static_cast<uint8_t>(value));
+    position = number_end - text.c_str();
+  }
+  return !data->empty();
+}
+
+bool ReadModel(const char* path, std::vector<uint8_t>* data) {
+  if (!ReadFile(path, data)) {
+    return false;
+  }
+  const std::string name = path;
+  if (EndsWith(name, ".c") || EndsWith(name, ".cc") ||
+      EndsWith(name, ".cpp")) {
+    const std::vector<uint8_t> source = *data;
+    return ParseSourceArray(source, data);
+  }
+  return true;
+}
+
+// Allocates and runs the model in `interpreter` as its demo does.
+TfLiteStatus RunModel(tflite::MicroInterpreter* interpreter, int hop) {
+  if (hop > 0) {
+    TF_LITE_ENSURE_STATUS(interpreter->EnableStreaming(hop));
+  }
+  TF_LITE_ENSURE_STATUS(interpreter->AllocateTensors());
+  for (size_t i = 0; i < interpreter->inputs_size(); ++i) {
+    TfLiteTensor* input = interpreter->input(i);
+    if (input == nullptr) {
+      return kTfLiteError;
+    }
+    memset(input->data.raw, 0, input->bytes);
+  }
+  for (size_t i = 0; i < interpreter->outputs_size(); ++i) {
+    if (interpreter->output(i) == nullptr) {
+      return kTfLiteError;
+    }
+  }
+  if (hop > 0) {
+    const TfLiteTensor* input = interpreter->input(0);
+    const std::vector<uint8_t> frames(
+        input->bytes / input->dims->data[1] * hop, 0);
+    return interpreter->InvokeStreaming(frames.data(), frames.size());
+  }
+  return interpreter->Invoke();
+}
+
+bool RunsInArena(const tflite::Model* model,
+                 const tflite::MicroOpResolver& op_resolver, uint8_t* arena,
+                 size_t arena_size, int hop) {
+  SilentErrorReporter error_reporter;
+  tflite::MicroInterpreter interpreter(model, op_resolver, arena, arena_size,
+                                       &error_reporter);
+  return RunModel(&interpreter, hop) == kTfLiteOk;
+}
+
+// Whether the allocator gives the tensor a TfLiteAffineQuantization, see
+// InitializeTfLiteTensorFromFlatbuffer().
+bool HasAffineQuantization(const tflite::Tensor* tensor) {
+  const tflite::QuantizationParameters* quantization = tensor->quantization();
+  return quantization != nullptr && quantization->scale() != nullptr &&
+         quantization->scale()->size() > 0 &&
+         quantization->zero_point() != nullptr &&
+         quantization->zero_point()->size() > 0;
+}
+
+// Bytes the recorded allocations take less on the 32-bit device.
+size_t DeviceSavings(const tflite::Model* model,
+                     const tflite::RecordingMicroAllocator& allocator) {
+  const tflite::RecordedAllocation eval_tensors =
+      allocator.GetRecordedAllocation(
+          tflite::RecordedAllocationType::kTfLiteEvalTensorData);
+  const tflite::RecordedAllocation nodes = allocator.GetRecordedAllocation(
+      tflite::RecordedAllocationType::kNodeAndRegistrationArray);
+  const tflite::RecordedAllocation tensors = allocator.GetRecordedAllocation(
+      tflite::RecordedAllocationType::kPersistentTfLiteTensorData);
+  const tflite::RecordedAllocation handles = allocator.GetRecordedAllocation(
+      tflite::RecordedAllocationType::kScratchBufferHandles);
+
+  // RunModel() asks for a persistent TfLiteTensor of every input and output.
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  size_t quantized_tensors = 0;
+  for (const int32_t index : *subgraph->inputs()) {
+    quantized_tensors += HasAffineQuantization(subgraph->tensors()->Get(index));
+  }
+  for (const int32_t index : *subgraph->outputs()) {
+    quantized_tensors += HasAffineQuantization(subgraph->tensors()->Get(index));
+  }
+
+  return eval_tensors.requested_bytes / sizeof(TfLiteEvalTensor) *
+             (sizeof(TfLiteEvalTensor) - kDeviceEvalTensorSize) +
+         nodes.requested_bytes / sizeof(tflite::NodeAndRegistration) *
+             (sizeof(tflite::NodeAndRegistration) -
+              kDeviceNodeAndRegistrationSize) +
+         tensors.count * (sizeof(TfLiteTensor) - kDeviceTensorSize) +
+         quantized_tensors * (sizeof(TfLiteAffineQuantization) -
+                              kDeviceAffineQuantizationSize) +
+         handles.requested_bytes /
+             sizeof(tflite::internal::ScratchBufferHandle) *
+             (sizeof(tflite::internal::ScratchBufferHandle) -
+              kDeviceScratchBufferHandleSize);
+}
+
+// Bytes the TfLiteTensors of the model and their quantization params take
+// on the 32-bit device, see InitializeTfLiteTensorFromFlatbuffer(). All of
+// them are multiples of 4 bytes there, so no alignment is lost in between.
+size_t DeviceKeptTensorsSize(const tflite::Model* model) {
+  const tflite::SubGraph* subgraph = model->subgraphs()->Get(0);
+  size_t size = 0;
+  for (const tflite::Tensor* tensor : *subgraph->tensors()) {
+    size += kDeviceTensorSize;
+    if (HasAffineQuantization(tensor)) {
+      // The zero points and scales are a TfLiteIntArray and a
+      // TfLiteFloatArray of one int or float per channel.
+      const size_t channels = tensor->quantization()->scale()->size();
+      size += kDeviceAffineQuantizationSize + 2 * (4 + 4 * channels);
+    }
+  }
+  return size;
+}
+
+void WriteHeader(FILE* out, const char* name, const char* model_path, int hop,
+                 size_t arena_min_size, size_t kept_tensors_size) {
+  fprintf(out, "// Generated by arena_budget from %s", model_path);
+  if (hop > 0) {
+    fprintf(out, " (hop %d)", hop);
+  }
+  fprintf(out, ". Do not edit.\n\n");
+  std::string guard = name;
+  for (char& c : guard) {
+    c = static_cast<char>(toupper(c));
+  }
+  guard += "_ARENA_BUDGET_H_";
+  fprintf(out, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+  fprintf(out, "namespace %s {\n\n", name);
+  fprintf(out,
+          "// Smallest tensor arena, in bytes, that the model allocates and "
+          "runs in on\n"
+          "// the 32-bit device.\n"
+          "constexpr int kArenaMinSize = %zu;\n\n",
+          arena_min_size);
+  fprintf(out,
+          "// Bytes of the TfLiteTensors that MICRO_RUNTIME builds keep, "
+          "which their\n"
+          "// arena needs on top of kArenaMinSize.\n"
+          "constexpr int kKeptTensorsSize = %zu;\n\n",
+          kept_tensors_size);
+  fprintf(out, "}  // namespace %s\n\n#endif  // %s\n", name, guard.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+  if (argc < 4 || argc > 5 || !IsIdentifier(argv[1])) {
+    fprintf(stderr, "usage: %s <name> <output_dir> <model> [hop]\n", argv[0]);
+    fprintf(stderr,
+            "<name> must be a C++ identifier. A model is a .tflite file or "
+            "a C/C++ source with the model as a hex byte array.\n");
+    return 1;
+  }
+#ifndef ARENA_BUDGET_DEVICE_KERNELS
+  fprintf(stderr,
+          "%s was not built with the kernels of the device. Configure with "
+          "-DTFLM_USE_CMSIS_NN=ON -DCMSIS_DSP_EMULATION=ON.\n",
+          argv[0]);
+  return 1;
+#endif
+  const char* name = argv[1];
+  const std::string output_path =
+      std::string(argv[2]) + "/" + name + "_arena_budget.h";
+  const char* model_path = argv[3];
+  const int hop = argc == 5 ? atoi(argv[4]) : 0;
+
+  std::vector<uint8_t> model_data;
+  if (!ReadModel(model_path, &model_data)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot read a model from %s",
+                         model_path);
+    return 1;
+  }
+  flatbuffers::Verifier verifier(model_data.data(), model_data.size());
+  if (!tflite::VerifyModelBuffer(verifier)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "%s is not a valid model",
+                         model_path);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Model provided is schema version %d not equal "
+                         "to supported version %d.",
+                         model->version(), TFLITE_SCHEMA_VERSION);
+    return 1;
+  }
+
+  tflite::AllOpsResolver op_resolver;
+  std::vector<uint8_t> arena_buffer(kMaxArenaSize + kBufferAlignment);
+  uint8_t* arena = reinterpret_cast<uint8_t*>(
+      (reinterpret_cast<uintptr_t>(arena_buffer.data()) + kBufferAlignment -
+       1) &
+      ~(kBufferAlignment - 1));
+
+  size_t used_bytes;
+  size_t device_savings;
+  {
+    tflite::RecordingMicroInterpreter interpreter(
+        model, &op_resolver, arena, kMaxArenaSize, error_reporter);
+    if (RunModel(&interpreter, hop) != kTfLiteOk) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "%s does not run in a %d byte arena", model_path,
+                           kMaxArenaSize);
+      return 1;
+    }
+    const tflite::RecordingMicroAllocator& allocator =
+        interpreter.GetMicroAllocator();
+    const tflite::RecordingSimpleMemoryAllocator* memory_allocator =
+        allocator.GetSimpleMemoryAllocator();
+    used_bytes = memory_allocator->GetUsedBytes();
+
+    printf("%s: %s\n", name, model_path);
+    printf("  %-32s %10s %10s %8s\n", "category", "requested", "used",
+           "count");
+    size_t recorded_bytes = 0;
+    size_t alignment_waste = 0;
+    for (const Category& category : kCategories) {
+      const tflite::RecordedAllocation allocation =
+          allocator.GetRecordedAllocation(category.type);
+      printf("  %-32s %10zu %10zu %8zu%s\n", category.name,
+             allocation.requested_bytes, allocation.used_bytes,
+             allocation.count, category.temp ? "  (temp)" : "");
+      if (!category.temp) {
+        recorded_bytes += allocation.used_bytes;
+        alignment_waste += allocation.used_bytes - allocation.requested_bytes;
+      }
+    }
+    // The allocators themselves, the interpreter's bookkeeping and the
+    // streaming plan are allocated outside of the recorded categories.
+    printf("  %-32s %10s %10zu\n", "Other", "",
+           used_bytes - recorded_bytes);
+    printf("  head %zu, tail %zu, used %zu bytes, %zu lost to alignment\n",
+           memory_allocator->GetHeadUsedBytes(),
+           memory_allocator->GetTailUsedBytes(), used_bytes, alignment_waste);
+    device_savings = DeviceSavings(model, allocator);
+  }
+
+  // The planner and the temp allocations during AllocateTensors() and
+  // Invoke() need room beyond the used bytes, so the smallest arena is
+  // searched for.
+  size_t too_small = used_bytes - 1;
+  size_t large_enough = kMaxArenaSize;
+  while (large_enough - too_small > 1) {
+    const size_t arena_size = too_small + (large_enough - too_small) / 2;
+    if (RunsInArena(model, op_resolver, arena, arena_size, hop)) {
+      large_enough = arena_size;
+    } else {
+      too_small = arena_size;
+    }
+  }
+  const size_t arena_min_size =
+      large_enough - device_savings + kBufferAlignment - 1;
+  printf("  minimal arena %zu bytes on the host, %zu fewer on a 32-bit "
+         "device, budget %zu bytes\n",
+         large_enough, device_savings, arena_min_size);
+
+  FILE* header = fopen(output_path.c_str(), "w");
+  if (header == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot write %s",
+                         output_path.c_str());
+    return 1;
+  }
+  const size_t kept_tensors_size = DeviceKeptTensorsSize(model);
+  printf("  MICRO_RUNTIME keeps %zu bytes of TfLiteTensors on top\n",
+         kept_tensors_size);
+  WriteHeader(header, name, model_path, hop, arena_min_size,
+              kept_tensors_size);
+  fclose(header);
+  fprintf(stderr, "%s: %zu bytes\n", output_path.c_str(), arena_min_size);
+  return 0;
+}
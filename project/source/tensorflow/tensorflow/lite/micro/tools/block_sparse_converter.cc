@@ -0,0 +1,428 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Stores the weights of a model as blocks, dropping the blocks that are zero.
+//
+// Usage: block_sparse_converter [--block=RxC] [--prune=F] <input.tflite>
+//                               <output.tflite>
+//
+// The constant weights of FULLY_CONNECTED and CONV_2D ops are cut into R x C
+// blocks of the [output channels, rest] matrix, by default 1 x 16 bytes
+// (1x16 for 8-bit weights, 1x4 for float) or the widest block under that
+// which divides the rows. With --prune, the fraction F of
+// the blocks with the smallest sum of magnitudes is set to zero first, per
+// tensor. A block is zero when all of its values equal the filter zero point.
+// Weights are then written in the block-sparse format of
+// kernels/block_sparse.h when that is smaller than the dense ones, counting
+// 4 bytes of index per stored block; the others are left dense (pruned).
+//
+// The output model is run with MicroInterpreter on random inputs and must
+// give exactly the outputs of the pruned dense model, which is the accuracy
+// to check on real data before shipping it. Convert it into a C array with
+// `xxd -i` like the models in app/lib_src.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+constexpr size_t kArenaSize = 16 * 1024 * 1024;
+constexpr int kBlockBytes = 16;
+constexpr int kVerifyRuns = 4;
+
+alignas(16) uint8_t tensor_arena[kArenaSize];
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data->resize(size > 0 ? size : 0);
+  const bool ok = size > 0 && fread(data->data(), 1, size, file) ==
+                                  static_cast<size_t>(size);
+  fclose(file);
+  return ok;
+}
+
+bool WriteFile(const char* path, const uint8_t* data, size_t size) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool ok = fwrite(data, 1, size, file) == size;
+  return fclose(file) == 0 && ok;
+}
+
+// Bytes of a weight value, 0 for types the block-sparse kernels do not read.
+int ValueSize(tflite::TensorType type) {
+  switch (type) {
+    case tflite::TensorType_FLOAT32:
+      return sizeof(float);
+    case tflite::TensorType_INT8:
+    case tflite::TensorType_UINT8:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+// Distance of a weight value from zero, which is the zero point for
+// quantized weights.
+double Magnitude(tflite::TensorType type, const uint8_t* value,
+                 int64_t zero_point) {
+  switch (type) {
+    case tflite::TensorType_FLOAT32: {
+      float real;
+      memcpy(&real, value, sizeof(real));
+      return std::fabs(real);
+    }
+    case tflite::TensorType_INT8:
+      return std::abs(*reinterpret_cast<const int8_t*>(value) - zero_point);
+    default:
+      return std::abs(*value - zero_point);
+  }
+}
+
+void SetZero(tflite::TensorType type, uint8_t* value, int64_t zero_point) {
+  if (type == tflite::TensorType_FLOAT32) {
+    memset(value, 0, sizeof(float));
+  } else {
+    *value = static_cast<uint8_t>(zero_point);
+  }
+}
+
+// Returns the tensors of subgraph 0 that are the constant weights of a
+// FULLY_CONNECTED or CONV_2D op and read by nothing else, with a buffer of
+// their own.
+std::vector<int> FindWeights(const tflite::ModelT& model) {
+  const tflite::SubGraphT& subgraph = *model.subgraphs[0];
+  std::vector<int> uses(subgraph.tensors.size(), 0);
+  std::vector<bool> is_weights(subgraph.tensors.size(), false);
+  std::vector<int> buffer_uses(model.buffers.size(), 0);
+  for (const auto& tensor : subgraph.tensors) {
+    ++buffer_uses[tensor->buffer];
+  }
+  for (const auto& op : subgraph.operators) {
+    const tflite::BuiltinOperator builtin_code =
+        model.operator_codes[op->opcode_index]->builtin_code;
+    for (size_t i = 0; i < op->inputs.size(); ++i) {
+      const int tensor_index = op->inputs[i];
+      if (tensor_index < 0) {
+        continue;
+      }
+      ++uses[tensor_index];
+      if (i == 1 &&
+          (builtin_code == tflite::BuiltinOperator_FULLY_CONNECTED ||
+           builtin_code == tflite::BuiltinOperator_CONV_2D)) {
+        is_weights[tensor_index] = true;
+      }
+    }
+  }
+  std::vector<int> weights;
+  for (size_t i = 0; i < subgraph.tensors.size(); ++i) {
+    const tflite::TensorT& tensor = *subgraph.tensors[i];
+    if (is_weights[i] && uses[i] == 1 && buffer_uses[tensor.buffer] == 1 &&
+        !model.buffers[tensor.buffer]->data.empty() &&
+        tensor.sparsity == nullptr &&
+        (tensor.quantization == nullptr ||
+         tensor.quantization->details.type ==
+             tflite::QuantizationDetails_NONE) &&
+        ValueSize(tensor.type) > 0 && tensor.shape.size() >= 2) {
+      weights.push_back(i);
+    }
+  }
+  return weights;
+}
+
+struct Options {
+  int block_rows = 1;
+  // 0 for up to kBlockBytes of the weight type.
+  int block_cols = 0;
+  double prune = 0.0;
+};
+
+// Prunes the weights in tensor `index` of `pruned` and `sparse` (two copies
+// of the same model), then writes them block-sparse into `sparse` if that
+// saves flash. Adds the bytes of the weights before and after to
+// `*dense_bytes` and `*sparse_bytes`.
+void ConvertWeights(int index, const Options& options, tflite::ModelT* pruned,
+                    tflite::ModelT* sparse, size_t* dense_bytes,
+                    size_t* sparse_bytes) {
+  tflite::TensorT* tensor = sparse->subgraphs[0]->tensors[index].get();
+  std::vector<uint8_t>& data = sparse->buffers[tensor->buffer]->data;
+  const tflite::TensorType type = tensor->type;
+  const int value_size = ValueSize(type);
+  const int rows = tensor->shape[0];
+  const int cols = static_cast<int>(data.size() / value_size / rows);
+  const int block_rows = options.block_rows;
+  int block_cols = options.block_cols;
+  if (block_cols == 0) {
+    // The widest block of up to kBlockBytes that fits the rows.
+    block_cols = kBlockBytes / value_size;
+    while (cols % block_cols != 0) {
+      --block_cols;
+    }
+  }
+  const int64_t zero_point =
+      tensor->quantization != nullptr &&
+              !tensor->quantization->zero_point.empty()
+          ? tensor->quantization->zero_point[0]
+          : 0;
+  *dense_bytes += data.size();
+  if (rows % block_rows != 0 || cols % block_cols != 0) {
+    fprintf(stderr, "tensor %d (%s): [%d, %d] is not a multiple of %dx%d\n",
+            index, tensor->name.c_str(), rows, cols, block_rows, block_cols);
+    *sparse_bytes += data.size();
+    return;
+  }
+
+  // Blocks are numbered row-major, values are found at
+  // ((block_row * block_rows + i) * cols + block_col * block_cols + j).
+  const int num_block_rows = rows / block_rows;
+  const int num_block_cols = cols / block_cols;
+  const int num_blocks = num_block_rows * num_block_cols;
+  auto value = [&](int block, int i, int j) {
+    const int row = (block / num_block_cols) * block_rows + i;
+    const int col = (block % num_block_cols) * block_cols + j;
+    return &data[(static_cast<size_t>(row) * cols + col) * value_size];
+  };
+  std::vector<double> magnitudes(num_blocks, 0.0);
+  for (int block = 0; block < num_blocks; ++block) {
+    for (int i = 0; i < block_rows; ++i) {
+      for (int j = 0; j < block_cols; ++j) {
+        magnitudes[block] += Magnitude(type, value(block, i, j), zero_point);
+      }
+    }
+  }
+
+  // Zeroes the smallest blocks, ties broken by position to stay stable.
+  const int prune_count = static_cast<int>(options.prune * num_blocks);
+  std::vector<int> order(num_blocks);
+  for (int block = 0; block < num_blocks; ++block) {
+    order[block] = block;
+  }
+  std::stable_sort(order.begin(), order.end(), [&](int a, int b) {
+    return magnitudes[a] < magnitudes[b];
+  });
+  for (int k = 0; k < prune_count; ++k) {
+    const int block = order[k];
+    magnitudes[block] = 0.0;
+    for (int i = 0; i < block_rows; ++i) {
+      for (int j = 0; j < block_cols; ++j) {
+        SetZero(type, value(block, i, j), zero_point);
+      }
+    }
+  }
+  pruned->buffers[tensor->buffer]->data = data;
+
+  std::unique_ptr<tflite::SparsityParametersT> sparsity(
+      new tflite::SparsityParametersT);
+  tflite::Int32VectorT segments;
+  tflite::Int32VectorT indices;
+  std::vector<uint8_t> values;
+  segments.values.push_back(0);
+  for (int block = 0; block < num_blocks; ++block) {
+    if (magnitudes[block] != 0.0) {
+      indices.values.push_back(block % num_block_cols);
+      for (int i = 0; i < block_rows; ++i) {
+        const uint8_t* block_row = value(block, i, 0);
+        values.insert(values.end(), block_row,
+                      block_row + block_cols * value_size);
+      }
+    }
+    if (block % num_block_cols == num_block_cols - 1) {
+      segments.values.push_back(indices.values.size());
+    }
+  }
+  const size_t encoded_bytes =
+      values.size() +
+      (segments.values.size() + indices.values.size()) * sizeof(int32_t);
+  fprintf(stderr,
+          "tensor %d (%s): [%d, %d] in %dx%d blocks, %d of %d kept, "
+          "%zu -> %zu bytes%s\n",
+          index, tensor->name.c_str(), rows, cols, block_rows, block_cols,
+          static_cast<int>(indices.values.size()), num_blocks, data.size(),
+          encoded_bytes, encoded_bytes < data.size() ? "" : ", left dense");
+  if (encoded_bytes >= data.size()) {
+    *sparse_bytes += data.size();
+    return;
+  }
+  *sparse_bytes += encoded_bytes;
+
+  // The 2D view of kernels/block_sparse.h, in the 3 dimensions TFLite uses
+  // when blocks are a single row.
+  std::vector<int32_t> dense_sizes = {num_block_rows, 0, block_cols};
+  if (block_rows == 1) {
+    sparsity->traversal_order = {0, 1, 2};
+    sparsity->block_map = {1};
+  } else {
+    sparsity->traversal_order = {0, 1, 2, 3};
+    sparsity->block_map = {0, 1};
+    dense_sizes = {num_block_rows, 0, block_rows, block_cols};
+  }
+  for (size_t i = 0; i < dense_sizes.size(); ++i) {
+    std::unique_ptr<tflite::DimensionMetadataT> dim(
+        new tflite::DimensionMetadataT);
+    dim->dense_size = dense_sizes[i];
+    if (i == 1) {
+      dim->format = tflite::DimensionType_SPARSE_CSR;
+      dim->array_segments.Set(std::move(segments));
+      dim->array_indices.Set(std::move(indices));
+    }
+    sparsity->dim_metadata.push_back(std::move(dim));
+  }
+  tensor->sparsity = std::move(sparsity);
+  data = std::move(values);
+}
+
+// Runs `model` kVerifyRuns times on pseudo-random inputs, the same for every
+// model with the same inputs, and appends the bytes of its outputs.
+bool RunModel(const std::vector<uint8_t>& model_data,
+              tflite::ErrorReporter* error_reporter,
+              std::vector<uint8_t>* outputs) {
+  tflite::AllOpsResolver resolver;
+  tflite::MicroInterpreter interpreter(tflite::GetModel(model_data.data()),
+                                       resolver, tensor_arena, kArenaSize,
+                                       error_reporter);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    return false;
+  }
+  uint32_t seed = 1;
+  for (int run = 0; run < kVerifyRuns; ++run) {
+    for (size_t i = 0; i < interpreter.inputs_size(); ++i) {
+      TfLiteTensor* input = interpreter.input(i);
+      for (size_t j = 0; j < input->bytes; ++j) {
+        seed = seed * 1664525u + 1013904223u;
+        if (input->type == kTfLiteFloat32) {
+          if (j % sizeof(float) == 0) {
+            input->data.f[j / sizeof(float)] =
+                static_cast<float>(seed >> 8) / (1 << 23) - 1.0f;
+          }
+        } else {
+          input->data.uint8[j] = static_cast<uint8_t>(seed >> 24);
+        }
+      }
+    }
+    if (interpreter.Invoke() != kTfLiteOk) {
+      return false;
+    }
+    for (size_t i = 0; i < interpreter.outputs_size(); ++i) {
+      const TfLiteTensor* output = interpreter.output(i);
+      outputs->insert(outputs->end(), output->data.uint8,
+                      output->data.uint8 + output->bytes);
+    }
+  }
+  return true;
+}
+
+std::vector<uint8_t> PackModel(const tflite::ModelT& model) {
+  flatbuffers::FlatBufferBuilder builder;
+  tflite::FinishModelBuffer(builder, tflite::Model::Pack(builder, &model));
+  return std::vector<uint8_t>(builder.GetBufferPointer(),
+                              builder.GetBufferPointer() + builder.GetSize());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+  Options options;
+  for (; argc > 3; ++argv, --argc) {
+    if (sscanf(argv[1], "--block=%dx%d", &options.block_rows,
+               &options.block_cols) == 2 &&
+        options.block_rows > 0 && options.block_cols > 0) {
+      continue;
+    }
+    if (sscanf(argv[1], "--prune=%lf", &options.prune) == 1 &&
+        options.prune >= 0.0 && options.prune < 1.0) {
+      continue;
+    }
+    break;
+  }
+  if (argc != 3) {
+    fprintf(stderr,
+            "usage: %s [--block=RxC] [--prune=F] <input.tflite> "
+            "<output.tflite>\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::vector<uint8_t> model_data;
+  if (!ReadFile(argv[1], &model_data)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot read %s", argv[1]);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Model provided is schema version %d not equal "
+                         "to supported version %d.",
+                         model->version(), TFLITE_SCHEMA_VERSION);
+    return 1;
+  }
+  if (model->subgraphs()->size() != 1) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Only one subgraph is supported");
+    return 1;
+  }
+
+  std::unique_ptr<tflite::ModelT> pruned(model->UnPack());
+  std::unique_ptr<tflite::ModelT> sparse(model->UnPack());
+  size_t dense_bytes = 0;
+  size_t sparse_bytes = 0;
+  for (int index : FindWeights(*sparse)) {
+    ConvertWeights(index, options, pruned.get(), sparse.get(), &dense_bytes,
+                   &sparse_bytes);
+  }
+
+  const std::vector<uint8_t> pruned_data = PackModel(*pruned);
+  const std::vector<uint8_t> sparse_data = PackModel(*sparse);
+  if (!WriteFile(argv[2], sparse_data.data(), sparse_data.size())) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot write %s", argv[2]);
+    return 1;
+  }
+
+  // The block-sparse kernels must match the dense ones on the pruned model.
+  std::vector<uint8_t> pruned_outputs;
+  std::vector<uint8_t> sparse_outputs;
+  if (!RunModel(pruned_data, error_reporter, &pruned_outputs) ||
+      !RunModel(sparse_data, error_reporter, &sparse_outputs) ||
+      pruned_outputs != sparse_outputs) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Verification of the block-sparse model failed");
+    return 1;
+  }
+
+  fprintf(stderr, "%s: weights %zu -> %zu bytes, model %zu -> %zu bytes\n",
+          argv[2], dense_bytes, sparse_bytes, model_data.size(),
+          sparse_data.size());
+  return 0;
+}
@@ -0,0 +1,215 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Writes an offline memory plan into a model.
+//
+// Usage: offline_memory_plan [--branch_and_bound] <input.tflite>
+//                            <output.tflite>
+//
+// The model is planned on the host by MicroInterpreter::AllocateTensors(),
+// with GreedyMemoryPlanner or, given --branch_and_bound, with
+// BranchAndBoundMemoryPlanner, and the arena offset of every activation tensor is stored in the
+// "OfflineMemoryAllocation" metadata of the output model as
+//
+//   [version = 1, subgraph = 0, tensor count, offset of tensor 0, ...]
+//
+// with -1 for tensors that are not in the arena (weights and variables).
+// MicroAllocator uses these offsets as they are and skips the memory planner
+// at boot. Scratch buffers depend on the kernels the device is built with,
+// so they are not part of the plan; if a kernel requests any, they are placed
+// online around the fixed tensors.
+//
+// The output model is then loaded again with plan verification enabled and
+// must give the same tensor placement. Convert it into a C array with
+// `xxd -i` like the models in app/lib_src.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_allocator.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+constexpr size_t kArenaSize = 16 * 1024 * 1024;
+constexpr char kOfflineMemAllocMetadata[] = "OfflineMemoryAllocation";
+constexpr int32_t kOfflineMemAllocVersion = 1;
+
+alignas(16) uint8_t tensor_arena[kArenaSize];
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data->resize(size > 0 ? size : 0);
+  const bool ok = size > 0 && fread(data->data(), 1, size, file) ==
+                                  static_cast<size_t>(size);
+  fclose(file);
+  return ok;
+}
+
+bool WriteFile(const char* path, const uint8_t* data, size_t size) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool ok = fwrite(data, 1, size, file) == size;
+  return fclose(file) == 0 && ok;
+}
+
+// Plans `model` and returns the arena offset of every tensor, -1 for the
+// tensors that are not in the non-persistent part of the arena.
+bool PlanModel(const tflite::Model* model, bool verify,
+               tflite::MemoryPlannerType planner_type,
+               tflite::ErrorReporter* error_reporter,
+               std::vector<int32_t>* offsets, size_t* arena_used_bytes) {
+  tflite::AllOpsResolver resolver;
+  tflite::MicroAllocator* allocator =
+      tflite::MicroAllocator::Create(tensor_arena, kArenaSize, error_reporter,
+                                     planner_type);
+  allocator->set_verify_offline_plan(verify);
+  tflite::MicroInterpreter interpreter(model, &resolver, allocator,
+                                       error_reporter);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    return false;
+  }
+  // Read before tensor() allocates the TfLiteTensors it returns.
+  *arena_used_bytes = interpreter.arena_used_bytes();
+  offsets->clear();
+  for (size_t i = 0; i < interpreter.tensors_size(); ++i) {
+    const TfLiteTensor* tensor = interpreter.tensor(i);
+    const uint8_t* data = reinterpret_cast<const uint8_t*>(tensor->data.raw);
+    const bool in_head = tensor->allocation_type == kTfLiteArenaRw &&
+                         !tensor->is_variable && data != nullptr;
+    offsets->push_back(in_head ? static_cast<int32_t>(data - tensor_arena)
+                               : -1);
+  }
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+  tflite::MemoryPlannerType planner_type = tflite::MemoryPlannerType::kGreedy;
+  if (argc == 4 && strcmp(argv[1], "--branch_and_bound") == 0) {
+    planner_type = tflite::MemoryPlannerType::kBranchAndBound;
+    ++argv;
+    --argc;
+  }
+  if (argc != 3) {
+    fprintf(stderr,
+            "usage: %s [--branch_and_bound] <input.tflite> <output.tflite>\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::vector<uint8_t> model_data;
+  if (!ReadFile(argv[1], &model_data)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot read %s", argv[1]);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Model provided is schema version %d not equal "
+                         "to supported version %d.",
+                         model->version(), TFLITE_SCHEMA_VERSION);
+    return 1;
+  }
+  if (model->subgraphs()->size() != 1) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Only one subgraph is supported");
+    return 1;
+  }
+
+  std::vector<int32_t> offsets;
+  size_t online_used_bytes = 0;
+  if (!PlanModel(model, false, planner_type, error_reporter, &offsets,
+                 &online_used_bytes)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "AllocateTensors() failed");
+    return 1;
+  }
+
+  std::vector<int32_t> plan = {kOfflineMemAllocVersion, 0,
+                               static_cast<int32_t>(offsets.size())};
+  plan.insert(plan.end(), offsets.begin(), offsets.end());
+  std::unique_ptr<tflite::BufferT> plan_buffer(new tflite::BufferT);
+  plan_buffer->data.resize(plan.size() * sizeof(int32_t));
+  memcpy(plan_buffer->data.data(), plan.data(), plan_buffer->data.size());
+
+  // Replace the buffer of an existing plan, or add a new metadata entry.
+  std::unique_ptr<tflite::ModelT> model_t(model->UnPack());
+  tflite::MetadataT* plan_metadata = nullptr;
+  for (auto& metadata : model_t->metadata) {
+    if (metadata->name == kOfflineMemAllocMetadata) {
+      plan_metadata = metadata.get();
+    }
+  }
+  if (plan_metadata == nullptr) {
+    model_t->metadata.emplace_back(new tflite::MetadataT);
+    plan_metadata = model_t->metadata.back().get();
+    plan_metadata->name = kOfflineMemAllocMetadata;
+    plan_metadata->buffer = model_t->buffers.size();
+    model_t->buffers.push_back(std::move(plan_buffer));
+  } else {
+    model_t->buffers[plan_metadata->buffer] = std::move(plan_buffer);
+  }
+
+  flatbuffers::FlatBufferBuilder builder;
+  tflite::FinishModelBuffer(builder,
+                            tflite::Model::Pack(builder, model_t.get()));
+  if (!WriteFile(argv[2], builder.GetBufferPointer(), builder.GetSize())) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot write %s", argv[2]);
+    return 1;
+  }
+
+  // The planned model must load with verification and keep the placement.
+  std::vector<uint8_t> planned_data(
+      builder.GetBufferPointer(),
+      builder.GetBufferPointer() + builder.GetSize());
+  std::vector<int32_t> planned_offsets;
+  size_t offline_used_bytes = 0;
+  if (!PlanModel(tflite::GetModel(planned_data.data()), true, planner_type,
+                 error_reporter, &planned_offsets, &offline_used_bytes) ||
+      planned_offsets != offsets) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Verification of the offline plan failed");
+    return 1;
+  }
+
+  int planned_count = 0;
+  for (int32_t offset : offsets) {
+    planned_count += offset >= 0 ? 1 : 0;
+  }
+  fprintf(stderr,
+          "%s: %d of %d tensors planned offline, arena used %zu bytes "
+          "(%zu when planned online)\n",
+          argv[2], planned_count, static_cast<int>(offsets.size()),
+          offline_used_bytes, online_used_bytes);
+  return 0;
+}
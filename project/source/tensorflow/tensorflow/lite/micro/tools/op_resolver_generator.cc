@@ -0,0 +1,276 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Generates the op resolver of one or more models.
+//
+// Usage: op_resolver_generator <name> <output_dir> <model>...
+//
+// Writes <output_dir>/<name>_op_resolver.h, which defines
+// <name>::OpResolver, a MicroStaticOpResolver for exactly the builtin
+// operators in the operator code tables of the models:
+//
+//   static emergency_detect::OpResolver resolver;
+//   static tflite::MicroInterpreter interpreter(model, resolver, ...);
+//
+// A model is either a .tflite file or a C/C++ source that holds the model as
+// an array of hex bytes, as written by xxd -i. Ops with a dedicated parser of
+// their builtin options use it, the others use ParseOpData(), as in
+// MicroMutableOpResolver.
+
+#include <cctype>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include <string>
+#include <vector>
+
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_static_op_resolver.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+// Ops with a parser of their own in flatbuffer_conversions.h.
+struct OpParser {
+  tflite::BuiltinOperator op;
+  const char* parser;
+};
+
+const OpParser kOpParsers[] = {
+    {tflite::BuiltinOperator_CONV_2D, "ParseConv2D"},
+    {tflite::BuiltinOperator_DEPTHWISE_CONV_2D, "ParseDepthwiseConv2D"},
+    {tflite::BuiltinOperator_DEQUANTIZE, "ParseDequantize"},
+    {tflite::BuiltinOperator_FULLY_CONNECTED, "ParseFullyConnected"},
+    {tflite::BuiltinOperator_QUANTIZE, "ParseQuantize"},
+    {tflite::BuiltinOperator_RESHAPE, "ParseReshape"},
+    {tflite::BuiltinOperator_SOFTMAX, "ParseSoftmax"},
+    {tflite::BuiltinOperator_SVDF, "ParseSvdf"},
+};
+
+const char* ParserName(tflite::BuiltinOperator op) {
+  for (const OpParser& op_parser : kOpParsers) {
+    if (op_parser.op == op) {
+      return op_parser.parser;
+    }
+  }
+  return "ParseOpData";
+}
+
+bool IsIdentifier(const char* name) {
+  if (name[0] == '\0' || (name[0] >= '0' && name[0] <= '9')) {
+    return false;
+  }
+  for (const char* c = name; *c != '\0'; ++c) {
+    if (!(*c == '_' || (*c >= 'a' && *c <= 'z') || (*c >= 'A' && *c <= 'Z') ||
+          (*c >= '0' && *c <= '9'))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+bool EndsWith(const std::string& text, const char* suffix) {
+  const size_t length = strlen(suffix);
+  return text.size() >= length &&
+         text.compare(text.size() - length, length, suffix) == 0;
+}
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data->resize(size > 0 ? size : 0);
+  const bool ok = size > 0 && fread(data->data(), 1, size, file) ==
+                                  static_cast<size_t>(size);
+  fclose(file);
+  return ok;
+}
+
+// Reads the bytes of the first array initializer in a C/C++ source.
+bool ParseSourceArray(const std::vector<uint8_t>& source,
+                      std::vector<uint8_t>* data) {
+  const std::string text(source.begin(), source.end());
+  size_t position = text.find("= {");
+  if (position == std::string::npos) {
+    return false;
+  }
+  const size_t end = text.find('}', position);
+  data->clear();
+  while ((position = text.find("0x", position)) < end) {
+    char* number_end;
+    const unsigned long value =
+        strtoul(text.c_str() + position + 2, &number_end, 16);
+    if (value > 0xff) {
+      return false;
+    }
+    data->push_back(static_cast<uint8_t>(value));
+    position = number_end - text.c_str();
+  }
+  return !data->empty();
+}
+
+bool ReadModel(const char* path, std::vector<uint8_t>* data) {
+  if (!ReadFile(path, data)) {
+    return false;
+  }
+  const std::string name = path;
+  if (EndsWith(name, ".c") || EndsWith(name, ".cc") ||
+      EndsWith(name, ".cpp")) {
+    const std::vector<uint8_t> source = *data;
+    return ParseSourceArray(source, data);
+  }
+  return true;
+}
+
+void WriteHeader(FILE* out, const char* name, int model_count,
+                 char** model_paths,
+                 const std::set<tflite::BuiltinOperator>& ops) {
+  fprintf(out, "// Generated by op_resolver_generator from");
+  for (int i = 0; i < model_count; ++i) {
+    fprintf(out, " %s", model_paths[i]);
+  }
+  fprintf(out, ". Do not edit.\n\n");
+  std::string guard = name;
+  for (char& c : guard) {
+    c = static_cast<char>(toupper(c));
+  }
+  guard += "_OP_RESOLVER_H_";
+  fprintf(out, "#ifndef %s\n#define %s\n\n", guard.c_str(), guard.c_str());
+  fprintf(out,
+          "#include <cstdint>\n\n"
+          "#include \"tensorflow/lite/core/api/flatbuffer_conversions.h\"\n"
+          "#include \"tensorflow/lite/micro/compatibility.h\"\n"
+          "#include \"tensorflow/lite/micro/kernels/micro_ops.h\"\n"
+          "#include \"tensorflow/lite/micro/micro_static_op_resolver.h\"\n\n");
+  fprintf(out, "namespace %s {\n\n", name);
+
+  fprintf(out, "constexpr tflite::MicroStaticOp kOps[] = {\n");
+  std::vector<int> slots(tflite::kMicroStaticOpSlots, -1);
+  int slot = 0;
+  for (tflite::BuiltinOperator op : ops) {
+    const char* op_name = tflite::EnumNameBuiltinOperator(op);
+    fprintf(out,
+            "    {tflite::BuiltinOperator_%s,\n"
+            "     tflite::ops::micro::Register_%s,\n"
+            "     tflite::%s},\n",
+            op_name, op_name, ParserName(op));
+    slots[op] = slot++;
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out,
+          "// Index into kOps of every tflite::BuiltinOperator, -1 for the "
+          "ops that\n// are not used.\n"
+          "constexpr int8_t kOpSlots[tflite::kMicroStaticOpSlots] = {\n");
+  constexpr int kSlotsPerLine = 16;
+  for (int i = 0; i < tflite::kMicroStaticOpSlots; i += kSlotsPerLine) {
+    fprintf(out, "   ");
+    for (int j = i; j < i + kSlotsPerLine && j < tflite::kMicroStaticOpSlots;
+         ++j) {
+      fprintf(out, " %d,", slots[j]);
+    }
+    fprintf(out, "  // %d\n", i);
+  }
+  fprintf(out, "};\n\n");
+
+  fprintf(out,
+          "class OpResolver : public tflite::MicroStaticOpResolver<%zu> {\n"
+          " public:\n"
+          "  OpResolver() : MicroStaticOpResolver(kOps, kOpSlots) {}\n\n"
+          " private:\n"
+          "  TF_LITE_REMOVE_VIRTUAL_DELETE\n"
+          "};\n\n",
+          ops.size());
+  fprintf(out, "}  // namespace %s\n\n#endif  // %s\n", name, guard.c_str());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+  if (argc < 4 || !IsIdentifier(argv[1])) {
+    fprintf(stderr, "usage: %s <name> <output_dir> <model>...\n", argv[0]);
+    fprintf(stderr,
+            "<name> must be a C++ identifier. A model is a .tflite file or "
+            "a C/C++ source with the model as a hex byte array.\n");
+    return 1;
+  }
+  const char* name = argv[1];
+  const std::string output_path =
+      std::string(argv[2]) + "/" + name + "_op_resolver.h";
+
+  // Only ops the runtime has kernels for can be resolved.
+  tflite::AllOpsResolver all_ops_resolver;
+  std::set<tflite::BuiltinOperator> ops;
+  for (int i = 3; i < argc; ++i) {
+    std::vector<uint8_t> model_data;
+    if (!ReadModel(argv[i], &model_data)) {
+      TF_LITE_REPORT_ERROR(error_reporter, "Cannot read a model from %s",
+                           argv[i]);
+      return 1;
+    }
+    flatbuffers::Verifier verifier(model_data.data(), model_data.size());
+    if (!tflite::VerifyModelBuffer(verifier)) {
+      TF_LITE_REPORT_ERROR(error_reporter, "%s is not a valid model",
+                           argv[i]);
+      return 1;
+    }
+    const tflite::Model* model = tflite::GetModel(model_data.data());
+    if (model->version() != TFLITE_SCHEMA_VERSION) {
+      TF_LITE_REPORT_ERROR(error_reporter,
+                           "Model provided is schema version %d not equal "
+                           "to supported version %d.",
+                           model->version(), TFLITE_SCHEMA_VERSION);
+      return 1;
+    }
+    const auto* opcodes = model->operator_codes();
+    for (size_t j = 0; opcodes != nullptr && j < opcodes->size(); ++j) {
+      const tflite::BuiltinOperator op = opcodes->Get(j)->builtin_code();
+      if (op == tflite::BuiltinOperator_CUSTOM) {
+        TF_LITE_REPORT_ERROR(error_reporter,
+                             "%s uses custom op %s, which needs a "
+                             "MicroMutableOpResolver",
+                             argv[i], opcodes->Get(j)->custom_code()->c_str());
+        return 1;
+      }
+      if (all_ops_resolver.FindOp(op) == nullptr) {
+        TF_LITE_REPORT_ERROR(error_reporter, "%s uses unsupported op %s",
+                             argv[i], tflite::EnumNameBuiltinOperator(op));
+        return 1;
+      }
+      ops.insert(op);
+    }
+  }
+
+  FILE* header = fopen(output_path.c_str(), "w");
+  if (header == nullptr) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot write %s",
+                         output_path.c_str());
+    return 1;
+  }
+  WriteHeader(header, name, argc - 3, argv + 3, ops);
+  fclose(header);
+  fprintf(stderr, "%s: %zu ops\n", output_path.c_str(), ops.size());
+  return 0;
+}
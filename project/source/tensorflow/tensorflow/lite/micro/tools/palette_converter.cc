@@ -0,0 +1,432 @@
+/* Copyright 2020 The TensorFlow Authors. All Rights Reserved.
+
+Licensed under the Apache License, Version 2.0 (the "License");
+you may not use this file except in compliance with the License.
+You may obtain a copy of the License at
+
+    http://www.apache.org/licenses/LICENSE-2.0
+
+Unless required by applicable law or agreed to in writing, software
+distributed under the License is distributed on an "AS IS" BASIS,
+WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+See the License for the specific language governing permissions and
+limitations under the License.
+==============================================================================*/
+
+// Stores the weights of a model as packed indices into a small palette.
+//
+// Usage: palette_converter [--bits=N] [--uniform] <input.tflite>
+//                          <output.tflite>
+//
+// The constant weights of FULLY_CONNECTED and CONV_2D ops get a palette of
+// 2^N values (N = 1, 2, 4 or 8, 4 by default) per tensor, found by k-means
+// clustering of their values, or evenly spaced between their minimum and
+// maximum with --uniform, which for int8 weights and N = 4 is packed int4.
+// Weights with at most 2^N distinct values keep them exactly. Every value is
+// replaced by the index of the nearest palette value, and the tensor is
+// written in the palettized format of kernels/palettized.h when that is
+// smaller than the dense one; the others are left dense.
+//
+// The output model is run with MicroInterpreter on random inputs and must
+// give exactly the outputs of the dense model with the palette values, which
+// is the accuracy to check on real data before shipping it. Convert it into a
+// C array with `xxd -i` like the models in app/lib_src.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "flatbuffers/flatbuffers.h"  // from @flatbuffers
+#include "tensorflow/lite/micro/all_ops_resolver.h"
+#include "tensorflow/lite/micro/kernels/palettized.h"
+#include "tensorflow/lite/micro/micro_error_reporter.h"
+#include "tensorflow/lite/micro/micro_interpreter.h"
+#include "tensorflow/lite/schema/schema_generated.h"
+#include "tensorflow/lite/version.h"
+
+namespace {
+
+constexpr size_t kArenaSize = 16 * 1024 * 1024;
+constexpr int kKMeansIterations = 32;
+constexpr int kVerifyRuns = 4;
+
+alignas(16) uint8_t tensor_arena[kArenaSize];
+
+bool ReadFile(const char* path, std::vector<uint8_t>* data) {
+  FILE* file = fopen(path, "rb");
+  if (file == nullptr) {
+    return false;
+  }
+  fseek(file, 0, SEEK_END);
+  const long size = ftell(file);
+  fseek(file, 0, SEEK_SET);
+  data->resize(size > 0 ? size : 0);
+  const bool ok = size > 0 && fread(data->data(), 1, size, file) ==
+                                  static_cast<size_t>(size);
+  fclose(file);
+  return ok;
+}
+
+bool WriteFile(const char* path, const uint8_t* data, size_t size) {
+  FILE* file = fopen(path, "wb");
+  if (file == nullptr) {
+    return false;
+  }
+  const bool ok = fwrite(data, 1, size, file) == size;
+  return fclose(file) == 0 && ok;
+}
+
+// Bytes of a weight value, 0 for types the palettized kernels do not read.
+int ValueSize(tflite::TensorType type) {
+  switch (type) {
+    case tflite::TensorType_FLOAT32:
+      return sizeof(float);
+    case tflite::TensorType_INT8:
+    case tflite::TensorType_UINT8:
+      return 1;
+    default:
+      return 0;
+  }
+}
+
+double GetValue(tflite::TensorType type, const uint8_t* value) {
+  switch (type) {
+    case tflite::TensorType_FLOAT32: {
+      float real;
+      memcpy(&real, value, sizeof(real));
+      return real;
+    }
+    case tflite::TensorType_INT8:
+      return *reinterpret_cast<const int8_t*>(value);
+    default:
+      return *value;
+  }
+}
+
+void SetValue(tflite::TensorType type, double real, uint8_t* value) {
+  if (type == tflite::TensorType_FLOAT32) {
+    const float single = static_cast<float>(real);
+    memcpy(value, &single, sizeof(single));
+  } else if (type == tflite::TensorType_INT8) {
+    *reinterpret_cast<int8_t*>(value) = static_cast<int8_t>(real);
+  } else {
+    *value = static_cast<uint8_t>(real);
+  }
+}
+
+// Palette values as the kernels see them: float, or integers in range.
+double Representable(tflite::TensorType type, double real) {
+  switch (type) {
+    case tflite::TensorType_FLOAT32:
+      return static_cast<float>(real);
+    case tflite::TensorType_INT8:
+      return std::min(127.0, std::max(-128.0, std::round(real)));
+    default:
+      return std::min(255.0, std::max(0.0, std::round(real)));
+  }
+}
+
+// Returns the tensors of subgraph 0 that are the dense constant weights of a
+// FULLY_CONNECTED or CONV_2D op and read by nothing else, with a buffer of
+// their own.
+std::vector<int> FindWeights(const tflite::ModelT& model) {
+  const tflite::SubGraphT& subgraph = *model.subgraphs[0];
+  std::vector<int> uses(subgraph.tensors.size(), 0);
+  std::vector<bool> is_weights(subgraph.tensors.size(), false);
+  std::vector<int> buffer_uses(model.buffers.size(), 0);
+  for (const auto& tensor : subgraph.tensors) {
+    ++buffer_uses[tensor->buffer];
+  }
+  for (const auto& op : subgraph.operators) {
+    const tflite::BuiltinOperator builtin_code =
+        model.operator_codes[op->opcode_index]->builtin_code;
+    for (size_t i = 0; i < op->inputs.size(); ++i) {
+      const int tensor_index = op->inputs[i];
+      if (tensor_index < 0) {
+        continue;
+      }
+      ++uses[tensor_index];
+      if (i == 1 &&
+          (builtin_code == tflite::BuiltinOperator_FULLY_CONNECTED ||
+           builtin_code == tflite::BuiltinOperator_CONV_2D)) {
+        is_weights[tensor_index] = true;
+      }
+    }
+  }
+  std::vector<int> weights;
+  for (size_t i = 0; i < subgraph.tensors.size(); ++i) {
+    const tflite::TensorT& tensor = *subgraph.tensors[i];
+    if (is_weights[i] && uses[i] == 1 && buffer_uses[tensor.buffer] == 1 &&
+        !model.buffers[tensor.buffer]->data.empty() &&
+        tensor.sparsity == nullptr &&
+        (tensor.quantization == nullptr ||
+         tensor.quantization->details.type ==
+             tflite::QuantizationDetails_NONE) &&
+        ValueSize(tensor.type) > 0 && tensor.shape.size() >= 2) {
+      weights.push_back(i);
+    }
+  }
+  return weights;
+}
+
+struct Options {
+  int bits = 4;
+  bool uniform = false;
+};
+
+// Index of the value of the sorted `palette` nearest to `real`.
+int Nearest(const std::vector<double>& palette, double real) {
+  const auto upper = std::lower_bound(palette.begin(), palette.end(), real);
+  if (upper == palette.begin()) {
+    return 0;
+  }
+  if (upper == palette.end()) {
+    return static_cast<int>(palette.size()) - 1;
+  }
+  const int index = static_cast<int>(upper - palette.begin());
+  return real - palette[index - 1] <= palette[index] - real ? index - 1
+                                                            : index;
+}
+
+// Returns a sorted palette of `size` values for `values`.
+std::vector<double> FindPalette(tflite::TensorType type,
+                                std::vector<double> values, int size,
+                                bool uniform) {
+  std::sort(values.begin(), values.end());
+  std::vector<double> distinct(values.begin(), values.end());
+  distinct.erase(std::unique(distinct.begin(), distinct.end()),
+                 distinct.end());
+  if (static_cast<int>(distinct.size()) <= size) {
+    distinct.resize(size, distinct.back());
+    return distinct;
+  }
+  std::vector<double> palette;
+  const double low = values.front();
+  const double step = (values.back() - low) / (size - 1);
+  for (int k = 0; k < size; ++k) {
+    palette.push_back(Representable(type, low + k * step));
+  }
+  if (!uniform) {
+    // Lloyd's algorithm in one dimension, from the uniform palette so that
+    // the extremes keep a value of their own.
+    for (int iteration = 0; iteration < kKMeansIterations; ++iteration) {
+      std::vector<double> sums(size, 0.0);
+      std::vector<int> counts(size, 0);
+      for (double real : values) {
+        const int k = Nearest(palette, real);
+        sums[k] += real;
+        ++counts[k];
+      }
+      bool changed = false;
+      for (int k = 0; k < size; ++k) {
+        if (counts[k] == 0) {
+          continue;
+        }
+        const double centroid = Representable(type, sums[k] / counts[k]);
+        changed |= centroid != palette[k];
+        palette[k] = centroid;
+      }
+      std::sort(palette.begin(), palette.end());
+      if (!changed) {
+        break;
+      }
+    }
+  }
+  palette.erase(std::unique(palette.begin(), palette.end()), palette.end());
+  palette.resize(size, palette.back());
+  return palette;
+}
+
+// Writes the weights in tensor `index` of `decoded` and `palettized` (two
+// copies of the same model) with their palette values, densely into `decoded`
+// and palettized into `palettized` if that saves flash. Adds the bytes of the
+// weights before and after to `*dense_bytes` and `*palettized_bytes`.
+void ConvertWeights(int index, const Options& options,
+                    tflite::ModelT* decoded, tflite::ModelT* palettized,
+                    size_t* dense_bytes, size_t* palettized_bytes) {
+  tflite::TensorT* tensor = palettized->subgraphs[0]->tensors[index].get();
+  std::vector<uint8_t>& data = palettized->buffers[tensor->buffer]->data;
+  const tflite::TensorType type = tensor->type;
+  const int value_size = ValueSize(type);
+  const size_t count = data.size() / value_size;
+  const int size = 1 << options.bits;
+  *dense_bytes += data.size();
+
+  std::vector<double> values(count);
+  for (size_t i = 0; i < count; ++i) {
+    values[i] = GetValue(type, &data[i * value_size]);
+  }
+  const std::vector<double> palette =
+      FindPalette(type, values, size, options.uniform);
+
+  std::vector<uint8_t> indices((count * options.bits + 7) / 8, 0);
+  double max_error = 0.0;
+  for (size_t i = 0; i < count; ++i) {
+    const int k = Nearest(palette, values[i]);
+    max_error = std::max(max_error, std::fabs(palette[k] - values[i]));
+    SetValue(type, palette[k], &data[i * value_size]);
+    const size_t bit = i * options.bits;
+    indices[bit / 8] |= static_cast<uint8_t>(k << (bit % 8));
+  }
+  decoded->buffers[tensor->buffer]->data = data;
+
+  std::vector<uint8_t> custom(tflite::micro::kPaletteHeaderSize, 0);
+  memcpy(custom.data(), tflite::micro::kPaletteMagic,
+         sizeof(tflite::micro::kPaletteMagic));
+  custom[3] = tflite::micro::kPaletteVersion;
+  custom[4] = static_cast<uint8_t>(options.bits);
+  custom.resize(custom.size() + size * value_size);
+  for (int k = 0; k < size; ++k) {
+    SetValue(type, palette[k],
+             &custom[tflite::micro::kPaletteHeaderSize + k * value_size]);
+  }
+
+  const size_t encoded_bytes = indices.size() + custom.size();
+  fprintf(stderr,
+          "tensor %d (%s): %zu values, %d-bit palette, max error %g, "
+          "%zu -> %zu bytes%s\n",
+          index, tensor->name.c_str(), count, options.bits, max_error,
+          data.size(), encoded_bytes,
+          encoded_bytes < data.size() ? "" : ", left dense");
+  if (encoded_bytes >= data.size()) {
+    *palettized_bytes += data.size();
+    return;
+  }
+  *palettized_bytes += encoded_bytes;
+
+  if (tensor->quantization == nullptr) {
+    tensor->quantization.reset(new tflite::QuantizationParametersT);
+  }
+  tflite::CustomQuantizationT details;
+  details.custom = std::move(custom);
+  tensor->quantization->details.Set(std::move(details));
+  data = std::move(indices);
+}
+
+// Runs `model` kVerifyRuns times on pseudo-random inputs, the same for every
+// model with the same inputs, and appends the bytes of its outputs.
+bool RunModel(const std::vector<uint8_t>& model_data,
+              tflite::ErrorReporter* error_reporter,
+              std::vector<uint8_t>* outputs) {
+  tflite::AllOpsResolver resolver;
+  tflite::MicroInterpreter interpreter(tflite::GetModel(model_data.data()),
+                                       resolver, tensor_arena, kArenaSize,
+                                       error_reporter);
+  if (interpreter.AllocateTensors() != kTfLiteOk) {
+    return false;
+  }
+  uint32_t seed = 1;
+  for (int run = 0; run < kVerifyRuns; ++run) {
+    for (size_t i = 0; i < interpreter.inputs_size(); ++i) {
+      TfLiteTensor* input = interpreter.input(i);
+      for (size_t j = 0; j < input->bytes; ++j) {
+        seed = seed * 1664525u + 1013904223u;
+        if (input->type == kTfLiteFloat32) {
+          if (j % sizeof(float) == 0) {
+            input->data.f[j / sizeof(float)] =
+                static_cast<float>(seed >> 8) / (1 << 23) - 1.0f;
+          }
+        } else {
+          input->data.uint8[j] = static_cast<uint8_t>(seed >> 24);
+        }
+      }
+    }
+    if (interpreter.Invoke() != kTfLiteOk) {
+      return false;
+    }
+    for (size_t i = 0; i < interpreter.outputs_size(); ++i) {
+      const TfLiteTensor* output = interpreter.output(i);
+      outputs->insert(outputs->end(), output->data.uint8,
+                      output->data.uint8 + output->bytes);
+    }
+  }
+  return true;
+}
+
+std::vector<uint8_t> PackModel(const tflite::ModelT& model) {
+  flatbuffers::FlatBufferBuilder builder;
+  tflite::FinishModelBuffer(builder, tflite::Model::Pack(builder, &model));
+  return std::vector<uint8_t>(builder.GetBufferPointer(),
+                              builder.GetBufferPointer() + builder.GetSize());
+}
+
+}  // namespace
+
+int main(int argc, char** argv) {
+  tflite::MicroErrorReporter micro_error_reporter;
+  tflite::ErrorReporter* error_reporter = &micro_error_reporter;
+  Options options;
+  for (; argc > 3; ++argv, --argc) {
+    if (sscanf(argv[1], "--bits=%d", &options.bits) == 1 &&
+        (options.bits == 1 || options.bits == 2 || options.bits == 4 ||
+         options.bits == 8)) {
+      continue;
+    }
+    if (strcmp(argv[1], "--uniform") == 0) {
+      options.uniform = true;
+      continue;
+    }
+    break;
+  }
+  if (argc != 3) {
+    fprintf(stderr,
+            "usage: %s [--bits=1|2|4|8] [--uniform] <input.tflite> "
+            "<output.tflite>\n",
+            argv[0]);
+    return 1;
+  }
+
+  std::vector<uint8_t> model_data;
+  if (!ReadFile(argv[1], &model_data)) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot read %s", argv[1]);
+    return 1;
+  }
+  const tflite::Model* model = tflite::GetModel(model_data.data());
+  if (model->version() != TFLITE_SCHEMA_VERSION) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Model provided is schema version %d not equal "
+                         "to supported version %d.",
+                         model->version(), TFLITE_SCHEMA_VERSION);
+    return 1;
+  }
+  if (model->subgraphs()->size() != 1) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Only one subgraph is supported");
+    return 1;
+  }
+
+  std::unique_ptr<tflite::ModelT> decoded(model->UnPack());
+  std::unique_ptr<tflite::ModelT> palettized(model->UnPack());
+  size_t dense_bytes = 0;
+  size_t palettized_bytes = 0;
+  for (int index : FindWeights(*palettized)) {
+    ConvertWeights(index, options, decoded.get(), palettized.get(),
+                   &dense_bytes, &palettized_bytes);
+  }
+
+  const std::vector<uint8_t> decoded_data = PackModel(*decoded);
+  const std::vector<uint8_t> palettized_data = PackModel(*palettized);
+  if (!WriteFile(argv[2], palettized_data.data(), palettized_data.size())) {
+    TF_LITE_REPORT_ERROR(error_reporter, "Cannot write %s", argv[2]);
+    return 1;
+  }
+
+  // The palettized kernels must match the dense ones on the palette values.
+  std::vector<uint8_t> decoded_outputs;
+  std::vector<uint8_t> palettized_outputs;
+  if (!RunModel(decoded_data, error_reporter, &decoded_outputs) ||
+      !RunModel(palettized_data, error_reporter, &palettized_outputs) ||
+      decoded_outputs != palettized_outputs) {
+    TF_LITE_REPORT_ERROR(error_reporter,
+                         "Verification of the palettized model failed");
+    return 1;
+  }
+
+  fprintf(stderr, "%s: weights %zu -> %zu bytes, model %zu -> %zu bytes\n",
+          argv[2], dense_bytes, palettized_bytes, model_data.size(),
+          palettized_data.size());
+  return 0;
+}
@@ -18,4 +18,28 @@ file(GLOB_RECURSE EXT_LIB_FILES
 )
 add_library(cmsis STATIC ${EXT_LIB_FILES})
 
+# Host builds can run the s8 matrix and depthwise cores of CMSIS-NN with x86
+# SIMD instead of the portable C paths. The results are bit exact either way.
+set(CMSIS_NN_X86_SIMD NONE CACHE STRING
+	"x86 SIMD level for the CMSIS-NN cores (NONE, SSE4.1 or AVX2)")
+set_property(CACHE CMSIS_NN_X86_SIMD PROPERTY STRINGS NONE SSE4.1 AVX2)
+if(CMSIS_NN_X86_SIMD STREQUAL "AVX2")
+	target_compile_options(cmsis PRIVATE -mavx2)
+elseif(CMSIS_NN_X86_SIMD STREQUAL "SSE4.1")
+	target_compile_options(cmsis PRIVATE -msse4.1)
+elseif(NOT CMSIS_NN_X86_SIMD STREQUAL "NONE")
+	message(FATAL_ERROR "Unknown CMSIS_NN_X86_SIMD: ${CMSIS_NN_X86_SIMD}")
+endif()
+
+# Builds the ARM_MATH_DSP paths, the code that ships on Cortex-M4/M7, with
+# the portable intrinsics of cmsis_dsp_emulation.h so they can be tested and
+# benchmarked on the host.
+option(CMSIS_DSP_EMULATION "Build the CMSIS DSP extension paths with emulated intrinsics" OFF)
+if(CMSIS_DSP_EMULATION)
+	if(NOT CMSIS_NN_X86_SIMD STREQUAL "NONE")
+		message(FATAL_ERROR "CMSIS_DSP_EMULATION and CMSIS_NN_X86_SIMD are exclusive")
+	endif()
+	target_compile_definitions(cmsis PRIVATE __ARM_FEATURE_DSP=1 CMSIS_DSP_EMULATION)
+endif()
+
 list(APPEND ALL_EXT_LIBS cmsis)
\ No newline at end of file
@@ -0,0 +1,75 @@
+cmake_minimum_required(VERSION 3.8)
+
+message("### setting library tensorflow-microlite ###")
+
+# Builds the TFLM runtime for the host. The reference kernels in
+# micro/kernels/linux are used unless TFLM_USE_CMSIS_NN is set, in which case
+# the micro/kernels/cmsis-nn variants replace them and run the portable C
+# paths of the CMSIS-NN library.
+option(TFLM_USE_CMSIS_NN "Use the CMSIS-NN kernels (portable C paths)" OFF)
+# MicroInterpreter reports per-operator events to an attached profiler only
+# when TF_LITE_MICRO_PROFILE is defined. It is independent of NDEBUG, so that
+# release builds can be profiled too.
+option(TFLM_PROFILE "Report operator invocations to the profiler" ON)
+# The host FULLY_CONNECTED and CONV_2D kernels in micro/kernels/linux split
+# their work over the std::thread pool in micro/linux/host_thread_pool.cc
+# when TF_LITE_MICRO_HOST_THREADS is defined. Other builds of those kernels,
+# e.g. for the device, stay single-threaded.
+option(TFLM_HOST_THREADS "Multithread the host kernels" ON)
+
+set(TFLM_DIR ${CMAKE_SOURCE_DIR}/source/tensorflow/tensorflow/lite)
+
+include_directories(
+	source/tensorflow
+	third_party/flatbuffers/include
+	third_party/gemmlowp
+	third_party/ruy
+	)
+
+add_definitions(-DTF_LITE_STATIC_MEMORY)
+if(TFLM_PROFILE)
+	add_definitions(-DTF_LITE_MICRO_PROFILE)
+endif()
+if(TFLM_HOST_THREADS)
+	add_definitions(-DTF_LITE_MICRO_HOST_THREADS)
+endif()
+
+file(GLOB TFLM_FILES
+	${TFLM_DIR}/c/*.c
+	${TFLM_DIR}/core/api/*.cc
+	${TFLM_DIR}/kernels/*.cc
+	${TFLM_DIR}/kernels/internal/*.cc
+	${TFLM_DIR}/micro/*.cc
+	${TFLM_DIR}/micro/memory_planner/*.cc
+	${TFLM_DIR}/micro/kernels/*.cc
+	${TFLM_DIR}/micro/linux/*.cc
+)
+# Replaced by the clock_gettime() version in micro/linux.
+list(REMOVE_ITEM TFLM_FILES ${TFLM_DIR}/micro/micro_time.cc)
+if(NOT TFLM_HOST_THREADS)
+	list(REMOVE_ITEM TFLM_FILES ${TFLM_DIR}/micro/linux/host_thread_pool.cc)
+endif()
+
+file(GLOB TFLM_KERNEL_FILES ${TFLM_DIR}/micro/kernels/linux/*.cc)
+if(TFLM_USE_CMSIS_NN)
+	file(GLOB TFLM_CMSIS_NN_FILES ${TFLM_DIR}/micro/kernels/cmsis-nn/*.cc)
+	foreach(CMSIS_NN_FILE ${TFLM_CMSIS_NN_FILES})
+		get_filename_component(KERNEL_NAME ${CMSIS_NN_FILE} NAME)
+		list(REMOVE_ITEM TFLM_KERNEL_FILES
+			${TFLM_DIR}/micro/kernels/linux/${KERNEL_NAME})
+	endforeach()
+	list(APPEND TFLM_KERNEL_FILES ${TFLM_CMSIS_NN_FILES})
+	# The kernels only call into CMSIS-NN on DSP targets. Without ARM_MATH_DSP
+	# the library itself still builds its portable C paths.
+	set_source_files_properties(${TFLM_CMSIS_NN_FILES}
+		PROPERTIES COMPILE_DEFINITIONS __ARM_FEATURE_DSP)
+endif()
+
+add_library(tensorflow-microlite STATIC ${TFLM_FILES} ${TFLM_KERNEL_FILES})
+target_link_libraries(tensorflow-microlite cmsis)
+if(TFLM_HOST_THREADS)
+	find_package(Threads REQUIRED)
+	target_link_libraries(tensorflow-microlite Threads::Threads)
+endif()
+
+list(APPEND ALL_EXT_LIBS tensorflow-microlite)